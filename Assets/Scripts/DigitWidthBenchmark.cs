@@ -0,0 +1,131 @@
+using System.Diagnostics;
+using GPUInt64Sorting.Runtime;
+using UnityEngine;
+using Debug = UnityEngine.Debug;
+
+//Times the 8 and 11-bit DeviceRadixSort on random ulong keys for every
+//power of two size in [m_minPower, m_maxPower], and logs which width is
+//faster. The size where the winner flips is the crossover of the device.
+public class DigitWidthBenchmark : MonoBehaviour
+{
+    public ComputeShader m_computeShader;
+    public int m_minPower = 10;
+    public int m_maxPower = 24;
+    public int m_batchSize = 20;
+
+    private DeviceRadixSort m_narrowSort;
+    private DeviceRadixSort m_wideSort;
+
+    private GraphicsBuffer m_source;
+    private GraphicsBuffer m_keys;
+    private GraphicsBuffer m_narrowAlt;
+    private GraphicsBuffer m_narrowGlobalHist;
+    private GraphicsBuffer m_narrowPassHist;
+    private GraphicsBuffer m_wideAlt;
+    private GraphicsBuffer m_wideGlobalHist;
+    private GraphicsBuffer m_widePassHist;
+
+    private readonly ulong[] m_sync = new ulong[1];
+
+    private void Start()
+    {
+        if (m_computeShader == null || m_minPower < 1 || m_maxPower < m_minPower)
+            return;
+
+        int maxSize = 1 << m_maxPower;
+        m_narrowSort = new DeviceRadixSort(
+            m_computeShader,
+            maxSize,
+            ref m_narrowAlt,
+            ref m_narrowGlobalHist,
+            ref m_narrowPassHist,
+            DeviceRadixSort.DigitWidth.Bits8);
+        m_wideSort = new DeviceRadixSort(
+            m_computeShader,
+            maxSize,
+            ref m_wideAlt,
+            ref m_wideGlobalHist,
+            ref m_widePassHist,
+            DeviceRadixSort.DigitWidth.Bits11);
+
+        //Both widths are timed on their passes, even below a tile
+        m_narrowSort.SmallSortSize = 0;
+        m_wideSort.SmallSortSize = 0;
+
+        ulong[] keys = new ulong[maxSize];
+        System.Random random = new System.Random(10);
+        byte[] bytes = new byte[8];
+        for (int i = 0; i < maxSize; ++i)
+        {
+            random.NextBytes(bytes);
+            keys[i] = System.BitConverter.ToUInt64(bytes, 0);
+        }
+
+        m_source = new GraphicsBuffer(GraphicsBuffer.Target.Structured, maxSize, 8) { name = "BenchmarkSource" };
+        m_source.SetData(keys);
+        m_keys = new GraphicsBuffer(GraphicsBuffer.Target.Structured, maxSize, 8) { name = "BenchmarkKeys" };
+
+        Debug.Log("Size, 8-bit Mkeys/s, 11-bit Mkeys/s, Faster");
+        for (int power = m_minPower; power <= m_maxPower; ++power)
+        {
+            int size = 1 << power;
+            double narrow = Run(m_narrowSort, size, m_narrowAlt, m_narrowGlobalHist, m_narrowPassHist);
+            double wide = Run(m_wideSort, size, m_wideAlt, m_wideGlobalHist, m_widePassHist);
+            Debug.Log(size + ", " + narrow.ToString("F1") + ", " + wide.ToString("F1") + ", " +
+                (wide > narrow ? "11" : "8"));
+        }
+    }
+
+    //The first sort is a warm up, and the one validated
+    private double Run(
+        DeviceRadixSort sorter,
+        int size,
+        GraphicsBuffer alt,
+        GraphicsBuffer globalHist,
+        GraphicsBuffer passHist)
+    {
+        double seconds = 0.0;
+        for (int i = 0; i <= m_batchSize; ++i)
+        {
+            Graphics.CopyBuffer(m_source, m_keys);
+            m_keys.GetData(m_sync, 0, 0, 1);
+
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            sorter.Sort(size, m_keys, alt, globalHist, passHist, typeof(ulong), true);
+            m_keys.GetData(m_sync, 0, 0, 1);
+            stopwatch.Stop();
+
+            if (i == 0)
+                Validate(size, sorter.LastDigitBits);
+            else
+                seconds += stopwatch.Elapsed.TotalSeconds;
+        }
+        return size / seconds * m_batchSize / 1e6;
+    }
+
+    private void Validate(int size, int digitBits)
+    {
+        ulong[] sorted = new ulong[size];
+        m_keys.GetData(sorted, 0, 0, size);
+        for (int i = 1; i < size; ++i)
+        {
+            if (sorted[i - 1] > sorted[i])
+            {
+                Debug.LogError(digitBits + "-bit sort failed validation at size " + size);
+                return;
+            }
+        }
+    }
+
+    private void OnDestroy()
+    {
+        m_source?.Dispose();
+        m_keys?.Dispose();
+        m_narrowAlt?.Dispose();
+        m_narrowGlobalHist?.Dispose();
+        m_narrowPassHist?.Dispose();
+        m_wideAlt?.Dispose();
+        m_wideGlobalHist?.Dispose();
+        m_widePassHist?.Dispose();
+    }
+}
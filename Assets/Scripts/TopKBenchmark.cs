@@ -0,0 +1,171 @@
+using System.Diagnostics;
+using GPUInt64Sorting.Runtime;
+using UnityEngine;
+using Debug = UnityEngine.Debug;
+
+//Times a full DeviceRadixSort of m_size random ulong keys against a
+//RadixSelect.TopK of the k smallest for each k in m_topKs, and validates
+//each top k against the first k keys of the full sort. The edge cases,
+//k of 1, n - 1 and n, and an input of equal keys, are always validated.
+public class TopKBenchmark : MonoBehaviour
+{
+    public ComputeShader m_sortShader;
+    public ComputeShader m_selectShader;
+    public int m_size = 1 << 24;
+    public int[] m_topKs = { 16, 1024, 65536 };
+    public int m_batchSize = 20;
+
+    private DeviceRadixSort m_sort;
+    private RadixSelect m_select;
+
+    private GraphicsBuffer m_source;
+    private GraphicsBuffer m_keys;
+    private GraphicsBuffer m_topK;
+    private GraphicsBuffer m_sortAlt;
+    private GraphicsBuffer m_sortGlobalHist;
+    private GraphicsBuffer m_sortPassHist;
+    private GraphicsBuffer m_selectTemp;
+    private GraphicsBuffer m_selectAlt;
+    private GraphicsBuffer m_selectGlobalHist;
+    private GraphicsBuffer m_selectArgs;
+    private GraphicsBuffer m_selectInfo;
+
+    private readonly ulong[] m_sync = new ulong[1];
+
+    private void Start()
+    {
+        if (m_sortShader == null || m_selectShader == null || m_size < 2)
+            return;
+
+        m_sort = new DeviceRadixSort(
+            m_sortShader,
+            m_size,
+            ref m_sortAlt,
+            ref m_sortGlobalHist,
+            ref m_sortPassHist);
+        m_select = new RadixSelect(
+            m_selectShader,
+            m_size,
+            ref m_selectTemp,
+            ref m_selectAlt,
+            ref m_selectGlobalHist,
+            ref m_selectArgs,
+            ref m_selectInfo);
+
+        ulong[] keys = new ulong[m_size];
+        System.Random random = new System.Random(10);
+        byte[] bytes = new byte[8];
+        for (int i = 0; i < m_size; ++i)
+        {
+            random.NextBytes(bytes);
+            keys[i] = System.BitConverter.ToUInt64(bytes, 0);
+        }
+
+        m_source = new GraphicsBuffer(GraphicsBuffer.Target.Structured, m_size, 8) { name = "BenchmarkSource" };
+        m_source.SetData(keys);
+        m_keys = new GraphicsBuffer(GraphicsBuffer.Target.Structured, m_size, 8) { name = "BenchmarkKeys" };
+        m_topK = new GraphicsBuffer(GraphicsBuffer.Target.Structured, m_size, 8) { name = "BenchmarkTopK" };
+
+        ulong[] sorted = new ulong[m_size];
+        double full = RunSort(sorted);
+        Debug.Log("Size " + m_size + ", full sort " + full.ToString("F1") + " Mkeys/s");
+
+        Debug.Log("k, Top k Mkeys/s, Speedup");
+        foreach (int k in m_topKs)
+        {
+            if (k < 1 || k > m_size)
+                continue;
+
+            double topK = RunTopK(k, sorted);
+            Debug.Log(k + ", " + topK.ToString("F1") + ", " + (topK / full).ToString("F2"));
+        }
+
+        foreach (int k in new int[] { 1, m_size - 1, m_size })
+            RunTopK(k, sorted);
+
+        //Every digit of every key lands in one bucket, so each digit passes
+        //all the candidates on, and the last digit picks k of the ties
+        const ulong equalKey = 0x0123456789abcdefUL;
+        for (int i = 0; i < m_size; ++i)
+        {
+            keys[i] = equalKey;
+            sorted[i] = equalKey;
+        }
+        m_source.SetData(keys);
+        foreach (int k in new int[] { 1, m_size / 2, m_size - 1, m_size })
+            RunTopK(k, sorted);
+        Debug.Log("Top k edge cases validated");
+    }
+
+    //The first sort is a warm up, and the one kept as the reference
+    private double RunSort(ulong[] sorted)
+    {
+        double seconds = 0.0;
+        for (int i = 0; i <= m_batchSize; ++i)
+        {
+            Graphics.CopyBuffer(m_source, m_keys);
+            m_keys.GetData(m_sync, 0, 0, 1);
+
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            m_sort.Sort(m_size, m_keys, m_sortAlt, m_sortGlobalHist, m_sortPassHist, typeof(ulong), true);
+            m_keys.GetData(m_sync, 0, 0, 1);
+            stopwatch.Stop();
+
+            if (i == 0)
+                m_keys.GetData(sorted);
+            else
+                seconds += stopwatch.Elapsed.TotalSeconds;
+        }
+        return m_size / seconds * m_batchSize / 1e6;
+    }
+
+    //The input is never modified by the select, so there is no copy
+    private double RunTopK(int k, ulong[] sorted)
+    {
+        double seconds = 0.0;
+        for (int i = 0; i <= m_batchSize; ++i)
+        {
+            Stopwatch stopwatch = Stopwatch.StartNew();
+            m_select.TopK(m_size, k, m_source, m_topK, m_selectTemp, m_selectAlt, m_selectGlobalHist,
+                m_selectArgs, m_selectInfo, m_sort, m_sortAlt, m_sortGlobalHist, m_sortPassHist,
+                typeof(ulong), true);
+            m_topK.GetData(m_sync, 0, 0, 1);
+            stopwatch.Stop();
+
+            if (i == 0)
+                Validate(k, sorted);
+            else
+                seconds += stopwatch.Elapsed.TotalSeconds;
+        }
+        return m_size / seconds * m_batchSize / 1e6;
+    }
+
+    private void Validate(int k, ulong[] sorted)
+    {
+        ulong[] topK = new ulong[k];
+        m_topK.GetData(topK, 0, 0, k);
+        for (int i = 0; i < k; ++i)
+        {
+            if (topK[i] != sorted[i])
+            {
+                Debug.LogError("Top " + k + " failed validation at index " + i);
+                return;
+            }
+        }
+    }
+
+    private void OnDestroy()
+    {
+        m_source?.Dispose();
+        m_keys?.Dispose();
+        m_topK?.Dispose();
+        m_sortAlt?.Dispose();
+        m_sortGlobalHist?.Dispose();
+        m_sortPassHist?.Dispose();
+        m_selectTemp?.Dispose();
+        m_selectAlt?.Dispose();
+        m_selectGlobalHist?.Dispose();
+        m_selectArgs?.Dispose();
+        m_selectInfo?.Dispose();
+    }
+}
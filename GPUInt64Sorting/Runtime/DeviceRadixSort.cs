@@ -14,19 +14,87 @@ namespace GPUInt64Sorting.Runtime
 {
     public class DeviceRadixSort : GPUSortBase
     {
+        protected const int k_globalHistPartSize = k_partitionSize * 8;  //Eight sorting tiles, G_HIST_TILES
+        protected const int k_indirectArgsSize = 6;         //Global histogram, then partition tile dispatch arguments
+        protected const int k_partitionArgsOffset = 3 * 4;  //Byte offset of the partition tile dispatch arguments
+        protected const int k_sortInfoSize = 3;
+        protected const int k_initDim = 1024;                //Threads in an InitDeviceRadixSort threadblock
+
+        //Eleven bit digits save two of the eight passes, six dispatches and a
+        //quarter of the key reads and writes. In exchange, the tile histograms
+        //grow eightfold, the downsweep takes the full 32KB of groupshared
+        //memory, most wave sizes rank serially, and a tile scatters runs of
+        //about two keys per digit. Which width wins depends on the size and
+        //the device, run the DigitWidthBenchmark to find the crossover.
+        //Bits8 is the default.
+        public enum DigitWidth
+        {
+            Bits8 = 8,
+            Bits11 = 11,
+        }
+
+        private int m_kernelSetupIndirect = -1;
         private int m_kernelInit = -1;
+        private int m_kernelGlobalHist = -1;
+        private int m_kernelGlobalHistScan = -1;
         private int m_kernelUpsweep = -1;
         private int m_kernelScan = -1;
         private int m_kernelDownsweep = -1;
 
         private readonly bool k_keysOnly;
 
+        //The width the buffers were allocated for, and the width used by the
+        //most recent sort, which differs for SmallSort
+        private readonly DigitWidth k_digitWidth;
+        private int m_digitBits = k_digitBits;
+        private LocalKeyword m_wideDigitKeyword;
+
+        //Set for the indirect overloads, where the key count and thread
+        //block counts are read from b_sortInfo instead of the constants
+        private LocalKeyword m_indirectKeyword;
+
+        //Opt-in: skip passes whose digit is the same for every key.
+        //Requires reading the global histogram back to the host, so it
+        //only applies to the immediate mode overloads with a host key
+        //count. The CommandBuffer and indirect overloads always run every
+        //pass in the bit range, and assert that this is off.
+        //
+        //The readback is a full stall: GetData waits for everything queued
+        //before it, then the passes are only recorded afterwards, so the
+        //GPU idles for a round trip while the CPU blocks. That only pays
+        //off when a skipped pass costs more than the round trip, i.e. for
+        //large sorts over narrow keys. ReadbackMilliseconds reports the
+        //stall of the last skipping sort, compare it with the sort time
+        //before enabling this on a given device.
+        private bool m_skipTrivialPasses;
+        private int m_skippedPasses;
+        private double m_readbackMilliseconds;
+        private readonly uint[] m_globalHistReadback = new uint[k_wideRadix * k_wideRadixPasses];
+
+        public bool SkipTrivialPasses
+        {
+            get => m_skipTrivialPasses;
+            set => m_skipTrivialPasses = value;
+        }
+
+        //The number of passes skipped by the most recent sort
+        public int SkippedPasses => m_skippedPasses;
+
+        //Wall time the most recent skipping sort blocked on the readback
+        public double ReadbackMilliseconds => m_readbackMilliseconds;
+
+        public DigitWidth AllocatedDigitWidth => k_digitWidth;
+
+        //Digit width in bits of the most recent sort
+        public int LastDigitBits => m_digitBits;
+
         public DeviceRadixSort(
             ComputeShader compute,
             int allocationSize,
             ref GraphicsBuffer tempKeyBuffer,
             ref GraphicsBuffer tempGlobalHistBuffer,
-            ref GraphicsBuffer tempPassHistBuffer) : 
+            ref GraphicsBuffer tempPassHistBuffer,
+            DigitWidth digitWidth = DigitWidth.Bits8) : 
             base(
                 compute,
                 allocationSize)
@@ -34,14 +102,15 @@ namespace GPUInt64Sorting.Runtime
             InitKernels();
             m_cs.DisableKeyword(m_sortPairKeyword);
             k_keysOnly = true;
+            k_digitWidth = digitWidth;
 
             tempKeyBuffer?.Dispose();
             tempGlobalHistBuffer?.Dispose();
             tempPassHistBuffer?.Dispose();
 
             tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
-            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * k_radixPasses, 4) { name="TempGloabalHist" };
-            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * DivRoundUp(k_maxKeysAllocated, k_partitionSize), 4) { name="TempPassHist" };
+            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, GlobalHistSize(MaxDigitBits()), 4) { name="TempGloabalHist" };
+            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, (1 << MaxDigitBits()) * DivRoundUp(k_maxKeysAllocated, k_partitionSize), 4) { name="TempPassHist" };
         }
 
         public DeviceRadixSort(
@@ -50,7 +119,30 @@ namespace GPUInt64Sorting.Runtime
             ref GraphicsBuffer tempKeyBuffer,
             ref GraphicsBuffer tempPayloadBuffer,
             ref GraphicsBuffer tempGlobalHistBuffer,
-            ref GraphicsBuffer tempPassHistBuffer) :
+            ref GraphicsBuffer tempPassHistBuffer,
+            DigitWidth digitWidth = DigitWidth.Bits8) :
+            this(
+                compute,
+                allocationSize,
+                typeof(uint),
+                ref tempKeyBuffer,
+                ref tempPayloadBuffer,
+                ref tempGlobalHistBuffer,
+                ref tempPassHistBuffer,
+                digitWidth)
+        {
+        }
+
+        //Pairs with an explicit payload type, a ulong payload needs an 8 byte temp payload buffer
+        public DeviceRadixSort(
+            ComputeShader compute,
+            int allocationSize,
+            System.Type payloadType,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempPayloadBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempPassHistBuffer,
+            DigitWidth digitWidth = DigitWidth.Bits8) :
             base(
                 compute,
                 allocationSize)
@@ -58,6 +150,7 @@ namespace GPUInt64Sorting.Runtime
             InitKernels();
             m_cs.EnableKeyword(m_sortPairKeyword);
             k_keysOnly = false;
+            k_digitWidth = digitWidth;
 
             tempKeyBuffer?.Dispose();
             tempPayloadBuffer?.Dispose();
@@ -65,9 +158,9 @@ namespace GPUInt64Sorting.Runtime
             tempPassHistBuffer?.Dispose();
 
             tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
-            tempPayloadBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4) { name="TempPayload" };
-            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * k_radixPasses, 4) { name="TempGloabalHist" };
-            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * DivRoundUp(k_maxKeysAllocated, k_partitionSize), 4) { name="TempPassHist" };
+            tempPayloadBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, PayloadStride(payloadType)) { name="TempPayload" };
+            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, GlobalHistSize(MaxDigitBits()), 4) { name="TempGloabalHist" };
+            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, (1 << MaxDigitBits()) * DivRoundUp(k_maxKeysAllocated, k_partitionSize), 4) { name="TempPassHist" };
         }
 
         private void InitKernels()
@@ -76,20 +169,29 @@ namespace GPUInt64Sorting.Runtime
 
             if (m_cs)
             {
+                m_kernelSetupIndirect = m_cs.FindKernel("SetupIndirect");
                 m_kernelInit = m_cs.FindKernel("InitDeviceRadixSort");
+                m_kernelGlobalHist = m_cs.FindKernel("GlobalHistogram");
+                m_kernelGlobalHistScan = m_cs.FindKernel("GlobalHistScan");
                 m_kernelUpsweep = m_cs.FindKernel("Upsweep");
                 m_kernelScan = m_cs.FindKernel("Scan");
                 m_kernelDownsweep = m_cs.FindKernel("Downsweep");
             }
 
-            isValid =   m_kernelInit >= 0 &&
+            isValid =   m_kernelSetupIndirect >= 0 &&
+                        m_kernelInit >= 0 &&
+                        m_kernelGlobalHist >= 0 &&
+                        m_kernelGlobalHistScan >= 0 &&
                         m_kernelUpsweep >= 0 &&
                         m_kernelScan >= 0 &&
                         m_kernelDownsweep >= 0;
 
             if (isValid)
             {
-                if (!m_cs.IsSupported(m_kernelInit) ||
+                if (!m_cs.IsSupported(m_kernelSetupIndirect) ||
+                    !m_cs.IsSupported(m_kernelInit) ||
+                    !m_cs.IsSupported(m_kernelGlobalHist) ||
+                    !m_cs.IsSupported(m_kernelGlobalHistScan) ||
                     !m_cs.IsSupported(m_kernelUpsweep) ||
                     !m_cs.IsSupported(m_kernelScan) ||
                     !m_cs.IsSupported(m_kernelDownsweep))
@@ -98,22 +200,177 @@ namespace GPUInt64Sorting.Runtime
                 }
             }
 
+            if (isValid && !InitSmallSortKernel())
+                isValid = false;
+
             Assert.IsTrue(isValid);
+
+            if (m_cs)
+            {
+                m_indirectKeyword = new LocalKeyword(m_cs, "INDIRECT_COUNT");
+                m_wideDigitKeyword = new LocalKeyword(m_cs, "RADIX_11");
+            }
+        }
+
+        private int MaxDigitBits()
+        {
+            return k_digitWidth == DigitWidth.Bits8 ? k_digitBits : k_wideDigitBits;
+        }
+
+        private static int GlobalHistSize(int digitBits)
+        {
+            return (1 << digitBits) * RadixPasses(digitBits);
+        }
+
+        private void SetDigitBits()
+        {
+            m_digitBits = (int)k_digitWidth;
+        }
+
+        //SmallSort splits 8-bit digits whatever the width, the narrow
+        //variant keeps its groupshared memory at 16KB
+        private void SetSmallSortDigitBits()
+        {
+            m_digitBits = k_digitBits;
+            m_skippedPasses = 0;
+            SetDigitWidthKeyword();
+        }
+
+        private void SetSmallSortDigitBits(CommandBuffer _cmd)
+        {
+            m_digitBits = k_digitBits;
+            m_skippedPasses = 0;
+            SetDigitWidthKeyword(_cmd);
+        }
+
+        private void SetDigitWidthKeyword()
+        {
+            if (m_digitBits == k_wideDigitBits)
+                m_cs.EnableKeyword(m_wideDigitKeyword);
+            else
+                m_cs.DisableKeyword(m_wideDigitKeyword);
+        }
+
+        private void SetDigitWidthKeyword(CommandBuffer _cmd)
+        {
+            if (m_digitBits == k_wideDigitBits)
+                _cmd.EnableKeyword(m_cs, m_wideDigitKeyword);
+            else
+                _cmd.DisableKeyword(m_cs, m_wideDigitKeyword);
+        }
+
+        //Allocates the buffers the indirect overloads need, on top of the
+        //ones allocated by the constructor
+        public static void InitIndirectBuffers(
+            ref GraphicsBuffer tempIndirectArgsBuffer,
+            ref GraphicsBuffer tempSortInfoBuffer)
+        {
+            tempIndirectArgsBuffer?.Dispose();
+            tempSortInfoBuffer?.Dispose();
+
+            tempIndirectArgsBuffer = new GraphicsBuffer(
+                GraphicsBuffer.Target.IndirectArguments | GraphicsBuffer.Target.Structured,
+                k_indirectArgsSize, sizeof(uint)) { name="TempIndirectArgs" };
+            tempSortInfoBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_sortInfoSize, sizeof(uint)) { name="TempSortInfo" };
+        }
+
+        private void SetIndirectKeyword(bool _isIndirect)
+        {
+            if (_isIndirect)
+                m_cs.EnableKeyword(m_indirectKeyword);
+            else
+                m_cs.DisableKeyword(m_indirectKeyword);
+        }
+
+        private void SetIndirectKeyword(CommandBuffer _cmd, bool _isIndirect)
+        {
+            if (_isIndirect)
+                _cmd.EnableKeyword(m_cs, m_indirectKeyword);
+            else
+                _cmd.DisableKeyword(m_cs, m_indirectKeyword);
+        }
+
+        //A pass is trivial when a single bin holds every key, making it an
+        //identity permutation. b_globalHist holds exclusive prefix sums, so
+        //a bin's count is the next bin's prefix minus its own. The final
+        //pass is kept when descending, because it performs the reversal.
+        private int GetTrivialPassMask(
+            int numKeys,
+            bool shouldAscend,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _globalHistBuffer)
+        {
+            int skipMask = 0;
+            int radix = 1 << m_digitBits;
+            int passBegin = PassIndex(beginBit, m_digitBits);
+            int passEnd = PassIndex(endBit - 1, m_digitBits) + (shouldAscend ? 1 : 0);
+            if (passEnd <= passBegin)
+            {
+                m_readbackMilliseconds = 0.0;
+                return skipMask;
+            }
+
+            //Only the histograms of the candidate passes are read back
+            System.Diagnostics.Stopwatch stopwatch = System.Diagnostics.Stopwatch.StartNew();
+            _globalHistBuffer.GetData(
+                m_globalHistReadback,
+                passBegin * radix,
+                passBegin * radix,
+                (passEnd - passBegin) * radix);
+            m_readbackMilliseconds = stopwatch.Elapsed.TotalMilliseconds;
+
+            for (int pass = passBegin; pass < passEnd; ++pass)
+            {
+                int passOffset = pass * radix;
+                for (int i = 0; i < radix; ++i)
+                {
+                    uint next = i < radix - 1 ? m_globalHistReadback[passOffset + i + 1] : (uint)numKeys;
+                    if (next - m_globalHistReadback[passOffset + i] == numKeys)
+                    {
+                        skipMask |= 1 << pass;
+                        break;
+                    }
+                }
+            }
+
+            return skipMask;
+        }
+
+        //GlobalHistogram also writes the tile counts of the lowest pass that
+        //would be dispatched without skipping, so that pass needs no Upsweep.
+        //It is always the first dispatched pass when it is dispatched at all,
+        //otherwise the keys have not moved and the next pass runs its own.
+        private int GetTileCountPass(int beginBit, int endBit)
+        {
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            int pass = 0;
+            while ((passMask >> pass & 1) == 0)
+                pass++;
+            return pass;
         }
 
         private void SetStaticRootParameters(
             int numKeys,
-            int numThreadBlocks,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _sortBuffer,
             GraphicsBuffer _passHistBuffer,
             GraphicsBuffer _globalHistBuffer)
         {
             m_cs.SetInt("e_numKeys", numKeys);
-            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+            m_cs.SetInt("e_beginBit", beginBit);
+            m_cs.SetInt("e_endBit", endBit);
 
             m_cs.SetBuffer(m_kernelInit, "b_globalHist", _globalHistBuffer);
 
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_sort", _sortBuffer);
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_passHist", _passHistBuffer);
+
+            m_cs.SetBuffer(m_kernelGlobalHistScan, "b_globalHist", _globalHistBuffer);
+
             m_cs.SetBuffer(m_kernelUpsweep, "b_passHist", _passHistBuffer);
-            m_cs.SetBuffer(m_kernelUpsweep, "b_globalHist", _globalHistBuffer);
 
             m_cs.SetBuffer(m_kernelScan, "b_passHist", _passHistBuffer);
 
@@ -123,18 +380,26 @@ namespace GPUInt64Sorting.Runtime
 
         private void SetStaticRootParameters(
             int numKeys,
-            int numThreadBlocks,
+            int beginBit,
+            int endBit,
             CommandBuffer _cmd,
+            GraphicsBuffer _sortBuffer,
             GraphicsBuffer _passHistBuffer,
             GraphicsBuffer _globalHistBuffer)
         {
             _cmd.SetComputeIntParam(m_cs, "e_numKeys", numKeys);
-            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+            _cmd.SetComputeIntParam(m_cs, "e_beginBit", beginBit);
+            _cmd.SetComputeIntParam(m_cs, "e_endBit", endBit);
 
             _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_globalHist", _globalHistBuffer);
 
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_sort", _sortBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_passHist", _passHistBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHistScan, "b_globalHist", _globalHistBuffer);
+
             _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_passHist", _passHistBuffer);
-            _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_globalHist", _globalHistBuffer);
 
             _cmd.SetComputeBufferParam(m_cs, m_kernelScan, "b_passHist", _passHistBuffer);
 
@@ -142,25 +407,96 @@ namespace GPUInt64Sorting.Runtime
             _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_globalHist", _globalHistBuffer);
         }
 
+        //e_numKeys is the upper bound the device count is clamped to
+        private void SetIndirectRootParameters(
+            int keyCountOffset,
+            GraphicsBuffer _keyCountBuffer,
+            GraphicsBuffer _indirectArgsBuffer,
+            GraphicsBuffer _sortInfoBuffer)
+        {
+            m_cs.SetInt("e_keyCountOffset", keyCountOffset);
+            m_cs.SetInt("e_isPartial", k_isNotPartialBitFlag);
+
+            m_cs.SetBuffer(m_kernelSetupIndirect, "b_keyCount", _keyCountBuffer);
+            m_cs.SetBuffer(m_kernelSetupIndirect, "b_indirectArgs", _indirectArgsBuffer);
+            m_cs.SetBuffer(m_kernelSetupIndirect, "b_sortInfo", _sortInfoBuffer);
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_sortInfo", _sortInfoBuffer);
+            m_cs.SetBuffer(m_kernelUpsweep, "b_sortInfo", _sortInfoBuffer);
+            m_cs.SetBuffer(m_kernelScan, "b_sortInfo", _sortInfoBuffer);
+            m_cs.SetBuffer(m_kernelDownsweep, "b_sortInfo", _sortInfoBuffer);
+        }
+
+        private void SetIndirectRootParameters(
+            int keyCountOffset,
+            CommandBuffer _cmd,
+            GraphicsBuffer _keyCountBuffer,
+            GraphicsBuffer _indirectArgsBuffer,
+            GraphicsBuffer _sortInfoBuffer)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_keyCountOffset", keyCountOffset);
+            _cmd.SetComputeIntParam(m_cs, "e_isPartial", k_isNotPartialBitFlag);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSetupIndirect, "b_keyCount", _keyCountBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSetupIndirect, "b_indirectArgs", _indirectArgsBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSetupIndirect, "b_sortInfo", _sortInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_sortInfo", _sortInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sortInfo", _sortInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelScan, "b_sortInfo", _sortInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sortInfo", _sortInfoBuffer);
+        }
+
         private void Dispatch(
             int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int numKeys,
+            int beginBit,
+            int endBit,
+            bool shouldAscend,
+            GraphicsBuffer _globalHist,
             GraphicsBuffer _toSort,
             GraphicsBuffer _alt)
         {
-            m_cs.Dispatch(m_kernelInit, 2, 1, 1);
+            m_cs.Dispatch(m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            m_cs.SetInt("e_radixShift", PassShift(tileCountPass, m_digitBits));
+            m_cs.SetInt("e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(m_kernelGlobalHist, globalHistThreadBlocks);
+
+            m_cs.Dispatch(m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
 
-            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+
+            int trivialMask = m_skipTrivialPasses ?
+                GetTrivialPassMask(numKeys, shouldAscend, beginBit, endBit, _globalHist) : 0;
+            int passMask = GetPassMask(beginBit, endBit, trivialMask, m_digitBits);
+            m_skippedPasses = 0;
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
             {
+                //Outside of the window, or an identity permutation
+                if ((passMask >> pass & 1) == 0)
+                {
+                    if ((trivialMask >> pass & 1) != 0)
+                        m_skippedPasses++;
+                    continue;
+                }
+
+                int radixShift = PassShift(pass, m_digitBits);
+
                 m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
 
-                m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
-                m_cs.Dispatch(m_kernelUpsweep, numThreadBlocks, 1, 1);
+                if (pass != tileCountPass)
+                {
+                    m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
+                    DispatchFlattened(m_kernelUpsweep, numThreadBlocks);
+                }
 
-                m_cs.Dispatch(m_kernelScan, k_radix, 1, 1);
+                m_cs.Dispatch(m_kernelScan, 1 << m_digitBits, 1, 1);
 
                 m_cs.SetBuffer(m_kernelDownsweep, "b_sort", _toSort);
                 m_cs.SetBuffer(m_kernelDownsweep, "b_alt", _alt);
-                m_cs.Dispatch(m_kernelDownsweep, numThreadBlocks, 1, 1);
+                DispatchFlattened(m_kernelDownsweep, numThreadBlocks);
 
                 (_toSort, _alt) = (_alt, _toSort);
             }
@@ -168,24 +504,47 @@ namespace GPUInt64Sorting.Runtime
 
         private void Dispatch(
             int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
             CommandBuffer _cmd,
             GraphicsBuffer _toSort,
             GraphicsBuffer _alt)
         {
-            _cmd.DispatchCompute(m_cs, m_kernelInit, 2, 1, 1);
+            m_skippedPasses = 0;
+            _cmd.DispatchCompute(m_cs, m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            _cmd.SetComputeIntParam(m_cs, "e_radixShift", PassShift(tileCountPass, m_digitBits));
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(_cmd, m_kernelGlobalHist, globalHistThreadBlocks);
+
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
 
-            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
             {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
                 _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
 
-                _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
-                _cmd.DispatchCompute(m_cs, m_kernelUpsweep, numThreadBlocks, 1, 1);
+                if (pass != tileCountPass)
+                {
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
+                    DispatchFlattened(_cmd, m_kernelUpsweep, numThreadBlocks);
+                }
 
-                _cmd.DispatchCompute(m_cs, m_kernelScan, k_radix, 1, 1);
+                _cmd.DispatchCompute(m_cs, m_kernelScan, 1 << m_digitBits, 1, 1);
 
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sort", _toSort);
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_alt", _alt);
-                _cmd.DispatchCompute(m_cs, m_kernelDownsweep, numThreadBlocks, 1, 1);
+                DispatchFlattened(_cmd, m_kernelDownsweep, numThreadBlocks);
 
                 (_toSort, _alt) = (_alt, _toSort);
             }
@@ -193,27 +552,60 @@ namespace GPUInt64Sorting.Runtime
 
         private void Dispatch(
             int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int numKeys,
+            int beginBit,
+            int endBit,
+            bool shouldAscend,
+            GraphicsBuffer _globalHist,
             GraphicsBuffer _toSort,
             GraphicsBuffer _toSortPayload,
             GraphicsBuffer _alt,
             GraphicsBuffer _altPayload)
         {
-            m_cs.Dispatch(m_kernelInit, 2, 1, 1);
+            m_cs.Dispatch(m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            m_cs.SetInt("e_radixShift", PassShift(tileCountPass, m_digitBits));
+            m_cs.SetInt("e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(m_kernelGlobalHist, globalHistThreadBlocks);
+
+            m_cs.Dispatch(m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
 
-            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+
+            int trivialMask = m_skipTrivialPasses ?
+                GetTrivialPassMask(numKeys, shouldAscend, beginBit, endBit, _globalHist) : 0;
+            int passMask = GetPassMask(beginBit, endBit, trivialMask, m_digitBits);
+            m_skippedPasses = 0;
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
             {
+                //Outside of the window, or an identity permutation
+                if ((passMask >> pass & 1) == 0)
+                {
+                    if ((trivialMask >> pass & 1) != 0)
+                        m_skippedPasses++;
+                    continue;
+                }
+
+                int radixShift = PassShift(pass, m_digitBits);
+
                 m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
 
-                m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
-                m_cs.Dispatch(m_kernelUpsweep, numThreadBlocks, 1, 1);
+                if (pass != tileCountPass)
+                {
+                    m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
+                    DispatchFlattened(m_kernelUpsweep, numThreadBlocks);
+                }
 
-                m_cs.Dispatch(m_kernelScan, k_radix, 1, 1);
+                m_cs.Dispatch(m_kernelScan, 1 << m_digitBits, 1, 1);
 
                 m_cs.SetBuffer(m_kernelDownsweep, "b_sort", _toSort);
                 m_cs.SetBuffer(m_kernelDownsweep, "b_sortPayload", _toSortPayload);
                 m_cs.SetBuffer(m_kernelDownsweep, "b_alt", _alt);
                 m_cs.SetBuffer(m_kernelDownsweep, "b_altPayload", _altPayload);
-                m_cs.Dispatch(m_kernelDownsweep, numThreadBlocks, 1, 1);
+                DispatchFlattened(m_kernelDownsweep, numThreadBlocks);
 
                 (_toSort, _alt) = (_alt, _toSort);
                 (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
@@ -222,58 +614,302 @@ namespace GPUInt64Sorting.Runtime
 
         private void Dispatch(
             int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
             CommandBuffer _cmd,
             GraphicsBuffer _toSort,
             GraphicsBuffer _toSortPayload,
             GraphicsBuffer _alt,
             GraphicsBuffer _altPayload)
         {
-            _cmd.DispatchCompute(m_cs, m_kernelInit, 2, 1, 1);
+            m_skippedPasses = 0;
+            _cmd.DispatchCompute(m_cs, m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            _cmd.SetComputeIntParam(m_cs, "e_radixShift", PassShift(tileCountPass, m_digitBits));
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(_cmd, m_kernelGlobalHist, globalHistThreadBlocks);
+
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
 
-            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
             {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
                 _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
 
-                _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
-                _cmd.DispatchCompute(m_cs, m_kernelUpsweep, numThreadBlocks, 1, 1);
+                if (pass != tileCountPass)
+                {
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
+                    DispatchFlattened(_cmd, m_kernelUpsweep, numThreadBlocks);
+                }
 
-                _cmd.DispatchCompute(m_cs, m_kernelScan, k_radix, 1, 1);
+                _cmd.DispatchCompute(m_cs, m_kernelScan, 1 << m_digitBits, 1, 1);
                 
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sort", _toSort);
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sortPayload", _toSortPayload);
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_alt", _alt);
                 _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_altPayload", _altPayload);
-                _cmd.DispatchCompute(m_cs, m_kernelDownsweep, numThreadBlocks, 1, 1);
+                DispatchFlattened(_cmd, m_kernelDownsweep, numThreadBlocks);
                 
                 (_toSort, _alt) = (_alt, _toSort);
                 (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
             }
         }
 
-        private void AssertChecksKeys(int _inputSize, System.Type _keyType)
+        //The grids come from the device, so trivial passes cannot be found
+        //without a readback, and are never skipped
+        private void DispatchIndirect(
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _alt)
+        {
+            m_skippedPasses = 0;
+            m_cs.Dispatch(m_kernelSetupIndirect, 1, 1, 1);
+            m_cs.Dispatch(m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            m_cs.SetInt("e_radixShift", PassShift(tileCountPass, m_digitBits));
+            m_cs.DispatchIndirect(m_kernelGlobalHist, _indirectArgs, 0);
+            m_cs.Dispatch(m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
+            {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
+                m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
+
+                if (pass != tileCountPass)
+                {
+                    m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
+                    m_cs.DispatchIndirect(m_kernelUpsweep, _indirectArgs, k_partitionArgsOffset);
+                }
+
+                m_cs.Dispatch(m_kernelScan, 1 << m_digitBits, 1, 1);
+
+                m_cs.SetBuffer(m_kernelDownsweep, "b_sort", _toSort);
+                m_cs.SetBuffer(m_kernelDownsweep, "b_alt", _alt);
+                m_cs.DispatchIndirect(m_kernelDownsweep, _indirectArgs, k_partitionArgsOffset);
+
+                (_toSort, _alt) = (_alt, _toSort);
+            }
+        }
+
+        private void DispatchIndirect(
+            int beginBit,
+            int endBit,
+            CommandBuffer _cmd,
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _alt)
+        {
+            m_skippedPasses = 0;
+            _cmd.DispatchCompute(m_cs, m_kernelSetupIndirect, 1, 1, 1);
+            _cmd.DispatchCompute(m_cs, m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            _cmd.SetComputeIntParam(m_cs, "e_radixShift", PassShift(tileCountPass, m_digitBits));
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHist, _indirectArgs, 0);
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
+            {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
+                _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
+
+                if (pass != tileCountPass)
+                {
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
+                    _cmd.DispatchCompute(m_cs, m_kernelUpsweep, _indirectArgs, k_partitionArgsOffset);
+                }
+
+                _cmd.DispatchCompute(m_cs, m_kernelScan, 1 << m_digitBits, 1, 1);
+
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sort", _toSort);
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_alt", _alt);
+                _cmd.DispatchCompute(m_cs, m_kernelDownsweep, _indirectArgs, k_partitionArgsOffset);
+
+                (_toSort, _alt) = (_alt, _toSort);
+            }
+        }
+
+        private void DispatchIndirect(
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _alt,
+            GraphicsBuffer _altPayload)
+        {
+            m_skippedPasses = 0;
+            m_cs.Dispatch(m_kernelSetupIndirect, 1, 1, 1);
+            m_cs.Dispatch(m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            m_cs.SetInt("e_radixShift", PassShift(tileCountPass, m_digitBits));
+            m_cs.DispatchIndirect(m_kernelGlobalHist, _indirectArgs, 0);
+            m_cs.Dispatch(m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
+            {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
+                m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
+
+                if (pass != tileCountPass)
+                {
+                    m_cs.SetBuffer(m_kernelUpsweep, "b_sort", _toSort);
+                    m_cs.DispatchIndirect(m_kernelUpsweep, _indirectArgs, k_partitionArgsOffset);
+                }
+
+                m_cs.Dispatch(m_kernelScan, 1 << m_digitBits, 1, 1);
+
+                m_cs.SetBuffer(m_kernelDownsweep, "b_sort", _toSort);
+                m_cs.SetBuffer(m_kernelDownsweep, "b_sortPayload", _toSortPayload);
+                m_cs.SetBuffer(m_kernelDownsweep, "b_alt", _alt);
+                m_cs.SetBuffer(m_kernelDownsweep, "b_altPayload", _altPayload);
+                m_cs.DispatchIndirect(m_kernelDownsweep, _indirectArgs, k_partitionArgsOffset);
+
+                (_toSort, _alt) = (_alt, _toSort);
+                (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
+            }
+        }
+
+        private void DispatchIndirect(
+            int beginBit,
+            int endBit,
+            CommandBuffer _cmd,
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _alt,
+            GraphicsBuffer _altPayload)
+        {
+            m_skippedPasses = 0;
+            _cmd.DispatchCompute(m_cs, m_kernelSetupIndirect, 1, 1, 1);
+            _cmd.DispatchCompute(m_cs, m_kernelInit, GlobalHistSize(m_digitBits) / k_initDim, 1, 1);
+            int tileCountPass = GetTileCountPass(beginBit, endBit);
+            _cmd.SetComputeIntParam(m_cs, "e_radixShift", PassShift(tileCountPass, m_digitBits));
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHist, _indirectArgs, 0);
+            _cmd.DispatchCompute(m_cs, m_kernelGlobalHistScan, RadixPasses(m_digitBits), 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0, m_digitBits);
+            for (int pass = 0; pass < RadixPasses(m_digitBits); ++pass)
+            {
+                if ((passMask >> pass & 1) == 0)
+                    continue;
+
+                int radixShift = PassShift(pass, m_digitBits);
+
+                _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift, m_digitBits));
+
+                if (pass != tileCountPass)
+                {
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelUpsweep, "b_sort", _toSort);
+                    _cmd.DispatchCompute(m_cs, m_kernelUpsweep, _indirectArgs, k_partitionArgsOffset);
+                }
+
+                _cmd.DispatchCompute(m_cs, m_kernelScan, 1 << m_digitBits, 1, 1);
+
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sort", _toSort);
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_sortPayload", _toSortPayload);
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_alt", _alt);
+                _cmd.SetComputeBufferParam(m_cs, m_kernelDownsweep, "b_altPayload", _altPayload);
+                _cmd.DispatchCompute(m_cs, m_kernelDownsweep, _indirectArgs, k_partitionArgsOffset);
+
+                (_toSort, _alt) = (_alt, _toSort);
+                (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
+            }
+        }
+
+        private void AssertChecksKeys(int _inputSize, System.Type _keyType, int _beginBit, int _endBit)
         {
             Assert.IsTrue(k_keysOnly);
             Assert.IsTrue(_inputSize > k_minSize && _inputSize <= k_maxKeysAllocated);
+            Assert.IsTrue(_beginBit >= 0 && _beginBit < _endBit && _endBit <= k_passBit);
             Assert.IsTrue(
                 _keyType == typeof(uint)    ||
                 _keyType == typeof(float)   ||
                 _keyType == typeof(int)     ||
-                _keyType == typeof(ulong));
+                _keyType == typeof(ulong)   ||
+                _keyType == typeof(long)    ||
+                _keyType == typeof(double));
         }
 
-        private void AssertChecksPairs(int _inputSize, System.Type _keyType, System.Type _payloadType)
+        //The trivial passes are found on the host, from a readback of the
+        //global histogram between GlobalHistogram and the first pass, so
+        //skipping has no command buffer or indirect form
+        private void AssertChecksNoSkipping()
+        {
+            Assert.IsFalse(m_skipTrivialPasses, "SkipTrivialPasses only applies to the immediate mode overloads");
+        }
+
+        private void AssertChecksIndirect(
+            int _keyCountOffset,
+            GraphicsBuffer _keyCountBuffer,
+            GraphicsBuffer _indirectArgsBuffer,
+            GraphicsBuffer _sortInfoBuffer)
+        {
+            Assert.IsTrue((_keyCountBuffer.target & GraphicsBuffer.Target.Raw) != 0);
+            Assert.IsTrue(_keyCountOffset >= 0 && (_keyCountOffset & 3) == 0 &&
+                _keyCountOffset + 4 <= _keyCountBuffer.count * _keyCountBuffer.stride);
+            Assert.IsTrue((_indirectArgsBuffer.target & GraphicsBuffer.Target.IndirectArguments) != 0 &&
+                _indirectArgsBuffer.count >= k_indirectArgsSize);
+            Assert.IsTrue(_sortInfoBuffer.count >= k_sortInfoSize);
+        }
+
+        private void AssertChecksPairs(
+            int _inputSize,
+            System.Type _keyType,
+            System.Type _payloadType,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _tempPayloadBuffer,
+            int _beginBit,
+            int _endBit)
         {
             Assert.IsFalse(k_keysOnly);
             Assert.IsTrue(_inputSize > k_minSize && _inputSize <= k_maxKeysAllocated);
+            Assert.IsTrue(_beginBit >= 0 && _beginBit < _endBit && _endBit <= k_passBit);
             Assert.IsTrue(
                 _keyType == typeof(uint)    ||
                 _keyType == typeof(float)   ||
                 _keyType == typeof(int)     ||
-                _keyType == typeof(ulong));
+                _keyType == typeof(ulong)   ||
+                _keyType == typeof(long)    ||
+                _keyType == typeof(double));
             Assert.IsTrue(
                 _payloadType == typeof(uint)    || 
                 _payloadType == typeof(float)   || 
-                _payloadType == typeof(int));
+                _payloadType == typeof(int)     ||
+                _payloadType == typeof(ulong));
+            Assert.IsTrue(
+                _toSortPayload.stride == PayloadStride(_payloadType) &&
+                _tempPayloadBuffer.stride == PayloadStride(_payloadType));
         }
 
         //Keys only
@@ -284,18 +920,32 @@ namespace GPUInt64Sorting.Runtime
             GraphicsBuffer tempGlobalHistBuffer,
             GraphicsBuffer tempPassHistBuffer,
             System.Type keyType,
-            bool shouldAscend)
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
         {
-            AssertChecksKeys(sortSize, keyType);
+            AssertChecksKeys(sortSize, keyType, beginBit, endBit);
             SetKeyTypeKeywords(keyType);
             SetAscendingKeyWords(shouldAscend);
+            SetIndirectKeyword(false);
+            if (IsSmallSort(sortSize))
+            {
+                SetSmallSortDigitBits();
+                DispatchSmallSort(sortSize, beginBit, endBit, toSort, null);
+                return;
+            }
+            SetDigitBits();
+            SetDigitWidthKeyword();
             int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
             SetStaticRootParameters(
                 sortSize,
-                threadBlocks,
+                beginBit,
+                endBit,
+                toSort,
                 tempPassHistBuffer,
                 tempGlobalHistBuffer);
-            Dispatch(threadBlocks, toSort, tempKeyBuffer);
+            Dispatch(threadBlocks, globalHistThreadBlocks, sortSize, beginBit, endBit, shouldAscend, tempGlobalHistBuffer, toSort, tempKeyBuffer);
         }
 
         //Keys only
@@ -308,19 +958,34 @@ namespace GPUInt64Sorting.Runtime
             GraphicsBuffer tempGlobalHistBuffer,
             GraphicsBuffer tempPassHistBuffer,
             System.Type keyType,
-            bool shouldAscend)
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
         {
-            AssertChecksKeys(sortSize, keyType);
+            AssertChecksKeys(sortSize, keyType, beginBit, endBit);
+            AssertChecksNoSkipping();
             SetKeyTypeKeywords(cmd, keyType);
             SetAscendingKeyWords(cmd, shouldAscend);
+            SetIndirectKeyword(cmd, false);
+            if (IsSmallSort(sortSize))
+            {
+                SetSmallSortDigitBits(cmd);
+                DispatchSmallSort(cmd, sortSize, beginBit, endBit, toSort, null);
+                return;
+            }
+            SetDigitBits();
+            SetDigitWidthKeyword(cmd);
             int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
             SetStaticRootParameters(
                 sortSize,
-                threadBlocks,
+                beginBit,
+                endBit,
                 cmd,
+                toSort,
                 tempPassHistBuffer,
                 tempGlobalHistBuffer);
-            Dispatch(threadBlocks, cmd, toSort, tempKeyBuffer);
+            Dispatch(threadBlocks, globalHistThreadBlocks, beginBit, endBit, cmd, toSort, tempKeyBuffer);
         }
 
         //Pairs
@@ -334,19 +999,33 @@ namespace GPUInt64Sorting.Runtime
             GraphicsBuffer tempPassHistBuffer,
             System.Type keyType,
             System.Type payloadType,
-            bool shouldAscend)
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
         {
-            AssertChecksPairs(sortSize, keyType, payloadType);
+            AssertChecksPairs(sortSize, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
             SetKeyTypeKeywords(keyType);
             SetPayloadTypeKeywords(payloadType);
             SetAscendingKeyWords(shouldAscend);
+            SetIndirectKeyword(false);
+            if (IsSmallSort(sortSize))
+            {
+                SetSmallSortDigitBits();
+                DispatchSmallSort(sortSize, beginBit, endBit, toSort, toSortPayload);
+                return;
+            }
+            SetDigitBits();
+            SetDigitWidthKeyword();
             int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
             SetStaticRootParameters(
                 sortSize,
-                threadBlocks,
+                beginBit,
+                endBit,
+                toSort,
                 tempPassHistBuffer,
                 tempGlobalHistBuffer);
-            Dispatch(threadBlocks, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
+            Dispatch(threadBlocks, globalHistThreadBlocks, sortSize, beginBit, endBit, shouldAscend, tempGlobalHistBuffer, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
         }
 
         //Pairs
@@ -361,20 +1040,191 @@ namespace GPUInt64Sorting.Runtime
             GraphicsBuffer tempPassHistBuffer,
             System.Type keyType,
             System.Type payloadType,
-            bool shouldAscend)
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
         {
-            AssertChecksPairs(sortSize, keyType, payloadType);
+            AssertChecksPairs(sortSize, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
+            AssertChecksNoSkipping();
             SetKeyTypeKeywords(cmd, keyType);
             SetPayloadTypeKeywords(cmd, payloadType);
             SetAscendingKeyWords(cmd, shouldAscend);
+            SetIndirectKeyword(cmd, false);
+            if (IsSmallSort(sortSize))
+            {
+                SetSmallSortDigitBits(cmd);
+                DispatchSmallSort(cmd, sortSize, beginBit, endBit, toSort, toSortPayload);
+                return;
+            }
+            SetDigitBits();
+            SetDigitWidthKeyword(cmd);
             int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
             SetStaticRootParameters(
                 sortSize,
-                threadBlocks,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer);
+            Dispatch(threadBlocks, globalHistThreadBlocks, beginBit, endBit, cmd, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
+        }
+
+        //Keys only, the key count is read on the device from keyCountBuffer,
+        //a Raw buffer, at keyCountOffset bytes. The count is clamped to the
+        //allocation size and to toSort. Buffers from InitIndirectBuffers.
+        public void Sort(
+            GraphicsBuffer keyCountBuffer,
+            int keyCountOffset,
+            GraphicsBuffer toSort,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSortInfoBuffer,
+            System.Type keyType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            int maxKeys = System.Math.Min(k_maxKeysAllocated, toSort.count);
+            AssertChecksKeys(maxKeys, keyType, beginBit, endBit);
+            AssertChecksNoSkipping();
+            AssertChecksIndirect(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            SetKeyTypeKeywords(keyType);
+            SetAscendingKeyWords(shouldAscend);
+            SetIndirectKeyword(true);
+            SetDigitBits();
+            SetDigitWidthKeyword();
+            SetStaticRootParameters(
+                maxKeys,
+                beginBit,
+                endBit,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer);
+            SetIndirectRootParameters(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            DispatchIndirect(beginBit, endBit, tempIndirectArgsBuffer, toSort, tempKeyBuffer);
+        }
+
+        //Keys only, indirect key count
+        //Command queue
+        public void Sort(
+            CommandBuffer cmd,
+            GraphicsBuffer keyCountBuffer,
+            int keyCountOffset,
+            GraphicsBuffer toSort,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSortInfoBuffer,
+            System.Type keyType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            int maxKeys = System.Math.Min(k_maxKeysAllocated, toSort.count);
+            AssertChecksKeys(maxKeys, keyType, beginBit, endBit);
+            AssertChecksNoSkipping();
+            AssertChecksIndirect(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            SetIndirectKeyword(cmd, true);
+            SetDigitBits();
+            SetDigitWidthKeyword(cmd);
+            SetStaticRootParameters(
+                maxKeys,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer);
+            SetIndirectRootParameters(keyCountOffset, cmd, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            DispatchIndirect(beginBit, endBit, cmd, tempIndirectArgsBuffer, toSort, tempKeyBuffer);
+        }
+
+        //Pairs, indirect key count
+        public void Sort(
+            GraphicsBuffer keyCountBuffer,
+            int keyCountOffset,
+            GraphicsBuffer toSort,
+            GraphicsBuffer toSortPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSortInfoBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            int maxKeys = System.Math.Min(k_maxKeysAllocated, toSort.count);
+            AssertChecksPairs(maxKeys, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
+            AssertChecksNoSkipping();
+            AssertChecksIndirect(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            SetKeyTypeKeywords(keyType);
+            SetPayloadTypeKeywords(payloadType);
+            SetAscendingKeyWords(shouldAscend);
+            SetIndirectKeyword(true);
+            SetDigitBits();
+            SetDigitWidthKeyword();
+            SetStaticRootParameters(
+                maxKeys,
+                beginBit,
+                endBit,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer);
+            SetIndirectRootParameters(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            DispatchIndirect(beginBit, endBit, tempIndirectArgsBuffer, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
+        }
+
+        //Pairs, indirect key count
+        //Command queue
+        public void Sort(
+            CommandBuffer cmd,
+            GraphicsBuffer keyCountBuffer,
+            int keyCountOffset,
+            GraphicsBuffer toSort,
+            GraphicsBuffer toSortPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSortInfoBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            int maxKeys = System.Math.Min(k_maxKeysAllocated, toSort.count);
+            AssertChecksPairs(maxKeys, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
+            AssertChecksNoSkipping();
+            AssertChecksIndirect(keyCountOffset, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetPayloadTypeKeywords(cmd, payloadType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            SetIndirectKeyword(cmd, true);
+            SetDigitBits();
+            SetDigitWidthKeyword(cmd);
+            SetStaticRootParameters(
+                maxKeys,
+                beginBit,
+                endBit,
                 cmd,
+                toSort,
                 tempPassHistBuffer,
                 tempGlobalHistBuffer);
-            Dispatch(threadBlocks, cmd, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
+            SetIndirectRootParameters(keyCountOffset, cmd, keyCountBuffer, tempIndirectArgsBuffer, tempSortInfoBuffer);
+            DispatchIndirect(beginBit, endBit, cmd, tempIndirectArgsBuffer, toSort, toSortPayload, tempKeyBuffer, tempPayloadBuffer);
         }
     }
 }
\ No newline at end of file
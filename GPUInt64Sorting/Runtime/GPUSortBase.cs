@@ -21,8 +21,25 @@ namespace GPUInt64Sorting.Runtime
         protected const int k_partitionSize = 3840;
         protected const int k_passBit = 8 * k_radixPasses;
 
+        //Wide digits, compiled with RADIX_11. Digits never straddle the two
+        //32-bit words of a key, so they come in 11, 11 and 10 bit triples.
+        protected const int k_digitBits = 8;
+        protected const int k_wideDigitBits = 11;
+        protected const int k_wideRadix = 2048;
+        protected const int k_wideRadixPasses = 6;
+
+        protected const int k_passFlagFirst = 1;    //Radix trick applied on load
+        protected const int k_passFlagLast = 2;     //Radix trick undone on write
+
+        protected const int k_maxDispatchDimension = 65535;
+        protected const int k_isNotPartialBitFlag = 0;
+        protected const int k_isPartialBitFlag = 1;
+
+        //Thread blocks past the dispatch dimension limit are flattened, so
+        //the only ceiling left is the element count of a GraphicsBuffer.
+        //The device's own buffer size limit is checked on allocation.
         protected const int k_minSize = 1;
-        protected const int k_maxSize = 65535 * k_partitionSize;
+        protected const int k_maxSize = int.MaxValue;
 
         protected ComputeShader m_cs;
 
@@ -30,6 +47,8 @@ namespace GPUInt64Sorting.Runtime
         protected LocalKeyword m_keyUintKeyword;
         protected LocalKeyword m_keyFloatKeyword;
         protected LocalKeyword m_keyUlongKeyword;
+        protected LocalKeyword m_keyLongKeyword;
+        protected LocalKeyword m_keyDoubleKeyword;
         protected LocalKeyword m_payloadIntKeyword;
         protected LocalKeyword m_payloadUintKeyword;
         protected LocalKeyword m_payloadFloatKeyword;
@@ -39,6 +58,21 @@ namespace GPUInt64Sorting.Runtime
 
         protected readonly int k_maxKeysAllocated;
 
+        //SmallSort of the compute shaders that include SmallSort.hlsl
+        protected int m_kernelSmallSort = -1;
+        private int m_smallSortSize = k_partitionSize;
+
+        //Sorts of at most this many keys run as one SmallSort threadblock in
+        //a single dispatch instead of the device wide passes. SmallSort is a
+        //stable split sort, one bit at a time in groupshared memory, not a
+        //sorting network, so equal keys keep the order the radix passes give
+        //them. Clamped to a tile, 0 disables it.
+        public int SmallSortSize
+        {
+            get => m_smallSortSize;
+            set => m_smallSortSize = System.Math.Max(0, System.Math.Min(value, k_partitionSize));
+        }
+
         public GPUSortBase(
             ComputeShader compute,
             int allocationSize)
@@ -50,9 +84,164 @@ namespace GPUInt64Sorting.Runtime
             InitializeKeywords();
         }
 
+        //Safe up to int.MaxValue, x + y - 1 is not
         protected static int DivRoundUp(int x, int y)
         {
-            return (x + y - 1) / y;
+            return x / y + (x % y != 0 ? 1 : 0);
+        }
+
+        //Grids larger than the dispatch dimension limit go out as a 2D
+        //dispatch of full rows, followed by a 1D dispatch of the remainder.
+        //The kernels recover the linear group id with flattenGid. Every
+        //kernel that flattens must be dispatched through here, so that
+        //e_isPartial is never stale.
+        protected void DispatchFlattened(int kernel, int threadBlocks)
+        {
+            int fullBlocks = threadBlocks / k_maxDispatchDimension;
+            if (fullBlocks > 0)
+            {
+                m_cs.SetInt("e_isPartial", k_isNotPartialBitFlag);
+                m_cs.Dispatch(kernel, k_maxDispatchDimension, fullBlocks, 1);
+            }
+
+            int partialBlocks = threadBlocks - fullBlocks * k_maxDispatchDimension;
+            if (partialBlocks > 0)
+            {
+                m_cs.SetInt("e_isPartial", fullBlocks << 1 | k_isPartialBitFlag);
+                m_cs.Dispatch(kernel, partialBlocks, 1, 1);
+            }
+        }
+
+        protected void DispatchFlattened(CommandBuffer _cmd, int kernel, int threadBlocks)
+        {
+            int fullBlocks = threadBlocks / k_maxDispatchDimension;
+            if (fullBlocks > 0)
+            {
+                _cmd.SetComputeIntParam(m_cs, "e_isPartial", k_isNotPartialBitFlag);
+                _cmd.DispatchCompute(m_cs, kernel, k_maxDispatchDimension, fullBlocks, 1);
+            }
+
+            int partialBlocks = threadBlocks - fullBlocks * k_maxDispatchDimension;
+            if (partialBlocks > 0)
+            {
+                _cmd.SetComputeIntParam(m_cs, "e_isPartial", fullBlocks << 1 | k_isPartialBitFlag);
+                _cmd.DispatchCompute(m_cs, kernel, partialBlocks, 1, 1);
+            }
+        }
+
+        protected static int DigitsPerWord(int digitBits)
+        {
+            return DivRoundUp(32, digitBits);
+        }
+
+        protected static int RadixPasses(int digitBits)
+        {
+            return 2 * DigitsPerWord(digitBits);
+        }
+
+        protected static int PassShift(int pass, int digitBits)
+        {
+            return (pass / DigitsPerWord(digitBits) << 5) + pass % DigitsPerWord(digitBits) * digitBits;
+        }
+
+        //The last digit of each word is cut short at the word boundary
+        protected static int PassWidth(int pass, int digitBits)
+        {
+            return System.Math.Min(digitBits, 32 - (PassShift(pass, digitBits) & 31));
+        }
+
+        protected static int PassIndex(int radixShift, int digitBits)
+        {
+            return (radixShift >> 5) * DigitsPerWord(digitBits) + (radixShift & 31) / digitBits;
+        }
+
+        //One bit per pass that has to be dispatched for [beginBit, endBit).
+        //The result has to land back in the sort buffer, so an odd number of
+        //passes either keeps the lowest trivial pass, or adds a pass outside of
+        //the window. Its digit is masked to zero, so it only moves the keys.
+        protected static int GetPassMask(int beginBit, int endBit, int trivialMask, int digitBits = k_digitBits)
+        {
+            int passMask = 0;
+            for (int pass = 0; pass < RadixPasses(digitBits); ++pass)
+            {
+                int radixShift = PassShift(pass, digitBits);
+                if (radixShift < endBit && radixShift + PassWidth(pass, digitBits) > beginBit)
+                    passMask |= 1 << pass;
+            }
+            passMask &= ~trivialMask;
+
+            int passCount = 0;
+            for (int t = passMask; t != 0; t &= t - 1)
+                passCount++;
+
+            if ((passCount & 1) != 0)
+            {
+                int beginPass = PassIndex(beginBit, digitBits);
+                if (trivialMask != 0)
+                    passMask |= trivialMask & -trivialMask;
+                else
+                    passMask |= 1 << (beginPass > 0 ? beginPass - 1 : PassIndex(endBit - 1, digitBits) + 1);
+            }
+
+            return passMask;
+        }
+
+        //Marks the first and last dispatched pass, where 64-bit signed and
+        //double keys are converted to and from their radix representation
+        protected static int GetPassFlags(int passMask, int radixShift, int digitBits = k_digitBits)
+        {
+            int pass = PassIndex(radixShift, digitBits);
+            int flags = 0;
+            if ((passMask & ((1 << pass) - 1)) == 0)
+                flags |= k_passFlagFirst;
+            if ((passMask >> (pass + 1)) == 0)
+                flags |= k_passFlagLast;
+            return flags;
+        }
+
+        protected bool InitSmallSortKernel()
+        {
+            m_kernelSmallSort = m_cs ? m_cs.FindKernel("SmallSort") : -1;
+            return m_kernelSmallSort >= 0 && m_cs.IsSupported(m_kernelSmallSort);
+        }
+
+        protected bool IsSmallSort(int sortSize)
+        {
+            return sortSize <= m_smallSortSize && m_kernelSmallSort >= 0;
+        }
+
+        //Sorts toSort in place, pass a null payload buffer for keys only
+        protected void DispatchSmallSort(
+            int numKeys,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload)
+        {
+            m_cs.SetInt("e_numKeys", numKeys);
+            m_cs.SetInt("e_beginBit", beginBit);
+            m_cs.SetInt("e_endBit", endBit);
+            m_cs.SetBuffer(m_kernelSmallSort, "b_sort", _toSort);
+            if (_toSortPayload != null)
+                m_cs.SetBuffer(m_kernelSmallSort, "b_sortPayload", _toSortPayload);
+            m_cs.Dispatch(m_kernelSmallSort, 1, 1, 1);
+        }
+
+        protected void DispatchSmallSort(
+            CommandBuffer _cmd,
+            int numKeys,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_numKeys", numKeys);
+            _cmd.SetComputeIntParam(m_cs, "e_beginBit", beginBit);
+            _cmd.SetComputeIntParam(m_cs, "e_endBit", endBit);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSmallSort, "b_sort", _toSort);
+            if (_toSortPayload != null)
+                _cmd.SetComputeBufferParam(m_cs, m_kernelSmallSort, "b_sortPayload", _toSortPayload);
+            _cmd.DispatchCompute(m_cs, m_kernelSmallSort, 1, 1, 1);
         }
 
         protected void InitializeKeywords()
@@ -63,9 +252,12 @@ namespace GPUInt64Sorting.Runtime
             m_keyIntKeyword = new LocalKeyword(m_cs, "KEY_INT");
             m_keyFloatKeyword = new LocalKeyword(m_cs, "KEY_FLOAT");
             m_keyUlongKeyword = new LocalKeyword(m_cs, "KEY_ULONG");
+            m_keyLongKeyword = new LocalKeyword(m_cs, "KEY_LONG");
+            m_keyDoubleKeyword = new LocalKeyword(m_cs, "KEY_DOUBLE");
             m_payloadUintKeyword = new LocalKeyword(m_cs, "PAYLOAD_UINT");
             m_payloadIntKeyword = new LocalKeyword(m_cs, "PAYLOAD_INT");
             m_payloadFloatKeyword = new LocalKeyword(m_cs, "PAYLOAD_FLOAT");
+            m_payloadUlongKeyword = new LocalKeyword(m_cs, "PAYLOAD_ULONG");
         }
 
         protected void SetKeyTypeKeywords(System.Type _type)
@@ -76,6 +268,8 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.DisableKeyword(m_keyUintKeyword);
                 m_cs.DisableKeyword(m_keyFloatKeyword);
                 m_cs.DisableKeyword(m_keyUlongKeyword);
+                m_cs.DisableKeyword(m_keyLongKeyword);
+                m_cs.DisableKeyword(m_keyDoubleKeyword);
             }
 
             if (_type == typeof(uint))
@@ -84,6 +278,8 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.EnableKeyword(m_keyUintKeyword);
                 m_cs.DisableKeyword(m_keyFloatKeyword);
                 m_cs.DisableKeyword(m_keyUlongKeyword);
+                m_cs.DisableKeyword(m_keyLongKeyword);
+                m_cs.DisableKeyword(m_keyDoubleKeyword);
             }
 
             if (_type == typeof(float))
@@ -92,14 +288,38 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.DisableKeyword(m_keyUintKeyword);
                 m_cs.EnableKeyword(m_keyFloatKeyword);
                 m_cs.DisableKeyword(m_keyUlongKeyword);
+                m_cs.DisableKeyword(m_keyLongKeyword);
+                m_cs.DisableKeyword(m_keyDoubleKeyword);
             }
-            
+
             if (_type == typeof(ulong))
             {
                 m_cs.DisableKeyword(m_keyIntKeyword);
                 m_cs.DisableKeyword(m_keyUintKeyword);
                 m_cs.DisableKeyword(m_keyFloatKeyword);
                 m_cs.EnableKeyword(m_keyUlongKeyword);
+                m_cs.DisableKeyword(m_keyLongKeyword);
+                m_cs.DisableKeyword(m_keyDoubleKeyword);
+            }
+
+            if (_type == typeof(long))
+            {
+                m_cs.DisableKeyword(m_keyIntKeyword);
+                m_cs.DisableKeyword(m_keyUintKeyword);
+                m_cs.DisableKeyword(m_keyFloatKeyword);
+                m_cs.DisableKeyword(m_keyUlongKeyword);
+                m_cs.EnableKeyword(m_keyLongKeyword);
+                m_cs.DisableKeyword(m_keyDoubleKeyword);
+            }
+
+            if (_type == typeof(double))
+            {
+                m_cs.DisableKeyword(m_keyIntKeyword);
+                m_cs.DisableKeyword(m_keyUintKeyword);
+                m_cs.DisableKeyword(m_keyFloatKeyword);
+                m_cs.DisableKeyword(m_keyUlongKeyword);
+                m_cs.DisableKeyword(m_keyLongKeyword);
+                m_cs.EnableKeyword(m_keyDoubleKeyword);
             }
         }
 
@@ -111,6 +331,8 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.DisableKeyword(m_cs, m_keyUintKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyFloatKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyDoubleKeyword);
             }
 
             if (_type == typeof(uint))
@@ -119,6 +341,8 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.EnableKeyword(m_cs, m_keyUintKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyFloatKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyDoubleKeyword);
             }
 
             if (_type == typeof(float))
@@ -127,6 +351,8 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.DisableKeyword(m_cs, m_keyUintKeyword);
                 _cmd.EnableKeyword(m_cs, m_keyFloatKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyDoubleKeyword);
             }
 
             if (_type == typeof(ulong))
@@ -135,6 +361,28 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.DisableKeyword(m_cs, m_keyUintKeyword);
                 _cmd.DisableKeyword(m_cs, m_keyFloatKeyword);
                 _cmd.EnableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyDoubleKeyword);
+            }
+
+            if (_type == typeof(long))
+            {
+                _cmd.DisableKeyword(m_cs, m_keyIntKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyUintKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyFloatKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.EnableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyDoubleKeyword);
+            }
+
+            if (_type == typeof(double))
+            {
+                _cmd.DisableKeyword(m_cs, m_keyIntKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyUintKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyFloatKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyUlongKeyword);
+                _cmd.DisableKeyword(m_cs, m_keyLongKeyword);
+                _cmd.EnableKeyword(m_cs, m_keyDoubleKeyword);
             }
         }
 
@@ -145,6 +393,7 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.EnableKeyword(m_payloadIntKeyword);
                 m_cs.DisableKeyword(m_payloadUintKeyword);
                 m_cs.DisableKeyword(m_payloadFloatKeyword);
+                m_cs.DisableKeyword(m_payloadUlongKeyword);
             }
 
             if (_type == typeof(uint))
@@ -152,6 +401,7 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.DisableKeyword(m_payloadIntKeyword);
                 m_cs.EnableKeyword(m_payloadUintKeyword);
                 m_cs.DisableKeyword(m_payloadFloatKeyword);
+                m_cs.DisableKeyword(m_payloadUlongKeyword);
             }
 
             if (_type == typeof(float))
@@ -159,6 +409,15 @@ namespace GPUInt64Sorting.Runtime
                 m_cs.DisableKeyword(m_payloadIntKeyword);
                 m_cs.DisableKeyword(m_payloadUintKeyword);
                 m_cs.EnableKeyword(m_payloadFloatKeyword);
+                m_cs.DisableKeyword(m_payloadUlongKeyword);
+            }
+
+            if (_type == typeof(ulong))
+            {
+                m_cs.DisableKeyword(m_payloadIntKeyword);
+                m_cs.DisableKeyword(m_payloadUintKeyword);
+                m_cs.DisableKeyword(m_payloadFloatKeyword);
+                m_cs.EnableKeyword(m_payloadUlongKeyword);
             }
         }
 
@@ -169,6 +428,7 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.EnableKeyword(m_cs, m_payloadIntKeyword);
                 _cmd.DisableKeyword(m_cs, m_payloadUintKeyword);
                 _cmd.DisableKeyword(m_cs, m_payloadFloatKeyword);
+                _cmd.DisableKeyword(m_cs, m_payloadUlongKeyword);
             }
 
             if (_type == typeof(uint))
@@ -176,6 +436,7 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.DisableKeyword(m_cs, m_payloadIntKeyword);
                 _cmd.EnableKeyword(m_cs, m_payloadUintKeyword);
                 _cmd.DisableKeyword(m_cs, m_payloadFloatKeyword);
+                _cmd.DisableKeyword(m_cs, m_payloadUlongKeyword);
             }
 
             if (_type == typeof(float))
@@ -183,7 +444,21 @@ namespace GPUInt64Sorting.Runtime
                 _cmd.DisableKeyword(m_cs, m_payloadIntKeyword);
                 _cmd.DisableKeyword(m_cs, m_payloadUintKeyword);
                 _cmd.EnableKeyword(m_cs, m_payloadFloatKeyword);
+                _cmd.DisableKeyword(m_cs, m_payloadUlongKeyword);
             }
+
+            if (_type == typeof(ulong))
+            {
+                _cmd.DisableKeyword(m_cs, m_payloadIntKeyword);
+                _cmd.DisableKeyword(m_cs, m_payloadUintKeyword);
+                _cmd.DisableKeyword(m_cs, m_payloadFloatKeyword);
+                _cmd.EnableKeyword(m_cs, m_payloadUlongKeyword);
+            }
+        }
+
+        protected static int PayloadStride(System.Type _type)
+        {
+            return _type == typeof(ulong) ? 8 : 4;
         }
 
         protected void SetAscendingKeyWords(bool _shouldAscend)
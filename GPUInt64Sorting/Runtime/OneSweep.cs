@@ -0,0 +1,599 @@
+/******************************************************************************
+ * GPUSorting
+ *
+ * SPDX-License-Identifier: MIT
+ * Copyright Thomas Smith 4/28/2024
+ * https://github.com/b0nes164/GPUSorting
+ *
+ ******************************************************************************/
+using UnityEngine;
+using UnityEngine.Rendering;
+using UnityEngine.Assertions;
+
+namespace GPUInt64Sorting.Runtime
+{
+    public class OneSweep : GPUSortBase
+    {
+        protected const int k_globalHistPartSize = 32768;
+
+        //The pass histogram packs a 2 bit flag under each prefix sum,
+        //so the prefix sums have to fit in 30 bits
+        protected const int k_maxSweepSize = 1 << 30;
+
+        protected int m_kernelInit = -1;
+        protected int m_kernelGlobalHist = -1;
+        protected int m_kernelScan = -1;
+        protected int m_digitBinningPass = -1;
+
+        protected readonly bool k_keysOnly;
+
+        //Opt-in: stalled threadblocks rebuild the reduction of the tile they
+        //are waiting on instead of spinning. Required on devices that do not
+        //guarantee forward progress between threadblocks.
+        protected LocalKeyword m_fallbackKeyword;
+        private bool m_decoupledFallback;
+
+        public bool DecoupledFallback
+        {
+            get => m_decoupledFallback;
+            set => m_decoupledFallback = value;
+        }
+
+        //keys
+        public OneSweep(
+            ComputeShader compute,
+            int allocationSize,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempPassHistBuffer,
+            ref GraphicsBuffer tempIndexBuffer) :
+            base(
+                compute,
+                allocationSize)
+        {
+            Assert.IsTrue(allocationSize < k_maxSweepSize);
+            InitKernels();
+            m_cs.DisableKeyword(m_sortPairKeyword);
+            k_keysOnly = true;
+
+            tempKeyBuffer?.Dispose();
+            tempGlobalHistBuffer?.Dispose();
+            tempPassHistBuffer?.Dispose();
+            tempIndexBuffer?.Dispose();
+
+            tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
+            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * k_radixPasses, 4) { name="TempGlobalHist" };
+            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * DivRoundUp(k_maxKeysAllocated, k_partitionSize) * k_radixPasses, 4) { name="TempPassHist" };
+            tempIndexBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radixPasses, sizeof(uint)) { name="TempIndex" };
+        }
+
+        //pairs
+        public OneSweep(
+            ComputeShader compute,
+            int allocationSize,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempPayloadBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempPassHistBuffer,
+            ref GraphicsBuffer tempIndexBuffer) :
+            this(
+                compute,
+                allocationSize,
+                typeof(uint),
+                ref tempKeyBuffer,
+                ref tempPayloadBuffer,
+                ref tempGlobalHistBuffer,
+                ref tempPassHistBuffer,
+                ref tempIndexBuffer)
+        {
+        }
+
+        //pairs with an explicit payload type, a ulong payload needs an 8 byte temp payload buffer
+        public OneSweep(
+            ComputeShader compute,
+            int allocationSize,
+            System.Type payloadType,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempPayloadBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempPassHistBuffer,
+            ref GraphicsBuffer tempIndexBuffer) :
+            base(
+                compute,
+                allocationSize)
+        {
+            Assert.IsTrue(allocationSize < k_maxSweepSize);
+            InitKernels();
+            m_cs.EnableKeyword(m_sortPairKeyword);
+            k_keysOnly = false;
+
+            tempKeyBuffer?.Dispose();
+            tempPayloadBuffer?.Dispose();
+            tempGlobalHistBuffer?.Dispose();
+            tempPassHistBuffer?.Dispose();
+            tempIndexBuffer?.Dispose();
+
+            tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
+            tempPayloadBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, PayloadStride(payloadType)) { name="TempPayload" };
+            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * k_radixPasses, 4) { name="TempGlobalHist" };
+            tempPassHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * DivRoundUp(k_maxKeysAllocated, k_partitionSize) * k_radixPasses, 4) { name="TempPassHist" };
+            tempIndexBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radixPasses, sizeof(uint)) { name="TempIndex" };
+        }
+
+        protected virtual void InitKernels()
+        {
+            bool isValid;
+            if (m_cs)
+            {
+                m_kernelInit = m_cs.FindKernel("InitSweep");
+                m_kernelGlobalHist = m_cs.FindKernel("GlobalHistogram");
+                m_kernelScan = m_cs.FindKernel("Scan");
+                m_digitBinningPass = m_cs.FindKernel("DigitBinningPass");
+                m_fallbackKeyword = new LocalKeyword(m_cs, "DECOUPLED_FALLBACK");
+            }
+
+            isValid = m_kernelInit >= 0 &&
+                        m_kernelGlobalHist >= 0 &&
+                        m_kernelScan >= 0 &&
+                        m_digitBinningPass >= 0;
+
+            if (isValid)
+            {
+                if (!m_cs.IsSupported(m_kernelInit) ||
+                    !m_cs.IsSupported(m_kernelGlobalHist) ||
+                    !m_cs.IsSupported(m_kernelScan) ||
+                    !m_cs.IsSupported(m_digitBinningPass))
+                {
+                    isValid = false;
+                }
+            }
+
+            if (isValid && !InitSmallSortKernel())
+                isValid = false;
+
+            Assert.IsTrue(isValid);
+        }
+
+        private void SetFallbackKeyword()
+        {
+            if (m_decoupledFallback)
+                m_cs.EnableKeyword(m_fallbackKeyword);
+            else
+                m_cs.DisableKeyword(m_fallbackKeyword);
+        }
+
+        private void SetFallbackKeyword(CommandBuffer _cmd)
+        {
+            if (m_decoupledFallback)
+                _cmd.EnableKeyword(m_cs, m_fallbackKeyword);
+            else
+                _cmd.DisableKeyword(m_cs, m_fallbackKeyword);
+        }
+
+        private void SetStaticRootParameters(
+            int numKeys,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _sortBuffer,
+            GraphicsBuffer _passHistBuffer,
+            GraphicsBuffer _globalHistBuffer,
+            GraphicsBuffer _indexBuffer)
+        {
+            m_cs.SetInt("e_numKeys", numKeys);
+            m_cs.SetInt("e_beginBit", beginBit);
+            m_cs.SetInt("e_endBit", endBit);
+
+            m_cs.SetBuffer(m_kernelInit, "b_passHist", _passHistBuffer);
+            m_cs.SetBuffer(m_kernelInit, "b_globalHist", _globalHistBuffer);
+            m_cs.SetBuffer(m_kernelInit, "b_index", _indexBuffer);
+
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_sort", _sortBuffer);
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+
+            m_cs.SetBuffer(m_kernelScan, "b_passHist", _passHistBuffer);
+            m_cs.SetBuffer(m_kernelScan, "b_globalHist", _globalHistBuffer);
+
+            m_cs.SetBuffer(m_digitBinningPass, "b_passHist", _passHistBuffer);
+            m_cs.SetBuffer(m_digitBinningPass, "b_index", _indexBuffer);
+        }
+
+        private void SetStaticRootParameters(
+            int numKeys,
+            int beginBit,
+            int endBit,
+            CommandBuffer _cmd,
+            GraphicsBuffer _sortBuffer,
+            GraphicsBuffer _passHistBuffer,
+            GraphicsBuffer _globalHistBuffer,
+            GraphicsBuffer _indexBuffer)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_numKeys", numKeys);
+            _cmd.SetComputeIntParam(m_cs, "e_beginBit", beginBit);
+            _cmd.SetComputeIntParam(m_cs, "e_endBit", endBit);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_passHist", _passHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_globalHist", _globalHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_index", _indexBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_sort", _sortBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelScan, "b_passHist", _passHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelScan, "b_globalHist", _globalHistBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_passHist", _passHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_index", _indexBuffer);
+        }
+
+        private void Dispatch(
+            int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _alt)
+        {
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+            m_cs.Dispatch(m_kernelInit, 256, 1, 1);
+
+            m_cs.SetInt("e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(m_kernelGlobalHist, globalHistThreadBlocks);
+
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+            m_cs.Dispatch(m_kernelScan, k_radixPasses, 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0);
+            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            {
+                if ((passMask >> (radixShift >> 3) & 1) == 0)
+                    continue;
+
+                m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift));
+                m_cs.SetBuffer(m_digitBinningPass, "b_sort", _toSort);
+                m_cs.SetBuffer(m_digitBinningPass, "b_alt", _alt);
+                DispatchFlattened(m_digitBinningPass, numThreadBlocks);
+
+                (_toSort, _alt) = (_alt, _toSort);
+            }
+        }
+
+        private void Dispatch(
+            int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
+            CommandBuffer _cmd,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _alt)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+            _cmd.DispatchCompute(m_cs, m_kernelInit, 256, 1, 1);
+
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(_cmd, m_kernelGlobalHist, globalHistThreadBlocks);
+
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+            _cmd.DispatchCompute(m_cs, m_kernelScan, k_radixPasses, 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0);
+            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            {
+                if ((passMask >> (radixShift >> 3) & 1) == 0)
+                    continue;
+
+                _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift));
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_sort", _toSort);
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_alt", _alt);
+                DispatchFlattened(_cmd, m_digitBinningPass, numThreadBlocks);
+
+                (_toSort, _alt) = (_alt, _toSort);
+            }
+        }
+
+        private void Dispatch(
+            int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _alt,
+            GraphicsBuffer _altPayload)
+        {
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+            m_cs.Dispatch(m_kernelInit, 256, 1, 1);
+
+            m_cs.SetInt("e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(m_kernelGlobalHist, globalHistThreadBlocks);
+
+            m_cs.SetInt("e_threadBlocks", numThreadBlocks);
+            m_cs.Dispatch(m_kernelScan, k_radixPasses, 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0);
+            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            {
+                if ((passMask >> (radixShift >> 3) & 1) == 0)
+                    continue;
+
+                m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", GetPassFlags(passMask, radixShift));
+                m_cs.SetBuffer(m_digitBinningPass, "b_sort", _toSort);
+                m_cs.SetBuffer(m_digitBinningPass, "b_sortPayload", _toSortPayload);
+                m_cs.SetBuffer(m_digitBinningPass, "b_alt", _alt);
+                m_cs.SetBuffer(m_digitBinningPass, "b_altPayload", _altPayload);
+                DispatchFlattened(m_digitBinningPass, numThreadBlocks);
+
+                (_toSort, _alt) = (_alt, _toSort);
+                (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
+            }
+        }
+
+        private void Dispatch(
+            int numThreadBlocks,
+            int globalHistThreadBlocks,
+            int beginBit,
+            int endBit,
+            CommandBuffer _cmd,
+            GraphicsBuffer _toSort,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _alt,
+            GraphicsBuffer _altPayload)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+            _cmd.DispatchCompute(m_cs, m_kernelInit, 256, 1, 1);
+
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", globalHistThreadBlocks);
+            DispatchFlattened(_cmd, m_kernelGlobalHist, globalHistThreadBlocks);
+
+            _cmd.SetComputeIntParam(m_cs, "e_threadBlocks", numThreadBlocks);
+            _cmd.DispatchCompute(m_cs, m_kernelScan, k_radixPasses, 1, 1);
+
+            int passMask = GetPassMask(beginBit, endBit, 0);
+            for (int radixShift = 0; radixShift < k_passBit; radixShift += 8)
+            {
+                if ((passMask >> (radixShift >> 3) & 1) == 0)
+                    continue;
+
+                _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", GetPassFlags(passMask, radixShift));
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_sort", _toSort);
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_sortPayload", _toSortPayload);
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_alt", _alt);
+                _cmd.SetComputeBufferParam(m_cs, m_digitBinningPass, "b_altPayload", _altPayload);
+                DispatchFlattened(_cmd, m_digitBinningPass, numThreadBlocks);
+
+                (_toSort, _alt) = (_alt, _toSort);
+                (_toSortPayload, _altPayload) = (_altPayload, _toSortPayload);
+            }
+        }
+
+        private void AssertChecksKeys(int _inputSize, System.Type _keyType, int _beginBit, int _endBit)
+        {
+            Assert.IsTrue(k_keysOnly);
+            Assert.IsTrue(_inputSize > k_minSize && _inputSize <= k_maxKeysAllocated);
+            Assert.IsTrue(_beginBit >= 0 && _beginBit < _endBit && _endBit <= k_passBit);
+            Assert.IsTrue(
+                _keyType == typeof(uint)    ||
+                _keyType == typeof(float)   ||
+                _keyType == typeof(int)     ||
+                _keyType == typeof(ulong)   ||
+                _keyType == typeof(long)    ||
+                _keyType == typeof(double));
+        }
+
+        private void AssertChecksPairs(
+            int _inputSize,
+            System.Type _keyType,
+            System.Type _payloadType,
+            GraphicsBuffer _toSortPayload,
+            GraphicsBuffer _tempPayloadBuffer,
+            int _beginBit,
+            int _endBit)
+        {
+            Assert.IsFalse(k_keysOnly);
+            Assert.IsTrue(_inputSize > k_minSize && _inputSize <= k_maxKeysAllocated);
+            Assert.IsTrue(_beginBit >= 0 && _beginBit < _endBit && _endBit <= k_passBit);
+            Assert.IsTrue(
+                _keyType == typeof(uint)    ||
+                _keyType == typeof(float)   ||
+                _keyType == typeof(int)     ||
+                _keyType == typeof(ulong)   ||
+                _keyType == typeof(long)    ||
+                _keyType == typeof(double));
+            Assert.IsTrue(
+                _payloadType == typeof(uint)    ||
+                _payloadType == typeof(float)   ||
+                _payloadType == typeof(int)     ||
+                _payloadType == typeof(ulong));
+            Assert.IsTrue(
+                _toSortPayload.stride == PayloadStride(_payloadType) &&
+                _tempPayloadBuffer.stride == PayloadStride(_payloadType));
+        }
+
+        //Keys only
+        public void Sort(
+            int sortSize,
+            GraphicsBuffer toSort,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndexBuffer,
+            System.Type keyType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            AssertChecksKeys(sortSize, keyType, beginBit, endBit);
+            SetKeyTypeKeywords(keyType);
+            SetAscendingKeyWords(shouldAscend);
+            if (IsSmallSort(sortSize))
+            {
+                DispatchSmallSort(sortSize, beginBit, endBit, toSort, null);
+                return;
+            }
+            SetFallbackKeyword();
+            int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
+            SetStaticRootParameters(
+                sortSize,
+                beginBit,
+                endBit,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer,
+                tempIndexBuffer);
+            Dispatch(
+                threadBlocks,
+                globalHistThreadBlocks,
+                beginBit,
+                endBit,
+                toSort,
+                tempKeyBuffer);
+        }
+
+        //Keys only
+        //Command queue
+        public void Sort(
+            CommandBuffer cmd,
+            int sortSize,
+            GraphicsBuffer toSort,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndexBuffer,
+            System.Type keyType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            AssertChecksKeys(sortSize, keyType, beginBit, endBit);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            if (IsSmallSort(sortSize))
+            {
+                DispatchSmallSort(cmd, sortSize, beginBit, endBit, toSort, null);
+                return;
+            }
+            SetFallbackKeyword(cmd);
+            int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
+            SetStaticRootParameters(
+                sortSize,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer,
+                tempIndexBuffer);
+            Dispatch(
+                threadBlocks,
+                globalHistThreadBlocks,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                tempKeyBuffer);
+        }
+
+        //Pairs
+        public void Sort(
+            int sortSize,
+            GraphicsBuffer toSort,
+            GraphicsBuffer toSortPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndexBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            AssertChecksPairs(sortSize, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
+            SetKeyTypeKeywords(keyType);
+            SetPayloadTypeKeywords(payloadType);
+            SetAscendingKeyWords(shouldAscend);
+            if (IsSmallSort(sortSize))
+            {
+                DispatchSmallSort(sortSize, beginBit, endBit, toSort, toSortPayload);
+                return;
+            }
+            SetFallbackKeyword();
+            int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
+            SetStaticRootParameters(
+                sortSize,
+                beginBit,
+                endBit,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer,
+                tempIndexBuffer);
+            Dispatch(
+                threadBlocks,
+                globalHistThreadBlocks,
+                beginBit,
+                endBit,
+                toSort,
+                toSortPayload,
+                tempKeyBuffer,
+                tempPayloadBuffer);
+        }
+
+        //Pairs
+        //Command queue
+        public void Sort(
+            CommandBuffer cmd,
+            int sortSize,
+            GraphicsBuffer toSort,
+            GraphicsBuffer toSortPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempPassHistBuffer,
+            GraphicsBuffer tempIndexBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend,
+            int beginBit = 0,
+            int endBit = k_passBit)
+        {
+            AssertChecksPairs(sortSize, keyType, payloadType, toSortPayload, tempPayloadBuffer, beginBit, endBit);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetPayloadTypeKeywords(cmd, payloadType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            if (IsSmallSort(sortSize))
+            {
+                DispatchSmallSort(cmd, sortSize, beginBit, endBit, toSort, toSortPayload);
+                return;
+            }
+            SetFallbackKeyword(cmd);
+            int threadBlocks = DivRoundUp(sortSize, k_partitionSize);
+            int globalHistThreadBlocks = DivRoundUp(sortSize, k_globalHistPartSize);
+            SetStaticRootParameters(
+                sortSize,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                tempPassHistBuffer,
+                tempGlobalHistBuffer,
+                tempIndexBuffer);
+            Dispatch(
+                threadBlocks,
+                globalHistThreadBlocks,
+                beginBit,
+                endBit,
+                cmd,
+                toSort,
+                toSortPayload,
+                tempKeyBuffer,
+                tempPayloadBuffer);
+        }
+    }
+}
@@ -0,0 +1,567 @@
+/******************************************************************************
+ * GPUSorting
+ *
+ * SPDX-License-Identifier: MIT
+ * Copyright Thomas Smith 4/28/2024
+ * https://github.com/b0nes164/GPUSorting
+ *
+ ******************************************************************************/
+using UnityEngine;
+using UnityEngine.Rendering;
+using UnityEngine.Assertions;
+
+namespace GPUInt64Sorting.Runtime
+{
+    //The k smallest or largest 64-bit keys, without sorting the rest. Each
+    //of the eight digits, top down, is one histogram of the candidates'
+    //current digit, one bucket search, and one compaction that keeps only
+    //the keys tied with the k-th key so far. Past the first digit, random
+    //keys leave about 1/256 of the candidates per digit, so the select reads
+    //the input twice, against eight read, scatter and write passes of a full
+    //sort. Skewed or equal keys keep every candidate, up to eight histogram
+    //and compaction reads. TopKBenchmark measures it against the full sort.
+    //
+    //Select leaves the keys in topK unordered, TopK sorts them afterwards
+    //with a DeviceRadixSort. Which of several keys equal to the k-th key
+    //are selected, and so which payloads, is not deterministic.
+    public class RadixSelect : GPUSortBase
+    {
+        protected const int k_selectInfoSize = 8;           //b_sortInfo, then the selection state
+        protected const int k_indirectArgsSize = 6;         //Next global histogram, then this compaction
+        protected const int k_compactArgsOffset = 3 * 4;    //Byte offset of the compaction dispatch arguments
+
+        private int m_kernelInit = -1;
+        private int m_kernelGlobalHist = -1;
+        private int m_kernelSelectBucket = -1;
+        private int m_kernelSelectCompact = -1;
+
+        private readonly bool k_keysOnly;
+
+        //keys
+        public RadixSelect(
+            ComputeShader compute,
+            int allocationSize,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempAltKeyBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempIndirectArgsBuffer,
+            ref GraphicsBuffer tempSelectInfoBuffer) :
+            base(
+                compute,
+                allocationSize)
+        {
+            InitKernels();
+            m_cs.DisableKeyword(m_sortPairKeyword);
+            k_keysOnly = true;
+
+            tempKeyBuffer?.Dispose();
+            tempAltKeyBuffer?.Dispose();
+            InitSelectBuffers(ref tempGlobalHistBuffer, ref tempIndirectArgsBuffer, ref tempSelectInfoBuffer);
+
+            tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
+            tempAltKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempAltKey" };
+        }
+
+        public RadixSelect(
+            ComputeShader compute,
+            int allocationSize,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempAltKeyBuffer,
+            ref GraphicsBuffer tempPayloadBuffer,
+            ref GraphicsBuffer tempAltPayloadBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempIndirectArgsBuffer,
+            ref GraphicsBuffer tempSelectInfoBuffer) :
+            this(
+                compute,
+                allocationSize,
+                typeof(uint),
+                ref tempKeyBuffer,
+                ref tempAltKeyBuffer,
+                ref tempPayloadBuffer,
+                ref tempAltPayloadBuffer,
+                ref tempGlobalHistBuffer,
+                ref tempIndirectArgsBuffer,
+                ref tempSelectInfoBuffer)
+        {
+        }
+
+        //Pairs with an explicit payload type, a ulong payload needs 8 byte temp payload buffers
+        public RadixSelect(
+            ComputeShader compute,
+            int allocationSize,
+            System.Type payloadType,
+            ref GraphicsBuffer tempKeyBuffer,
+            ref GraphicsBuffer tempAltKeyBuffer,
+            ref GraphicsBuffer tempPayloadBuffer,
+            ref GraphicsBuffer tempAltPayloadBuffer,
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempIndirectArgsBuffer,
+            ref GraphicsBuffer tempSelectInfoBuffer) :
+            base(
+                compute,
+                allocationSize)
+        {
+            InitKernels();
+            m_cs.EnableKeyword(m_sortPairKeyword);
+            k_keysOnly = false;
+
+            tempKeyBuffer?.Dispose();
+            tempAltKeyBuffer?.Dispose();
+            tempPayloadBuffer?.Dispose();
+            tempAltPayloadBuffer?.Dispose();
+            InitSelectBuffers(ref tempGlobalHistBuffer, ref tempIndirectArgsBuffer, ref tempSelectInfoBuffer);
+
+            tempKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempKey" };
+            tempAltKeyBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, 4 * 2) { name="TempAltKey" };
+            tempPayloadBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, PayloadStride(payloadType)) { name="TempPayload" };
+            tempAltPayloadBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_maxKeysAllocated, PayloadStride(payloadType)) { name="TempAltPayload" };
+        }
+
+        private static void InitSelectBuffers(
+            ref GraphicsBuffer tempGlobalHistBuffer,
+            ref GraphicsBuffer tempIndirectArgsBuffer,
+            ref GraphicsBuffer tempSelectInfoBuffer)
+        {
+            tempGlobalHistBuffer?.Dispose();
+            tempIndirectArgsBuffer?.Dispose();
+            tempSelectInfoBuffer?.Dispose();
+
+            tempGlobalHistBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_radix * k_radixPasses, 4) { name="TempGlobalHist" };
+            tempIndirectArgsBuffer = new GraphicsBuffer(
+                GraphicsBuffer.Target.IndirectArguments | GraphicsBuffer.Target.Structured,
+                k_indirectArgsSize, sizeof(uint)) { name="TempIndirectArgs" };
+            tempSelectInfoBuffer = new GraphicsBuffer(GraphicsBuffer.Target.Structured, k_selectInfoSize, sizeof(uint)) { name="TempSelectInfo" };
+        }
+
+        private void InitKernels()
+        {
+            bool isValid;
+            if (m_cs)
+            {
+                m_kernelInit = m_cs.FindKernel("InitSelect");
+                m_kernelGlobalHist = m_cs.FindKernel("GlobalHistogram");
+                m_kernelSelectBucket = m_cs.FindKernel("SelectBucket");
+                m_kernelSelectCompact = m_cs.FindKernel("SelectCompact");
+            }
+
+            isValid =   m_kernelInit >= 0 &&
+                        m_kernelGlobalHist >= 0 &&
+                        m_kernelSelectBucket >= 0 &&
+                        m_kernelSelectCompact >= 0;
+
+            if (isValid)
+            {
+                if (!m_cs.IsSupported(m_kernelInit) ||
+                    !m_cs.IsSupported(m_kernelGlobalHist) ||
+                    !m_cs.IsSupported(m_kernelSelectBucket) ||
+                    !m_cs.IsSupported(m_kernelSelectCompact))
+                {
+                    isValid = false;
+                }
+            }
+
+            Assert.IsTrue(isValid);
+        }
+
+        private void SetStaticRootParameters(
+            int numKeys,
+            int k,
+            GraphicsBuffer _topK,
+            GraphicsBuffer _topKPayload,
+            GraphicsBuffer _globalHistBuffer,
+            GraphicsBuffer _indirectArgsBuffer,
+            GraphicsBuffer _selectInfoBuffer)
+        {
+            m_cs.SetInt("e_numKeys", numKeys);
+            m_cs.SetInt("e_selectCount", k);
+            m_cs.SetInt("e_beginBit", 0);
+            m_cs.SetInt("e_endBit", k_passBit);
+            m_cs.SetInt("e_isPartial", k_isNotPartialBitFlag);
+
+            m_cs.SetBuffer(m_kernelInit, "b_globalHist", _globalHistBuffer);
+            m_cs.SetBuffer(m_kernelInit, "b_sortInfo", _selectInfoBuffer);
+            m_cs.SetBuffer(m_kernelInit, "b_indirectArgs", _indirectArgsBuffer);
+
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+            m_cs.SetBuffer(m_kernelGlobalHist, "b_sortInfo", _selectInfoBuffer);
+
+            m_cs.SetBuffer(m_kernelSelectBucket, "b_globalHist", _globalHistBuffer);
+            m_cs.SetBuffer(m_kernelSelectBucket, "b_sortInfo", _selectInfoBuffer);
+            m_cs.SetBuffer(m_kernelSelectBucket, "b_indirectArgs", _indirectArgsBuffer);
+
+            m_cs.SetBuffer(m_kernelSelectCompact, "b_sortInfo", _selectInfoBuffer);
+            m_cs.SetBuffer(m_kernelSelectCompact, "b_topK", _topK);
+            if (!k_keysOnly)
+                m_cs.SetBuffer(m_kernelSelectCompact, "b_topKPayload", _topKPayload);
+        }
+
+        private void SetStaticRootParameters(
+            int numKeys,
+            int k,
+            CommandBuffer _cmd,
+            GraphicsBuffer _topK,
+            GraphicsBuffer _topKPayload,
+            GraphicsBuffer _globalHistBuffer,
+            GraphicsBuffer _indirectArgsBuffer,
+            GraphicsBuffer _selectInfoBuffer)
+        {
+            _cmd.SetComputeIntParam(m_cs, "e_numKeys", numKeys);
+            _cmd.SetComputeIntParam(m_cs, "e_selectCount", k);
+            _cmd.SetComputeIntParam(m_cs, "e_beginBit", 0);
+            _cmd.SetComputeIntParam(m_cs, "e_endBit", k_passBit);
+            _cmd.SetComputeIntParam(m_cs, "e_isPartial", k_isNotPartialBitFlag);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_globalHist", _globalHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_sortInfo", _selectInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelInit, "b_indirectArgs", _indirectArgsBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_globalHist", _globalHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_sortInfo", _selectInfoBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSelectBucket, "b_globalHist", _globalHistBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSelectBucket, "b_sortInfo", _selectInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSelectBucket, "b_indirectArgs", _indirectArgsBuffer);
+
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_sortInfo", _selectInfoBuffer);
+            _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_topK", _topK);
+            if (!k_keysOnly)
+                _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_topKPayload", _topKPayload);
+        }
+
+        //Every digit is recorded, the grids of the ones left with no
+        //candidates come out empty. The first digit reads toSelect, the
+        //rest ping pong between the two temp buffers.
+        private void Dispatch(
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSelect,
+            GraphicsBuffer _toSelectPayload,
+            GraphicsBuffer _temp,
+            GraphicsBuffer _tempPayload,
+            GraphicsBuffer _tempAlt,
+            GraphicsBuffer _tempAltPayload)
+        {
+            m_cs.Dispatch(m_kernelInit, 1, 1, 1);
+            for (int radixShift = k_passBit - 8; radixShift >= 0; radixShift -= 8)
+            {
+                m_cs.SetInt("e_radixShift", radixShift);
+                m_cs.SetInt("e_passFlags", radixShift == 0 ? k_passFlagLast : 0);
+
+                m_cs.SetBuffer(m_kernelGlobalHist, "b_sort", _toSelect);
+                m_cs.DispatchIndirect(m_kernelGlobalHist, _indirectArgs, 0);
+
+                m_cs.Dispatch(m_kernelSelectBucket, 1, 1, 1);
+
+                m_cs.SetBuffer(m_kernelSelectCompact, "b_sort", _toSelect);
+                m_cs.SetBuffer(m_kernelSelectCompact, "b_alt", _temp);
+                if (!k_keysOnly)
+                {
+                    m_cs.SetBuffer(m_kernelSelectCompact, "b_sortPayload", _toSelectPayload);
+                    m_cs.SetBuffer(m_kernelSelectCompact, "b_altPayload", _tempPayload);
+                }
+                m_cs.DispatchIndirect(m_kernelSelectCompact, _indirectArgs, k_compactArgsOffset);
+
+                (_toSelect, _temp, _tempAlt) = (_temp, _tempAlt, _temp);
+                (_toSelectPayload, _tempPayload, _tempAltPayload) = (_tempPayload, _tempAltPayload, _tempPayload);
+            }
+        }
+
+        private void Dispatch(
+            CommandBuffer _cmd,
+            GraphicsBuffer _indirectArgs,
+            GraphicsBuffer _toSelect,
+            GraphicsBuffer _toSelectPayload,
+            GraphicsBuffer _temp,
+            GraphicsBuffer _tempPayload,
+            GraphicsBuffer _tempAlt,
+            GraphicsBuffer _tempAltPayload)
+        {
+            _cmd.DispatchCompute(m_cs, m_kernelInit, 1, 1, 1);
+            for (int radixShift = k_passBit - 8; radixShift >= 0; radixShift -= 8)
+            {
+                _cmd.SetComputeIntParam(m_cs, "e_radixShift", radixShift);
+                _cmd.SetComputeIntParam(m_cs, "e_passFlags", radixShift == 0 ? k_passFlagLast : 0);
+
+                _cmd.SetComputeBufferParam(m_cs, m_kernelGlobalHist, "b_sort", _toSelect);
+                _cmd.DispatchCompute(m_cs, m_kernelGlobalHist, _indirectArgs, 0);
+
+                _cmd.DispatchCompute(m_cs, m_kernelSelectBucket, 1, 1, 1);
+
+                _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_sort", _toSelect);
+                _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_alt", _temp);
+                if (!k_keysOnly)
+                {
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_sortPayload", _toSelectPayload);
+                    _cmd.SetComputeBufferParam(m_cs, m_kernelSelectCompact, "b_altPayload", _tempPayload);
+                }
+                _cmd.DispatchCompute(m_cs, m_kernelSelectCompact, _indirectArgs, k_compactArgsOffset);
+
+                (_toSelect, _temp, _tempAlt) = (_temp, _tempAlt, _temp);
+                (_toSelectPayload, _tempPayload, _tempAltPayload) = (_tempPayload, _tempAltPayload, _tempPayload);
+            }
+        }
+
+        private void AssertChecks(int _inputSize, int _k, System.Type _keyType, GraphicsBuffer _topK)
+        {
+            Assert.IsTrue(_inputSize > k_minSize && _inputSize <= k_maxKeysAllocated);
+            Assert.IsTrue(_k > 0 && _k <= _inputSize && _k <= _topK.count);
+            Assert.IsTrue(
+                _keyType == typeof(ulong)   ||
+                _keyType == typeof(long)    ||
+                _keyType == typeof(double));
+        }
+
+        private void AssertChecksPairs(
+            System.Type _payloadType,
+            GraphicsBuffer _toSelectPayload,
+            GraphicsBuffer _topKPayload,
+            GraphicsBuffer _tempPayloadBuffer,
+            GraphicsBuffer _tempAltPayloadBuffer)
+        {
+            Assert.IsFalse(k_keysOnly);
+            Assert.IsTrue(
+                _payloadType == typeof(uint)    ||
+                _payloadType == typeof(float)   ||
+                _payloadType == typeof(int)     ||
+                _payloadType == typeof(ulong));
+            Assert.IsTrue(
+                _toSelectPayload.stride == PayloadStride(_payloadType) &&
+                _topKPayload.stride == PayloadStride(_payloadType) &&
+                _tempPayloadBuffer.stride == PayloadStride(_payloadType) &&
+                _tempAltPayloadBuffer.stride == PayloadStride(_payloadType));
+        }
+
+        //Keys only, the k smallest when ascending, else the k largest, into
+        //topK[0, k) in no particular order
+        public void Select(
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer topK,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            System.Type keyType,
+            bool shouldAscend)
+        {
+            AssertChecks(selectSize, k, keyType, topK);
+            Assert.IsTrue(k_keysOnly);
+            SetKeyTypeKeywords(keyType);
+            SetAscendingKeyWords(shouldAscend);
+            SetStaticRootParameters(selectSize, k, topK, null, tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer);
+            Dispatch(tempIndirectArgsBuffer, toSelect, null, tempKeyBuffer, null, tempAltKeyBuffer, null);
+        }
+
+        //Keys only
+        //Command queue
+        public void Select(
+            CommandBuffer cmd,
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer topK,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            System.Type keyType,
+            bool shouldAscend)
+        {
+            AssertChecks(selectSize, k, keyType, topK);
+            Assert.IsTrue(k_keysOnly);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            SetStaticRootParameters(selectSize, k, cmd, topK, null, tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer);
+            Dispatch(cmd, tempIndirectArgsBuffer, toSelect, null, tempKeyBuffer, null, tempAltKeyBuffer, null);
+        }
+
+        //Pairs, each selected key keeps its payload
+        public void Select(
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer toSelectPayload,
+            GraphicsBuffer topK,
+            GraphicsBuffer topKPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempAltPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend)
+        {
+            AssertChecks(selectSize, k, keyType, topK);
+            AssertChecksPairs(payloadType, toSelectPayload, topKPayload, tempPayloadBuffer, tempAltPayloadBuffer);
+            SetKeyTypeKeywords(keyType);
+            SetPayloadTypeKeywords(payloadType);
+            SetAscendingKeyWords(shouldAscend);
+            SetStaticRootParameters(selectSize, k, topK, topKPayload, tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer);
+            Dispatch(tempIndirectArgsBuffer, toSelect, toSelectPayload, tempKeyBuffer, tempPayloadBuffer, tempAltKeyBuffer, tempAltPayloadBuffer);
+        }
+
+        //Pairs
+        //Command queue
+        public void Select(
+            CommandBuffer cmd,
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer toSelectPayload,
+            GraphicsBuffer topK,
+            GraphicsBuffer topKPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempAltPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend)
+        {
+            AssertChecks(selectSize, k, keyType, topK);
+            AssertChecksPairs(payloadType, toSelectPayload, topKPayload, tempPayloadBuffer, tempAltPayloadBuffer);
+            SetKeyTypeKeywords(cmd, keyType);
+            SetPayloadTypeKeywords(cmd, payloadType);
+            SetAscendingKeyWords(cmd, shouldAscend);
+            SetStaticRootParameters(selectSize, k, cmd, topK, topKPayload, tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer);
+            Dispatch(cmd, tempIndirectArgsBuffer, toSelect, toSelectPayload, tempKeyBuffer, tempPayloadBuffer, tempAltKeyBuffer, tempAltPayloadBuffer);
+        }
+
+        //Keys only, Select then sort topK[0, k) in the same order with a
+        //keys only sorter allocated for at least k keys. The sorter's temp
+        //buffers are the ones from its constructor.
+        public void TopK(
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer topK,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            DeviceRadixSort sorter,
+            GraphicsBuffer sortTempKeyBuffer,
+            GraphicsBuffer sortTempGlobalHistBuffer,
+            GraphicsBuffer sortTempPassHistBuffer,
+            System.Type keyType,
+            bool shouldAscend)
+        {
+            Select(selectSize, k, toSelect, topK, tempKeyBuffer, tempAltKeyBuffer,
+                tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer, keyType, shouldAscend);
+            if (k > k_minSize)
+            {
+                sorter.Sort(k, topK, sortTempKeyBuffer, sortTempGlobalHistBuffer, sortTempPassHistBuffer,
+                    keyType, shouldAscend);
+            }
+        }
+
+        //Keys only
+        //Command queue
+        public void TopK(
+            CommandBuffer cmd,
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer topK,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            DeviceRadixSort sorter,
+            GraphicsBuffer sortTempKeyBuffer,
+            GraphicsBuffer sortTempGlobalHistBuffer,
+            GraphicsBuffer sortTempPassHistBuffer,
+            System.Type keyType,
+            bool shouldAscend)
+        {
+            Select(cmd, selectSize, k, toSelect, topK, tempKeyBuffer, tempAltKeyBuffer,
+                tempGlobalHistBuffer, tempIndirectArgsBuffer, tempSelectInfoBuffer, keyType, shouldAscend);
+            if (k > k_minSize)
+            {
+                sorter.Sort(cmd, k, topK, sortTempKeyBuffer, sortTempGlobalHistBuffer, sortTempPassHistBuffer,
+                    keyType, shouldAscend);
+            }
+        }
+
+        //Pairs, with a pairs sorter of the same payload type
+        public void TopK(
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer toSelectPayload,
+            GraphicsBuffer topK,
+            GraphicsBuffer topKPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempAltPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            DeviceRadixSort sorter,
+            GraphicsBuffer sortTempKeyBuffer,
+            GraphicsBuffer sortTempPayloadBuffer,
+            GraphicsBuffer sortTempGlobalHistBuffer,
+            GraphicsBuffer sortTempPassHistBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend)
+        {
+            Select(selectSize, k, toSelect, toSelectPayload, topK, topKPayload, tempKeyBuffer, tempAltKeyBuffer,
+                tempPayloadBuffer, tempAltPayloadBuffer, tempGlobalHistBuffer, tempIndirectArgsBuffer,
+                tempSelectInfoBuffer, keyType, payloadType, shouldAscend);
+            if (k > k_minSize)
+            {
+                sorter.Sort(k, topK, topKPayload, sortTempKeyBuffer, sortTempPayloadBuffer,
+                    sortTempGlobalHistBuffer, sortTempPassHistBuffer, keyType, payloadType, shouldAscend);
+            }
+        }
+
+        //Pairs
+        //Command queue
+        public void TopK(
+            CommandBuffer cmd,
+            int selectSize,
+            int k,
+            GraphicsBuffer toSelect,
+            GraphicsBuffer toSelectPayload,
+            GraphicsBuffer topK,
+            GraphicsBuffer topKPayload,
+            GraphicsBuffer tempKeyBuffer,
+            GraphicsBuffer tempAltKeyBuffer,
+            GraphicsBuffer tempPayloadBuffer,
+            GraphicsBuffer tempAltPayloadBuffer,
+            GraphicsBuffer tempGlobalHistBuffer,
+            GraphicsBuffer tempIndirectArgsBuffer,
+            GraphicsBuffer tempSelectInfoBuffer,
+            DeviceRadixSort sorter,
+            GraphicsBuffer sortTempKeyBuffer,
+            GraphicsBuffer sortTempPayloadBuffer,
+            GraphicsBuffer sortTempGlobalHistBuffer,
+            GraphicsBuffer sortTempPassHistBuffer,
+            System.Type keyType,
+            System.Type payloadType,
+            bool shouldAscend)
+        {
+            Select(cmd, selectSize, k, toSelect, toSelectPayload, topK, topKPayload, tempKeyBuffer, tempAltKeyBuffer,
+                tempPayloadBuffer, tempAltPayloadBuffer, tempGlobalHistBuffer, tempIndirectArgsBuffer,
+                tempSelectInfoBuffer, keyType, payloadType, shouldAscend);
+            if (k > k_minSize)
+            {
+                sorter.Sort(cmd, k, topK, topKPayload, sortTempKeyBuffer, sortTempPayloadBuffer,
+                    sortTempGlobalHistBuffer, sortTempPassHistBuffer, keyType, payloadType, shouldAscend);
+            }
+        }
+    }
+}
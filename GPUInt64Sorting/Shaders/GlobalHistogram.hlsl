@@ -0,0 +1,275 @@
+/******************************************************************************
+ * GPUSorting
+ *
+ * SPDX-License-Identifier: MIT
+ * Copyright Thomas Smith 4/28/2024
+ * https://github.com/b0nes164/GPUSorting
+ *
+ ******************************************************************************/
+//Shared by DeviceRadixSort and OneSweep, which build the device level
+//histograms of all eight digits in the same single read. With RADIX_11,
+//the six wide digit histograms are counted in one read as well.
+//RadixSelect defines SINGLE_DIGIT_HIST: its candidates change after
+//every digit, so only the digit at e_radixShift is counted.
+//DeviceRadixSort defines G_HIST_TILE_COUNTS: the same read also counts
+//the digit at e_radixShift of each sorting tile into b_passHist, so the
+//first dispatched pass needs no Upsweep. Declare b_passHist before it.
+//Include after SortCommon.hlsl.
+
+// #pragma kernel GlobalHistogram
+
+#if defined(G_HIST_TILE_COUNTS)
+#define G_HIST_TILES        8U      //Sorting tiles per GlobalHistogram tile
+#define G_HIST_PART_SIZE    (PART_SIZE * G_HIST_TILES)
+#else
+#define G_HIST_PART_SIZE    32768U  //The size of a GlobalHistogram partition tile.
+#endif
+#define G_HIST_DIM          128U    //The number of threads in a global hist threadblock
+#define G_HIST_HIGH_START   512U    //Offset of the upper four digit histograms in g_gHist
+
+#define SEC_RADIX_START     256     //Offset for retrieving value from global histogram buffer
+#define THIRD_RADIX_START   512     //Offset for retrieving value from global histogram buffer
+#define FOURTH_RADIX_START  768     //Offset for retrieving value from global histogram buffer
+#define FIFTH_RADIX_START   1024    //Offset for retrieving value from global histogram buffer
+#define SIXTH_RADIX_START   1280    //Offset for retrieving value from global histogram buffer
+#define SEVENTH_RADIX_START 1536    //Offset for retrieving value from global histogram buffer
+#define EIGHTH_RADIX_START  1792    //Offset for retrieving value from global histogram buffer
+
+RWStructuredBuffer<uint> b_globalHist;  //buffer holding device level offsets for each binning pass
+
+#if defined(RADIX_11)
+//The 11, 11 and 10 bit histograms of each word, 5120 bins per word. A tile
+//holds at most G_HIST_PART_SIZE keys, so two 16-bit counts pack in a uint.
+#define G_HIST_WORD_BINS    5120U
+
+groupshared uint g_gHist[G_HIST_WORD_BINS];  //Shared memory for GlobalHistogram, one 16-bit count per bin
+#elif defined(SINGLE_DIGIT_HIST)
+groupshared uint g_gHist[RADIX * 2];    //Shared memory for GlobalHistogram, two histograms of one digit
+#else
+groupshared uint4 g_gHist[RADIX * 4];   //Shared memory for GlobalHistogram, two uint4 per bin for 8 digits
+#endif
+
+#if defined(G_HIST_TILE_COUNTS)
+groupshared uint g_tileHist[RADIX];     //Shared memory for GlobalHistogram, the digit at e_radixShift of one sorting tile
+#endif
+
+//The global histogram tiles are larger than the sorting tiles,
+//so it is dispatched with its own thread block count
+inline uint GlobalHistThreadBlocks()
+{
+#if defined(INDIRECT_COUNT)
+    return b_sortInfo[INFO_G_HIST_BLOCKS];
+#else
+    return e_threadBlocks;
+#endif
+}
+
+#if defined(G_HIST_TILE_COUNTS)
+//e_threadBlocks holds the GlobalHistogram grid while it runs,
+//b_passHist is laid out by the sorting tiles
+inline uint SortThreadBlocks()
+{
+    return (NumKeys() + PART_SIZE - 1) / PART_SIZE;
+}
+
+inline void CountTileDigit(uint64_t key)
+{
+    InterlockedAdd(g_tileHist[ExtractDigit(key)], 1);
+}
+
+//The counts are exactly what Upsweep produces for the first dispatched
+//pass, the keys have not moved and are windowed the same way
+inline void WriteTileDigitCounts(uint gtid, uint tile)
+{
+    for (uint i = gtid; i < RADIX; i += G_HIST_DIM)
+    {
+        b_passHist[i * SortThreadBlocks() + tile] = g_tileHist[i];
+        g_tileHist[i] = 0;
+    }
+}
+#endif
+
+//*****************************************************************************
+//GLOBAL HISTOGRAM KERNEL
+//*****************************************************************************
+//Every digit of a key is counted from a single read, so the
+//binning passes never have to rebuild the device level histogram.
+#if defined(RADIX_11)
+//Bin of a word's digit at shift, the digits of a word are laid
+//out back to back, 2048, 2048, then 1024 bins
+inline void CountWordDigits(uint word, uint wordBinStart)
+{
+    [unroll]
+    for (uint shift = 0; shift < 32; shift += RADIX_LOG)
+    {
+        const uint bin = wordBinStart + shift / RADIX_LOG * RADIX + (word >> shift & RADIX_MASK);
+        InterlockedAdd(g_gHist[bin >> 1], (bin & 1) ? 0x10000 : 1);
+    }
+}
+
+inline void GlobalHistogramDigitCounts(uint gtid, uint partitionStart, uint partitionEnd)
+{
+    uint64_t t;
+    for (uint i = gtid + partitionStart; i < partitionEnd; i += G_HIST_DIM)
+    {
+#if defined(KEY_UINT)
+        t = b_sort[i];
+#elif defined(KEY_INT)
+        t = IntToUint(b_sort[i]);
+#elif defined(KEY_FLOAT)
+        t = FloatToUint(b_sort[i]);
+#elif defined(KEY_ULONG)
+        t = b_sort[i];
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+        t = ToRadixKey(b_sort[i]);
+#endif
+        t &= KeyWindowMask();
+        CountWordDigits((uint)t, 0);
+        CountWordDigits((uint)(t >> 32), G_HIST_WORD_BINS);
+#if defined(G_HIST_TILE_COUNTS)
+        CountTileDigit(t);
+#endif
+    }
+}
+
+//Unpack and atomically add to device, the bins of a word
+//land at the histograms of its three passes
+inline void GlobalHistReduceWriteDigitCounts(uint gtid)
+{
+    for (uint i = gtid; i < G_HIST_WORD_BINS; i += G_HIST_DIM)
+    {
+        const uint packed = g_gHist[i];
+        const uint bin = i << 1;
+        const uint deviceBin = bin / G_HIST_WORD_BINS * DIGITS_PER_WORD * RADIX + bin % G_HIST_WORD_BINS;
+        InterlockedAdd(b_globalHist[deviceBin], packed & 0xffff);
+        InterlockedAdd(b_globalHist[deviceBin + 1], packed >> 16);
+    }
+}
+#elif defined(SINGLE_DIGIT_HIST)
+//histogram, 64 threads to a histogram
+inline void GlobalHistogramDigitCounts(uint gtid, uint partitionStart, uint partitionEnd)
+{
+    const uint histOffset = gtid / 64 * RADIX;
+    uint64_t t;
+    for (uint i = gtid + partitionStart; i < partitionEnd; i += G_HIST_DIM)
+    {
+#if defined(KEY_ULONG)
+        t = b_sort[i];
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+        t = ToRadixKey(b_sort[i]);
+#endif
+        InterlockedAdd(g_gHist[ExtractDigit(t) + histOffset], 1);
+    }
+}
+
+//reduce counts and atomically add to the histogram of the current digit
+inline void GlobalHistReduceWriteDigitCounts(uint gtid)
+{
+    for (uint i = gtid; i < RADIX; i += G_HIST_DIM)
+    {
+        const uint count = g_gHist[i] + g_gHist[i + RADIX];
+        if (count)
+            InterlockedAdd(b_globalHist[i + GlobalHistOffset()], count);
+    }
+}
+#else
+//histogram, 64 threads to a histogram
+inline void GlobalHistogramDigitCounts(uint gtid, uint partitionStart, uint partitionEnd)
+{
+    const uint histOffset = gtid / 64 * RADIX;
+    uint64_t t;
+    for (uint i = gtid + partitionStart; i < partitionEnd; i += G_HIST_DIM)
+    {
+#if defined(KEY_UINT)
+        t = b_sort[i];
+#elif defined(KEY_INT)
+        t = IntToUint(b_sort[i]);
+#elif defined(KEY_FLOAT)
+        t = FloatToUint(b_sort[i]);
+#elif defined(KEY_ULONG)
+        t = b_sort[i];
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+        t = ToRadixKey(b_sort[i]);
+#endif
+        t &= KeyWindowMask();
+        const uint low = (uint)t;
+        const uint high = (uint)(t >> 32);
+        InterlockedAdd(g_gHist[ExtractDigit(low, 0) + histOffset].x, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(low, 8) + histOffset].y, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(low, 16) + histOffset].z, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(low, 24) + histOffset].w, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(high, 0) + histOffset + G_HIST_HIGH_START].x, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(high, 8) + histOffset + G_HIST_HIGH_START].y, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(high, 16) + histOffset + G_HIST_HIGH_START].z, 1);
+        InterlockedAdd(g_gHist[ExtractDigit(high, 24) + histOffset + G_HIST_HIGH_START].w, 1);
+#if defined(G_HIST_TILE_COUNTS)
+        CountTileDigit(t);
+#endif
+    }
+}
+
+//reduce counts and atomically add to device
+inline void GlobalHistReduceWriteDigitCounts(uint gtid)
+{
+    for (uint i = gtid; i < RADIX; i += G_HIST_DIM)
+    {
+        const uint4 low = g_gHist[i] + g_gHist[i + RADIX];
+        const uint4 high = g_gHist[i + G_HIST_HIGH_START] +
+            g_gHist[i + G_HIST_HIGH_START + RADIX];
+        InterlockedAdd(b_globalHist[i], low.x);
+        InterlockedAdd(b_globalHist[i + SEC_RADIX_START], low.y);
+        InterlockedAdd(b_globalHist[i + THIRD_RADIX_START], low.z);
+        InterlockedAdd(b_globalHist[i + FOURTH_RADIX_START], low.w);
+        InterlockedAdd(b_globalHist[i + FIFTH_RADIX_START], high.x);
+        InterlockedAdd(b_globalHist[i + SIXTH_RADIX_START], high.y);
+        InterlockedAdd(b_globalHist[i + SEVENTH_RADIX_START], high.z);
+        InterlockedAdd(b_globalHist[i + EIGHTH_RADIX_START], high.w);
+    }
+}
+#endif
+
+[numthreads(G_HIST_DIM, 1, 1)]
+void GlobalHistogram(uint3 gtid : SV_GroupThreadID, uint3 gid : SV_GroupID)
+{
+    const uint partitionIndex = flattenGid(gid);
+#if defined(INDIRECT_COUNT)
+    if (partitionIndex >= GlobalHistThreadBlocks())
+        return;
+#endif
+
+    //clear shared memory
+#if defined(RADIX_11)
+    const uint histsEnd = G_HIST_WORD_BINS;
+#elif defined(SINGLE_DIGIT_HIST)
+    const uint histsEnd = RADIX * 2;
+#else
+    const uint histsEnd = RADIX * 4;
+#endif
+    for (uint i = gtid.x; i < histsEnd; i += G_HIST_DIM)
+        g_gHist[i] = 0;
+#if defined(G_HIST_TILE_COUNTS)
+    for (uint j = gtid.x; j < RADIX; j += G_HIST_DIM)
+        g_tileHist[j] = 0;
+#endif
+    GroupMemoryBarrierWithGroupSync();
+    
+#if defined(G_HIST_TILE_COUNTS)
+    //One sorting tile at a time, so each tile's digit counts can be written out
+    const uint tileEnd = min((partitionIndex + 1) * G_HIST_TILES, SortThreadBlocks());
+    for (uint tile = partitionIndex * G_HIST_TILES; tile < tileEnd; ++tile)
+    {
+        GlobalHistogramDigitCounts(gtid.x, tile * PART_SIZE,
+            tile == SortThreadBlocks() - 1 ? NumKeys() : (tile + 1) * PART_SIZE);
+        GroupMemoryBarrierWithGroupSync();
+        
+        WriteTileDigitCounts(gtid.x, tile);
+        GroupMemoryBarrierWithGroupSync();
+    }
+#else
+    GlobalHistogramDigitCounts(gtid.x, partitionIndex * G_HIST_PART_SIZE,
+        partitionIndex == GlobalHistThreadBlocks() - 1 ? NumKeys() : (partitionIndex + 1) * G_HIST_PART_SIZE);
+    GroupMemoryBarrierWithGroupSync();
+#endif
+    
+    GlobalHistReduceWriteDigitCounts(gtid.x);
+}
@@ -0,0 +1,224 @@
+/******************************************************************************
+ * GPUSorting
+ *
+ * SPDX-License-Identifier: MIT
+ * Copyright Thomas Smith 4/28/2024
+ * https://github.com/b0nes164/GPUSorting
+ *
+ ******************************************************************************/
+//Shared by DeviceRadixSort and OneSweep. Sorts of at most PART_SIZE keys
+//run in a single threadblock and a single dispatch, instead of a global
+//histogram, scan and three dispatches per pass. Every digit inside
+//[e_beginBit, e_endBit) is applied as stable one bit splits of packed
+//digit and index records in g_d, so the keys and payloads are only read
+//to extract digits and moved once at the end, in place in b_sort.
+//Include after SortCommon.hlsl.
+
+// #pragma kernel SmallSort
+
+#define SMALL_INDEX_BITS    12U     //Bits of a record holding the key's index, enough for PART_SIZE
+#define SMALL_INDEX_MASK    4095U
+#define SMALL_DIGIT_BITS    8U      //Digit width of the splits, independent of RADIX
+#define SMALL_DIGIT_MASK    255U
+
+#if defined(KEY_UINT) || defined(KEY_INT) || defined(KEY_FLOAT)
+#define SMALL_KEY_BITS      32U
+#else
+#define SMALL_KEY_BITS      64U
+#endif
+
+//The key with the radix trick applied, so its bits order as unsigned
+inline void LoadSmallSortKey(inout uint64_t key, uint index)
+{
+#if defined(KEY_UINT)
+    key = b_sort[index];
+#elif defined(KEY_INT)
+    key = IntToUint(b_sort[index]);
+#elif defined(KEY_FLOAT)
+    key = FloatToUint(b_sort[index]);
+#elif defined(KEY_ULONG)
+    key = b_sort[index];
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+    key = ToRadixKey(b_sort[index]);
+#endif
+}
+
+inline void WriteSmallSortKey(uint index, uint64_t key)
+{
+#if defined(KEY_UINT)
+    b_sort[index] = (uint)key;
+#elif defined(KEY_INT)
+    b_sort[index] = UintToInt((uint)key);
+#elif defined(KEY_FLOAT)
+    b_sort[index] = UintToFloat((uint)key);
+#elif defined(KEY_ULONG)
+    b_sort[index] = key;
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+    b_sort[index] = FromRadixKey(key);
+#endif
+}
+
+inline void WriteSmallSortPayload(uint index, uint64_t payload)
+{
+#if defined(PAYLOAD_UINT)
+    b_sortPayload[index] = (uint)payload;
+#elif defined(PAYLOAD_INT)
+    b_sortPayload[index] = asint((uint)payload);
+#elif defined(PAYLOAD_FLOAT)
+    b_sortPayload[index] = asfloat((uint)payload);
+#elif defined(PAYLOAD_ULONG)
+    b_sortPayload[index] = payload;
+#endif
+}
+
+//Each thread owns KEYS_PER_THREAD consecutive positions, so a thread's
+//serial count followed by a block wide scan keeps the splits stable
+inline uint SmallSortPosition(uint gtid, uint i)
+{
+    return gtid * KEYS_PER_THREAD + i;
+}
+
+//Exclusive block wide sum of one value per thread, the wave totals go
+//to g_d past the records. The caller syncs before g_d is written again.
+inline uint SmallSortExclusiveSum(uint gtid, uint value, out uint total)
+{
+    const uint waveIndex = getWaveIndex(gtid);
+    uint prefix = WavePrefixSum(value);
+    if (WaveGetLaneIndex() == WaveGetLaneCount() - 1)
+        g_d[PART_SIZE + waveIndex] = prefix + value;
+    GroupMemoryBarrierWithGroupSync();
+
+    total = 0;
+    for (uint w = 0; w < getWaveCountPass(); ++w)
+    {
+        const uint t = g_d[PART_SIZE + w];
+        if (w < waveIndex)
+            prefix += t;
+        total += t;
+    }
+    return prefix;
+}
+
+//Records with a zero at the bit keep their order ahead of the ones
+inline void SmallSortSplit(uint gtid, uint numKeys, uint bit, inout uint records[KEYS_PER_THREAD])
+{
+    uint zeros = 0;
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        if (SmallSortPosition(gtid, i) < numKeys && (records[i] >> bit & 1) == 0)
+            zeros++;
+    }
+
+    uint totalZeros;
+    uint zerosBefore = SmallSortExclusiveSum(gtid, zeros, totalZeros);
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        const uint position = SmallSortPosition(gtid, i);
+        if (position < numKeys)
+        {
+            if (records[i] >> bit & 1)
+            {
+                g_d[totalZeros + position - zerosBefore] = records[i];
+            }
+            else
+            {
+                g_d[zerosBefore] = records[i];
+                zerosBefore++;
+            }
+        }
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        const uint position = SmallSortPosition(gtid, i);
+        if (position < numKeys)
+            records[i] = g_d[position];
+    }
+}
+
+//*****************************************************************************
+//SMALL SORT KERNEL
+//*****************************************************************************
+//A single threadblock, e_numKeys at most PART_SIZE. A descending sort is
+//the stable ascending order mirrored, as in the final pass of the others.
+[numthreads(D_DIM, 1, 1)]
+void SmallSort(uint3 gtid : SV_GroupThreadID)
+{
+    const uint numKeys = e_numKeys;
+    const uint64_t windowMask = KeyWindowMask();
+
+    uint records[KEYS_PER_THREAD];
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        records[i] = SmallSortPosition(gtid.x, i);
+
+    for (uint radixShift = 0; radixShift < SMALL_KEY_BITS; radixShift += SMALL_DIGIT_BITS)
+    {
+        const uint digitMask = (uint)(windowMask >> radixShift) & SMALL_DIGIT_MASK;
+        if (digitMask == 0)
+            continue;
+
+        [unroll]
+        for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        {
+            if (SmallSortPosition(gtid.x, i) < numKeys)
+            {
+                const uint index = records[i] & SMALL_INDEX_MASK;
+                uint64_t key = 0;
+                LoadSmallSortKey(key, index);
+                const uint digit = (uint)(key >> radixShift) & digitMask;
+                records[i] = digit << SMALL_INDEX_BITS | index;
+            }
+        }
+
+        for (uint bit = 0; bit < SMALL_DIGIT_BITS; ++bit)
+        {
+            if (digitMask >> bit & 1)
+                SmallSortSplit(gtid.x, numKeys, bit + SMALL_INDEX_BITS, records);
+        }
+    }
+
+    //Every key and payload is read before any is overwritten
+    uint64_t keys[KEYS_PER_THREAD];
+#if defined(SORT_PAIRS)
+    PayloadStruct payloads;
+#endif
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        keys[i] = 0;
+        if (SmallSortPosition(gtid.x, i) < numKeys)
+        {
+            const uint index = records[i] & SMALL_INDEX_MASK;
+            LoadSmallSortKey(keys[i], index);
+#if defined(SORT_PAIRS)
+            LoadPayload(payloads.k[i], index);
+#endif
+        }
+    }
+    DeviceMemoryBarrierWithGroupSync();
+
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        const uint position = SmallSortPosition(gtid.x, i);
+        if (position < numKeys)
+        {
+#if defined(SHOULD_ASCEND)
+            const uint deviceIndex = position;
+#else
+            const uint deviceIndex = numKeys - position - 1;
+#endif
+            WriteSmallSortKey(deviceIndex, keys[i]);
+#if defined(SORT_PAIRS)
+            WriteSmallSortPayload(deviceIndex, payloads.k[i]);
+#endif
+        }
+    }
+}
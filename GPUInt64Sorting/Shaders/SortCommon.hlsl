@@ -6,10 +6,11 @@
  * https://github.com/b0nes164/GPUSorting
  *
  ******************************************************************************/
-// #pragma multi_compile __ KEY_UINT KEY_INT KEY_FLOAT
-// #pragma multi_compile __ PAYLOAD_UINT PAYLOAD_INT PAYLOAD_FLOAT
+// #pragma multi_compile __ KEY_UINT KEY_INT KEY_FLOAT KEY_ULONG KEY_LONG KEY_DOUBLE
+// #pragma multi_compile __ PAYLOAD_UINT PAYLOAD_INT PAYLOAD_FLOAT PAYLOAD_ULONG
 // #pragma multi_compile __ SHOULD_ASCEND
 // #pragma multi_compile __ SORT_PAIRS
+// #pragma multi_compile __ RADIX_11
 //
 // #pragma use_dxc
 // #pragma require wavebasic
@@ -21,23 +22,47 @@
 #define KEYS_PER_THREAD     15U 
 #define D_DIM               256U
 #define PART_SIZE           3840U
-#define D_TOTAL_SMEM        4096U
 
-#define MAX_DISPATCH_DIM    65535U  //The max value of any given dispatch dimension
+#if !defined(MAX_DISPATCH_DIM)
+#define MAX_DISPATCH_DIM    65535U  //The max value of any given dispatch dimension, hosts may lower it to test flattening
+#endif
+
+//Digits never straddle the two 32-bit words of a key, so 11-bit digits
+//come in 11, 11 and 10 bit triples, six passes instead of eight.
+//Only DeviceRadixSort compiles the wide digit variant.
+#if defined(RADIX_11)
+#define D_TOTAL_SMEM        8192U   //The full 32KB, four wave histograms
+#define RADIX               2048U   //Number of digit bins
+#define RADIX_MASK          2047U   //Mask of digit bins
+#define HALF_RADIX          1024U   //For smaller waves where bit packing is necessary
+#define HALF_MASK           1023U   // ''
+#define RADIX_LOG           11U     //log2(RADIX)
+#define RADIX_PASSES        6U      //Passes over the two words of the key
+#define DIGITS_PER_WORD     3U      //Passes per 32-bit word
+#else
+#define D_TOTAL_SMEM        4096U
 #define RADIX               256U    //Number of digit bins
 #define RADIX_MASK          255U    //Mask of digit bins
 #define HALF_RADIX          128U    //For smaller waves where bit packing is necessary
 #define HALF_MASK           127U    // '' 
 #define RADIX_LOG           8U      //log2(RADIX)
 #define RADIX_PASSES        8U      //(Key width) / RADIX_LOG
-#define RADIX_LAST_BIT      56U
+#define DIGITS_PER_WORD     4U      //Passes per 32-bit word
+#endif
+
+#define PASS_FLAG_FIRST     1U      //Set on the first dispatched pass
+#define PASS_FLAG_LAST      2U      //Set on the last dispatched pass
 
 cbuffer cbGpuSorting : register(b0)
 {
     uint e_numKeys;
     uint e_radixShift;
     uint e_threadBlocks;
-    uint padding;
+    uint e_beginBit;
+    uint e_endBit;
+    uint e_passFlags;
+    uint e_isPartial;
+    uint e_keyCountOffset;
 };
 
 
@@ -53,6 +78,9 @@ RWStructuredBuffer<float> b_alt;
 #elif defined(KEY_ULONG)
 RWStructuredBuffer<uint64_t> b_sort;
 RWStructuredBuffer<uint64_t> b_alt;
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+RWStructuredBuffer<uint64_t> b_sort;    //Raw bit patterns, no double arithmetic needed
+RWStructuredBuffer<uint64_t> b_alt;
 #endif
 
 #if defined(PAYLOAD_UINT)
@@ -64,9 +92,18 @@ RWStructuredBuffer<int> b_altPayload;
 #elif defined(PAYLOAD_FLOAT)
 RWStructuredBuffer<float> b_sortPayload;
 RWStructuredBuffer<float> b_altPayload;
+#elif defined(PAYLOAD_ULONG)
+RWStructuredBuffer<uint64_t> b_sortPayload;
+RWStructuredBuffer<uint64_t> b_altPayload;
 #endif
 
-groupshared uint g_d_high[D_TOTAL_SMEM];
+//Key and thread block counts, written on the device when the
+//key count is read indirectly. See SetupIndirect.
+#define INFO_NUM_KEYS           0
+#define INFO_THREAD_BLOCKS      1
+#define INFO_G_HIST_BLOCKS      2
+RWStructuredBuffer<uint> b_sortInfo;
+
 groupshared uint g_d[D_TOTAL_SMEM]; //Shared memory for DigitBinningPass and DownSweep kernels
 
 struct KeyStruct
@@ -80,7 +117,16 @@ struct KeyStruct
 
 struct PayloadStruct
 {
+#if defined(PAYLOAD_ULONG)
+    uint64_t k[KEYS_PER_THREAD];
+#else
     uint k[KEYS_PER_THREAD];
+#endif
+};
+
+struct WordStruct
+{
+    uint w[KEYS_PER_THREAD];
 };
 
 struct OffsetStruct
@@ -109,6 +155,42 @@ inline uint getWaveIndex(uint gtid)
     return gtid / WaveGetLaneCount();
 }
 
+inline bool isPartialDispatch()
+{
+    return e_isPartial & 1;
+}
+
+#if defined(INDIRECT_COUNT)
+inline uint NumKeys()
+{
+    return b_sortInfo[INFO_NUM_KEYS];
+}
+
+inline uint ThreadBlocks()
+{
+    return b_sortInfo[INFO_THREAD_BLOCKS];
+}
+#else
+inline uint NumKeys()
+{
+    return e_numKeys;
+}
+
+inline uint ThreadBlocks()
+{
+    return e_threadBlocks;
+}
+#endif
+
+//Grids past MAX_DISPATCH_DIM are split into a 2D dispatch of full rows,
+//then a 1D dispatch of the remainder with the row count in e_isPartial
+inline uint flattenGid(uint3 gid)
+{
+    return isPartialDispatch() ?
+        gid.x + (e_isPartial >> 1) * MAX_DISPATCH_DIM :
+        gid.x + gid.y * MAX_DISPATCH_DIM;
+}
+
 //Radix Tricks by Michael Herf
 //http://stereopsis.com/radix.html
 inline uint FloatToUint(float f)
@@ -133,16 +215,108 @@ inline int UintToInt(uint u)
     return asint(u ^ 0x80000000);
 }
 
+//64-bit equivalents, on the raw bits of an int64 or a double
+inline uint64_t DoubleToUlong(uint64_t d)
+{
+    const uint64_t mask = (d >> 63) ? ~(uint64_t)0 : (uint64_t)1 << 63;
+    return d ^ mask;
+}
+
+inline uint64_t UlongToDouble(uint64_t u)
+{
+    const uint64_t mask = (u >> 63) ? (uint64_t)1 << 63 : ~(uint64_t)0;
+    return u ^ mask;
+}
+
+inline uint64_t LongToUlong(uint64_t l)
+{
+    return l ^ ((uint64_t)1 << 63);
+}
+
+inline uint64_t UlongToLong(uint64_t u)
+{
+    return u ^ ((uint64_t)1 << 63);
+}
+
+inline bool IsFirstDispatchedPass()
+{
+    return e_passFlags & PASS_FLAG_FIRST;
+}
+
+inline bool IsLastDispatchedPass()
+{
+    return e_passFlags & PASS_FLAG_LAST;
+}
+
+//For 64-bit signed and double keys, the radix trick is applied once when the
+//keys are first read and undone on the last write, so the passes in between
+//move plain uint64 keys through b_sort and b_alt.
+#if defined(KEY_LONG) || defined(KEY_DOUBLE)
+inline uint64_t ToRadixKey(uint64_t key)
+{
+#if defined(KEY_LONG)
+    return LongToUlong(key);
+#else
+    return DoubleToUlong(key);
+#endif
+}
+
+inline uint64_t FromRadixKey(uint64_t key)
+{
+#if defined(KEY_LONG)
+    return UlongToLong(key);
+#else
+    return UlongToDouble(key);
+#endif
+}
+
+inline uint64_t LoadPassKey(uint index)
+{
+    return IsFirstDispatchedPass() ? ToRadixKey(b_sort[index]) : b_sort[index];
+}
+#endif
+
 inline uint getWaveCountPass()
 {
     return D_DIM / WaveGetLaneCount();
 }
 
-inline uint64_t getGD(uint index)
+//Width of the current digit, cut short at the top of its 32-bit word
+inline uint PassWidth()
+{
+    return min(RADIX_LOG, 32 - (e_radixShift & 31));
+}
+
+//Index of the current pass, and of its histogram in b_globalHist
+inline uint PassIndex()
+{
+    return (e_radixShift >> 5) * DIGITS_PER_WORD + (e_radixShift & 31) / RADIX_LOG;
+}
+
+//Bits of the current digit that fall inside [e_beginBit, e_endBit),
+//bits outside of the window never influence the order
+inline uint DigitMask()
+{
+    if (e_endBit <= e_radixShift || e_beginBit >= e_radixShift + PassWidth())
+        return 0;
+    
+    const uint lowCut = e_beginBit > e_radixShift ? e_beginBit - e_radixShift : 0;
+    const uint highCut = min(e_endBit - e_radixShift, PassWidth());
+    return (RADIX_MASK >> (RADIX_LOG - highCut)) & ~((1U << lowCut) - 1);
+}
+
+//The same window over the whole key, for the GlobalHistogram
+inline uint64_t KeyWindowMask()
+{
+    const uint64_t high = e_endBit >= 64 ?
+        ~(uint64_t)0 : ((uint64_t)1 << e_endBit) - 1;
+    return high & ~(((uint64_t)1 << e_beginBit) - 1);
+}
+
+//The last pass is the one covering the top bit of the window
+inline bool IsFinalPass()
 {
-    uint64_t high = g_d_high[index];
-    high <<= 32;
-    return high | ((uint64_t)g_d[index] & (((uint64_t)1U << 32) - 1));
+    return e_radixShift < e_endBit && e_radixShift + PassWidth() >= e_endBit;
 }
 
 // inline uint ExtractDigit(uint key)
@@ -151,7 +325,7 @@ inline uint64_t getGD(uint index)
 // }
 inline uint ExtractDigit(uint64_t key)
 {
-    return key >> e_radixShift & RADIX_MASK;
+    return key >> e_radixShift & DigitMask();
 }
 
 inline uint ExtractDigit(uint key, uint shift)
@@ -159,17 +333,17 @@ inline uint ExtractDigit(uint key, uint shift)
     return key >> shift & RADIX_MASK;
 }
 
-inline uint ExtractPackedIndex(uint key)
+inline uint ExtractPackedIndex(uint64_t key)
 {
-    return key >> (e_radixShift + 1) & HALF_MASK;
+    return ExtractDigit(key) >> 1;
 }
 
-inline uint ExtractPackedShift(uint key)
+inline uint ExtractPackedShift(uint64_t key)
 {
-    return (key >> e_radixShift & 1) ? 16 : 0;
+    return (ExtractDigit(key) & 1) ? 16 : 0;
 }
 
-inline uint ExtractPackedValue(uint packed, uint key)
+inline uint ExtractPackedValue(uint packed, uint64_t key)
 {
     return packed >> ExtractPackedShift(key) & 0xffff;
 }
@@ -208,7 +382,7 @@ inline uint DeviceOffsetWLT16(uint gtid, uint partIndex, uint serialIterations)
 
 inline uint GlobalHistOffset()
 {
-    return e_radixShift << 5;
+    return PassIndex() * RADIX;
 }
 
 inline uint WaveHistsSizeWGE16()
@@ -237,10 +411,7 @@ inline void ClearWaveHists(uint gtid)
     const uint histsEnd = WaveGetLaneCount() >= 16 ?
         WaveHistsSizeWGE16() : WaveHistsSizeWLT16();
     for (uint i = gtid; i < histsEnd; i += D_DIM)
-    {
         g_d[i] = 0;
-        g_d_high[i]= 0;
-    }    
 }
 
 inline void LoadKey(inout uint64_t key, uint index)
@@ -249,11 +420,13 @@ inline void LoadKey(inout uint64_t key, uint index)
 #if defined(KEY_UINT)
     key = b_sort[index];
 #elif defined(KEY_INT)
-    key = UintToInt(b_sort[index]);
+    key = IntToUint(b_sort[index]);
 #elif defined(KEY_FLOAT)
     key = FloatToUint(b_sort[index]);
 #elif defined(KEY_ULONG)
     key = b_sort[index];
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+    key = LoadPassKey(index);
 #endif
 }
 
@@ -298,7 +471,7 @@ inline KeyStruct LoadKeysPartialWGE16(uint gtid, uint partIndex)
                  i < KEYS_PER_THREAD;
                  ++i, t += WaveGetLaneCount())
     {
-        if (t < e_numKeys)
+        if (t < NumKeys())
             LoadKey(keys.k[i], t);
         else
             LoadDummyKey(keys.k[i]);
@@ -314,7 +487,7 @@ inline KeyStruct LoadKeysPartialWLT16(uint gtid, uint partIndex, uint serialIter
         i < KEYS_PER_THREAD;
         ++i, t += WaveGetLaneCount() * serialIterations)
     {
-        if (t < e_numKeys)
+        if (t < NumKeys())
             LoadKey(keys.k[i], t);
         else
             LoadDummyKey(keys.k[i]);
@@ -336,22 +509,24 @@ inline uint WaveFlagsWLT16()
 inline void WarpLevelMultiSplitWGE16(uint64_t key, uint waveParts, inout uint4 waveFlags)
 // inline void WarpLevelMultiSplitWGE16(uint key, uint waveParts, inout uint4 waveFlags)
 {
+    const uint digit = ExtractDigit(key);
     [unroll]
     for (uint k = 0; k < RADIX_LOG; ++k)
     {
-        const bool t = key >> (k + e_radixShift) & 1;
+        const bool t = digit >> k & 1;
         const uint4 ballot = WaveActiveBallot(t);
         for (uint wavePart = 0; wavePart < waveParts; ++wavePart)
             waveFlags[wavePart] &= (t ? 0 : 0xffffffff) ^ ballot[wavePart];
     }
 }
 
-inline void WarpLevelMultiSplitWLT16(uint key, inout uint waveFlags)
+inline void WarpLevelMultiSplitWLT16(uint64_t key, inout uint waveFlags)
 {
+    const uint digit = ExtractDigit(key);
     [unroll]
     for (uint k = 0; k < RADIX_LOG; ++k)
     {
-        const bool t = key >> (k + e_radixShift) & 1;
+        const bool t = digit >> k & 1;
         waveFlags &= (t ? 0 : 0xffffffff) ^ (uint) WaveActiveBallot(t);
     }
 }
@@ -584,34 +759,261 @@ inline void UpdateOffsetsWLT16(
     }
 }
 
+//*****************************************************************************
+//WIDE DIGITS
+//*****************************************************************************
+//A 2048 bin histogram per wave does not fit in shared memory, so only
+//D_TOTAL_SMEM / RADIX of them are kept. Like the WLT16 path, the waves
+//sharing a histogram rank their keys serially, but without packing,
+//so any wave size works. Each thread then owns RADIX / D_DIM digits.
+#if defined(RADIX_11)
+#define WIDE_DIGITS_PER_THREAD  8U  //RADIX / D_DIM
+
+struct WideReductionStruct
+{
+    uint r[WIDE_DIGITS_PER_THREAD];
+};
+
+inline uint SerialIterationsWide()
+{
+    return max(getWaveCountPass() * RADIX / D_TOTAL_SMEM, 1);
+}
+
+inline uint WaveHistsSizeWide()
+{
+    return getWaveCountPass() / SerialIterationsWide() * RADIX;
+}
+
+inline void ClearWaveHistsWide(uint gtid)
+{
+    for (uint i = gtid; i < WaveHistsSizeWide(); i += D_DIM)
+        g_d[i] = 0;
+}
+
+inline OffsetStruct RankKeysWide(uint gtid, KeyStruct keys, uint serialIterations)
+{
+    OffsetStruct offsets;
+    const uint waveParts = (WaveGetLaneCount() + 31) / 32;
+    const uint histOffset = getWaveIndex(gtid) / serialIterations * RADIX;
+    
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+    {
+        uint4 waveFlags = WaveFlagsWGE16();
+        WarpLevelMultiSplitWGE16(keys.k[i], waveParts, waveFlags);
+        
+        const uint index = ExtractDigit(keys.k[i]) + histOffset;
+        uint peerBits = 0;
+        uint totalBits = 0;
+        CountPeerBits(peerBits, totalBits, waveFlags, waveParts);
+        
+        for (uint k = 0; k < serialIterations; ++k)
+        {
+            if (getWaveIndex(gtid) % serialIterations == k)
+                offsets.o[i] = g_d[index] + peerBits;
+            
+            GroupMemoryBarrierWithGroupSync();
+            if (getWaveIndex(gtid) % serialIterations == k && peerBits == 0)
+                g_d[index] += totalBits;
+            GroupMemoryBarrierWithGroupSync();
+        }
+    }
+    
+    return offsets;
+}
+
+//Exclusive scan each digit down the histograms, leaving the
+//digit's total count in the first histogram
+inline void WaveHistExclusiveScanWide(uint gtid)
+{
+    for (uint i = gtid; i < RADIX; i += D_DIM)
+    {
+        uint histReduction = g_d[i];
+        for (uint j = i + RADIX; j < WaveHistsSizeWide(); j += RADIX)
+        {
+            histReduction += g_d[j];
+            g_d[j] = histReduction - g_d[j];
+        }
+        g_d[i] = histReduction;
+    }
+}
+
+//Exclusive scan of the digit totals, each thread scans its digits
+//serially, then the thread reductions are scanned across the waves.
+//The scanned totals are also returned for the device offsets.
+inline WideReductionStruct DigitReductionExclusiveScanWide(uint gtid)
+{
+    WideReductionStruct reductions;
+    uint threadReduction = 0;
+    [unroll]
+    for (uint i = 0, t = gtid * WIDE_DIGITS_PER_THREAD; i < WIDE_DIGITS_PER_THREAD; ++i, ++t)
+    {
+        reductions.r[i] = threadReduction;
+        threadReduction += g_d[t];
+    }
+    
+    uint prefix = WavePrefixSum(threadReduction);
+    GroupMemoryBarrierWithGroupSync();
+    if (WaveGetLaneIndex() == WaveGetLaneCount() - 1)
+        g_d[getWaveIndex(gtid)] = prefix + threadReduction;
+    GroupMemoryBarrierWithGroupSync();
+    
+    for (uint w = 0; w < getWaveIndex(gtid); ++w)
+        prefix += g_d[w];
+    GroupMemoryBarrierWithGroupSync();
+    
+    [unroll]
+    for (uint i = 0, t = gtid * WIDE_DIGITS_PER_THREAD; i < WIDE_DIGITS_PER_THREAD; ++i, ++t)
+    {
+        reductions.r[i] += prefix;
+        g_d[t] = reductions.r[i];
+    }
+    return reductions;
+}
+
+inline void UpdateOffsetsWide(
+    uint gtid,
+    uint serialIterations,
+    inout OffsetStruct offsets,
+    KeyStruct keys)
+{
+    if (gtid >= WaveGetLaneCount() * serialIterations)
+    {
+        const uint t = getWaveIndex(gtid) / serialIterations * RADIX;
+        [unroll]
+        for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        {
+            const uint t2 = ExtractDigit(keys.k[i]);
+            offsets.o[i] += g_d[t2 + t] + g_d[t2];
+        }
+    }
+    else
+    {
+        [unroll]
+        for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+            offsets.o[i] += g_d[ExtractDigit(keys.k[i])];
+    }
+}
+#endif
+
+//*****************************************************************************
+//SCATTERING: SHARED MEMORY STAGING
+//*****************************************************************************
+//Shared memory holds a single 32-bit word per element, so 64-bit elements
+//are staged in two phases. For keys, the word holding the current digit
+//goes first so that every thread can capture its digits, then the other
+//word follows and the key is reassembled in registers before the device
+//write. Digits never straddle the word boundary, see PassWidth.
+inline uint DigitWord(uint64_t key)
+{
+    return (uint)(e_radixShift >= 32 ? key >> 32 : key);
+}
+
+inline uint OtherWord(uint64_t key)
+{
+    return (uint)(e_radixShift >= 32 ? key : key >> 32);
+}
+
+inline uint64_t JoinWords(uint digitWord, uint otherWord)
+{
+    return e_radixShift >= 32 ?
+        (uint64_t)digitWord << 32 | otherWord :
+        (uint64_t)otherWord << 32 | digitWord;
+}
+
+inline uint ExtractDigitWord(uint digitWord)
+{
+    return digitWord >> (e_radixShift & 31) & DigitMask();
+}
+
 inline void ScatterKeysShared(OffsetStruct offsets, KeyStruct keys)
 {
     [unroll]
     for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        g_d[offsets.o[i]] = DigitWord(keys.k[i]);
+}
+
+inline void ScatterKeysSharedOtherWord(OffsetStruct offsets, KeyStruct keys)
+{
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        g_d[offsets.o[i]] = OtherWord(keys.k[i]);
+}
+
+//Read back the staged digit words, capturing the digits of the elements
+//this thread writes to device memory
+inline void LoadDigitWords(
+    uint gtid,
+    inout WordStruct words,
+    inout DigitStruct digits)
+{
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
     {
-        g_d[offsets.o[i]] = (uint)(keys.k[i] & (((uint64_t)1U << 32) - 1));
-        g_d_high[offsets.o[i]] = (uint)(keys.k[i] >> 32);
+        words.w[i] = g_d[t];
+        digits.d[i] = ExtractDigitWord(words.w[i]);
     }
 }
 
 inline uint DescendingIndex(uint deviceIndex)
 {
-    return e_numKeys - deviceIndex - 1;
+    return NumKeys() - deviceIndex - 1;
 }
 
-inline void WriteKey(uint deviceIndex, uint groupSharedIndex)
+//The final pass of a descending sort writes in reverse
+inline uint DeviceIndex(uint digit, uint groupSharedIndex)
+{
+    const uint deviceIndex = g_d[digit + PART_SIZE] + groupSharedIndex;
+#if defined(SHOULD_ASCEND)
+    return deviceIndex;
+#else
+    return IsFinalPass() ? DescendingIndex(deviceIndex) : deviceIndex;
+#endif
+}
+
+inline void WriteKey(uint deviceIndex, uint64_t key)
 {
 #if defined(KEY_UINT)
-b_alt[deviceIndex] = g_d[groupSharedIndex];
+    b_alt[deviceIndex] = (uint)key;
 #elif defined(KEY_INT)
-b_alt[deviceIndex] = UintToInt(g_d[groupSharedIndex]);
+    b_alt[deviceIndex] = UintToInt((uint)key);
 #elif defined(KEY_FLOAT)
-b_alt[deviceIndex] = UintToFloat(g_d[groupSharedIndex]);
+    b_alt[deviceIndex] = UintToFloat((uint)key);
 #elif defined(KEY_ULONG)
-b_alt[deviceIndex] = getGD(groupSharedIndex);
+    b_alt[deviceIndex] = key;
+#elif defined(KEY_LONG) || defined(KEY_DOUBLE)
+    b_alt[deviceIndex] = IsLastDispatchedPass() ? FromRadixKey(key) : key;
 #endif
 }
 
+#if defined(PAYLOAD_ULONG)
+inline void LoadPayload(inout uint64_t payload, uint deviceIndex)
+{
+    payload = b_sortPayload[deviceIndex];
+}
+
+//Low words first, then the high words, in the same two phases as the keys
+inline void ScatterPayloadsShared(OffsetStruct offsets, PayloadStruct payloads)
+{
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        g_d[offsets.o[i]] = (uint)payloads.k[i];
+}
+
+inline void ScatterPayloadsSharedHigh(OffsetStruct offsets, PayloadStruct payloads)
+{
+    [unroll]
+    for (uint i = 0; i < KEYS_PER_THREAD; ++i)
+        g_d[offsets.o[i]] = (uint)(payloads.k[i] >> 32);
+}
+
+inline void LoadPayloadLowWords(uint gtid, inout WordStruct words)
+{
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
+        words.w[i] = g_d[t];
+}
+#else
 inline void LoadPayload(inout uint payload, uint deviceIndex)
 {
 #if defined(PAYLOAD_UINT)
@@ -629,84 +1031,40 @@ inline void ScatterPayloadsShared(OffsetStruct offsets, PayloadStruct payloads)
         g_d[offsets.o[i]] = payloads.k[i];
     }
 }
+#endif
 
-inline void WritePayload(uint deviceIndex, uint groupSharedIndex)
+inline void WritePayload(uint deviceIndex, uint64_t payload)
 {
 #if defined(PAYLOAD_UINT)
-    b_altPayload[deviceIndex] = g_d[groupSharedIndex];
+    b_altPayload[deviceIndex] = (uint)payload;
 #elif defined(PAYLOAD_INT)
-    b_altPayload[deviceIndex] = asint(g_d[groupSharedIndex]);
+    b_altPayload[deviceIndex] = asint((uint)payload);
 #elif defined(PAYLOAD_FLOAT)
-    b_altPayload[deviceIndex] = asfloat(g_d[groupSharedIndex]);
+    b_altPayload[deviceIndex] = asfloat((uint)payload);
+#elif defined(PAYLOAD_ULONG)
+    b_altPayload[deviceIndex] = payload;
 #endif
 }
 
 //*****************************************************************************
 //SCATTERING: FULL PARTITIONS
 //*****************************************************************************
-//KEYS ONLY
-inline void ScatterKeysOnlyDeviceAscending(uint gtid)
-{
-    for (uint i = gtid; i < PART_SIZE; i += D_DIM)
-        // WriteKey(g_d[ExtractDigit(g_d[i]) + PART_SIZE] + i, i);
-        WriteKey(g_d[ExtractDigit(getGD(i)) + PART_SIZE] + i, i);
-}
-
-inline void ScatterKeysOnlyDeviceDescending(uint gtid)
-{
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        for (uint i = gtid; i < PART_SIZE; i += D_DIM)
-            // WriteKey(DescendingIndex(g_d[ExtractDigit(g_d[i]) + PART_SIZE] + i), i);
-            WriteKey(DescendingIndex(g_d[ExtractDigit(getGD(i)) + PART_SIZE] + i), i);
-    }
-    else
-    {
-        ScatterKeysOnlyDeviceAscending(gtid);
-    }
-}
-
-inline void ScatterKeysOnlyDevice(uint gtid)
-{
-#if defined(SHOULD_ASCEND)
-    ScatterKeysOnlyDeviceAscending(gtid);
-#else
-    ScatterKeysOnlyDeviceDescending(gtid);
-#endif
-}
-
-//KEY VALUE PAIRS
-inline void ScatterPairsKeyPhaseAscending(
+inline void ScatterKeysDevice(
     uint gtid,
+    OffsetStruct offsets,
+    KeyStruct keys,
     inout DigitStruct digits)
 {
+    WordStruct words;
+    LoadDigitWords(gtid, words, digits);
+    GroupMemoryBarrierWithGroupSync();
+    
+    ScatterKeysSharedOtherWord(offsets, keys);
+    GroupMemoryBarrierWithGroupSync();
+    
     [unroll]
     for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-    {
-        // digits.d[i] = ExtractDigit(g_d[t]);
-        digits.d[i] = ExtractDigit(getGD(t));
-        WriteKey(g_d[digits.d[i] + PART_SIZE] + t, t);
-    }
-}
-
-inline void ScatterPairsKeyPhaseDescending(
-    uint gtid,
-    inout DigitStruct digits)
-{
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        [unroll]
-        for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-        {
-            // digits.d[i] = ExtractDigit(g_d[t]);
-            digits.d[i] = ExtractDigit(getGD(t));
-            WriteKey(DescendingIndex(g_d[digits.d[i] + PART_SIZE] + t), t);
-        }
-    }
-    else
-    {
-        ScatterPairsKeyPhaseAscending(gtid, digits);
-    }
+        WriteKey(DeviceIndex(digits.d[i], t), JoinWords(words.w[i], g_d[t]));
 }
 
 inline void LoadPayloadsWGE16(
@@ -738,150 +1096,78 @@ inline void LoadPayloadsWLT16(
     }
 }
 
-inline void ScatterPayloadsAscending(uint gtid, DigitStruct digits)
-{
-    [unroll]
-    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-        WritePayload(g_d[digits.d[i] + PART_SIZE] + t, t);
-}
-
-inline void ScatterPayloadsDescending(uint gtid, DigitStruct digits)
-{
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        [unroll]
-        for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-            WritePayload(DescendingIndex(g_d[digits.d[i] + PART_SIZE] + t), t);
-    }
-    else
-    {
-        ScatterPayloadsAscending(gtid, digits);
-    }
-}
-
-inline void ScatterPairsDevice(
+inline void ScatterPayloadsDevice(
     uint gtid,
     uint partIndex,
-    OffsetStruct offsets)
+    OffsetStruct offsets,
+    DigitStruct digits)
 {
-    DigitStruct digits;
-#if defined(SHOULD_ASCEND)
-    ScatterPairsKeyPhaseAscending(gtid, digits);
-#else
-    ScatterPairsKeyPhaseDescending(gtid, digits);
-#endif
-    GroupMemoryBarrierWithGroupSync();
-    
     PayloadStruct payloads;
+#if defined(RADIX_11)
+    LoadPayloadsWLT16(gtid, partIndex, SerialIterationsWide(), payloads);
+#else
     if (WaveGetLaneCount() >= 16)
         LoadPayloadsWGE16(gtid, partIndex, payloads);
     else
         LoadPayloadsWLT16(gtid, partIndex, SerialIterations(), payloads);
+#endif
     ScatterPayloadsShared(offsets, payloads);
     GroupMemoryBarrierWithGroupSync();
     
-#if defined(SHOULD_ASCEND)
-    ScatterPayloadsAscending(gtid, digits);
+#if defined(PAYLOAD_ULONG)
+    WordStruct words;
+    LoadPayloadLowWords(gtid, words);
+    GroupMemoryBarrierWithGroupSync();
+    
+    ScatterPayloadsSharedHigh(offsets, payloads);
+    GroupMemoryBarrierWithGroupSync();
+    
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
+        WritePayload(DeviceIndex(digits.d[i], t), (uint64_t)g_d[t] << 32 | words.w[i]);
 #else
-    ScatterPayloadsDescending(gtid, digits);
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
+        WritePayload(DeviceIndex(digits.d[i], t), g_d[t]);
 #endif
 }
 
 inline void ScatterDevice(
     uint gtid,
     uint partIndex,
-    OffsetStruct offsets)
+    OffsetStruct offsets,
+    KeyStruct keys)
 {
+    DigitStruct digits;
+    ScatterKeysDevice(gtid, offsets, keys, digits);
 #if defined(SORT_PAIRS)
-    ScatterPairsDevice(
-        gtid,
-        partIndex,
-        offsets);
-#else
-    ScatterKeysOnlyDevice(gtid);
+    GroupMemoryBarrierWithGroupSync();
+    ScatterPayloadsDevice(gtid, partIndex, offsets, digits);
 #endif
 }
 
 //*****************************************************************************
 //SCATTERING: PARTIAL PARTITIONS
 //*****************************************************************************
-//KEYS ONLY
-inline void ScatterKeysOnlyDevicePartialAscending(uint gtid, uint finalPartSize)
-{
-    for (uint i = gtid; i < PART_SIZE; i += D_DIM)
-    {
-        if (i < finalPartSize)
-            // WriteKey(g_d[ExtractDigit(g_d[i]) + PART_SIZE] + i, i);
-            WriteKey(g_d[ExtractDigit(getGD(i)) + PART_SIZE] + i, i);
-    }
-}
-
-inline void ScatterKeysOnlyDevicePartialDescending(uint gtid, uint finalPartSize)
-{
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        for (uint i = gtid; i < PART_SIZE; i += D_DIM)
-        {
-            if (i < finalPartSize)
-                // WriteKey(DescendingIndex(g_d[ExtractDigit(g_d[i]) + PART_SIZE] + i), i);
-                WriteKey(DescendingIndex(g_d[ExtractDigit(getGD(i)) + PART_SIZE] + i), i);
-        }
-    }
-    else
-    {
-        ScatterKeysOnlyDevicePartialAscending(gtid, finalPartSize);
-    }
-}
-
-inline void ScatterKeysOnlyDevicePartial(uint gtid, uint partIndex)
-{
-    const uint finalPartSize = e_numKeys - partIndex * PART_SIZE;
-#if defined(SHOULD_ASCEND)
-    ScatterKeysOnlyDevicePartialAscending(gtid, finalPartSize);
-#else
-    ScatterKeysOnlyDevicePartialDescending(gtid, finalPartSize);
-#endif
-}
-
-//KEY VALUE PAIRS
-inline void ScatterPairsKeyPhaseAscendingPartial(
+inline void ScatterKeysDevicePartial(
     uint gtid,
     uint finalPartSize,
+    OffsetStruct offsets,
+    KeyStruct keys,
     inout DigitStruct digits)
 {
+    WordStruct words;
+    LoadDigitWords(gtid, words, digits);
+    GroupMemoryBarrierWithGroupSync();
+    
+    ScatterKeysSharedOtherWord(offsets, keys);
+    GroupMemoryBarrierWithGroupSync();
+    
     [unroll]
     for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
     {
         if (t < finalPartSize)
-        {
-            // digits.d[i] = ExtractDigit(g_d[t]);
-            digits.d[i] = ExtractDigit(getGD(t));
-            WriteKey(g_d[digits.d[i] + PART_SIZE] + t, t);
-        }
-    }
-}
-
-inline void ScatterPairsKeyPhaseDescendingPartial(
-    uint gtid,
-    uint finalPartSize,
-    inout DigitStruct digits)
-{
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        [unroll]
-        for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-        {
-            if (t < finalPartSize)
-            {
-                // digits.d[i] = ExtractDigit(g_d[t]);
-                digits.d[i] = ExtractDigit(getGD(t));
-                WriteKey(DescendingIndex(g_d[digits.d[i] + PART_SIZE] + t), t);
-            }
-        }
-    }
-    else
-    {
-        ScatterPairsKeyPhaseAscendingPartial(gtid, finalPartSize, digits);
+            WriteKey(DeviceIndex(digits.d[i], t), JoinWords(words.w[i], g_d[t]));
     }
 }
 
@@ -895,7 +1181,7 @@ inline void LoadPayloadsPartialWGE16(
         i < KEYS_PER_THREAD;
         ++i, t += WaveGetLaneCount())
     {
-        if (t < e_numKeys)
+        if (t < NumKeys())
             LoadPayload(payloads.k[i], t);
     }
 }
@@ -911,84 +1197,65 @@ inline void LoadPayloadsPartialWLT16(
         i < KEYS_PER_THREAD;
         ++i, t += WaveGetLaneCount() * serialIterations)
     {
-        if (t < e_numKeys)
+        if (t < NumKeys())
             LoadPayload(payloads.k[i], t);
     }
 }
 
-inline void ScatterPayloadsAscendingPartial(
-    uint gtid,
-    uint finalPartSize,
-    DigitStruct digits)
-{
-    [unroll]
-    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-    {
-        if (t < finalPartSize)
-            WritePayload(g_d[digits.d[i] + PART_SIZE] + t, t);
-    }
-}
-
-inline void ScatterPayloadsDescendingPartial(
+inline void ScatterPayloadsDevicePartial(
     uint gtid,
+    uint partIndex,
     uint finalPartSize,
+    OffsetStruct offsets,
     DigitStruct digits)
 {
-    if (e_radixShift == RADIX_LAST_BIT)
-    {
-        [unroll]
-        for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
-        {
-            if (t < finalPartSize)
-                WritePayload(DescendingIndex(g_d[digits.d[i] + PART_SIZE] + t), t);
-        }
-    }
-    else
-    {
-        ScatterPayloadsAscendingPartial(gtid, finalPartSize, digits);
-    }
-}
-
-inline void ScatterPairsDevicePartial(
-    uint gtid,
-    uint partIndex,
-    OffsetStruct offsets)
-{
-    DigitStruct digits;
-    const uint finalPartSize = e_numKeys - partIndex * PART_SIZE;
-#if defined(SHOULD_ASCEND)
-    ScatterPairsKeyPhaseAscendingPartial(gtid, finalPartSize, digits);
-#else
-    ScatterPairsKeyPhaseDescendingPartial(gtid, finalPartSize, digits);
-#endif
-    GroupMemoryBarrierWithGroupSync();
-    
     PayloadStruct payloads;
+#if defined(RADIX_11)
+    LoadPayloadsPartialWLT16(gtid, partIndex, SerialIterationsWide(), payloads);
+#else
     if (WaveGetLaneCount() >= 16)
         LoadPayloadsPartialWGE16(gtid, partIndex, payloads);
     else
         LoadPayloadsPartialWLT16(gtid, partIndex, SerialIterations(), payloads);
+#endif
     ScatterPayloadsShared(offsets, payloads);
     GroupMemoryBarrierWithGroupSync();
     
-#if defined(SHOULD_ASCEND)
-    ScatterPayloadsAscendingPartial(gtid, finalPartSize, digits);
+#if defined(PAYLOAD_ULONG)
+    WordStruct words;
+    LoadPayloadLowWords(gtid, words);
+    GroupMemoryBarrierWithGroupSync();
+    
+    ScatterPayloadsSharedHigh(offsets, payloads);
+    GroupMemoryBarrierWithGroupSync();
+    
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
+    {
+        if (t < finalPartSize)
+            WritePayload(DeviceIndex(digits.d[i], t), (uint64_t)g_d[t] << 32 | words.w[i]);
+    }
 #else
-    ScatterPayloadsDescendingPartial(gtid, finalPartSize, digits);
+    [unroll]
+    for (uint i = 0, t = gtid; i < KEYS_PER_THREAD; ++i, t += D_DIM)
+    {
+        if (t < finalPartSize)
+            WritePayload(DeviceIndex(digits.d[i], t), g_d[t]);
+    }
 #endif
 }
 
 inline void ScatterDevicePartial(
     uint gtid,
     uint partIndex,
-    OffsetStruct offsets)
+    OffsetStruct offsets,
+    KeyStruct keys)
 {
+    DigitStruct digits;
+    const uint finalPartSize = NumKeys() - partIndex * PART_SIZE;
+    ScatterKeysDevicePartial(gtid, finalPartSize, offsets, keys, digits);
 #if defined(SORT_PAIRS)
-    ScatterPairsDevicePartial(
-        gtid,
-        partIndex,
-        offsets);
-#else
-    ScatterKeysOnlyDevicePartial(gtid, partIndex);
+    GroupMemoryBarrierWithGroupSync();
+    ScatterPayloadsDevicePartial(gtid, partIndex, finalPartSize, offsets, digits);
 #endif
-}
\ No newline at end of file
+}
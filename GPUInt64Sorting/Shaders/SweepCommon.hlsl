@@ -0,0 +1,375 @@
+/******************************************************************************
+ * GPUSorting
+ *
+ * SPDX-License-Identifier: MIT
+ * Copyright Thomas Smith 4/28/2024
+ * https://github.com/b0nes164/GPUSorting
+ *
+ ******************************************************************************/
+//Compiler Defines
+//#define KEY_UINT KEY_INT KEY_FLOAT KEY_ULONG KEY_LONG KEY_DOUBLE
+//#define PAYLOAD_UINT PAYLOAD_INT PAYLOAD_FLOAT PAYLOAD_ULONG
+//#define SHOULD_ASCEND
+//#define SORT_PAIRS
+//#define ENABLE_16_BIT
+#include "SortCommon.hlsl"
+#include "GlobalHistogram.hlsl"
+
+// #pragma kernel InitSweep
+// #pragma kernel GlobalHistogram
+// #pragma kernel Scan
+
+#define FLAG_NOT_READY      0       //Flag value inidicating neither inclusive sum, nor reduction of a partition tile is ready
+#define FLAG_REDUCTION      1       //Flag value indicating reduction of a partition tile is ready
+#define FLAG_INCLUSIVE      2       //Flag value indicating inclusive sum of a partition tile is ready
+#define FLAG_MASK           3       //Mask used to retrieve flag values
+
+//How long a threadblock waits on a preceeding tile before falling back.
+//Hosts may lower it to force the fallback path under test.
+#if !defined(MAX_SPIN_COUNT)
+#define MAX_SPIN_COUNT      4
+#endif
+
+RWStructuredBuffer<uint> b_passHist;   //buffer used to store reduced sums of partition tiles
+RWStructuredBuffer<uint> b_index;      //buffer used to atomically assign partition tile indexes
+
+groupshared uint g_scan[RADIX];         //Shared memory for Scan
+
+inline uint CurrentPass()
+{
+    return e_radixShift >> 3;
+}
+
+inline uint PassHistOffset(uint index)
+{
+    return ((CurrentPass() * ThreadBlocks()) + index) << RADIX_LOG;
+}
+
+[numthreads(256, 1, 1)]
+void InitSweep(uint3 id : SV_DispatchThreadID)
+{
+    const uint increment = 256 * 256;
+    const uint clearEnd = ThreadBlocks() * RADIX * RADIX_PASSES;
+    for (uint i = id.x; i < clearEnd; i += increment)
+        b_passHist[i] = 0;
+
+    if (id.x < RADIX * RADIX_PASSES)
+        b_globalHist[id.x] = 0;
+
+    if (id.x < RADIX_PASSES)
+        b_index[id.x] = 0;
+}
+
+//*****************************************************************************
+//SCAN KERNEL
+//*****************************************************************************
+//One threadblock per digit pass, the exclusive prefix sums are posted as the
+//inclusive values of the first tile of the pass, seeding the lookback
+inline void LoadInclusiveScan(uint gtid, uint gid)
+{
+    const uint t = b_globalHist[gtid + gid * RADIX];
+    g_scan[gtid] = t + WavePrefixSum(t);
+}
+
+inline void GlobalHistExclusiveScanWGE16(uint gtid, uint gid)
+{
+    GroupMemoryBarrierWithGroupSync();
+    if (gtid < (RADIX / WaveGetLaneCount()))
+    {
+        g_scan[(gtid + 1) * WaveGetLaneCount() - 1] +=
+            WavePrefixSum(g_scan[(gtid + 1) * WaveGetLaneCount() - 1]);
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint laneMask = WaveGetLaneCount() - 1;
+    const uint index = (WaveGetLaneIndex() + 1 & laneMask) + (gtid & ~laneMask);
+    b_passHist[index + gid * RADIX * ThreadBlocks()] =
+        ((WaveGetLaneIndex() != laneMask ? g_scan[gtid] : 0) +
+        (gtid >= WaveGetLaneCount() ? WaveReadLaneAt(g_scan[gtid - 1], 0) : 0)) << 2 | FLAG_INCLUSIVE;
+}
+
+inline void GlobalHistExclusiveScanWLT16(uint gtid, uint gid)
+{
+    const uint passHistOffset = gid * RADIX * ThreadBlocks();
+    if (gtid < WaveGetLaneCount())
+    {
+        const uint circularLaneShift = WaveGetLaneIndex() + 1 &
+            WaveGetLaneCount() - 1;
+        b_passHist[circularLaneShift + passHistOffset] =
+            (circularLaneShift ? g_scan[gtid] : 0) << 2 | FLAG_INCLUSIVE;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    const uint laneLog = countbits(WaveGetLaneCount() - 1);
+    uint offset = laneLog;
+    uint j = WaveGetLaneCount();
+    for (; j < (RADIX >> 1); j <<= laneLog)
+    {
+        if (gtid < (RADIX >> offset))
+        {
+            g_scan[((gtid + 1) << offset) - 1] +=
+                WavePrefixSum(g_scan[((gtid + 1) << offset) - 1]);
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        if ((gtid & ((j << laneLog) - 1)) >= j)
+        {
+            if (gtid < (j << laneLog))
+            {
+                b_passHist[gtid + passHistOffset] =
+                    (WaveReadLaneAt(g_scan[((gtid >> offset) << offset) - 1], 0) +
+                    ((gtid & (j - 1)) ? g_scan[gtid - 1] : 0)) << 2 | FLAG_INCLUSIVE;
+            }
+            else
+            {
+                if ((gtid + 1) & (j - 1))
+                {
+                    g_scan[gtid] +=
+                        WaveReadLaneAt(g_scan[((gtid >> offset) << offset) - 1], 0);
+                }
+            }
+        }
+        offset += laneLog;
+    }
+    GroupMemoryBarrierWithGroupSync();
+
+    //If RADIX is not a power of lanecount
+    const uint index = gtid + j;
+    if (index < RADIX)
+    {
+        b_passHist[index + passHistOffset] =
+            (WaveReadLaneAt(g_scan[((index >> offset) << offset) - 1], 0) +
+            ((index & (j - 1)) ? g_scan[index - 1] : 0)) << 2 | FLAG_INCLUSIVE;
+    }
+}
+
+[numthreads(RADIX, 1, 1)]
+void Scan(uint3 gtid : SV_GroupThreadID, uint3 gid : SV_GroupID)
+{
+    LoadInclusiveScan(gtid.x, gid.x);
+
+    if (WaveGetLaneCount() >= 16)
+        GlobalHistExclusiveScanWGE16(gtid.x, gid.x);
+
+    if (WaveGetLaneCount() < 16)
+        GlobalHistExclusiveScanWLT16(gtid.x, gid.x);
+}
+
+//*****************************************************************************
+//DIGIT BINNING PASS KERNEL
+//*****************************************************************************
+inline void AssignPartitionTile(uint gtid, inout uint partitionIndex)
+{
+    if (!gtid)
+        InterlockedAdd(b_index[CurrentPass()], 1, g_d[D_TOTAL_SMEM - 1]);
+    GroupMemoryBarrierWithGroupSync();
+    partitionIndex = g_d[D_TOTAL_SMEM - 1];
+}
+
+inline void DeviceBroadcastReductionsWGE16(uint gtid, uint partIndex, uint histReduction)
+{
+    if (partIndex < ThreadBlocks() - 1)
+    {
+        InterlockedAdd(b_passHist[gtid + PassHistOffset(partIndex + 1)],
+            FLAG_REDUCTION | histReduction << 2);
+    }
+}
+
+inline void DeviceBroadcastReductionsWLT16(uint gtid, uint partIndex, uint histReduction)
+{
+    if (partIndex < ThreadBlocks() - 1)
+    {
+        InterlockedAdd(b_passHist[(gtid << 1) + PassHistOffset(partIndex + 1)],
+            FLAG_REDUCTION | (histReduction & 0xffff) << 2);
+
+        InterlockedAdd(b_passHist[(gtid << 1) + 1 + PassHistOffset(partIndex + 1)],
+            FLAG_REDUCTION | (histReduction >> 16 & 0xffff) << 2);
+    }
+}
+
+//With the fallback, a reduction may already have been posted by a
+//threadblock that gave up waiting, so the post must not add twice
+inline void CASDeviceBroadcastReductionsWGE16(uint gtid, uint partIndex, uint histReduction)
+{
+    if (partIndex < ThreadBlocks() - 1)
+    {
+        InterlockedCompareStore(b_passHist[gtid + PassHistOffset(partIndex + 1)], 0,
+            FLAG_REDUCTION | histReduction << 2);
+    }
+}
+
+inline void CASDeviceBroadcastReductionsWLT16(uint gtid, uint partIndex, uint histReduction)
+{
+    if (partIndex < ThreadBlocks() - 1)
+    {
+        InterlockedCompareStore(b_passHist[(gtid << 1) + PassHistOffset(partIndex + 1)], 0,
+            FLAG_REDUCTION | (histReduction & 0xffff) << 2);
+
+        InterlockedCompareStore(b_passHist[(gtid << 1) + 1 + PassHistOffset(partIndex + 1)], 0,
+            FLAG_REDUCTION | (histReduction >> 16 & 0xffff) << 2);
+    }
+}
+
+inline void Lookback(uint gtid, uint partIndex, uint exclusiveHistReduction)
+{
+    if (gtid < RADIX)
+    {
+        uint lookbackReduction = 0;
+        for (uint k = partIndex; k >= 0;)
+        {
+            const uint flagPayload = b_passHist[gtid + PassHistOffset(k)];
+            if ((flagPayload & FLAG_MASK) == FLAG_INCLUSIVE)
+            {
+                lookbackReduction += flagPayload >> 2;
+                if (partIndex < ThreadBlocks() - 1)
+                {
+                    InterlockedAdd(b_passHist[gtid + PassHistOffset(partIndex + 1)],
+                        1 | lookbackReduction << 2);
+                }
+                g_d[gtid + PART_SIZE] = lookbackReduction - exclusiveHistReduction;
+                break;
+            }
+
+            if ((flagPayload & FLAG_MASK) == FLAG_REDUCTION)
+            {
+                lookbackReduction += flagPayload >> 2;
+                k--;
+            }
+        }
+    }
+}
+
+//*****************************************************************************
+//DECOUPLED FALLBACK
+//*****************************************************************************
+//Without forward progress guarantees, a threadblock spinning on a tile whose
+//threadblock has not been scheduled can deadlock. Instead of waiting, the
+//stalled threadblock rebuilds the reduction of the tile it is waiting on and
+//posts it itself.
+inline void InitializeLookbackFallback(uint gtid)
+{
+    if (gtid == 0)
+        g_d[0] = 0;
+
+    if (gtid == 1)
+        g_d[1] = 0;
+}
+
+inline void FallbackHistogram(uint index)
+{
+    uint64_t key;
+    LoadKey(key, index);
+    InterlockedAdd(g_d[ExtractDigit(key) + RADIX], 1);
+}
+
+inline void LookbackWithFallback(uint gtid, uint partIndex, uint exclusiveHistReduction)
+{
+    uint spinCount = 0;
+    uint lookbackReduction = 0;
+    bool lookbackComplete = gtid < RADIX ? false : true;
+    bool warpLookbackComplete = gtid < RADIX ? false : true;
+    uint lookbackIndex = (gtid & RADIX_MASK) + PassHistOffset(partIndex);
+
+    while (g_d[0] < D_DIM / WaveGetLaneCount())
+    {
+        //Try to read the preceeding tiles
+        uint flagPayload = 0;
+        if (!warpLookbackComplete)
+        {
+            if (!lookbackComplete)
+            {
+                while (spinCount < MAX_SPIN_COUNT)
+                {
+                    flagPayload = b_passHist[lookbackIndex];
+                    if ((flagPayload & FLAG_MASK) > FLAG_NOT_READY)
+                        break;
+                    else
+                        spinCount++;
+                }
+            }
+
+            //Did we encounter any deadlocks?
+            if (WaveActiveAnyTrue(spinCount == MAX_SPIN_COUNT) && !WaveGetLaneIndex())
+                InterlockedOr(g_d[1], 1);
+        }
+        GroupMemoryBarrierWithGroupSync();
+
+        //Yes: fallback
+        if (g_d[1])
+        {
+            //The tile whose reduction lives at the slot being looked at
+            const uint fallbackTile = (lookbackIndex >> RADIX_LOG) - ThreadBlocks() * CurrentPass() - 1;
+            if (gtid < RADIX)
+                g_d[gtid + RADIX] = 0;
+            GroupMemoryBarrierWithGroupSync();
+            if (!gtid)
+                g_d[1] = 0;
+
+            const uint fallbackEnd = PART_SIZE * (fallbackTile + 1);
+            for (uint i = gtid + PART_SIZE * fallbackTile; i < fallbackEnd; i += D_DIM)
+                FallbackHistogram(i);
+            GroupMemoryBarrierWithGroupSync();
+
+            uint reduceOut = 0;
+            if (gtid < RADIX)
+            {
+                InterlockedCompareExchange(b_passHist[lookbackIndex], 0,
+                    FLAG_REDUCTION | g_d[gtid + RADIX] << 2, reduceOut);
+            }
+
+            if (!lookbackComplete)
+            {
+                if ((reduceOut & FLAG_MASK) == FLAG_INCLUSIVE)
+                {
+                    lookbackReduction += reduceOut >> 2;
+                    if (partIndex < ThreadBlocks() - 1)
+                    {
+                        InterlockedAdd(b_passHist[gtid + PassHistOffset(partIndex + 1)],
+                            1 | lookbackReduction << 2);
+                    }
+                    lookbackComplete = true;
+                }
+                else
+                {
+                    lookbackReduction += g_d[gtid + RADIX];
+                }
+            }
+
+            spinCount = 0;
+        }
+        else //No: proceed as normal
+        {
+            if (!lookbackComplete)
+            {
+                lookbackReduction += flagPayload >> 2;
+                if ((flagPayload & FLAG_MASK) == FLAG_INCLUSIVE)
+                {
+                    if (partIndex < ThreadBlocks() - 1)
+                    {
+                        InterlockedAdd(b_passHist[gtid + PassHistOffset(partIndex + 1)],
+                            1 | lookbackReduction << 2);
+                    }
+                    lookbackComplete = true;
+                }
+                else
+                {
+                    spinCount = 0;
+                }
+            }
+        }
+        lookbackIndex -= RADIX; //The threadblock lookbacks in lockstep.
+
+        //Have all digits completed their lookbacks?
+        if (!warpLookbackComplete)
+        {
+            warpLookbackComplete = WaveActiveAllTrue(lookbackComplete);
+            if (warpLookbackComplete && !WaveGetLaneIndex())
+                InterlockedAdd(g_d[0], 1);
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+
+    //Post results into shared memory
+    if (gtid < RADIX)
+        g_d[gtid + PART_SIZE] = lookbackReduction - exclusiveHistReduction;
+}
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Runtime checks for the vector builds of the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "CPUFeatures.h"
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#if defined(CPU_SORTING_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace CPUSorting
+{
+    bool HasCPUFeature(CPU_FEATURE feature)
+    {
+#if !defined(CPU_SORTING_X86)
+        (void)feature;
+        return false;
+#elif defined(_MSC_VER)
+        int info[4];
+        __cpuidex(info, 0, 0);
+        if (info[0] < 7)
+            return false;
+
+        __cpuidex(info, 1, 0);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        if (!osxsave)
+            return false;
+
+        //The OS has to save the ymm, and for AVX-512 the zmm, state
+        const unsigned long long xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        const bool zmmState = (xcr0 & 0xe6) == 0xe6;
+        switch (feature)
+        {
+        case CPU_FEATURE_AVX2:
+            return (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+        case CPU_FEATURE_AVX512F:
+            return zmmState && (info[1] & (1 << 16)) != 0;
+        case CPU_FEATURE_AVX512CD_VPOPCNTDQ:
+            return zmmState && (info[1] & (1 << 16)) != 0 &&
+                (info[1] & (1 << 28)) != 0 && (info[2] & (1 << 14)) != 0;
+        default:
+            return false;
+        }
+#else
+        __builtin_cpu_init();
+        switch (feature)
+        {
+        case CPU_FEATURE_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case CPU_FEATURE_AVX512F:
+            return __builtin_cpu_supports("avx512f");
+        case CPU_FEATURE_AVX512CD_VPOPCNTDQ:
+            return __builtin_cpu_supports("avx512f") &&
+                __builtin_cpu_supports("avx512cd") &&
+                __builtin_cpu_supports("avx512vpopcntdq");
+        default:
+            return false;
+        }
+#endif
+    }
+
+    size_t L2CacheBytes()
+    {
+        constexpr size_t fallbackBytes = 1 << 20;
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE)
+        const long bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        if (bytes > 0)
+            return (size_t)bytes;
+#endif
+        return fallbackBytes;
+    }
+}
@@ -0,0 +1,30 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Runtime checks for the vector builds of the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstddef>
+
+namespace CPUSorting
+{
+    enum CPU_FEATURE
+    {
+        CPU_FEATURE_AVX2 = 0,
+        CPU_FEATURE_AVX512F = 1,
+
+        //Conflict detection and the dword popcount, used by the multisplit
+        CPU_FEATURE_AVX512CD_VPOPCNTDQ = 2,
+    };
+
+    //Also checks that the OS saves the needed register state. Always
+    //false in builds without CPU_SORTING_X86.
+    bool HasCPUFeature(CPU_FEATURE feature);
+
+    //Per core L2 size as reported by the OS, or 1 MiB where it is not
+    //available, used to size cache resident work
+    size_t L2CacheBytes();
+}
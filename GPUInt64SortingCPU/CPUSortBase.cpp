@@ -0,0 +1,455 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Shared state of the CPU radix sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "CPUSortBase.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace CPUSorting
+{
+    CPUSortBase::CPUSortBase(ThreadPool& pool, const char* sortName, uint32_t partSize) :
+        k_sortName(sortName),
+        k_partSize(partSize),
+        m_pool(pool),
+        m_globalHist(RADIX * RADIX_PASSES),
+        m_threadHist((size_t)pool.ThreadCount() * HIST_REPLICAS * HIST_REPLICA_SIZE),
+        m_threadDiff(pool.ThreadCount())
+    {
+        if (partSize == 0)
+            throw std::invalid_argument("partSize must be non zero");
+        SetHistogramISA(SelectHistogramISA());
+        SetSmallSortISA(DetectSmallSortISA());
+    }
+
+    void CPUSortBase::SetHistogramISA(HISTOGRAM_ISA isa)
+    {
+        m_histogramISA = IsHistogramISASupported(isa) ? isa : HISTOGRAM_ISA_SCALAR;
+        m_histogramKernel = GetHistogramKernel(m_histogramISA);
+    }
+
+    void CPUSortBase::SetSmallSortISA(SMALL_SORT_ISA isa)
+    {
+        m_smallSortISA = IsSmallSortISASupported(isa) ? isa : SMALL_SORT_ISA_SCALAR;
+        m_smallSortKernel = GetSmallSortKernel(m_smallSortISA);
+    }
+
+    void CPUSortBase::SetSmallSortSize(uint32_t size)
+    {
+        if (size > SMALL_SORT_SIZE)
+            throw std::invalid_argument("smallSortSize must be at most SMALL_SORT_SIZE");
+        m_smallSortSize = size;
+    }
+
+    void CPUSortBase::SetPresortMaxRuns(uint32_t runs)
+    {
+        if (runs == 0)
+            throw std::invalid_argument("presortMaxRuns must be non zero");
+        m_presortMaxRuns = runs;
+    }
+
+    void CPUSortBase::ValidateBitWindow(uint32_t beginBit, uint32_t endBit)
+    {
+        if (beginBit >= endBit || endBit > KEY_BITS)
+            throw std::invalid_argument("Invalid bit window, expected beginBit < endBit <= 64");
+    }
+
+    //Every digit of every pass in a single read. Each thread accumulates
+    //into its own copies, in place of the shared memory atomics of the GPU.
+    //Masking the key with the window is the same as masking each digit.
+    void CPUSortBase::GlobalHistogram(
+        const uint64_t* toSort,
+        uint32_t numKeys,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        const uint64_t windowMask = KeyWindowMask(beginBit, endBit);
+        const uint32_t partitions = DivRoundUp(numKeys, G_HIST_PART_SIZE);
+        std::fill(m_threadHist.begin(), m_threadHist.end(), 0);
+        if (m_detectPresorted)
+        {
+            m_partDescents.resize(partitions);
+            m_partAscents.resize(partitions);
+        }
+
+        m_pool.ParallelFor(
+            partitions,
+            [&](uint32_t partitionIndex, uint32_t threadIndex)
+            {
+                const uint32_t start = partitionIndex * G_HIST_PART_SIZE;
+                const uint32_t count = std::min(numKeys - start, G_HIST_PART_SIZE);
+                m_histogramKernel(
+                    toSort + start,
+                    count,
+                    windowMask,
+                    &m_threadHist[(size_t)threadIndex * HIST_REPLICAS * HIST_REPLICA_SIZE]);
+
+                //The partition was just pulled into cache by the histogram,
+                //so the second look at it does not go back to memory
+                if (m_detectPresorted)
+                    CountPartitionDescents(toSort, partitionIndex, count, windowMask);
+            });
+
+        //Reduce, then exclusive scan each pass, as in GlobalHistScan
+        const uint32_t replicaCount = m_pool.ThreadCount() * HIST_REPLICAS;
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+        {
+            uint32_t reduction = 0;
+            for (uint32_t i = 0; i < RADIX; ++i)
+            {
+                uint32_t count = 0;
+                for (uint32_t r = 0; r < replicaCount; ++r)
+                    count += m_threadHist[(size_t)r * HIST_REPLICA_SIZE + pass * RADIX + i];
+                m_globalHist[pass * RADIX + i] = reduction;
+                reduction += count;
+            }
+        }
+    }
+
+    void CPUSortBase::CountPartitionDescents(
+        const uint64_t* toSort,
+        uint32_t partitionIndex,
+        uint32_t count,
+        uint64_t windowMask)
+    {
+        const uint32_t start = partitionIndex * G_HIST_PART_SIZE;
+        uint32_t descents = 0;
+        uint32_t ascents = 0;
+        uint64_t prev = toSort[start != 0 ? start - 1 : 0] & windowMask;
+        for (uint32_t i = start; i < start + count; ++i)
+        {
+            const uint64_t key = toSort[i] & windowMask;
+            descents += prev > key ? 1 : 0;
+            ascents += prev < key ? 1 : 0;
+            prev = key;
+        }
+        m_partDescents[partitionIndex] = descents;
+        m_partAscents[partitionIndex] = ascents;
+    }
+
+    void CPUSortBase::CountDescents(
+        const uint64_t* toSort,
+        uint32_t numKeys,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        const uint64_t windowMask = KeyWindowMask(beginBit, endBit);
+        const uint32_t partitions = DivRoundUp(numKeys, G_HIST_PART_SIZE);
+        m_partDescents.resize(partitions);
+        m_partAscents.resize(partitions);
+        m_pool.ParallelFor(
+            partitions,
+            [&](uint32_t partitionIndex, uint32_t)
+            {
+                const uint32_t start = partitionIndex * G_HIST_PART_SIZE;
+                CountPartitionDescents(toSort, partitionIndex, std::min(numKeys - start, G_HIST_PART_SIZE), windowMask);
+            });
+    }
+
+    uint32_t CPUSortBase::DifferingTop(
+        const uint64_t* keys,
+        uint32_t numKeys,
+        uint32_t beginBit,
+        uint32_t top)
+    {
+        const uint64_t first = keys[0];
+        std::fill(m_threadDiff.begin(), m_threadDiff.end(), 0);
+        m_pool.ParallelFor(
+            DivRoundUp(numKeys, G_HIST_PART_SIZE),
+            [&](uint32_t partitionIndex, uint32_t threadIndex)
+            {
+                const uint32_t start = partitionIndex * G_HIST_PART_SIZE;
+                const uint32_t end = std::min(numKeys - start, G_HIST_PART_SIZE) + start;
+                uint64_t diff = 0;
+                for (uint32_t i = start; i < end; ++i)
+                    diff |= keys[i] ^ first;
+                m_threadDiff[threadIndex] |= diff;
+            });
+
+        uint64_t diff = 0;
+        for (uint64_t d : m_threadDiff)
+            diff |= d;
+        return TopOfDiff(diff & KeyWindowMask(beginBit, top), beginBit);
+    }
+
+    //A pass is trivial when a single bin holds every key, making it an
+    //identity permutation. The final pass is kept when descending,
+    //because it performs the reversal.
+    uint32_t CPUSortBase::GetTrivialPassMask(
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit) const
+    {
+        uint32_t skipMask = 0;
+        const uint32_t passEnd = order == ORDER_ASCENDING ? endBit : (endBit - 1) & ~7U;
+        for (uint32_t radixShift = beginBit & ~7U; radixShift < passEnd; radixShift += RADIX_LOG)
+        {
+            const uint32_t passOffset = (radixShift >> 3) * RADIX;
+            for (uint32_t i = 0; i < RADIX; ++i)
+            {
+                const uint32_t next = i < RADIX - 1 ? m_globalHist[passOffset + i + 1] : numKeys;
+                if (next - m_globalHist[passOffset + i] == numKeys)
+                {
+                    skipMask |= 1U << (radixShift >> 3);
+                    break;
+                }
+            }
+        }
+
+        return skipMask;
+    }
+
+    //Copies src to dst, reversed if asked, over G_HIST_PART_SIZE partitions.
+    //src == dst reverses in place, swapping mirrored pairs.
+    template<bool sortPairs, typename P>
+    static void MirrorCopy(
+        ThreadPool& pool,
+        uint64_t* src,
+        P* srcPayload,
+        uint64_t* dst,
+        P* dstPayload,
+        uint32_t numKeys,
+        bool reverse)
+    {
+        const uint32_t count = src == dst ? numKeys / 2 : numKeys;
+        pool.ParallelFor(
+            DivRoundUp(count, G_HIST_PART_SIZE),
+            [&](uint32_t partitionIndex, uint32_t)
+            {
+                const uint32_t start = partitionIndex * G_HIST_PART_SIZE;
+                const uint32_t end = std::min(count - start, G_HIST_PART_SIZE) + start;
+                if (!reverse)
+                {
+                    memcpy(dst + start, src + start, (end - start) * sizeof(uint64_t));
+                    if (sortPairs)
+                        memcpy(dstPayload + start, srcPayload + start, (end - start) * sizeof(P));
+                    return;
+                }
+
+                for (uint32_t i = start; i < end; ++i)
+                {
+                    const uint32_t mirror = numKeys - i - 1;
+                    if (src == dst)
+                    {
+                        std::swap(dst[i], dst[mirror]);
+                        if (sortPairs)
+                            std::swap(dstPayload[i], dstPayload[mirror]);
+                    }
+                    else
+                    {
+                        dst[mirror] = src[i];
+                        if (sortPairs)
+                            dstPayload[mirror] = srcPayload[i];
+                    }
+                }
+            });
+    }
+
+    //Keys of a before the split of diagonal d in the merge of a and b,
+    //ties go to a so the merge is stable
+    static uint32_t MergeSplit(
+        const uint64_t* a,
+        uint32_t aCount,
+        const uint64_t* b,
+        uint32_t bCount,
+        uint32_t d,
+        uint64_t windowMask)
+    {
+        uint32_t low = d > bCount ? d - bCount : 0;
+        uint32_t high = std::min(d, aCount);
+        while (low < high)
+        {
+            const uint32_t mid = (low + high) / 2;
+            if ((a[mid] & windowMask) <= (b[d - mid - 1] & windowMask))
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return low;
+    }
+
+    //Sorted input returns, input sorted the other way round is mirrored,
+    //and a few ascending runs are merged pairwise. Each merge of two runs
+    //is cut into G_HIST_PART_SIZE pieces of output along the merge path,
+    //so the last round still spreads over the whole pool. Descending
+    //order mirrors the ascending result, like DescendingIndex.
+    template<bool sortPairs, typename P>
+    bool CPUSortBase::SortPresorted(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        m_presortStats = PresortStats();
+        if (!m_detectPresorted)
+            return false;
+
+        for (size_t p = 0; p < m_partDescents.size(); ++p)
+        {
+            m_presortStats.descents += m_partDescents[p];
+            m_presortStats.ascents += m_partAscents[p];
+        }
+        m_presortStats.runs = m_presortStats.descents + 1;
+
+        //Equal neighbours keep their input order ascending, and are
+        //mirrored descending, so only a strict descent can be reversed
+        const bool descending = order == ORDER_DESCENDING;
+        const bool strictlyDescending = m_presortStats.descents == numKeys - 1;
+        if (m_presortStats.descents == 0 || strictlyDescending)
+        {
+            const bool reverse = descending != strictlyDescending;
+            m_presortStats.path = reverse ? PRESORT_REVERSED : PRESORT_SORTED;
+            if (reverse)
+                MirrorCopy<sortPairs>(m_pool, toSort, toSortPayload, toSort, toSortPayload, numKeys, true);
+            return true;
+        }
+
+        if (m_presortStats.runs > m_presortMaxRuns || alt == nullptr)
+            return false;
+        m_presortStats.path = PRESORT_MERGED;
+
+        //Only the partitions holding a descent are read again
+        const uint64_t windowMask = KeyWindowMask(beginBit, endBit);
+        m_runStarts.assign(1, 0);
+        for (uint32_t p = 0; p < (uint32_t)m_partDescents.size(); ++p)
+        {
+            if (m_partDescents[p] == 0)
+                continue;
+
+            const uint32_t start = std::max(p * G_HIST_PART_SIZE, 1U);
+            const uint32_t end = std::min(numKeys - p * G_HIST_PART_SIZE, G_HIST_PART_SIZE) + p * G_HIST_PART_SIZE;
+            for (uint32_t i = start; i < end; ++i)
+            {
+                if ((toSort[i - 1] & windowMask) > (toSort[i] & windowMask))
+                    m_runStarts.push_back(i);
+            }
+        }
+        m_runStarts.push_back(numKeys);
+
+        uint64_t* src = toSort;
+        uint64_t* dst = alt;
+        P* srcPayload = toSortPayload;
+        P* dstPayload = altPayload;
+        while (m_runStarts.size() > 2)
+        {
+            //A task is a pair of runs and the output offset of its piece
+            const uint32_t runs = (uint32_t)m_runStarts.size() - 1;
+            m_mergeTasks.clear();
+            for (uint32_t r = 0; r < runs; r += 2)
+            {
+                const uint32_t end = m_runStarts[std::min(r + 2, runs)];
+                for (uint32_t out = m_runStarts[r]; out < end; out += std::min(end - out, G_HIST_PART_SIZE))
+                {
+                    m_mergeTasks.push_back(r);
+                    m_mergeTasks.push_back(out);
+                }
+            }
+
+            m_pool.ParallelFor(
+                (uint32_t)m_mergeTasks.size() / 2,
+                [&](uint32_t taskIndex, uint32_t)
+                {
+                    const uint32_t r = m_mergeTasks[taskIndex * 2];
+                    const uint32_t out = m_mergeTasks[taskIndex * 2 + 1];
+                    const uint32_t aStart = m_runStarts[r];
+                    const uint32_t bStart = m_runStarts[std::min(r + 1, runs)];
+                    const uint32_t end = m_runStarts[std::min(r + 2, runs)];
+                    const uint32_t aCount = bStart - aStart;
+                    const uint32_t bCount = end - bStart;
+                    const uint32_t d = out - aStart;
+                    const uint32_t outCount = std::min(end - out, G_HIST_PART_SIZE);
+
+                    uint32_t i = MergeSplit(src + aStart, aCount, src + bStart, bCount, d, windowMask);
+                    uint32_t j = d - i;
+                    for (uint32_t k = out; k < out + outCount; ++k)
+                    {
+                        const bool takeA = j == bCount ||
+                            (i < aCount && (src[aStart + i] & windowMask) <= (src[bStart + j] & windowMask));
+                        const uint32_t index = takeA ? aStart + i++ : bStart + j++;
+                        dst[k] = src[index];
+                        if (sortPairs)
+                            dstPayload[k] = srcPayload[index];
+                    }
+                });
+
+            for (uint32_t r = 2; r < runs; r += 2)
+                m_runStarts[r / 2] = m_runStarts[r];
+            m_runStarts[(runs + 1) / 2] = numKeys;
+            m_runStarts.resize((runs + 1) / 2 + 1);
+
+            std::swap(src, dst);
+            if (sortPairs)
+                std::swap(srcPayload, dstPayload);
+        }
+
+        if (src != toSort || descending)
+            MirrorCopy<sortPairs>(m_pool, src, srcPayload, toSort, toSortPayload, numKeys, descending);
+        return true;
+    }
+
+    //The kernel orders the windowed keys with their input index as the
+    //tie break, which is the stable order of the radix passes. The
+    //original keys and payloads are then gathered through the indices,
+    //mirrored when descending, like DescendingIndex.
+    template<bool sortPairs, typename P>
+    bool CPUSortBase::SortSmall(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        if (numKeys > m_smallSortSize)
+            return false;
+
+        const uint64_t windowMask = KeyWindowMask(beginBit, endBit);
+        for (uint32_t i = 0; i < numKeys; ++i)
+        {
+            m_smallKeys[i] = toSort[i] & windowMask;
+            m_smallIndices[i] = i;
+        }
+        m_smallSortKernel(m_smallKeys, m_smallIndices, numKeys);
+
+        uint64_t keys[SMALL_SORT_SIZE];
+        P payloads[SMALL_SORT_SIZE];
+        for (uint32_t i = 0; i < numKeys; ++i)
+        {
+            const uint32_t deviceIndex = order == ORDER_ASCENDING ? i : numKeys - i - 1;
+            keys[deviceIndex] = toSort[m_smallIndices[i]];
+            if (sortPairs)
+                payloads[deviceIndex] = toSortPayload[m_smallIndices[i]];
+        }
+
+        memcpy(toSort, keys, numKeys * sizeof(uint64_t));
+        if (sortPairs)
+            memcpy(toSortPayload, payloads, numKeys * sizeof(P));
+        return true;
+    }
+
+    template bool CPUSortBase::SortPresorted<false, uint32_t>(
+        uint64_t*, uint32_t*, uint64_t*, uint32_t*, uint32_t, ORDER, uint32_t, uint32_t);
+    template bool CPUSortBase::SortPresorted<true, uint32_t>(
+        uint64_t*, uint32_t*, uint64_t*, uint32_t*, uint32_t, ORDER, uint32_t, uint32_t);
+    template bool CPUSortBase::SortPresorted<true, uint64_t>(
+        uint64_t*, uint64_t*, uint64_t*, uint64_t*, uint32_t, ORDER, uint32_t, uint32_t);
+
+    template bool CPUSortBase::SortSmall<false, uint32_t>(
+        uint64_t*, uint32_t*, uint32_t, ORDER, uint32_t, uint32_t);
+    template bool CPUSortBase::SortSmall<true, uint32_t>(
+        uint64_t*, uint32_t*, uint32_t, ORDER, uint32_t, uint32_t);
+    template bool CPUSortBase::SortSmall<true, uint64_t>(
+        uint64_t*, uint64_t*, uint32_t, ORDER, uint32_t, uint32_t);
+}
@@ -0,0 +1,221 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Shared state of the CPU radix sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Histogram.h"
+#include "SmallSort.h"
+#include "SortCommon.h"
+#include "ThreadPool.h"
+
+namespace CPUSorting
+{
+    //Pre-sortedness of the last sort's windowed keys, counted between
+    //neighbours during the global histogram read, or in a read of its
+    //own by the sorts that build no global histogram
+    struct PresortStats
+    {
+        PRESORT_PATH path = PRESORT_NONE;
+
+        //Neighbours where the key goes down, and where it goes up
+        uint32_t descents = 0;
+        uint32_t ascents = 0;
+
+        //Ascending runs, descents + 1
+        uint32_t runs = 0;
+    };
+
+    class CPUSortBase
+    {
+    protected:
+        const char* k_sortName;
+        const uint32_t k_partSize;
+        ThreadPool& m_pool;
+
+        bool m_skipTrivialPasses = false;
+        uint32_t m_skippedPasses = 0;
+
+        bool m_detectPresorted = false;
+        uint32_t m_presortMaxRuns = PRESORT_MAX_RUNS;
+        PresortStats m_presortStats;
+
+        //Descents and ascents of each G_HIST_PART_SIZE partition, including
+        //the one between its first key and the last key of the partition
+        //before it
+        std::vector<uint32_t> m_partDescents;
+        std::vector<uint32_t> m_partAscents;
+
+        //Start of every ascending run then numKeys, for the merge path
+        std::vector<uint32_t> m_runStarts;
+        std::vector<uint32_t> m_mergeTasks;
+
+        //Exclusive prefix sums of every digit of every pass
+        std::vector<uint32_t> m_globalHist;
+
+        //HIST_REPLICAS global histograms per pool thread, reduced after the read
+        std::vector<uint32_t> m_threadHist;
+
+        //Bits where a key differs from the first one, per pool thread
+        std::vector<uint64_t> m_threadDiff;
+
+        HISTOGRAM_ISA m_histogramISA;
+        HistogramKernel m_histogramKernel;
+
+        uint32_t m_smallSortSize = SMALL_SORT_SIZE;
+        SMALL_SORT_ISA m_smallSortISA;
+        SmallSortKernel m_smallSortKernel;
+
+        //Windowed keys and input indices for the small sort kernel
+        uint64_t m_smallKeys[SMALL_SORT_SIZE];
+        uint64_t m_smallIndices[SMALL_SORT_SIZE];
+
+        CPUSortBase(ThreadPool& pool, const char* sortName, uint32_t partSize);
+
+        static void ValidateBitWindow(uint32_t beginBit, uint32_t endBit);
+
+        void GlobalHistogram(
+            const uint64_t* toSort,
+            uint32_t numKeys,
+            uint32_t beginBit,
+            uint32_t endBit);
+
+        //The descents of GlobalHistogram in a read of their own, for the
+        //sorts that build no global histogram
+        void CountDescents(
+            const uint64_t* toSort,
+            uint32_t numKeys,
+            uint32_t beginBit,
+            uint32_t endBit);
+
+        void CountPartitionDescents(
+            const uint64_t* toSort,
+            uint32_t partitionIndex,
+            uint32_t count,
+            uint64_t windowMask);
+
+        //Leading bits every key shares can never split a range. Returns one
+        //above the highest bit in [beginBit, top) where two keys differ, or
+        //beginBit if all keys are equal in that window.
+        uint32_t DifferingTop(
+            const uint64_t* keys,
+            uint32_t numKeys,
+            uint32_t beginBit,
+            uint32_t top);
+
+        uint32_t GetTrivialPassMask(
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit) const;
+
+        //After GlobalHistogram or CountDescents, finishes the sort without
+        //radix passes if the counted neighbours allow it and returns true.
+        //The output is the same as the radix sort's, equal keys included.
+        //A null alt rules out the merge path, sorted and reversed input
+        //are still finished in place.
+        template<bool sortPairs, typename P>
+        bool SortPresorted(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+
+        //Sorts inputs of at most SmallSortSize keys on the calling thread
+        //and returns true. The output is the same as the radix sort's,
+        //equal keys included.
+        template<bool sortPairs, typename P>
+        bool SortSmall(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+
+    public:
+        virtual ~CPUSortBase() = default;
+
+        const char* SortName() const { return k_sortName; }
+
+        //Skips passes where a single digit holds every key. The CPU already
+        //has the global histogram in memory, so this costs no readback.
+        bool SkipTrivialPasses() const { return m_skipTrivialPasses; }
+        void SetSkipTrivialPasses(bool skip) { m_skipTrivialPasses = skip; }
+
+        //Defaults to SelectHistogramISA. Requesting an unsupported
+        //build falls back to scalar.
+        HISTOGRAM_ISA HistogramISA() const { return m_histogramISA; }
+        void SetHistogramISA(HISTOGRAM_ISA isa);
+
+        //Inputs of at most this many keys skip the histogram, the passes
+        //and the pool, and go through a single sorting network. 0 disables
+        //it, the largest accepted is SMALL_SORT_SIZE.
+        uint32_t SmallSortSize() const { return m_smallSortSize; }
+        void SetSmallSortSize(uint32_t size);
+
+        //Defaults to DetectSmallSortISA. Requesting an unsupported
+        //build falls back to scalar.
+        SMALL_SORT_ISA SmallSortISA() const { return m_smallSortISA; }
+        void SetSmallSortISA(SMALL_SORT_ISA isa);
+
+        //Number of passes skipped by the last sort
+        uint32_t SkippedPasses() const { return m_skippedPasses; }
+
+        //Counts descents while the global histogram is read, and finishes
+        //sorted, reversed, or few run input without radix passes. The MSD
+        //sorts count in an extra read, and the in place sort has no alt
+        //buffer to merge runs into, so it only finishes sorted and
+        //reversed input.
+        bool DetectPresorted() const { return m_detectPresorted; }
+        void SetDetectPresorted(bool detect) { m_detectPresorted = detect; }
+
+        //Most ascending runs sent to the merge path, 1 disables it
+        uint32_t PresortMaxRuns() const { return m_presortMaxRuns; }
+        void SetPresortMaxRuns(uint32_t runs);
+
+        const PresortStats& LastPresortStats() const { return m_presortStats; }
+
+        //RADIX * RADIX_PASSES exclusive prefix sums of the last sort,
+        //matching b_globalHist after the GlobalHistScan
+        const std::vector<uint32_t>& GlobalHist() const { return m_globalHist; }
+
+        //The sorted keys always land back in toSort, alt is scratch
+        virtual void Sort(
+            uint64_t* toSort,
+            uint64_t* alt,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) = 0;
+
+        virtual void Sort(
+            uint64_t* toSort,
+            uint32_t* toSortPayload,
+            uint64_t* alt,
+            uint32_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) = 0;
+
+        virtual void Sort(
+            uint64_t* toSort,
+            uint64_t* toSortPayload,
+            uint64_t* alt,
+            uint64_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) = 0;
+    };
+}
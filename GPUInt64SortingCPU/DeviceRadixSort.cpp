@@ -0,0 +1,484 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * CPU DeviceRadixSort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "DeviceRadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(CPU_SORTING_X86)
+#include <emmintrin.h>
+#endif
+
+namespace CPUSorting
+{
+    //Position of a key's address within its cache line
+    static uint32_t LineSlot(const uint64_t* p)
+    {
+        return (uint32_t)((uintptr_t)p / sizeof(uint64_t)) & (WC_LINE_KEYS - 1);
+    }
+
+    //Non-temporal stores bypass the cache, so a scatter over many lines
+    //neither evicts the input nor reads in the destination lines first.
+    //Falls back to a plain copy on unaligned destinations and non-x86.
+    static void StreamCopy(void* dst, const void* src, size_t size)
+    {
+#if defined(CPU_SORTING_X86)
+        if (((uintptr_t)dst & 15) == 0)
+        {
+            for (size_t i = 0; i < size; i += 16)
+            {
+                _mm_stream_si128(
+                    reinterpret_cast<__m128i*>(static_cast<char*>(dst) + i),
+                    _mm_load_si128(reinterpret_cast<const __m128i*>(static_cast<const char*>(src) + i)));
+            }
+            return;
+        }
+#endif
+        memcpy(dst, src, size);
+    }
+
+    DeviceRadixSort::DeviceRadixSort(ThreadPool& pool, uint32_t partSize) :
+        CPUSortBase(pool, "DeviceRadixSort", partSize)
+    {
+        SetRankISA(DetectRankISA());
+    }
+
+    void DeviceRadixSort::SetRankISA(RANK_ISA isa)
+    {
+        m_rankISA = IsRankISASupported(isa) ? isa : RANK_ISA_SCALAR;
+        m_rankKernel = GetRankKernel(m_rankISA);
+    }
+
+    void DeviceRadixSort::Upsweep(
+        const uint64_t* toSort,
+        uint32_t numKeys,
+        uint32_t threadBlocks,
+        uint32_t radixShift,
+        uint32_t digitMask)
+    {
+        m_pool.ParallelFor(
+            threadBlocks,
+            [&](uint32_t partitionIndex, uint32_t)
+            {
+                uint32_t hist[RADIX] = {};
+                const uint32_t start = partitionIndex * k_partSize;
+                const uint32_t end = std::min(numKeys - start, k_partSize) + start;
+                for (uint32_t i = start; i < end; ++i)
+                    hist[(uint32_t)(toSort[i] >> radixShift) & digitMask]++;
+
+                for (uint32_t i = 0; i < RADIX; ++i)
+                    m_passHist[(size_t)i * threadBlocks + partitionIndex] = hist[i];
+            });
+    }
+
+    //One task per digit, exclusive scan across the tiles, seeded with
+    //the digit's global offset so the downsweep can scatter directly
+    void DeviceRadixSort::Scan(uint32_t threadBlocks, uint32_t radixShift)
+    {
+        const uint32_t passOffset = (radixShift >> 3) * RADIX;
+        m_pool.ParallelFor(
+            RADIX,
+            [&](uint32_t digit, uint32_t)
+            {
+                uint32_t* passHist = &m_passHist[(size_t)digit * threadBlocks];
+                uint32_t reduction = m_globalHist[passOffset + digit];
+                for (uint32_t i = 0; i < threadBlocks; ++i)
+                {
+                    const uint32_t t = passHist[i];
+                    passHist[i] = reduction;
+                    reduction += t;
+                }
+            });
+    }
+
+    //Walking the tile in order keeps the scatter stable. On the final
+    //pass of a descending sort, the index is mirrored, see DescendingIndex.
+    template<bool sortPairs, typename P>
+    void DeviceRadixSort::Downsweep(
+        const uint64_t* toSort,
+        const P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        uint32_t threadBlocks,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        bool shouldReverse)
+    {
+        m_pool.ParallelFor(
+            threadBlocks,
+            [&](uint32_t partitionIndex, uint32_t)
+            {
+                uint32_t offsets[RADIX];
+                for (uint32_t i = 0; i < RADIX; ++i)
+                    offsets[i] = m_passHist[(size_t)i * threadBlocks + partitionIndex];
+
+                const uint32_t start = partitionIndex * k_partSize;
+                const uint32_t end = std::min(numKeys - start, k_partSize) + start;
+                for (uint32_t i = start; i < end; ++i)
+                {
+                    const uint64_t key = toSort[i];
+                    uint32_t deviceIndex = offsets[(uint32_t)(key >> radixShift) & digitMask]++;
+                    if (shouldReverse)
+                        deviceIndex = numKeys - deviceIndex - 1;
+
+                    alt[deviceIndex] = key;
+                    if (sortPairs)
+                        altPayload[deviceIndex] = toSortPayload[i];
+                }
+            });
+    }
+
+    //Ranks the tile, places it in digit order in the thread's buffer, then
+    //writes each digit's run to its destination in one go, so the stores
+    //to alt are sequential instead of spread over up to RADIX streams
+    template<bool sortPairs, typename P>
+    void DeviceRadixSort::DownsweepShared(
+        const uint64_t* toSort,
+        const P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        uint32_t threadBlocks,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        bool shouldReverse)
+    {
+        static_assert(sizeof(P) <= sizeof(uint64_t), "Payloads are staged in 64-bit slots");
+        m_pool.ParallelFor(
+            threadBlocks,
+            [&](uint32_t partitionIndex, uint32_t threadIndex)
+            {
+                const size_t scratchOffset = (size_t)threadIndex * k_partSize;
+                uint64_t* sharedKeys = &m_sharedKeys[scratchOffset];
+                P* sharedPayloads = reinterpret_cast<P*>(&m_sharedPayloads[scratchOffset]);
+                uint32_t* ranks = &m_ranks[scratchOffset];
+
+                const uint32_t start = partitionIndex * k_partSize;
+                const uint32_t count = std::min(numKeys - start, k_partSize);
+                uint32_t hist[RADIX] = {};
+                m_rankKernel(toSort + start, count, radixShift, digitMask, hist, ranks);
+
+                uint32_t localOffsets[RADIX];
+                uint32_t reduction = 0;
+                for (uint32_t i = 0; i < RADIX; ++i)
+                {
+                    localOffsets[i] = reduction;
+                    reduction += hist[i];
+                }
+
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    const uint64_t key = toSort[start + i];
+                    const uint32_t sharedIndex = localOffsets[(uint32_t)(key >> radixShift) & digitMask] + ranks[i];
+                    sharedKeys[sharedIndex] = key;
+                    if (sortPairs)
+                        sharedPayloads[sharedIndex] = toSortPayload[start + i];
+                }
+
+                for (uint32_t i = 0; i < RADIX; ++i)
+                {
+                    if (hist[i] == 0)
+                        continue;
+
+                    const uint32_t deviceIndex = m_passHist[(size_t)i * threadBlocks + partitionIndex];
+                    if (!shouldReverse)
+                    {
+                        memcpy(alt + deviceIndex, sharedKeys + localOffsets[i], hist[i] * sizeof(uint64_t));
+                        if (sortPairs)
+                            memcpy(altPayload + deviceIndex, sharedPayloads + localOffsets[i], hist[i] * sizeof(P));
+                        continue;
+                    }
+
+                    for (uint32_t k = 0; k < hist[i]; ++k)
+                    {
+                        const uint32_t reversedIndex = numKeys - (deviceIndex + k) - 1;
+                        alt[reversedIndex] = sharedKeys[localOffsets[i] + k];
+                        if (sortPairs)
+                            altPayload[reversedIndex] = sharedPayloads[localOffsets[i] + k];
+                    }
+                }
+            });
+    }
+
+    //Each task scatters a chunk of consecutive tiles. A digit's runs of
+    //neighbouring tiles are neighbours in alt too, so a chunk writes one
+    //run per digit and its keys are staged in a line that mirrors the
+    //destination cache line. A line is flushed when its last slot fills,
+    //which is whole unless the run started inside it. Only the chunk's
+    //first and last line of each run are written with plain stores.
+    template<bool sortPairs, typename P>
+    void DeviceRadixSort::DownsweepWriteCombining(
+        const uint64_t* toSort,
+        const P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        uint32_t threadBlocks,
+        uint32_t radixShift,
+        uint32_t digitMask)
+    {
+        static_assert(sizeof(P) <= sizeof(uint64_t), "Payloads are staged in 64-bit slots");
+        const uint32_t tilesPerChunk = std::max(WC_CHUNK_SIZE / k_partSize, 1U);
+        m_pool.ParallelFor(
+            DivRoundUp(threadBlocks, tilesPerChunk),
+            [&](uint32_t chunkIndex, uint32_t threadIndex)
+            {
+                StagingLine* keyLines = &m_stagingKeys[(size_t)threadIndex * RADIX];
+                StagingLine* payloadLines = sortPairs ?
+                    &m_stagingPayloads[(size_t)threadIndex * RADIX] : nullptr;
+                WriteCombiningStats stats;
+
+                //offsets is where the next key of a digit goes, lineStart
+                //where the keys staged in its line begin
+                const uint32_t firstTile = chunkIndex * tilesPerChunk;
+                uint32_t offsets[RADIX];
+                uint32_t lineStart[RADIX];
+                for (uint32_t i = 0; i < RADIX; ++i)
+                {
+                    offsets[i] = m_passHist[(size_t)i * threadBlocks + firstTile];
+                    lineStart[i] = offsets[i];
+                }
+
+                auto flush = [&](uint32_t digit, uint32_t from, uint32_t to)
+                {
+                    const uint32_t count = to - from;
+                    const uint32_t slot = LineSlot(alt + from);
+                    if (count == WC_LINE_KEYS)
+                    {
+                        StreamCopy(alt + from, keyLines[digit].slots, sizeof(StagingLine));
+                        if (sortPairs)
+                            StreamCopy(altPayload + from, payloadLines[digit].slots, WC_LINE_KEYS * sizeof(P));
+                        stats.streamedLines++;
+                        return;
+                    }
+
+                    memcpy(alt + from, keyLines[digit].slots + slot, count * sizeof(uint64_t));
+                    if (sortPairs)
+                    {
+                        const P* staged = reinterpret_cast<const P*>(payloadLines[digit].slots);
+                        memcpy(altPayload + from, staged + slot, count * sizeof(P));
+                    }
+                    stats.partialFlushes++;
+                };
+
+                const uint32_t start = firstTile * k_partSize;
+                const uint32_t end = (uint32_t)std::min((uint64_t)numKeys,
+                    (uint64_t)(firstTile + tilesPerChunk) * k_partSize);
+                for (uint32_t i = start; i < end; ++i)
+                {
+                    const uint64_t key = toSort[i];
+                    const uint32_t digit = (uint32_t)(key >> radixShift) & digitMask;
+                    const uint32_t deviceIndex = offsets[digit]++;
+                    const uint32_t slot = LineSlot(alt + deviceIndex);
+                    keyLines[digit].slots[slot] = key;
+                    if (sortPairs)
+                        reinterpret_cast<P*>(payloadLines[digit].slots)[slot] = toSortPayload[i];
+
+                    if (slot == WC_LINE_KEYS - 1)
+                    {
+                        flush(digit, lineStart[digit], deviceIndex + 1);
+                        lineStart[digit] = deviceIndex + 1;
+                    }
+                }
+
+                for (uint32_t i = 0; i < RADIX; ++i)
+                {
+                    if (lineStart[i] != offsets[i])
+                        flush(i, lineStart[i], offsets[i]);
+                }
+
+                m_threadFlushStats[threadIndex].streamedLines += stats.streamedLines;
+                m_threadFlushStats[threadIndex].partialFlushes += stats.partialFlushes;
+
+                //Streaming stores are weakly ordered, make them visible
+                //before the next pass reads alt on another thread
+#if defined(CPU_SORTING_X86)
+                _mm_sfence();
+#endif
+            });
+    }
+
+    template<bool sortPairs, typename P>
+    void DeviceRadixSort::Dispatch(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        ValidateBitWindow(beginBit, endBit);
+
+        m_skippedPasses = 0;
+        m_presortStats = PresortStats();
+        m_flushStats = WriteCombiningStats();
+        if (numKeys <= 1)
+            return;
+        if (SortSmall<sortPairs>(toSort, toSortPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        const uint32_t threadBlocks = DivRoundUp(numKeys, k_partSize);
+        m_passHist.resize((size_t)threadBlocks * RADIX);
+        m_threadFlushStats.clear();
+        if (m_downsweepMode == DOWNSWEEP_SHARED)
+        {
+            const size_t scratchSize = (size_t)m_pool.ThreadCount() * k_partSize;
+            m_sharedKeys.resize(scratchSize);
+            m_ranks.resize(scratchSize);
+            if (sortPairs)
+                m_sharedPayloads.resize(scratchSize);
+        }
+        else if (m_downsweepMode == DOWNSWEEP_WRITE_COMBINING)
+        {
+            const size_t stagingSize = (size_t)m_pool.ThreadCount() * RADIX;
+            m_stagingKeys.resize(stagingSize);
+            if (sortPairs)
+                m_stagingPayloads.resize(stagingSize);
+            m_threadFlushStats.assign(m_pool.ThreadCount(), WriteCombiningStats());
+        }
+
+        GlobalHistogram(toSort, numKeys, beginBit, endBit);
+        if (SortPresorted<sortPairs>(toSort, toSortPayload, alt, altPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        const uint32_t trivialMask = m_skipTrivialPasses ?
+            GetTrivialPassMask(numKeys, order, beginBit, endBit) : 0;
+        const uint32_t passMask = GetPassMask(beginBit, endBit, trivialMask);
+        for (uint32_t radixShift = 0; radixShift < KEY_BITS; radixShift += RADIX_LOG)
+        {
+            //Outside of the window, or an identity permutation
+            if ((passMask >> (radixShift >> 3) & 1) == 0)
+            {
+                if ((trivialMask >> (radixShift >> 3) & 1) != 0)
+                    m_skippedPasses++;
+                continue;
+            }
+
+            const uint32_t digitMask = DigitMask(radixShift, beginBit, endBit);
+            const bool shouldReverse = order == ORDER_DESCENDING && IsFinalPass(radixShift, endBit);
+
+            Upsweep(toSort, numKeys, threadBlocks, radixShift, digitMask);
+            Scan(threadBlocks, radixShift);
+            if (m_downsweepMode == DOWNSWEEP_SHARED)
+            {
+                DownsweepShared<sortPairs>(
+                    toSort,
+                    toSortPayload,
+                    alt,
+                    altPayload,
+                    numKeys,
+                    threadBlocks,
+                    radixShift,
+                    digitMask,
+                    shouldReverse);
+            }
+            else if (m_downsweepMode == DOWNSWEEP_WRITE_COMBINING && !shouldReverse)
+            {
+                DownsweepWriteCombining<sortPairs>(
+                    toSort,
+                    toSortPayload,
+                    alt,
+                    altPayload,
+                    numKeys,
+                    threadBlocks,
+                    radixShift,
+                    digitMask);
+            }
+            else
+            {
+                //The mirrored pass of a descending sort fills lines back to
+                //front, it keeps the direct scatter
+                Downsweep<sortPairs>(
+                    toSort,
+                    toSortPayload,
+                    alt,
+                    altPayload,
+                    numKeys,
+                    threadBlocks,
+                    radixShift,
+                    digitMask,
+                    shouldReverse);
+            }
+
+            std::swap(toSort, alt);
+            if (sortPairs)
+                std::swap(toSortPayload, altPayload);
+        }
+
+        for (const WriteCombiningStats& stats : m_threadFlushStats)
+        {
+            m_flushStats.streamedLines += stats.streamedLines;
+            m_flushStats.partialFlushes += stats.partialFlushes;
+        }
+    }
+
+    void DeviceRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t* alt,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<false, uint32_t>(
+            toSort,
+            nullptr,
+            alt,
+            nullptr,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void DeviceRadixSort::Sort(
+        uint64_t* toSort,
+        uint32_t* toSortPayload,
+        uint64_t* alt,
+        uint32_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void DeviceRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t* toSortPayload,
+        uint64_t* alt,
+        uint64_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+}
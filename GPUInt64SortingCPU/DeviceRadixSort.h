@@ -0,0 +1,166 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * CPU DeviceRadixSort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * A multithreaded port of DeviceRadixSort.compute. Each pass runs the same
+ * three phases as the GPU: an upsweep that writes one histogram per tile
+ * into a b_passHist style buffer, a scan of every digit across the tiles,
+ * and a stable downsweep scatter, with a thread pool standing in for the
+ * thread blocks. The pass selection and descending order follow
+ * DeviceRadixSort.cs, so the output is bit exact to the GPU sort.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CPUSortBase.h"
+#include "Multisplit.h"
+
+namespace CPUSorting
+{
+    //Keys per staging line of DOWNSWEEP_WRITE_COMBINING, one cache line
+    constexpr uint32_t WC_LINE_KEYS = 8;
+
+    //Consecutive keys a DOWNSWEEP_WRITE_COMBINING task scatters, rounded
+    //to whole tiles. Lines only stay open within a task, so the partial
+    //flushes at its edges are amortized over this many keys.
+    constexpr uint32_t WC_CHUNK_SIZE = 1 << 16;
+
+    //Line flushes of the last sort run with DOWNSWEEP_WRITE_COMBINING
+    struct WriteCombiningStats
+    {
+        //Whole cache lines, written with non-temporal stores
+        uint64_t streamedLines = 0;
+
+        //Heads and tails of a task's digit runs, written with plain stores
+        uint64_t partialFlushes = 0;
+    };
+
+    class DeviceRadixSort : public CPUSortBase
+    {
+        //digit * threadBlocks + tile, same layout as b_passHist
+        std::vector<uint32_t> m_passHist;
+
+        DOWNSWEEP_MODE m_downsweepMode = DOWNSWEEP_DIRECT;
+        RANK_ISA m_rankISA;
+        RankKernel m_rankKernel;
+
+        //k_partSize slots per pool thread for DOWNSWEEP_SHARED, payloads
+        //are staged in 64-bit slots whatever their type
+        std::vector<uint64_t> m_sharedKeys;
+        std::vector<uint64_t> m_sharedPayloads;
+        std::vector<uint32_t> m_ranks;
+
+        //RADIX lines per pool thread for DOWNSWEEP_WRITE_COMBINING
+        struct alignas(64) StagingLine
+        {
+            uint64_t slots[WC_LINE_KEYS];
+        };
+        std::vector<StagingLine> m_stagingKeys;
+        std::vector<StagingLine> m_stagingPayloads;
+        std::vector<WriteCombiningStats> m_threadFlushStats;
+        WriteCombiningStats m_flushStats;
+
+    public:
+        //The tile size defaults to the GPU partition size, larger
+        //tiles trade scan work for fewer scheduling round trips
+        DeviceRadixSort(ThreadPool& pool, uint32_t partSize = PART_SIZE);
+
+        DOWNSWEEP_MODE DownsweepMode() const { return m_downsweepMode; }
+        void SetDownsweepMode(DOWNSWEEP_MODE mode) { m_downsweepMode = mode; }
+
+        //Ranking build of DOWNSWEEP_SHARED, defaults to the widest one
+        //supported. Requesting an unsupported one falls back to scalar.
+        RANK_ISA RankISA() const { return m_rankISA; }
+        void SetRankISA(RANK_ISA isa);
+
+        const WriteCombiningStats& FlushStats() const { return m_flushStats; }
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* alt,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint32_t* toSortPayload,
+            uint64_t* alt,
+            uint32_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* toSortPayload,
+            uint64_t* alt,
+            uint64_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+    private:
+        void Upsweep(
+            const uint64_t* toSort,
+            uint32_t numKeys,
+            uint32_t threadBlocks,
+            uint32_t radixShift,
+            uint32_t digitMask);
+
+        void Scan(uint32_t threadBlocks, uint32_t radixShift);
+
+        template<bool sortPairs, typename P>
+        void Downsweep(
+            const uint64_t* toSort,
+            const P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            uint32_t threadBlocks,
+            uint32_t radixShift,
+            uint32_t digitMask,
+            bool shouldReverse);
+
+        template<bool sortPairs, typename P>
+        void DownsweepShared(
+            const uint64_t* toSort,
+            const P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            uint32_t threadBlocks,
+            uint32_t radixShift,
+            uint32_t digitMask,
+            bool shouldReverse);
+
+        template<bool sortPairs, typename P>
+        void DownsweepWriteCombining(
+            const uint64_t* toSort,
+            const P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            uint32_t threadBlocks,
+            uint32_t radixShift,
+            uint32_t digitMask);
+
+        template<bool sortPairs, typename P>
+        void Dispatch(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+    };
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Multi digit histogram kernels for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "Histogram.h"
+
+#include <chrono>
+#include <vector>
+#include "CPUFeatures.h"
+
+namespace CPUSorting
+{
+    //Unrolled by HIST_REPLICAS, key j of each group counts into replica j
+    void HistogramScalar(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist)
+    {
+        uint32_t i = 0;
+        for (; i + HIST_REPLICAS <= count; i += HIST_REPLICAS)
+        {
+            for (uint32_t j = 0; j < HIST_REPLICAS; ++j)
+            {
+                const uint64_t key = keys[i + j] & windowMask;
+                uint32_t* replica = hist + j * HIST_REPLICA_SIZE;
+                for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+                    replica[pass * RADIX + ((uint32_t)(key >> (pass * RADIX_LOG)) & RADIX_MASK)]++;
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            const uint64_t key = keys[i] & windowMask;
+            for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass)
+                hist[pass * RADIX + ((uint32_t)(key >> (pass * RADIX_LOG)) & RADIX_MASK)]++;
+        }
+    }
+
+    bool IsHistogramISASupported(HISTOGRAM_ISA isa)
+    {
+        switch (isa)
+        {
+        case HISTOGRAM_ISA_SCALAR:
+            return true;
+        case HISTOGRAM_ISA_AVX2:
+            return HasCPUFeature(CPU_FEATURE_AVX2);
+        case HISTOGRAM_ISA_AVX512:
+            return HasCPUFeature(CPU_FEATURE_AVX512F);
+        default:
+            return false;
+        }
+    }
+
+    HISTOGRAM_ISA DetectHistogramISA()
+    {
+        if (IsHistogramISASupported(HISTOGRAM_ISA_AVX512))
+            return HISTOGRAM_ISA_AVX512;
+        if (IsHistogramISASupported(HISTOGRAM_ISA_AVX2))
+            return HISTOGRAM_ISA_AVX2;
+        return HISTOGRAM_ISA_SCALAR;
+    }
+
+    HISTOGRAM_ISA SelectHistogramISA()
+    {
+        static const HISTOGRAM_ISA selected = []
+        {
+            constexpr uint32_t calibrationSize = 1 << 14;
+            constexpr uint32_t calibrationRuns = 8;
+            std::vector<uint64_t> keys(calibrationSize);
+            EntropyGenerator gen(0, 1);
+            for (uint64_t& key : keys)
+                key = gen.NextKey(ENTROPY_PRESET_1);
+            std::vector<uint32_t> hist(HIST_REPLICAS * HIST_REPLICA_SIZE);
+
+            HISTOGRAM_ISA best = HISTOGRAM_ISA_SCALAR;
+            double bestTime = 0.0;
+            for (int i = HISTOGRAM_ISA_SCALAR; i <= HISTOGRAM_ISA_AVX512; ++i)
+            {
+                const HISTOGRAM_ISA isa = (HISTOGRAM_ISA)i;
+                if (!IsHistogramISASupported(isa))
+                    continue;
+
+                //Fastest of several runs, the first one warms the cache
+                const HistogramKernel kernel = GetHistogramKernel(isa);
+                double time = 0.0;
+                for (uint32_t k = 0; k < calibrationRuns; ++k)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    kernel(keys.data(), calibrationSize, ~(uint64_t)0, hist.data());
+                    const double t = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start).count();
+                    time = k == 0 || t < time ? t : time;
+                }
+
+                if (i == HISTOGRAM_ISA_SCALAR || time < bestTime)
+                {
+                    best = isa;
+                    bestTime = time;
+                }
+            }
+            return best;
+        }();
+        return selected;
+    }
+
+    HistogramKernel GetHistogramKernel(HISTOGRAM_ISA isa)
+    {
+        if (!IsHistogramISASupported(isa))
+            return HistogramScalar;
+
+#if defined(CPU_SORTING_X86)
+        if (isa == HISTOGRAM_ISA_AVX512)
+            return HistogramAVX512;
+        if (isa == HISTOGRAM_ISA_AVX2)
+            return HistogramAVX2;
+#endif
+        return HistogramScalar;
+    }
+
+    const char* HistogramISAName(HISTOGRAM_ISA isa)
+    {
+        switch (isa)
+        {
+        case HISTOGRAM_ISA_AVX2:
+            return "AVX2";
+        case HISTOGRAM_ISA_AVX512:
+            return "AVX-512";
+        default:
+            return "Scalar";
+        }
+    }
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Multi digit histogram kernels for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * The CPU counterpart of the GlobalHistogram kernel: all eight 256 bin
+ * histograms of a 64-bit key are built in one streaming read. Counts go
+ * to HIST_REPLICAS copies of the histograms, one per key in a group of
+ * neighbours, so runs of equal digits do not serialize on store to load
+ * forwarding of the same counter. The vector builds only compute the
+ * bin indices, the increments stay scalar.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include "SortCommon.h"
+
+namespace CPUSorting
+{
+    constexpr uint32_t HIST_REPLICAS = 4;
+
+    //RADIX * RADIX_PASSES counters per replica
+    constexpr uint32_t HIST_REPLICA_SIZE = RADIX * RADIX_PASSES;
+
+    enum HISTOGRAM_ISA
+    {
+        HISTOGRAM_ISA_SCALAR = 0,
+        HISTOGRAM_ISA_AVX2 = 1,
+        HISTOGRAM_ISA_AVX512 = 2,
+    };
+
+    //Adds the digits of keys[0, count), ANDed with windowMask, to the
+    //HIST_REPLICAS * HIST_REPLICA_SIZE counters at hist
+    typedef void (*HistogramKernel)(
+        const uint64_t* keys,
+        uint32_t count,
+        uint64_t windowMask,
+        uint32_t* hist);
+
+    void HistogramScalar(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist);
+
+    //Only defined in x86 builds, see CMakeLists.txt
+    void HistogramAVX2(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist);
+    void HistogramAVX512(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist);
+
+    //The widest build both compiled in and supported by this CPU
+    HISTOGRAM_ISA DetectHistogramISA();
+
+    //The fastest supported build, timed once over a cache resident
+    //buffer on the first call. The increments bound every build, so
+    //the widest one is not always the fastest.
+    HISTOGRAM_ISA SelectHistogramISA();
+
+    bool IsHistogramISASupported(HISTOGRAM_ISA isa);
+
+    //Falls back to scalar for an unsupported isa
+    HistogramKernel GetHistogramKernel(HISTOGRAM_ISA isa);
+
+    const char* HistogramISAName(HISTOGRAM_ISA isa);
+}
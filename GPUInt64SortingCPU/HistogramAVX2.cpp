@@ -0,0 +1,60 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * AVX2 multi digit histogram
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Compiled with AVX2 enabled, only called after a runtime check. Do
+ * not call inline helpers from the shared headers here, the linker may
+ * keep this copy of them for the whole program.
+ *
+ ******************************************************************************/
+#include "Histogram.h"
+
+#if defined(CPU_SORTING_X86)
+#include <immintrin.h>
+
+namespace CPUSorting
+{
+    //The eight digits of a key are its eight bytes. Zero extending them
+    //gives the bins of every pass at once, the per pass and per replica
+    //offsets are a single add.
+    void HistogramAVX2(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist)
+    {
+        static_assert(HIST_REPLICAS == 4, "One replica per key of a 256-bit load");
+
+        const __m256i mask = _mm256_set1_epi64x((long long)windowMask);
+        const __m256i passOffsets = _mm256_setr_epi32(
+            0 * RADIX, 1 * RADIX, 2 * RADIX, 3 * RADIX,
+            4 * RADIX, 5 * RADIX, 6 * RADIX, 7 * RADIX);
+        __m256i offsets[HIST_REPLICAS];
+        for (uint32_t j = 0; j < HIST_REPLICAS; ++j)
+            offsets[j] = _mm256_add_epi32(passOffsets, _mm256_set1_epi32(j * HIST_REPLICA_SIZE));
+
+        alignas(32) uint32_t bins[HIST_REPLICAS * RADIX_PASSES];
+        uint32_t i = 0;
+        for (; i + HIST_REPLICAS <= count; i += HIST_REPLICAS)
+        {
+            const __m256i k = _mm256_and_si256(
+                _mm256_loadu_si256((const __m256i*)(keys + i)), mask);
+            const __m128i lo = _mm256_castsi256_si128(k);
+            const __m128i hi = _mm256_extracti128_si256(k, 1);
+
+            _mm256_store_si256((__m256i*)(bins + 0),
+                _mm256_add_epi32(_mm256_cvtepu8_epi32(lo), offsets[0]));
+            _mm256_store_si256((__m256i*)(bins + 8),
+                _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)), offsets[1]));
+            _mm256_store_si256((__m256i*)(bins + 16),
+                _mm256_add_epi32(_mm256_cvtepu8_epi32(hi), offsets[2]));
+            _mm256_store_si256((__m256i*)(bins + 24),
+                _mm256_add_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)), offsets[3]));
+
+            for (uint32_t j = 0; j < HIST_REPLICAS * RADIX_PASSES; ++j)
+                hist[bins[j]]++;
+        }
+
+        HistogramScalar(keys + i, count - i, windowMask, hist);
+    }
+}
+#endif
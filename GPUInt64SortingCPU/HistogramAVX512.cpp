@@ -0,0 +1,62 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * AVX-512 multi digit histogram
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Compiled with AVX-512F enabled, only called after a runtime check. Do
+ * not call inline helpers from the shared headers here, the linker may
+ * keep this copy of them for the whole program.
+ *
+ ******************************************************************************/
+#include "Histogram.h"
+
+#if defined(CPU_SORTING_X86)
+#include <immintrin.h>
+
+namespace CPUSorting
+{
+    //Same scheme as the AVX2 build, with a 512-bit load of eight keys.
+    //Each 128-bit lane holds two keys, whose bytes widen to 16 bins.
+    void HistogramAVX512(const uint64_t* keys, uint32_t count, uint64_t windowMask, uint32_t* hist)
+    {
+        static_assert(HIST_REPLICAS == 4, "Two replicas per 128-bit lane");
+        constexpr uint32_t keysPerLoad = 8;
+
+        const __m512i mask = _mm512_set1_epi64((long long)windowMask);
+        const __m512i passOffsets = _mm512_setr_epi32(
+            0 * RADIX, 1 * RADIX, 2 * RADIX, 3 * RADIX,
+            4 * RADIX, 5 * RADIX, 6 * RADIX, 7 * RADIX,
+            0 * RADIX + HIST_REPLICA_SIZE, 1 * RADIX + HIST_REPLICA_SIZE,
+            2 * RADIX + HIST_REPLICA_SIZE, 3 * RADIX + HIST_REPLICA_SIZE,
+            4 * RADIX + HIST_REPLICA_SIZE, 5 * RADIX + HIST_REPLICA_SIZE,
+            6 * RADIX + HIST_REPLICA_SIZE, 7 * RADIX + HIST_REPLICA_SIZE);
+
+        //Lanes 0 and 2 count into replicas 0 and 1, lanes 1 and 3 into 2 and 3
+        const __m512i offsetsEven = passOffsets;
+        const __m512i offsetsOdd = _mm512_add_epi32(passOffsets, _mm512_set1_epi32(2 * HIST_REPLICA_SIZE));
+
+        alignas(64) uint32_t bins[keysPerLoad * RADIX_PASSES];
+        uint32_t i = 0;
+        for (; i + keysPerLoad <= count; i += keysPerLoad)
+        {
+            const __m512i k = _mm512_and_si512(_mm512_loadu_si512((const void*)(keys + i)), mask);
+
+            _mm512_store_si512((void*)(bins + 0),
+                _mm512_add_epi32(_mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(k, 0)), offsetsEven));
+            _mm512_store_si512((void*)(bins + 16),
+                _mm512_add_epi32(_mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(k, 1)), offsetsOdd));
+            _mm512_store_si512((void*)(bins + 32),
+                _mm512_add_epi32(_mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(k, 2)), offsetsEven));
+            _mm512_store_si512((void*)(bins + 48),
+                _mm512_add_epi32(_mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(k, 3)), offsetsOdd));
+
+            for (uint32_t j = 0; j < keysPerLoad * RADIX_PASSES; ++j)
+                hist[bins[j]]++;
+        }
+
+        HistogramScalar(keys + i, count - i, windowMask, hist);
+    }
+}
+#endif
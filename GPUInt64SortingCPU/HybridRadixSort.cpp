@@ -0,0 +1,377 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Hybrid MSD then LSD radix sort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "HybridRadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "CPUFeatures.h"
+
+namespace CPUSorting
+{
+    HybridRadixSort::HybridRadixSort(ThreadPool& pool, uint32_t partSize) :
+        CPUSortBase(pool, "HybridRadixSort", partSize),
+        m_bucketBytes(L2CacheBytes() / 2),
+        m_largeBucketSort(pool, partSize)
+    {
+    }
+
+    uint32_t HybridRadixSort::SelectMSDBits(uint32_t numKeys, uint32_t elementBytes, size_t bucketBytes)
+    {
+        const size_t bucketKeys = std::max<size_t>(bucketBytes / elementBytes, 1);
+        uint32_t bits = HYBRID_MIN_MSD_BITS;
+        while (bits < HYBRID_MAX_MSD_BITS && (numKeys >> bits) > bucketKeys)
+            bits++;
+        return bits;
+    }
+
+    void HybridRadixSort::SetBucketBytes(size_t bytes)
+    {
+        if (bytes == 0)
+            throw std::invalid_argument("bucketBytes must be non zero");
+        m_bucketBytes = bytes;
+    }
+
+    void HybridRadixSort::SetMSDBits(uint32_t bits)
+    {
+        if (bits != 0 && (bits < HYBRID_MIN_MSD_BITS || bits > HYBRID_MAX_MSD_BITS))
+            throw std::invalid_argument("MSD bits must be 0, or between 8 and 11");
+        m_fixedMSDBits = bits;
+    }
+
+    //Upsweep, scan and downsweep of DeviceRadixSort on a single wide digit,
+    //with a few large tiles so the per tile histograms stay small
+    template<bool sortPairs, typename P>
+    void HybridRadixSort::PartitionMSD(
+        const uint64_t* toSort,
+        const P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        uint32_t msdShift,
+        uint32_t msdBits,
+        bool descending)
+    {
+        const uint32_t buckets = 1U << msdBits;
+        const uint32_t mask = buckets - 1;
+        const uint32_t flip = descending ? mask : 0;
+        const uint32_t tileSize = DivRoundUp(numKeys, m_pool.ThreadCount() * HYBRID_TILES_PER_THREAD);
+        const uint32_t tiles = DivRoundUp(numKeys, tileSize);
+        m_tileHist.resize((size_t)buckets * tiles);
+        m_bucketOffsets.resize(buckets + 1);
+
+        m_pool.ParallelFor(
+            tiles,
+            [&](uint32_t tile, uint32_t)
+            {
+                uint32_t hist[1 << HYBRID_MAX_MSD_BITS] = {};
+                const uint32_t start = tile * tileSize;
+                const uint32_t end = std::min(numKeys - start, tileSize) + start;
+                for (uint32_t i = start; i < end; ++i)
+                    hist[((uint32_t)(toSort[i] >> msdShift) & mask) ^ flip]++;
+
+                for (uint32_t d = 0; d < buckets; ++d)
+                    m_tileHist[(size_t)d * tiles + tile] = hist[d];
+            });
+
+        uint32_t reduction = 0;
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            m_bucketOffsets[d] = reduction;
+            for (uint32_t t = 0; t < tiles; ++t)
+            {
+                const uint32_t count = m_tileHist[(size_t)d * tiles + t];
+                m_tileHist[(size_t)d * tiles + t] = reduction;
+                reduction += count;
+            }
+        }
+        m_bucketOffsets[buckets] = reduction;
+
+        m_pool.ParallelFor(
+            tiles,
+            [&](uint32_t tile, uint32_t)
+            {
+                uint32_t offsets[1 << HYBRID_MAX_MSD_BITS];
+                for (uint32_t d = 0; d < buckets; ++d)
+                    offsets[d] = m_tileHist[(size_t)d * tiles + tile];
+
+                const uint32_t start = tile * tileSize;
+                const uint32_t end = std::min(numKeys - start, tileSize) + start;
+                for (uint32_t i = start; i < end; ++i)
+                {
+                    const uint64_t key = toSort[i];
+                    const uint32_t deviceIndex = offsets[((uint32_t)(key >> msdShift) & mask) ^ flip]++;
+                    alt[deviceIndex] = key;
+                    if (sortPairs)
+                        altPayload[deviceIndex] = toSortPayload[i];
+                }
+            });
+    }
+
+    //Every digit's histogram in one read, while the bucket is first pulled
+    //into cache, then one stable pass per digit that splits the bucket.
+    //Descending order sorts ascending and mirrors the result.
+    template<bool sortPairs, typename P>
+    void HybridRadixSort::SortBucketLSD(
+        uint64_t* keys,
+        P* payloads,
+        uint64_t* sorted,
+        P* sortedPayloads,
+        uint32_t count,
+        uint32_t beginBit,
+        uint32_t endBit,
+        bool descending)
+    {
+        const uint32_t passes = DivRoundUp(endBit - beginBit, RADIX_LOG);
+        const uint64_t windowMask = KeyWindowMask(beginBit, endBit);
+        uint32_t hist[RADIX_PASSES][RADIX] = {};
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const uint64_t key = keys[i] & windowMask;
+            for (uint32_t pass = 0; pass < passes; ++pass)
+                hist[pass][(uint32_t)(key >> (beginBit + pass * RADIX_LOG)) & RADIX_MASK]++;
+        }
+
+        uint64_t* src = keys;
+        uint64_t* dst = sorted;
+        P* srcPayloads = payloads;
+        P* dstPayloads = sortedPayloads;
+        for (uint32_t pass = 0; pass < passes; ++pass)
+        {
+            const uint32_t radixShift = beginBit + pass * RADIX_LOG;
+            uint32_t* passHist = hist[pass];
+            if (passHist[(uint32_t)((src[0] & windowMask) >> radixShift) & RADIX_MASK] == count)
+                continue;
+
+            uint32_t reduction = 0;
+            for (uint32_t i = 0; i < RADIX; ++i)
+            {
+                const uint32_t t = passHist[i];
+                passHist[i] = reduction;
+                reduction += t;
+            }
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const uint32_t index = passHist[(uint32_t)((src[i] & windowMask) >> radixShift) & RADIX_MASK]++;
+                dst[index] = src[i];
+                if (sortPairs)
+                    dstPayloads[index] = srcPayloads[i];
+            }
+
+            std::swap(src, dst);
+            if (sortPairs)
+                std::swap(srcPayloads, dstPayloads);
+        }
+
+        if (src == sorted)
+        {
+            if (descending)
+            {
+                std::reverse(sorted, sorted + count);
+                if (sortPairs)
+                    std::reverse(sortedPayloads, sortedPayloads + count);
+            }
+            return;
+        }
+
+        if (descending)
+        {
+            std::reverse_copy(src, src + count, sorted);
+            if (sortPairs)
+                std::reverse_copy(srcPayloads, srcPayloads + count, sortedPayloads);
+            return;
+        }
+
+        memcpy(sorted, src, count * sizeof(uint64_t));
+        if (sortPairs)
+            memcpy(sortedPayloads, srcPayloads, count * sizeof(P));
+    }
+
+    template<bool sortPairs, typename P>
+    void HybridRadixSort::Dispatch(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        ValidateBitWindow(beginBit, endBit);
+
+        m_skippedPasses = 0;
+        m_presortStats = PresortStats();
+        m_lastMSDBits = 0;
+        m_largeBuckets = 0;
+        if (numKeys <= 1)
+            return;
+        if (SortSmall<sortPairs>(toSort, toSortPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        if (m_detectPresorted)
+        {
+            CountDescents(toSort, numKeys, beginBit, endBit);
+            if (SortPresorted<sortPairs>(toSort, toSortPayload, alt, altPayload, numKeys, order, beginBit, endBit))
+                return;
+        }
+
+        //Equal keys only need the mirroring of a descending sort
+        const bool descending = order == ORDER_DESCENDING;
+        const uint32_t top = DifferingTop(toSort, numKeys, beginBit, endBit);
+        if (top == beginBit)
+        {
+            if (descending)
+            {
+                std::reverse(toSort, toSort + numKeys);
+                if (sortPairs)
+                    std::reverse(toSortPayload, toSortPayload + numKeys);
+            }
+            return;
+        }
+
+        const uint32_t elementBytes = (uint32_t)(sizeof(uint64_t) + (sortPairs ? sizeof(P) : 0));
+        const uint32_t msdBits = std::min(
+            m_fixedMSDBits != 0 ? m_fixedMSDBits : SelectMSDBits(numKeys, elementBytes, m_bucketBytes),
+            top - beginBit);
+        const uint32_t msdShift = top - msdBits;
+        m_lastMSDBits = msdBits;
+        PartitionMSD<sortPairs>(toSort, toSortPayload, alt, altPayload, numKeys, msdShift, msdBits, descending);
+
+        //A bucket larger than one thread's share of the keys gets the whole
+        //pool, the rest are one task each, largest first
+        const uint32_t buckets = 1U << msdBits;
+        const size_t largeSize = std::max<size_t>(numKeys / m_pool.ThreadCount(), m_bucketBytes / elementBytes);
+        std::vector<uint32_t> smallBuckets;
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            const uint32_t start = m_bucketOffsets[d];
+            const uint32_t count = m_bucketOffsets[d + 1] - start;
+            if (count == 0)
+                continue;
+
+            if (m_pool.ThreadCount() == 1 || count <= largeSize)
+            {
+                smallBuckets.push_back(d);
+                continue;
+            }
+
+            m_largeBuckets++;
+            if (msdShift > beginBit)
+            {
+                if (sortPairs)
+                {
+                    m_largeBucketSort.Sort(alt + start, altPayload + start, toSort + start, toSortPayload + start,
+                        count, ORDER_ASCENDING, beginBit, msdShift);
+                }
+                else
+                {
+                    m_largeBucketSort.Sort(alt + start, toSort + start, count, ORDER_ASCENDING, beginBit, msdShift);
+                }
+            }
+
+            m_pool.ParallelFor(
+                DivRoundUp(count, G_HIST_PART_SIZE),
+                [&](uint32_t partitionIndex, uint32_t)
+                {
+                    const uint32_t first = partitionIndex * G_HIST_PART_SIZE;
+                    const uint32_t last = std::min(count - first, G_HIST_PART_SIZE) + first;
+                    for (uint32_t i = first; i < last; ++i)
+                    {
+                        const uint32_t index = start + (descending ? count - i - 1 : i);
+                        toSort[index] = alt[start + i];
+                        if (sortPairs)
+                            toSortPayload[index] = altPayload[start + i];
+                    }
+                });
+        }
+
+        std::sort(smallBuckets.begin(), smallBuckets.end(), [&](uint32_t a, uint32_t b)
+        {
+            return m_bucketOffsets[a + 1] - m_bucketOffsets[a] > m_bucketOffsets[b + 1] - m_bucketOffsets[b];
+        });
+        m_pool.ParallelFor(
+            (uint32_t)smallBuckets.size(),
+            [&](uint32_t taskIndex, uint32_t)
+            {
+                const uint32_t start = m_bucketOffsets[smallBuckets[taskIndex]];
+                SortBucketLSD<sortPairs>(
+                    alt + start,
+                    sortPairs ? altPayload + start : nullptr,
+                    toSort + start,
+                    sortPairs ? toSortPayload + start : nullptr,
+                    m_bucketOffsets[smallBuckets[taskIndex] + 1] - start,
+                    beginBit,
+                    msdShift,
+                    descending);
+            });
+    }
+
+    void HybridRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t* alt,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<false, uint32_t>(
+            toSort,
+            nullptr,
+            alt,
+            nullptr,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void HybridRadixSort::Sort(
+        uint64_t* toSort,
+        uint32_t* toSortPayload,
+        uint64_t* alt,
+        uint32_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void HybridRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t* toSortPayload,
+        uint64_t* alt,
+        uint64_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+}
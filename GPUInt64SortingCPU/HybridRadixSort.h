@@ -0,0 +1,141 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Hybrid MSD then LSD radix sort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * An LSD sort streams every key through memory once per digit, even the
+ * high digits that a single MSD split would already have settled. This
+ * sort runs one parallel, stable MSD partition on the top 8 to 11 bits
+ * that differ, from toSort into alt, then sorts each bucket on the
+ * remaining bits with a single threaded LSD sort. The MSD width is picked
+ * from the input size, so an average bucket and its scratch fit in L2 and
+ * every LSD pass after the first read stays in cache.
+ *
+ * A bucket holding more than its share of the keys would serialize the
+ * LSD phase, so it is handed to a DeviceRadixSort across the whole pool.
+ * Descending order mirrors each bucket like DescendingIndex, so the output
+ * is bit exact to the other sorts.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CPUSortBase.h"
+#include "DeviceRadixSort.h"
+
+namespace CPUSorting
+{
+    constexpr uint32_t HYBRID_MIN_MSD_BITS = 8;
+    constexpr uint32_t HYBRID_MAX_MSD_BITS = 11;
+
+    //The MSD partition splits the keys into this many tiles per pool
+    //thread, its per tile histograms are 1 << HYBRID_MAX_MSD_BITS wide
+    constexpr uint32_t HYBRID_TILES_PER_THREAD = 4;
+
+    class HybridRadixSort : public CPUSortBase
+    {
+        //Bytes of keys and payloads a bucket is sized to
+        size_t m_bucketBytes;
+
+        //0 picks the MSD width from the input size
+        uint32_t m_fixedMSDBits = 0;
+
+        uint32_t m_lastMSDBits = 0;
+        uint32_t m_largeBuckets = 0;
+
+        //digit * tiles + tile, then the scatter offsets of each tile
+        std::vector<uint32_t> m_tileHist;
+        std::vector<uint32_t> m_bucketOffsets;
+
+        DeviceRadixSort m_largeBucketSort;
+
+    public:
+        //partSize is the tile size of the DeviceRadixSort for large buckets
+        HybridRadixSort(ThreadPool& pool, uint32_t partSize = PART_SIZE);
+
+        //Smallest width in [HYBRID_MIN_MSD_BITS, HYBRID_MAX_MSD_BITS] that
+        //brings the average bucket of numKeys elements under bucketBytes
+        static uint32_t SelectMSDBits(uint32_t numKeys, uint32_t elementBytes, size_t bucketBytes);
+
+        //Defaults to half of L2CacheBytes, the other half is the LSD scratch
+        size_t BucketBytes() const { return m_bucketBytes; }
+        void SetBucketBytes(size_t bytes);
+
+        //0 selects the width per sort, anything else must be within
+        //[HYBRID_MIN_MSD_BITS, HYBRID_MAX_MSD_BITS]
+        uint32_t MSDBits() const { return m_fixedMSDBits; }
+        void SetMSDBits(uint32_t bits);
+
+        //MSD width used by the last sort, narrower when the window is
+        uint32_t LastMSDBits() const { return m_lastMSDBits; }
+
+        //Buckets of the last sort that went to the DeviceRadixSort
+        uint32_t LargeBuckets() const { return m_largeBuckets; }
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* alt,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint32_t* toSortPayload,
+            uint64_t* alt,
+            uint32_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* toSortPayload,
+            uint64_t* alt,
+            uint64_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+    private:
+        template<bool sortPairs, typename P>
+        void PartitionMSD(
+            const uint64_t* toSort,
+            const P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            uint32_t msdShift,
+            uint32_t msdBits,
+            bool descending);
+
+        //Sorts the bucket at keys into sorted, using both as scratch
+        template<bool sortPairs, typename P>
+        static void SortBucketLSD(
+            uint64_t* keys,
+            P* payloads,
+            uint64_t* sorted,
+            P* sortedPayloads,
+            uint32_t count,
+            uint32_t beginBit,
+            uint32_t endBit,
+            bool descending);
+
+        template<bool sortPairs, typename P>
+        void Dispatch(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+    };
+}
@@ -0,0 +1,578 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * In place parallel MSD radix sort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "InPlaceRadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace CPUSorting
+{
+    //The digit just below top, RADIX_LOG bits wide unless it reaches
+    //beginBit. A descending sort flips the digit, so the buckets come
+    //out in reverse.
+    struct DigitLevel
+    {
+        uint32_t shift;
+        uint32_t mask;
+        uint32_t flip;
+
+        DigitLevel(uint32_t top, uint32_t beginBit, bool descending) :
+            shift(top > beginBit + RADIX_LOG ? top - RADIX_LOG : beginBit),
+            mask(RADIX_MASK >> (RADIX_LOG - (top - shift))),
+            flip(descending ? mask : 0)
+        {
+        }
+
+        uint32_t Buckets() const { return mask + 1; }
+
+        uint32_t Digit(uint64_t key) const
+        {
+            return ((uint32_t)(key >> shift) & mask) ^ flip;
+        }
+    };
+
+    //Single threaded DifferingTop, for a bucket owned by one task
+    static uint32_t SequentialDifferingTop(const uint64_t* keys, uint32_t count, uint32_t beginBit, uint32_t top)
+    {
+        const uint64_t windowMask = KeyWindowMask(beginBit, top);
+        uint64_t diff = 0;
+        for (uint32_t i = 1; i < count; ++i)
+            diff |= keys[i] ^ keys[0];
+        return TopOfDiff(diff & windowMask, beginBit);
+    }
+
+    InPlaceRadixSort::InPlaceRadixSort(ThreadPool& pool, uint32_t blockSize) :
+        CPUSortBase(pool, "InPlaceRadixSort", blockSize)
+    {
+    }
+
+    size_t InPlaceRadixSort::ScratchBytes() const
+    {
+        return (m_bufferKeys.capacity() + m_bufferPayloads.capacity() +
+            m_swapKeys.capacity() + m_swapPayloads.capacity() +
+            m_spillKeys.capacity() + m_spillPayloads.capacity() +
+            m_overflowKeys.capacity() + m_overflowPayloads.capacity()) * sizeof(uint64_t) +
+            (m_bufferCounts.capacity() + m_flushedBlocks.capacity() +
+            m_stripeBlocks.capacity()) * sizeof(uint32_t) +
+            m_tasks.capacity() * sizeof(Task);
+    }
+
+    template<bool sortPairs, typename P>
+    void InPlaceRadixSort::PartitionParallel(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint32_t start,
+        uint32_t count,
+        uint32_t top)
+    {
+        if (count <= IPR_PARALLEL_SIZE || m_pool.ThreadCount() == 1)
+        {
+            m_tasks.push_back({ start, count, top });
+            return;
+        }
+
+        uint64_t* keys = toSort + start;
+        P* payloads = sortPairs ? toSortPayload + start : nullptr;
+        top = DifferingTop(keys, count, m_beginBit, top);
+        if (top == m_beginBit)
+            return;
+
+        const DigitLevel level(top, m_beginBit, m_descending);
+        const uint32_t buckets = level.Buckets();
+        const uint32_t blockSize = k_partSize;
+        const uint32_t blocks = DivRoundUp(count, blockSize);
+        const uint32_t stripes = std::min(m_pool.ThreadCount(), blocks);
+        const bool unalignedEnd = count % blockSize != 0;
+        auto blockKeys = [&](uint64_t block) { return keys + block * blockSize; };
+        auto blockPayloads = [&](uint64_t block) { return payloads + block * blockSize; };
+        auto stripeBegin = [&](uint32_t stripe) { return (uint32_t)((uint64_t)stripe * blocks / stripes); };
+
+        //1. Classify each stripe into its buffers. The write position only
+        //ever trails the read position, so full blocks can go back in place.
+        std::fill(m_flushedBlocks.begin(), m_flushedBlocks.end(), 0);
+        m_pool.ParallelFor(
+            stripes,
+            [&](uint32_t stripe, uint32_t)
+            {
+                const size_t bufferOffset = (size_t)stripe * RADIX;
+                uint64_t* bufferKeys = &m_bufferKeys[bufferOffset * blockSize];
+                uint64_t* bufferPayloads = m_bufferPayloads.data() + (sortPairs ? bufferOffset * blockSize : 0);
+                uint32_t* bufferCounts = &m_bufferCounts[bufferOffset];
+                uint32_t* flushed = &m_flushedBlocks[bufferOffset];
+                std::fill(bufferCounts, bufferCounts + RADIX, 0);
+
+                const uint64_t begin = (uint64_t)stripeBegin(stripe) * blockSize;
+                const uint64_t end = std::min<uint64_t>((uint64_t)stripeBegin(stripe + 1) * blockSize, count);
+                uint64_t write = begin;
+                for (uint64_t i = begin; i < end; ++i)
+                {
+                    const uint32_t digit = level.Digit(keys[i]);
+                    const size_t block = (size_t)digit * blockSize;
+                    bufferKeys[block + bufferCounts[digit]] = keys[i];
+                    if (sortPairs)
+                        reinterpret_cast<P*>(bufferPayloads + block)[bufferCounts[digit]] = payloads[i];
+
+                    if (++bufferCounts[digit] == blockSize)
+                    {
+                        memcpy(keys + write, bufferKeys + block, blockSize * sizeof(uint64_t));
+                        if (sortPairs)
+                            memcpy(payloads + write, bufferPayloads + block, blockSize * sizeof(P));
+                        write += blockSize;
+                        bufferCounts[digit] = 0;
+                        flushed[digit]++;
+                    }
+                }
+                m_stripeBlocks[stripe] = (uint32_t)((write - begin) / blockSize);
+            });
+
+        //Bucket boundaries, and the first block each bucket owns
+        std::vector<uint32_t> bucketOffsets(buckets + 1);
+        std::vector<uint32_t> bucketBlocks(buckets);
+        std::vector<uint32_t> firstBlocks(buckets + 1);
+        uint32_t reduction = 0;
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            bucketOffsets[d] = reduction;
+            bucketBlocks[d] = 0;
+            for (uint32_t s = 0; s < stripes; ++s)
+            {
+                bucketBlocks[d] += m_flushedBlocks[(size_t)s * RADIX + d];
+                reduction += m_bufferCounts[(size_t)s * RADIX + d];
+            }
+            reduction += bucketBlocks[d] * blockSize;
+        }
+        bucketOffsets[buckets] = reduction;
+        for (uint32_t d = 0; d <= buckets; ++d)
+            firstBlocks[d] = DivRoundUp(bucketOffsets[d], blockSize);
+
+        //2. Move the full blocks to the front. The empty blocks left below
+        //fullBlocks pair off with the full blocks above it, in order.
+        uint32_t fullBlocks = 0;
+        for (uint32_t s = 0; s < stripes; ++s)
+            fullBlocks += m_stripeBlocks[s];
+
+        std::vector<uint32_t> holeOffsets(stripes + 1);
+        std::vector<uint32_t> sourceOffsets(stripes + 1);
+        for (uint32_t s = 0; s < stripes; ++s)
+        {
+            const uint32_t emptyBegin = stripeBegin(s) + m_stripeBlocks[s];
+            const uint32_t fullBegin = std::max(stripeBegin(s), fullBlocks);
+            holeOffsets[s + 1] = holeOffsets[s] +
+                (std::min(stripeBegin(s + 1), fullBlocks) - std::min(emptyBegin, fullBlocks));
+            sourceOffsets[s + 1] = sourceOffsets[s] +
+                (std::max(emptyBegin, fullBlocks) - fullBegin);
+        }
+
+        m_pool.ParallelFor(
+            stripes,
+            [&](uint32_t stripe, uint32_t)
+            {
+                uint32_t hole = holeOffsets[stripe];
+                if (hole == holeOffsets[stripe + 1])
+                    return;
+
+                uint32_t source = (uint32_t)(std::upper_bound(sourceOffsets.begin(), sourceOffsets.end(), hole) - sourceOffsets.begin()) - 1;
+                uint32_t sourceBlock = std::max(stripeBegin(source), fullBlocks) + (hole - sourceOffsets[source]);
+                uint32_t block = stripeBegin(stripe) + m_stripeBlocks[stripe];
+                for (; hole < holeOffsets[stripe + 1]; ++hole, ++block, ++sourceBlock)
+                {
+                    while (sourceBlock == stripeBegin(source) + m_stripeBlocks[source] ||
+                        sourceOffsets[source + 1] == sourceOffsets[source])
+                    {
+                        source++;
+                        sourceBlock = std::max(stripeBegin(source), fullBlocks);
+                    }
+                    memcpy(blockKeys(block), blockKeys(sourceBlock), blockSize * sizeof(uint64_t));
+                    if (sortPairs)
+                        memcpy(blockPayloads(block), blockPayloads(sourceBlock), blockSize * sizeof(P));
+                }
+            });
+
+        //3. Permute the blocks. Each bucket's unplaced blocks sit between
+        //its write and read pointers.
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            m_write[d] = firstBlocks[d];
+            m_read[d] = std::min(std::max(fullBlocks, firstBlocks[d]), firstBlocks[d + 1]);
+            m_reading[d] = 0;
+        }
+
+        m_pool.ParallelFor(
+            stripes,
+            [&](uint32_t stripe, uint32_t)
+            {
+                uint64_t* swapKeys[2] = {
+                    &m_swapKeys[(size_t)stripe * 2 * blockSize],
+                    &m_swapKeys[((size_t)stripe * 2 + 1) * blockSize] };
+                P* swapPayloads[2] = {
+                    reinterpret_cast<P*>(m_swapPayloads.data() + (sortPairs ? (size_t)stripe * 2 * blockSize : 0)),
+                    reinterpret_cast<P*>(m_swapPayloads.data() + (sortPairs ? ((size_t)stripe * 2 + 1) * blockSize : 0)) };
+                uint32_t current = 0;
+
+                //A block read below m_read is only overwritten once the
+                //reader is done with it, see the wait on m_reading
+                auto readBlock = [&](uint32_t bucket)
+                {
+                    m_reading[bucket]++;
+                    const int64_t block = m_read[bucket].fetch_sub(1) - 1;
+                    const bool claimed = block >= m_write[bucket].load();
+                    if (claimed)
+                    {
+                        memcpy(swapKeys[current], blockKeys(block), blockSize * sizeof(uint64_t));
+                        if (sortPairs)
+                            memcpy(swapPayloads[current], blockPayloads(block), blockSize * sizeof(P));
+                    }
+                    m_reading[bucket]--;
+                    return claimed;
+                };
+
+                //Returns true if an unplaced block was displaced into the
+                //other swap buffer
+                auto writeBlock = [&](uint32_t bucket)
+                {
+                    const int64_t block = m_write[bucket].fetch_add(1);
+                    const uint32_t other = current ^ 1;
+                    if (block < m_read[bucket].load())
+                    {
+                        memcpy(swapKeys[other], blockKeys(block), blockSize * sizeof(uint64_t));
+                        memcpy(blockKeys(block), swapKeys[current], blockSize * sizeof(uint64_t));
+                        if (sortPairs)
+                        {
+                            memcpy(swapPayloads[other], blockPayloads(block), blockSize * sizeof(P));
+                            memcpy(blockPayloads(block), swapPayloads[current], blockSize * sizeof(P));
+                        }
+                        current = other;
+                        return true;
+                    }
+
+                    while (m_reading[bucket].load() != 0)
+                        std::this_thread::yield();
+
+                    //Only the last block can run past the end of the range
+                    const bool overflow = unalignedEnd && block == blocks - 1;
+                    memcpy(overflow ? m_overflowKeys.data() : blockKeys(block), swapKeys[current], blockSize * sizeof(uint64_t));
+                    if (sortPairs)
+                    {
+                        P* dst = overflow ? reinterpret_cast<P*>(m_overflowPayloads.data()) : blockPayloads(block);
+                        memcpy(dst, swapPayloads[current], blockSize * sizeof(P));
+                    }
+                    return false;
+                };
+
+                const uint32_t firstBucket = (uint32_t)((uint64_t)stripe * buckets / stripes);
+                for (uint32_t i = 0; i < buckets; ++i)
+                {
+                    const uint32_t bucket = (firstBucket + i) % buckets;
+                    while (readBlock(bucket))
+                    {
+                        while (writeBlock(level.Digit(swapKeys[current][0])))
+                            ;
+                    }
+                }
+            });
+
+        //4. Save what spilled past the end of each bucket, then fill the
+        //head and tail of every bucket from the spill and the buffers
+        m_pool.ParallelFor(
+            buckets,
+            [&](uint32_t bucket, uint32_t)
+            {
+                const uint64_t fullEnd = (uint64_t)(firstBlocks[bucket] + bucketBlocks[bucket]) * blockSize;
+                const uint64_t bucketEnd = bucketOffsets[bucket + 1];
+                m_spillCounts[bucket] = 0;
+                if (bucketBlocks[bucket] == 0 || fullEnd <= bucketEnd)
+                    return;
+
+                uint64_t* spillKeys = &m_spillKeys[(size_t)bucket * blockSize];
+                P* spillPayloads = reinterpret_cast<P*>(m_spillPayloads.data() + (sortPairs ? (size_t)bucket * blockSize : 0));
+                m_spillCounts[bucket] = (uint32_t)(fullEnd - bucketEnd);
+                if (unalignedEnd && fullEnd == (uint64_t)blocks * blockSize)
+                {
+                    const uint32_t inPlace = (uint32_t)(bucketEnd - (uint64_t)(blocks - 1) * blockSize);
+                    const P* overflowPayloads = reinterpret_cast<const P*>(m_overflowPayloads.data());
+                    memcpy(blockKeys(blocks - 1), m_overflowKeys.data(), inPlace * sizeof(uint64_t));
+                    memcpy(spillKeys, m_overflowKeys.data() + inPlace, m_spillCounts[bucket] * sizeof(uint64_t));
+                    if (sortPairs)
+                    {
+                        memcpy(blockPayloads(blocks - 1), overflowPayloads, inPlace * sizeof(P));
+                        memcpy(spillPayloads, overflowPayloads + inPlace, m_spillCounts[bucket] * sizeof(P));
+                    }
+                    return;
+                }
+
+                memcpy(spillKeys, keys + bucketEnd, m_spillCounts[bucket] * sizeof(uint64_t));
+                if (sortPairs)
+                    memcpy(spillPayloads, payloads + bucketEnd, m_spillCounts[bucket] * sizeof(P));
+            });
+
+        m_pool.ParallelFor(
+            buckets,
+            [&](uint32_t bucket, uint32_t)
+            {
+                const uint64_t headEnd = std::min<uint64_t>((uint64_t)firstBlocks[bucket] * blockSize, bucketOffsets[bucket + 1]);
+                const uint64_t fullEnd = (uint64_t)(firstBlocks[bucket] + bucketBlocks[bucket]) * blockSize;
+                uint64_t position = bucketOffsets[bucket];
+                auto fill = [&](const uint64_t* sourceKeys, const P* sourcePayloads, uint32_t sourceCount)
+                {
+                    for (uint32_t i = 0; i < sourceCount; ++i)
+                    {
+                        if (position == headEnd)
+                            position = fullEnd;
+                        keys[position] = sourceKeys[i];
+                        if (sortPairs)
+                            payloads[position] = sourcePayloads[i];
+                        position++;
+                    }
+                };
+
+                fill(&m_spillKeys[(size_t)bucket * blockSize],
+                    reinterpret_cast<const P*>(m_spillPayloads.data() + (sortPairs ? (size_t)bucket * blockSize : 0)),
+                    m_spillCounts[bucket]);
+                for (uint32_t s = 0; s < stripes; ++s)
+                {
+                    const size_t bufferOffset = ((size_t)s * RADIX + bucket) * blockSize;
+                    fill(&m_bufferKeys[bufferOffset],
+                        reinterpret_cast<const P*>(m_bufferPayloads.data() + (sortPairs ? bufferOffset : 0)),
+                        m_bufferCounts[(size_t)s * RADIX + bucket]);
+                }
+            });
+
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            const uint32_t bucketCount = bucketOffsets[d + 1] - bucketOffsets[d];
+            if (bucketCount > 1)
+                PartitionParallel<sortPairs>(toSort, toSortPayload, start + bucketOffsets[d], bucketCount, level.shift);
+        }
+    }
+
+    //An American flag sort: count, then cycle every key to the next free
+    //slot of its bucket, then recurse on each bucket
+    template<bool sortPairs, typename P>
+    void InPlaceRadixSort::SortSequential(
+        uint64_t* keys,
+        P* payloads,
+        uint32_t count,
+        uint32_t top) const
+    {
+        if (count <= IPR_SMALL_SORT_SIZE)
+        {
+            InsertionSort<sortPairs>(keys, payloads, count, top);
+            return;
+        }
+
+        top = SequentialDifferingTop(keys, count, m_beginBit, top);
+        if (top == m_beginBit)
+            return;
+
+        const DigitLevel level(top, m_beginBit, m_descending);
+        const uint32_t buckets = level.Buckets();
+        uint32_t hist[RADIX] = {};
+        for (uint32_t i = 0; i < count; ++i)
+            hist[level.Digit(keys[i])]++;
+
+        uint32_t next[RADIX];
+        uint32_t end[RADIX];
+        uint32_t reduction = 0;
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            next[d] = reduction;
+            reduction += hist[d];
+            end[d] = reduction;
+        }
+
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            while (next[d] < end[d])
+            {
+                uint64_t key = keys[next[d]];
+                P payload = sortPairs ? payloads[next[d]] : P();
+                for (uint32_t digit = level.Digit(key); digit != d; digit = level.Digit(key))
+                {
+                    std::swap(key, keys[next[digit]]);
+                    if (sortPairs)
+                        std::swap(payload, payloads[next[digit]]);
+                    next[digit]++;
+                }
+
+                keys[next[d]] = key;
+                if (sortPairs)
+                    payloads[next[d]] = payload;
+                next[d]++;
+            }
+        }
+
+        uint32_t bucketStart = 0;
+        for (uint32_t d = 0; d < buckets; ++d)
+        {
+            if (hist[d] > 1)
+            {
+                SortSequential<sortPairs>(
+                    keys + bucketStart,
+                    sortPairs ? payloads + bucketStart : nullptr,
+                    hist[d],
+                    level.shift);
+            }
+            bucketStart += hist[d];
+        }
+    }
+
+    //Only the bits in [beginBit, top) can still differ
+    template<bool sortPairs, typename P>
+    void InPlaceRadixSort::InsertionSort(
+        uint64_t* keys,
+        P* payloads,
+        uint32_t count,
+        uint32_t top) const
+    {
+        const uint64_t windowMask = KeyWindowMask(m_beginBit, top);
+        const uint64_t flip = m_descending ? windowMask : 0;
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            const uint64_t key = keys[i];
+            const P payload = sortPairs ? payloads[i] : P();
+            const uint64_t sortKey = (key & windowMask) ^ flip;
+            uint32_t j = i;
+            for (; j > 0 && ((keys[j - 1] & windowMask) ^ flip) > sortKey; --j)
+            {
+                keys[j] = keys[j - 1];
+                if (sortPairs)
+                    payloads[j] = payloads[j - 1];
+            }
+
+            keys[j] = key;
+            if (sortPairs)
+                payloads[j] = payload;
+        }
+    }
+
+    template<bool sortPairs, typename P>
+    void InPlaceRadixSort::Dispatch(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        static_assert(sizeof(P) <= sizeof(uint64_t), "Payloads are staged in 64-bit slots");
+        ValidateBitWindow(beginBit, endBit);
+
+        m_skippedPasses = 0;
+        m_presortStats = PresortStats();
+        if (numKeys <= 1)
+            return;
+        if (SortSmall<sortPairs>(toSort, toSortPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        //No alt buffer, so runs are never merged
+        if (m_detectPresorted)
+        {
+            CountDescents(toSort, numKeys, beginBit, endBit);
+            if (SortPresorted<sortPairs, P>(toSort, toSortPayload, nullptr, nullptr, numKeys, order, beginBit, endBit))
+                return;
+        }
+
+        m_beginBit = beginBit;
+        m_descending = order == ORDER_DESCENDING;
+        m_tasks.clear();
+        if (numKeys > IPR_PARALLEL_SIZE && m_pool.ThreadCount() > 1)
+        {
+            const size_t stripes = m_pool.ThreadCount();
+            m_bufferKeys.resize(stripes * RADIX * k_partSize);
+            m_bufferCounts.resize(stripes * RADIX);
+            m_flushedBlocks.resize(stripes * RADIX);
+            m_stripeBlocks.resize(stripes);
+            m_swapKeys.resize(stripes * 2 * k_partSize);
+            m_spillKeys.resize((size_t)RADIX * k_partSize);
+            m_overflowKeys.resize(k_partSize);
+            if (sortPairs)
+            {
+                m_bufferPayloads.resize(stripes * RADIX * k_partSize);
+                m_swapPayloads.resize(stripes * 2 * k_partSize);
+                m_spillPayloads.resize((size_t)RADIX * k_partSize);
+                m_overflowPayloads.resize(k_partSize);
+            }
+        }
+
+        PartitionParallel<sortPairs>(toSort, toSortPayload, 0, numKeys, endBit);
+
+        //Largest first, so a big bucket does not start last
+        std::sort(m_tasks.begin(), m_tasks.end(), [](const Task& a, const Task& b)
+        {
+            return a.count > b.count;
+        });
+        m_pool.ParallelFor(
+            (uint32_t)m_tasks.size(),
+            [&](uint32_t taskIndex, uint32_t)
+            {
+                const Task& task = m_tasks[taskIndex];
+                SortSequential<sortPairs>(
+                    toSort + task.start,
+                    sortPairs ? toSortPayload + task.start : nullptr,
+                    task.count,
+                    task.top);
+            });
+    }
+
+    void InPlaceRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t*,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<false, uint32_t>(
+            toSort,
+            nullptr,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void InPlaceRadixSort::Sort(
+        uint64_t* toSort,
+        uint32_t* toSortPayload,
+        uint64_t*,
+        uint32_t*,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void InPlaceRadixSort::Sort(
+        uint64_t* toSort,
+        uint64_t* toSortPayload,
+        uint64_t*,
+        uint64_t*,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+}
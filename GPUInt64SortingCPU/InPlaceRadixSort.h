@@ -0,0 +1,160 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * In place parallel MSD radix sort for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Every other sort here scatters into an alt buffer as large as the input,
+ * which doubles the peak memory. This one permutes the keys within toSort.
+ * A level splits a range on its most significant differing digit in four
+ * parallel phases:
+ *
+ *  1. Each thread classifies a stripe of the range into one buffer block
+ *     per bucket, writing every full block back over the stripe.
+ *  2. The full blocks are compacted to the front of the range.
+ *  3. The blocks are permuted into their buckets, with a read and a write
+ *     pointer per bucket, swapping through two blocks per thread.
+ *  4. The partial blocks left in the buffers fill the edges of the buckets.
+ *
+ * Buckets recurse on the next digit down. Once a bucket is small enough it
+ * becomes a single threaded task, an American flag sort with an insertion
+ * sort below IPR_SMALL_SORT_SIZE. Scratch memory depends on the thread
+ * count and the block size, never on the input size.
+ *
+ * The permutation is not stable: the keys come out in the same order as
+ * the other sorts, the payloads of equal keys may not. alt and altPayload
+ * are never touched and may be null.
+ *
+ * Based off of Research by:
+ *          Michael Axtmann, Sascha Witt, Daniel Ferizovic, Peter Sanders
+ *          https://arxiv.org/abs/2009.13569
+ *
+ ******************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "CPUSortBase.h"
+
+namespace CPUSorting
+{
+    //Keys per block of the permutation, 2 KiB
+    constexpr uint32_t IPR_BLOCK_SIZE = 256;
+
+    //Buckets at or below this size are insertion sorted
+    constexpr uint32_t IPR_SMALL_SORT_SIZE = 32;
+
+    //Buckets at or below this size are sorted by a single thread
+    constexpr uint32_t IPR_PARALLEL_SIZE = 1 << 18;
+
+    class InPlaceRadixSort : public CPUSortBase
+    {
+        //A bucket left for a single thread, top is the bit above its digits
+        struct Task
+        {
+            uint32_t start;
+            uint32_t count;
+            uint32_t top;
+        };
+
+        uint32_t m_beginBit = 0;
+        bool m_descending = false;
+        std::vector<Task> m_tasks;
+
+        //RADIX buffer blocks per stripe, payloads are staged in 64-bit
+        //slots whatever their type
+        std::vector<uint64_t> m_bufferKeys;
+        std::vector<uint64_t> m_bufferPayloads;
+        std::vector<uint32_t> m_bufferCounts;
+
+        //Blocks of each bucket written back by each stripe
+        std::vector<uint32_t> m_flushedBlocks;
+        std::vector<uint32_t> m_stripeBlocks;
+
+        //Two blocks per stripe to swap through during the permutation
+        std::vector<uint64_t> m_swapKeys;
+        std::vector<uint64_t> m_swapPayloads;
+
+        //A bucket's last block may spill over into the next bucket, and the
+        //block at the end of an unaligned range has nowhere to go at all
+        std::vector<uint64_t> m_spillKeys;
+        std::vector<uint64_t> m_spillPayloads;
+        std::vector<uint64_t> m_overflowKeys;
+        std::vector<uint64_t> m_overflowPayloads;
+        uint32_t m_spillCounts[RADIX];
+
+        //Block indices, the permutation writes to m_write and reads the
+        //unplaced blocks below m_read
+        std::atomic<int64_t> m_write[RADIX];
+        std::atomic<int64_t> m_read[RADIX];
+        std::atomic<uint32_t> m_reading[RADIX];
+
+    public:
+        InPlaceRadixSort(ThreadPool& pool, uint32_t blockSize = IPR_BLOCK_SIZE);
+
+        //Bytes of scratch memory held after the last sort
+        size_t ScratchBytes() const;
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* alt,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint32_t* toSortPayload,
+            uint64_t* alt,
+            uint32_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* toSortPayload,
+            uint64_t* alt,
+            uint64_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+    private:
+        template<bool sortPairs, typename P>
+        void PartitionParallel(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint32_t start,
+            uint32_t count,
+            uint32_t top);
+
+        template<bool sortPairs, typename P>
+        void SortSequential(
+            uint64_t* keys,
+            P* payloads,
+            uint32_t count,
+            uint32_t top) const;
+
+        template<bool sortPairs, typename P>
+        void InsertionSort(
+            uint64_t* keys,
+            P* payloads,
+            uint32_t count,
+            uint32_t top) const;
+
+        template<bool sortPairs, typename P>
+        void Dispatch(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+    };
+}
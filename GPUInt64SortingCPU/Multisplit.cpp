@@ -0,0 +1,58 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Key ranking kernels for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "Multisplit.h"
+#include "CPUFeatures.h"
+
+namespace CPUSorting
+{
+    void RankScalar(
+        const uint64_t* keys,
+        uint32_t count,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        uint32_t* hist,
+        uint32_t* ranks)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+            ranks[i] = hist[(uint32_t)(keys[i] >> radixShift) & digitMask]++;
+    }
+
+    bool IsRankISASupported(RANK_ISA isa)
+    {
+        switch (isa)
+        {
+        case RANK_ISA_SCALAR:
+            return true;
+        case RANK_ISA_AVX512:
+            return HasCPUFeature(CPU_FEATURE_AVX512CD_VPOPCNTDQ);
+        default:
+            return false;
+        }
+    }
+
+    RANK_ISA DetectRankISA()
+    {
+        return IsRankISASupported(RANK_ISA_AVX512) ? RANK_ISA_AVX512 : RANK_ISA_SCALAR;
+    }
+
+    RankKernel GetRankKernel(RANK_ISA isa)
+    {
+#if defined(CPU_SORTING_X86)
+        if (isa == RANK_ISA_AVX512 && IsRankISASupported(isa))
+            return RankAVX512;
+#endif
+        (void)isa;
+        return RankScalar;
+    }
+
+    const char* RankISAName(RANK_ISA isa)
+    {
+        return isa == RANK_ISA_AVX512 ? "AVX-512" : "Scalar";
+    }
+}
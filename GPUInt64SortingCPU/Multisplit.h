@@ -0,0 +1,66 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Key ranking kernels for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * The CPU counterpart of WarpLevelMultiSplit in SortCommon.hlsl. A rank
+ * is the number of keys before it in the tile with the same digit, so
+ * the tile's exclusive digit offsets plus the ranks give stable local
+ * positions. The scalar build takes one running count per key, which
+ * serializes on the same counter when digits repeat. The AVX-512 build
+ * ranks sixteen keys at once: vpconflictd finds the earlier lanes with
+ * the same digit, the ballot of CountPeerBits, and a popcount of it is
+ * the rank among them.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include "SortCommon.h"
+
+namespace CPUSorting
+{
+    enum RANK_ISA
+    {
+        RANK_ISA_SCALAR = 0,
+        RANK_ISA_AVX512 = 1,
+    };
+
+    //Writes the rank of keys[0, count) to ranks, and adds the tile's digit
+    //counts to hist, which has to start zeroed
+    typedef void (*RankKernel)(
+        const uint64_t* keys,
+        uint32_t count,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        uint32_t* hist,
+        uint32_t* ranks);
+
+    void RankScalar(
+        const uint64_t* keys,
+        uint32_t count,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        uint32_t* hist,
+        uint32_t* ranks);
+
+    //Only defined in x86 builds, see CMakeLists.txt
+    void RankAVX512(
+        const uint64_t* keys,
+        uint32_t count,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        uint32_t* hist,
+        uint32_t* ranks);
+
+    bool IsRankISASupported(RANK_ISA isa);
+
+    //The widest build both compiled in and supported by this CPU
+    RANK_ISA DetectRankISA();
+
+    //Falls back to scalar for an unsupported isa
+    RankKernel GetRankKernel(RANK_ISA isa);
+
+    const char* RankISAName(RANK_ISA isa);
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * AVX-512 key ranking
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Compiled with AVX-512F, CD and VPOPCNTDQ enabled, only called after a
+ * runtime check. Do not call inline helpers from the shared headers
+ * here, the linker may keep this copy of them for the whole program.
+ *
+ ******************************************************************************/
+#include "Multisplit.h"
+
+#if defined(CPU_SORTING_X86)
+#include <immintrin.h>
+
+namespace CPUSorting
+{
+    //Per group of sixteen keys: gather the running counts of their digits,
+    //add each lane's count of lower peers, then scatter back the rank plus
+    //one. Scatters to the same address land in lane order, so the highest
+    //peer, the one holding the group's total, is the value that sticks.
+    void RankAVX512(
+        const uint64_t* keys,
+        uint32_t count,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        uint32_t* hist,
+        uint32_t* ranks)
+    {
+        constexpr uint32_t lanes = 16;
+        const __m512i shift = _mm512_set1_epi64(radixShift);
+        const __m512i mask = _mm512_set1_epi32(digitMask);
+        const __m512i one = _mm512_set1_epi32(1);
+
+        uint32_t i = 0;
+        for (; i + lanes <= count; i += lanes)
+        {
+            const __m256i lo = _mm512_cvtepi64_epi32(
+                _mm512_srlv_epi64(_mm512_loadu_si512((const void*)(keys + i)), shift));
+            const __m256i hi = _mm512_cvtepi64_epi32(
+                _mm512_srlv_epi64(_mm512_loadu_si512((const void*)(keys + i + 8)), shift));
+            const __m512i digits = _mm512_and_si512(
+                _mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1), mask);
+
+            const __m512i peers = _mm512_popcnt_epi32(_mm512_conflict_epi32(digits));
+            const __m512i rank = _mm512_add_epi32(_mm512_i32gather_epi32(digits, hist, 4), peers);
+            _mm512_storeu_si512((void*)(ranks + i), rank);
+            _mm512_i32scatter_epi32(hist, digits, _mm512_add_epi32(rank, one), 4);
+        }
+
+        for (; i < count; ++i)
+            ranks[i] = hist[(uint32_t)(keys[i] >> radixShift) & digitMask]++;
+    }
+}
+#endif
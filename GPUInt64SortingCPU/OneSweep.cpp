@@ -0,0 +1,272 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * CPU OneSweep for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "OneSweep.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace CPUSorting
+{
+    OneSweep::OneSweep(ThreadPool& pool, uint32_t partSize) :
+        CPUSortBase(pool, "OneSweep", partSize)
+    {
+        for (uint32_t i = 0; i < RADIX_PASSES; ++i)
+            m_index[i].store(0, std::memory_order_relaxed);
+    }
+
+    //Clears the tiles of every pass that will run, then posts the global
+    //offsets as the inclusive values of slot 0, seeding the lookback
+    void OneSweep::InitSweep(uint32_t threadBlocks, uint32_t passMask)
+    {
+        m_pool.ParallelFor(
+            RADIX_PASSES,
+            [&](uint32_t pass, uint32_t)
+            {
+                m_index[pass].store(0, std::memory_order_relaxed);
+                if ((passMask >> pass & 1) == 0)
+                    return;
+
+                std::atomic<uint32_t>* passHist = &m_passHist[(size_t)pass * threadBlocks * RADIX];
+                for (uint32_t i = 0; i < RADIX; ++i)
+                    passHist[i].store(m_globalHist[pass * RADIX + i] << 2 | FLAG_INCLUSIVE, std::memory_order_relaxed);
+                for (size_t i = RADIX; i < (size_t)threadBlocks * RADIX; ++i)
+                    passHist[i].store(FLAG_NOT_READY, std::memory_order_relaxed);
+            });
+    }
+
+    //Walks back from the tile's own slot, adding reductions until every
+    //digit has met an inclusive value. Slot 0 is always inclusive. The
+    //tiles looked at were claimed before this one, so their owners are
+    //running and will publish, barring preemption.
+    void OneSweep::Lookback(
+        uint32_t partitionIndex,
+        uint32_t threadBlocks,
+        uint32_t pass,
+        uint32_t* exclusive)
+    {
+        bool complete[RADIX] = {};
+        uint32_t remaining = RADIX;
+        for (uint32_t k = partitionIndex; remaining; --k)
+        {
+            const std::atomic<uint32_t>* slot =
+                &m_passHist[((size_t)pass * threadBlocks + k) * RADIX];
+            for (uint32_t i = 0; i < RADIX; ++i)
+            {
+                if (complete[i])
+                    continue;
+
+                uint32_t flagPayload;
+                uint32_t spinCount = 0;
+                while (((flagPayload = slot[i].load(std::memory_order_acquire)) & FLAG_MASK) == FLAG_NOT_READY)
+                {
+                    if (++spinCount == k_maxSpinCount)
+                    {
+                        std::this_thread::yield();
+                        spinCount = 0;
+                    }
+                }
+
+                exclusive[i] += flagPayload >> 2;
+                if ((flagPayload & FLAG_MASK) == FLAG_INCLUSIVE)
+                {
+                    complete[i] = true;
+                    remaining--;
+                }
+            }
+        }
+    }
+
+    //The tile is read once to count, and again from cache to scatter.
+    //Walking it in order keeps the scatter stable. On the final pass of
+    //a descending sort, the index is mirrored, see DescendingIndex.
+    template<bool sortPairs, typename P>
+    void OneSweep::DigitBinningPass(
+        const uint64_t* toSort,
+        const P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        uint32_t threadBlocks,
+        uint32_t radixShift,
+        uint32_t digitMask,
+        bool shouldReverse)
+    {
+        const uint32_t pass = radixShift >> 3;
+        m_pool.ParallelFor(
+            threadBlocks,
+            [&](uint32_t, uint32_t)
+            {
+                const uint32_t partitionIndex = m_index[pass].fetch_add(1, std::memory_order_relaxed);
+                const uint32_t start = partitionIndex * k_partSize;
+                const uint32_t end = std::min(numKeys - start, k_partSize) + start;
+
+                uint32_t hist[RADIX] = {};
+                for (uint32_t i = start; i < end; ++i)
+                    hist[(uint32_t)(toSort[i] >> radixShift) & digitMask]++;
+
+                //The last tile has no successor to publish to
+                std::atomic<uint32_t>* publish = partitionIndex < threadBlocks - 1 ?
+                    &m_passHist[((size_t)pass * threadBlocks + partitionIndex + 1) * RADIX] : nullptr;
+                if (publish != nullptr)
+                {
+                    for (uint32_t i = 0; i < RADIX; ++i)
+                        publish[i].store(hist[i] << 2 | FLAG_REDUCTION, std::memory_order_release);
+                }
+
+                uint32_t offsets[RADIX] = {};
+                Lookback(partitionIndex, threadBlocks, pass, offsets);
+
+                if (publish != nullptr)
+                {
+                    for (uint32_t i = 0; i < RADIX; ++i)
+                        publish[i].store((offsets[i] + hist[i]) << 2 | FLAG_INCLUSIVE, std::memory_order_release);
+                }
+
+                for (uint32_t i = start; i < end; ++i)
+                {
+                    const uint64_t key = toSort[i];
+                    uint32_t deviceIndex = offsets[(uint32_t)(key >> radixShift) & digitMask]++;
+                    if (shouldReverse)
+                        deviceIndex = numKeys - deviceIndex - 1;
+
+                    alt[deviceIndex] = key;
+                    if (sortPairs)
+                        altPayload[deviceIndex] = toSortPayload[i];
+                }
+            });
+    }
+
+    template<bool sortPairs, typename P>
+    void OneSweep::Dispatch(
+        uint64_t* toSort,
+        P* toSortPayload,
+        uint64_t* alt,
+        P* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        ValidateBitWindow(beginBit, endBit);
+        if (numKeys >= k_maxSweepSize)
+            throw std::length_error("OneSweep supports fewer than 2^30 keys");
+
+        m_skippedPasses = 0;
+        m_presortStats = PresortStats();
+        if (numKeys <= 1)
+            return;
+        if (SortSmall<sortPairs>(toSort, toSortPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        const uint32_t threadBlocks = DivRoundUp(numKeys, k_partSize);
+        const size_t passHistSize = (size_t)threadBlocks * RADIX * RADIX_PASSES;
+        if (passHistSize > m_passHistSize)
+        {
+            m_passHist.reset(new std::atomic<uint32_t>[passHistSize]);
+            m_passHistSize = passHistSize;
+        }
+
+        GlobalHistogram(toSort, numKeys, beginBit, endBit);
+        if (SortPresorted<sortPairs>(toSort, toSortPayload, alt, altPayload, numKeys, order, beginBit, endBit))
+            return;
+
+        const uint32_t trivialMask = m_skipTrivialPasses ?
+            GetTrivialPassMask(numKeys, order, beginBit, endBit) : 0;
+        const uint32_t passMask = GetPassMask(beginBit, endBit, trivialMask);
+        InitSweep(threadBlocks, passMask);
+
+        for (uint32_t radixShift = 0; radixShift < KEY_BITS; radixShift += RADIX_LOG)
+        {
+            //Outside of the window, or an identity permutation
+            if ((passMask >> (radixShift >> 3) & 1) == 0)
+            {
+                if ((trivialMask >> (radixShift >> 3) & 1) != 0)
+                    m_skippedPasses++;
+                continue;
+            }
+
+            DigitBinningPass<sortPairs>(
+                toSort,
+                toSortPayload,
+                alt,
+                altPayload,
+                numKeys,
+                threadBlocks,
+                radixShift,
+                DigitMask(radixShift, beginBit, endBit),
+                order == ORDER_DESCENDING && IsFinalPass(radixShift, endBit));
+
+            std::swap(toSort, alt);
+            if (sortPairs)
+                std::swap(toSortPayload, altPayload);
+        }
+    }
+
+    void OneSweep::Sort(
+        uint64_t* toSort,
+        uint64_t* alt,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<false, uint32_t>(
+            toSort,
+            nullptr,
+            alt,
+            nullptr,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void OneSweep::Sort(
+        uint64_t* toSort,
+        uint32_t* toSortPayload,
+        uint64_t* alt,
+        uint32_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+
+    void OneSweep::Sort(
+        uint64_t* toSort,
+        uint64_t* toSortPayload,
+        uint64_t* alt,
+        uint64_t* altPayload,
+        uint32_t numKeys,
+        ORDER order,
+        uint32_t beginBit,
+        uint32_t endBit)
+    {
+        Dispatch<true>(
+            toSort,
+            toSortPayload,
+            alt,
+            altPayload,
+            numKeys,
+            order,
+            beginBit,
+            endBit);
+    }
+}
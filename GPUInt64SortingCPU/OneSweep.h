@@ -0,0 +1,114 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * CPU OneSweep for 64-bit keys
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * A multithreaded port of OneSweep.compute. After the global histogram,
+ * each pass is a single digit binning pass: workers claim tiles through
+ * a bump counter, publish their per digit counts as packed flag words,
+ * and find their offsets by decoupled lookback over the preceding tiles,
+ * so the keys are read and written once per pass.
+ *
+ * Based off of Research by:
+ *          Andy Adinets, Nvidia Corporation
+ *          Duane Merrill, Nvidia Corporation
+ *          https://research.nvidia.com/publication/2022-06_onesweep-faster-least-significant-digit-radix-sort-gpus
+ *
+ ******************************************************************************/
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "CPUSortBase.h"
+
+namespace CPUSorting
+{
+    class OneSweep : public CPUSortBase
+    {
+        //Same flags as SweepCommon.hlsl, the count sits above them
+        static constexpr uint32_t FLAG_NOT_READY = 0;
+        static constexpr uint32_t FLAG_REDUCTION = 1;
+        static constexpr uint32_t FLAG_INCLUSIVE = 2;
+        static constexpr uint32_t FLAG_MASK = 3;
+
+        //Spins on a not ready tile before yielding the core, in case
+        //the thread that owns it has been descheduled
+        static constexpr uint32_t k_maxSpinCount = 1024;
+
+        //Packing two flag bits limits a count to 30 bits
+        static constexpr uint32_t k_maxSweepSize = 1U << 30;
+
+        //((pass * threadBlocks) + slot) * RADIX + digit, as b_passHist.
+        //Slot 0 holds the global offsets, tile i publishes to slot i + 1.
+        std::unique_ptr<std::atomic<uint32_t>[]> m_passHist;
+        size_t m_passHistSize = 0;
+
+        //One tile counter per pass, as b_index
+        std::atomic<uint32_t> m_index[RADIX_PASSES];
+
+    public:
+        OneSweep(ThreadPool& pool, uint32_t partSize = PART_SIZE);
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* alt,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint32_t* toSortPayload,
+            uint64_t* alt,
+            uint32_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+        void Sort(
+            uint64_t* toSort,
+            uint64_t* toSortPayload,
+            uint64_t* alt,
+            uint64_t* altPayload,
+            uint32_t numKeys,
+            ORDER order = ORDER_ASCENDING,
+            uint32_t beginBit = 0,
+            uint32_t endBit = KEY_BITS) override;
+
+    private:
+        void InitSweep(uint32_t threadBlocks, uint32_t passMask);
+
+        void Lookback(
+            uint32_t partitionIndex,
+            uint32_t threadBlocks,
+            uint32_t pass,
+            uint32_t* exclusive);
+
+        template<bool sortPairs, typename P>
+        void DigitBinningPass(
+            const uint64_t* toSort,
+            const P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            uint32_t threadBlocks,
+            uint32_t radixShift,
+            uint32_t digitMask,
+            bool shouldReverse);
+
+        template<bool sortPairs, typename P>
+        void Dispatch(
+            uint64_t* toSort,
+            P* toSortPayload,
+            uint64_t* alt,
+            P* altPayload,
+            uint32_t numKeys,
+            ORDER order,
+            uint32_t beginBit,
+            uint32_t endBit);
+    };
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Sorting network kernels for small CPU sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "SmallSort.h"
+#include "CPUFeatures.h"
+
+namespace CPUSorting
+{
+    void SmallSortScalar(uint64_t* keys, uint64_t* values, uint32_t count)
+    {
+        for (uint32_t i = 1; i < count; ++i)
+        {
+            const uint64_t key = keys[i];
+            const uint64_t value = values[i];
+            uint32_t j = i;
+            for (; j > 0 && (keys[j - 1] > key || (keys[j - 1] == key && values[j - 1] > value)); --j)
+            {
+                keys[j] = keys[j - 1];
+                values[j] = values[j - 1];
+            }
+            keys[j] = key;
+            values[j] = value;
+        }
+    }
+
+    bool IsSmallSortISASupported(SMALL_SORT_ISA isa)
+    {
+        switch (isa)
+        {
+        case SMALL_SORT_ISA_SCALAR:
+            return true;
+        case SMALL_SORT_ISA_AVX2:
+            return HasCPUFeature(CPU_FEATURE_AVX2);
+        default:
+            return false;
+        }
+    }
+
+    SMALL_SORT_ISA DetectSmallSortISA()
+    {
+        return IsSmallSortISASupported(SMALL_SORT_ISA_AVX2) ? SMALL_SORT_ISA_AVX2 : SMALL_SORT_ISA_SCALAR;
+    }
+
+    SmallSortKernel GetSmallSortKernel(SMALL_SORT_ISA isa)
+    {
+#if defined(CPU_SORTING_X86)
+        if (isa == SMALL_SORT_ISA_AVX2 && IsSmallSortISASupported(isa))
+            return SmallSortAVX2;
+#endif
+        (void)isa;
+        return SmallSortScalar;
+    }
+
+    const char* SmallSortISAName(SMALL_SORT_ISA isa)
+    {
+        return isa == SMALL_SORT_ISA_AVX2 ? "AVX2" : "Scalar";
+    }
+}
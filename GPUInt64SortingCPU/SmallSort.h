@@ -0,0 +1,54 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Sorting network kernels for small CPU sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Below a few hundred keys, the histogram read and the thread pool round
+ * trips of every pass cost more than the sort itself. The kernels sort
+ * (key, value) pairs in lexicographic order. With the input index as the
+ * value, the order by key alone is stable, so a small sort matches the
+ * radix sorts exactly. The AVX2 build runs a bitonic network four pairs
+ * to a register, the scalar build is an insertion sort.
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+#include "SortCommon.h"
+
+namespace CPUSorting
+{
+    //Largest input the kernels accept, and the default threshold below
+    //which the radix sorts switch to them
+    constexpr uint32_t SMALL_SORT_SIZE = 256;
+
+    enum SMALL_SORT_ISA
+    {
+        SMALL_SORT_ISA_SCALAR = 0,
+        SMALL_SORT_ISA_AVX2 = 1,
+    };
+
+    //Sorts the pairs (keys[i], values[i]) of [0, count) ascending by key,
+    //then by value, both compared as unsigned. count is at most
+    //SMALL_SORT_SIZE.
+    typedef void (*SmallSortKernel)(
+        uint64_t* keys,
+        uint64_t* values,
+        uint32_t count);
+
+    void SmallSortScalar(uint64_t* keys, uint64_t* values, uint32_t count);
+
+    //Only defined in x86 builds, see CMakeLists.txt
+    void SmallSortAVX2(uint64_t* keys, uint64_t* values, uint32_t count);
+
+    bool IsSmallSortISASupported(SMALL_SORT_ISA isa);
+
+    //The widest build both compiled in and supported by this CPU
+    SMALL_SORT_ISA DetectSmallSortISA();
+
+    //Falls back to scalar for an unsupported isa
+    SmallSortKernel GetSmallSortKernel(SMALL_SORT_ISA isa);
+
+    const char* SmallSortISAName(SMALL_SORT_ISA isa);
+}
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * AVX2 bitonic sorting network for small CPU sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Compiled with AVX2 enabled, only called after a runtime check. Do
+ * not call inline helpers from the shared headers here, the linker may
+ * keep this copy of them for the whole program.
+ *
+ ******************************************************************************/
+#include "SmallSort.h"
+
+#if defined(CPU_SORTING_X86)
+#include <immintrin.h>
+
+namespace CPUSorting
+{
+    //AVX2 only compares signed 64-bit lanes, flipping the top bit of the
+    //keys and values makes that order the unsigned one
+    static const uint64_t k_signBit = (uint64_t)1 << 63;
+
+    //Lanes where (ka, va) comes after (kb, vb)
+    static inline __m256i GreaterThan(__m256i ka, __m256i va, __m256i kb, __m256i vb)
+    {
+        return _mm256_or_si256(
+            _mm256_cmpgt_epi64(ka, kb),
+            _mm256_and_si256(_mm256_cmpeq_epi64(ka, kb), _mm256_cmpgt_epi64(va, vb)));
+    }
+
+    static inline __m256i Reverse(__m256i x)
+    {
+        return _mm256_permute4x64_epi64(x, 0x1B);
+    }
+
+    //The lesser pair of each lane to a, the greater to b
+    static inline void CompareExchange(__m256i& ka, __m256i& va, __m256i& kb, __m256i& vb)
+    {
+        const __m256i swap = GreaterThan(ka, va, kb, vb);
+        const __m256i k = _mm256_blendv_epi8(ka, kb, swap);
+        const __m256i v = _mm256_blendv_epi8(va, vb, swap);
+        kb = _mm256_blendv_epi8(kb, ka, swap);
+        vb = _mm256_blendv_epi8(vb, va, swap);
+        ka = k;
+        va = v;
+    }
+
+    //Pairs the lanes of one register as permuted by perm. The lanes set
+    //in lowMask keep the lesser pair, their partners the greater one.
+    template<int perm>
+    static inline void CompareExchangeLanes(__m256i& k, __m256i& v, __m256i lowMask)
+    {
+        const __m256i pk = _mm256_permute4x64_epi64(k, perm);
+        const __m256i pv = _mm256_permute4x64_epi64(v, perm);
+        const __m256i take = _mm256_blendv_epi8(
+            GreaterThan(pk, pv, k, v),
+            GreaterThan(k, v, pk, pv),
+            lowMask);
+        k = _mm256_blendv_epi8(k, pk, take);
+        v = _mm256_blendv_epi8(v, pv, take);
+    }
+
+    //The bitonic network with the first step of every merge mirrored,
+    //so both halves merge as ascending runs and every exchange puts the
+    //lesser pair first. The input is padded to a power of two with the
+    //greatest pair, which ties with a real one only if they are equal.
+    void SmallSortAVX2(uint64_t* keys, uint64_t* values, uint32_t count)
+    {
+        constexpr uint32_t lanes = 4;
+        alignas(32) uint64_t k[SMALL_SORT_SIZE];
+        alignas(32) uint64_t v[SMALL_SORT_SIZE];
+
+        uint32_t n = lanes;
+        while (n < count)
+            n <<= 1;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            k[i] = keys[i] ^ k_signBit;
+            v[i] = values[i] ^ k_signBit;
+        }
+        for (uint32_t i = count; i < n; ++i)
+        {
+            k[i] = ~k_signBit;
+            v[i] = ~k_signBit;
+        }
+
+        const __m256i lowEven = _mm256_setr_epi64x(-1, 0, -1, 0);
+        const __m256i lowHalf = _mm256_setr_epi64x(-1, -1, 0, 0);
+        for (uint32_t size = 2; size <= n; size <<= 1)
+        {
+            if (size == 2 || size == 4)
+            {
+                for (uint32_t i = 0; i < n; i += lanes)
+                {
+                    __m256i ki = _mm256_load_si256((const __m256i*)(k + i));
+                    __m256i vi = _mm256_load_si256((const __m256i*)(v + i));
+                    if (size == 2)
+                        CompareExchangeLanes<0xB1>(ki, vi, lowEven);
+                    else
+                        CompareExchangeLanes<0x1B>(ki, vi, lowHalf);
+                    _mm256_store_si256((__m256i*)(k + i), ki);
+                    _mm256_store_si256((__m256i*)(v + i), vi);
+                }
+            }
+            else
+            {
+                for (uint32_t base = 0; base < n; base += size)
+                {
+                    for (uint32_t i = base, j = base + size - lanes; i < j; i += lanes, j -= lanes)
+                    {
+                        __m256i ki = _mm256_load_si256((const __m256i*)(k + i));
+                        __m256i vi = _mm256_load_si256((const __m256i*)(v + i));
+                        __m256i kj = Reverse(_mm256_load_si256((const __m256i*)(k + j)));
+                        __m256i vj = Reverse(_mm256_load_si256((const __m256i*)(v + j)));
+                        CompareExchange(ki, vi, kj, vj);
+                        _mm256_store_si256((__m256i*)(k + i), ki);
+                        _mm256_store_si256((__m256i*)(v + i), vi);
+                        _mm256_store_si256((__m256i*)(k + j), Reverse(kj));
+                        _mm256_store_si256((__m256i*)(v + j), Reverse(vj));
+                    }
+                }
+            }
+
+            //Half cleaners, across registers down to a stride of one
+            //register, then within each register
+            for (uint32_t stride = size >> 2; stride >= lanes; stride >>= 1)
+            {
+                for (uint32_t i = 0; i < n; i += lanes)
+                {
+                    if (i & stride)
+                        continue;
+
+                    __m256i ki = _mm256_load_si256((const __m256i*)(k + i));
+                    __m256i vi = _mm256_load_si256((const __m256i*)(v + i));
+                    __m256i kj = _mm256_load_si256((const __m256i*)(k + i + stride));
+                    __m256i vj = _mm256_load_si256((const __m256i*)(v + i + stride));
+                    CompareExchange(ki, vi, kj, vj);
+                    _mm256_store_si256((__m256i*)(k + i), ki);
+                    _mm256_store_si256((__m256i*)(v + i), vi);
+                    _mm256_store_si256((__m256i*)(k + i + stride), kj);
+                    _mm256_store_si256((__m256i*)(v + i + stride), vj);
+                }
+            }
+
+            if (size >= 4)
+            {
+                for (uint32_t i = 0; i < n; i += lanes)
+                {
+                    __m256i ki = _mm256_load_si256((const __m256i*)(k + i));
+                    __m256i vi = _mm256_load_si256((const __m256i*)(v + i));
+                    if (size >= 8)
+                        CompareExchangeLanes<0x4E>(ki, vi, lowHalf);
+                    CompareExchangeLanes<0xB1>(ki, vi, lowEven);
+                    _mm256_store_si256((__m256i*)(k + i), ki);
+                    _mm256_store_si256((__m256i*)(v + i), vi);
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            keys[i] = k[i] ^ k_signBit;
+            values[i] = v[i] ^ k_signBit;
+        }
+    }
+}
+#endif
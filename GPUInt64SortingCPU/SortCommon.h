@@ -0,0 +1,188 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Shared constants and helpers for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#pragma once
+#include <cstdint>
+
+namespace CPUSorting
+{
+    // MUST match the defines in SortCommon.hlsl and DeviceRadixSort.compute
+    constexpr uint32_t RADIX = 256;
+    constexpr uint32_t RADIX_MASK = 255;
+    constexpr uint32_t RADIX_LOG = 8;
+    constexpr uint32_t RADIX_PASSES = 8;
+    constexpr uint32_t PART_SIZE = 3840;
+    constexpr uint32_t G_HIST_PART_SIZE = 32768;
+    constexpr uint32_t KEY_BITS = 64;
+
+    enum ORDER
+    {
+        ORDER_ASCENDING = 0,
+        ORDER_DESCENDING = 1,
+    };
+
+    //How the DeviceRadixSort downsweep places a tile's keys
+    enum DOWNSWEEP_MODE
+    {
+        //Each key straight to its destination, a counting sort scatter
+        DOWNSWEEP_DIRECT = 0,
+
+        //Ranked into a tile sized buffer first, then one copy per digit
+        //run, as ScatterKeysShared and ScatterDevice
+        DOWNSWEEP_SHARED = 1,
+
+        //Staged in one cache line per digit, full lines are written with
+        //non-temporal stores, a software write combining scatter
+        DOWNSWEEP_WRITE_COMBINING = 2,
+    };
+
+    //What the pre-sortedness check of the global histogram did with a sort
+    enum PRESORT_PATH
+    {
+        //Not detected, or not enabled, the full radix sort ran
+        PRESORT_NONE = 0,
+
+        //Already in order, returned without a pass
+        PRESORT_SORTED = 1,
+
+        //In the opposite order without equal neighbours, reversed in place
+        PRESORT_REVERSED = 2,
+
+        //At most the run limit of ascending runs, merged pairwise
+        PRESORT_MERGED = 3,
+    };
+
+    //Default limit of ascending runs that are merged instead of radix
+    //sorted, four merge rounds against up to eight scatter passes
+    constexpr uint32_t PRESORT_MAX_RUNS = 16;
+
+    //Same presets as UtilityKernels.cuh
+    enum ENTROPY_PRESET
+    {
+        ENTROPY_PRESET_1 = 0,
+        ENTROPY_PRESET_2 = 1,
+        ENTROPY_PRESET_3 = 2,
+        ENTROPY_PRESET_4 = 3,
+        ENTROPY_PRESET_5 = 4,
+    };
+
+    //Safe up to UINT32_MAX, x + y - 1 is not
+    inline uint32_t DivRoundUp(uint32_t x, uint32_t y)
+    {
+        return x / y + (x % y != 0 ? 1 : 0);
+    }
+
+    //Bits of the digit at radixShift that fall inside [beginBit, endBit),
+    //bits outside of the window never influence the order
+    inline uint32_t DigitMask(uint32_t radixShift, uint32_t beginBit, uint32_t endBit)
+    {
+        if (endBit <= radixShift || beginBit >= radixShift + RADIX_LOG)
+            return 0;
+
+        const uint32_t lowCut = beginBit > radixShift ? beginBit - radixShift : 0;
+        const uint32_t highCut = endBit - radixShift < RADIX_LOG ? endBit - radixShift : RADIX_LOG;
+        return (RADIX_MASK >> (RADIX_LOG - highCut)) & ~((1U << lowCut) - 1);
+    }
+
+    //The same window over the whole key, for the global histogram
+    inline uint64_t KeyWindowMask(uint32_t beginBit, uint32_t endBit)
+    {
+        const uint64_t high = endBit >= KEY_BITS ?
+            ~(uint64_t)0 : ((uint64_t)1 << endBit) - 1;
+        return high & ~(((uint64_t)1 << beginBit) - 1);
+    }
+
+    //One above the highest set bit of diff, or beginBit if there is none
+    inline uint32_t TopOfDiff(uint64_t diff, uint32_t beginBit)
+    {
+        uint32_t top = beginBit;
+        while (top < KEY_BITS && (diff >> top) != 0)
+            top++;
+        return top;
+    }
+
+    //The last pass is the one covering the top bit of the window
+    inline bool IsFinalPass(uint32_t radixShift, uint32_t endBit)
+    {
+        return radixShift < endBit && radixShift + RADIX_LOG >= endBit;
+    }
+
+    //One bit per 8 bit pass that has to be run for [beginBit, endBit), see
+    //GPUSortBase.GetPassMask. Keeping the pass count even lands the result
+    //back in the sort buffer, which keeps the CPU path a bit exact oracle.
+    inline uint32_t GetPassMask(uint32_t beginBit, uint32_t endBit, uint32_t trivialMask)
+    {
+        uint32_t passMask = 0;
+        for (uint32_t radixShift = beginBit & ~7U; radixShift < endBit; radixShift += RADIX_LOG)
+            passMask |= 1U << (radixShift >> 3);
+        passMask &= ~trivialMask;
+
+        uint32_t passCount = 0;
+        for (uint32_t t = passMask; t != 0; t &= t - 1)
+            passCount++;
+
+        if (passCount & 1)
+        {
+            if (trivialMask != 0)
+                passMask |= trivialMask & (0U - trivialMask);
+            else
+                passMask |= 1U << (beginBit >= 8 ? (beginBit >> 3) - 1 : (endBit + 7) >> 3);
+        }
+
+        return passMask;
+    }
+
+    //Hybrid LCG-Tausworthe PRNG, a serial port of InitRandom in
+    //UtilityKernels.cuh. Each 64-bit key draws two words per AND, so
+    //the entropy per bit matches the 32-bit presets.
+    class EntropyGenerator
+    {
+        uint32_t z1;
+        uint32_t z2;
+        uint32_t z3;
+        uint32_t z4;
+
+        uint32_t Next()
+        {
+            z1 = ((z1 & 4294967294U) << 12) ^ (((z1 << 13) ^ z1) >> 19);
+            z2 = ((z2 & 4294967288U) << 4) ^ (((z2 << 2) ^ z2) >> 25);
+            z3 = ((z3 & 4294967280U) << 17) ^ (((z3 << 3) ^ z3) >> 11);
+            z4 = z4 * 1664525 + 1013904223U;
+            return z1 ^ z2 ^ z3 ^ z4;
+        }
+
+    public:
+        EntropyGenerator(uint32_t idx, uint32_t seed) :
+            z1((idx << 2) * seed),
+            z2(((idx << 2) + 1) * seed),
+            z3(((idx << 2) + 2) * seed),
+            z4(((idx << 2) + 3) * seed)
+        {
+            Next();
+        }
+
+        uint64_t NextKey(ENTROPY_PRESET entropyPreset)
+        {
+            uint64_t t = ~(uint64_t)0;
+            for (uint32_t k = 0; k <= (uint32_t)entropyPreset; ++k)
+            {
+                const uint64_t low = Next();
+                t &= (uint64_t)Next() << 32 | low;
+            }
+            return t;
+        }
+    };
+
+    //Number of keys ANDed | Entropy per bit
+    //        0           |  1.0 bits
+    //        1           | .811 bits
+    //        2           | .544 bits
+    //        3           | .337 bits
+    //        4           | .201 bits
+    constexpr float k_entropyLookup[5] = { 1.0f, .811f, .544f, .337f, .201f };
+}
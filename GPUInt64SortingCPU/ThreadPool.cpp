@@ -0,0 +1,103 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Fixed size worker pool for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#include "ThreadPool.h"
+
+namespace CPUSorting
+{
+    ThreadPool::ThreadPool(uint32_t threadCount)
+    {
+        if (threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0)
+            threadCount = 1;
+
+        m_workers.reserve(threadCount - 1);
+        for (uint32_t i = 1; i < threadCount; ++i)
+            m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_startCondition.notify_all();
+
+        for (std::thread& worker : m_workers)
+            worker.join();
+    }
+
+    void ThreadPool::RunIndices(uint32_t threadIndex)
+    {
+        for (uint32_t i = m_next.fetch_add(1, std::memory_order_relaxed);
+            i < m_count;
+            i = m_next.fetch_add(1, std::memory_order_relaxed))
+        {
+            (*m_func)(i, threadIndex);
+        }
+    }
+
+    //Every worker checks in once per generation, so a worker can never
+    //wake up late and pick up indices of the next ParallelFor
+    void ThreadPool::WorkerLoop(uint32_t threadIndex)
+    {
+        uint64_t seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_startCondition.wait(lock, [&] {
+                    return m_stop || m_generation != seenGeneration; });
+                if (m_stop)
+                    return;
+                seenGeneration = m_generation;
+            }
+
+            RunIndices(threadIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (--m_active == 0)
+                    m_doneCondition.notify_one();
+            }
+        }
+    }
+
+    void ThreadPool::ParallelFor(
+        uint32_t count,
+        const std::function<void(uint32_t, uint32_t)>& func)
+    {
+        if (count == 0)
+            return;
+
+        if (m_workers.empty() || count == 1)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                func(i, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_func = &func;
+            m_count = count;
+            m_next.store(0, std::memory_order_relaxed);
+            m_active = (uint32_t)m_workers.size();
+            m_generation++;
+        }
+        m_startCondition.notify_all();
+
+        RunIndices(0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_doneCondition.wait(lock, [&] { return m_active == 0; });
+        m_func = nullptr;
+    }
+}
@@ -0,0 +1,63 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Fixed size worker pool for the CPU sorting path
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ ******************************************************************************/
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace CPUSorting
+{
+    //Stands in for a dispatch: ParallelFor hands out the indices of a grid
+    //to the workers, and returns once every index has run. Like a kernel
+    //boundary, this is the only synchronization between two phases.
+    class ThreadPool
+    {
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_startCondition;
+        std::condition_variable m_doneCondition;
+
+        const std::function<void(uint32_t, uint32_t)>* m_func = nullptr;
+        uint32_t m_count = 0;
+        std::atomic<uint32_t> m_next{ 0 };
+        uint32_t m_active = 0;
+        uint64_t m_generation = 0;
+        bool m_stop = false;
+
+        void WorkerLoop(uint32_t threadIndex);
+
+        void RunIndices(uint32_t threadIndex);
+
+    public:
+        //0 uses every hardware thread
+        explicit ThreadPool(uint32_t threadCount = 0);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        //Worker threads plus the calling thread
+        uint32_t ThreadCount() const
+        {
+            return (uint32_t)m_workers.size() + 1;
+        }
+
+        //Runs func(index, threadIndex) for every index in [0, count). The
+        //calling thread takes part as threadIndex 0, so threadIndex can be
+        //used to address per thread scratch memory of ThreadCount() slots.
+        void ParallelFor(
+            uint32_t count,
+            const std::function<void(uint32_t, uint32_t)>& func);
+    };
+}
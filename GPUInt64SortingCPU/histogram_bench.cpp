@@ -0,0 +1,191 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Microbenchmark for the multi digit histogram kernels
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Times every histogram build the CPU supports over the same keys, checks
+ * them against a plain loop, and reports GB/s next to a plain
+ * streaming read of the same buffer, which serves as the memory
+ * bandwidth ceiling.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Histogram.h"
+#include "SortCommon.h"
+#include "ThreadPool.h"
+
+using namespace CPUSorting;
+
+using Clock = std::chrono::steady_clock;
+
+// Tiles handed to the pool, the same as the global histogram of the sorts
+constexpr uint32_t TILE_SIZE = G_HIST_PART_SIZE;
+
+// Reduces every thread's replicas into one RADIX * RADIX_PASSES histogram
+static std::vector<uint32_t> Reduce(const std::vector<uint32_t>& threadHist) {
+    std::vector<uint32_t> hist(HIST_REPLICA_SIZE);
+    for (size_t i = 0; i < threadHist.size(); ++i) {
+        hist[i % HIST_REPLICA_SIZE] += threadHist[i];
+    }
+    return hist;
+}
+
+static double RunHistogram(ThreadPool& pool, HistogramKernel kernel,
+                           const std::vector<uint64_t>& keys,
+                           std::vector<uint32_t>& threadHist) {
+    const uint32_t size = (uint32_t)keys.size();
+    std::fill(threadHist.begin(), threadHist.end(), 0);
+
+    const auto start = Clock::now();
+    pool.ParallelFor(DivRoundUp(size, TILE_SIZE), [&](uint32_t tile,
+                                                      uint32_t threadIndex) {
+        const uint32_t begin = tile * TILE_SIZE;
+        kernel(keys.data() + begin, std::min(size - begin, TILE_SIZE),
+               ~(uint64_t)0,
+               &threadHist[(size_t)threadIndex * HIST_REPLICAS *
+                           HIST_REPLICA_SIZE]);
+    });
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// A read of every key with as little work as possible per key
+static double RunStreamingRead(ThreadPool& pool,
+                               const std::vector<uint64_t>& keys,
+                               std::vector<uint64_t>& sinks) {
+    const uint32_t size = (uint32_t)keys.size();
+    const auto start = Clock::now();
+    pool.ParallelFor(DivRoundUp(size, TILE_SIZE), [&](uint32_t tile,
+                                                      uint32_t threadIndex) {
+        const uint32_t begin = tile * TILE_SIZE;
+        const uint32_t end = std::min(size - begin, TILE_SIZE) + begin;
+        uint64_t t = 0;
+        for (uint32_t i = begin; i < end; ++i) {
+            t ^= keys[i];
+        }
+        sinks[threadIndex] ^= t;
+    });
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: <Input Size as Power of Two: uint32_t> <Test "
+                     "Batch Size: uint32_t> [threads=<Thread Count>] "
+                     "[entropy=<1..5>]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t size;
+    uint32_t batchSize;
+    uint32_t threads = 0;
+    ENTROPY_PRESET entropyPreset = ENTROPY_PRESET_1;
+    try {
+        const uint32_t powerOfTwo = std::stoul(argv[1]);
+        if (powerOfTwo > 31 || argv[1][0] == '-') {
+            throw std::runtime_error(
+                "Error: input size power must be a value between 0 and 31");
+        }
+        size = 1U << powerOfTwo;
+        batchSize = std::stoul(argv[2]);
+        if (argv[2][0] == '-' || batchSize == 0) {
+            throw std::runtime_error("Error: test batch size must be positive");
+        }
+
+        for (int i = 3; i < argc; ++i) {
+            const std::string option = argv[i];
+            const size_t eq = option.find('=');
+            const std::string name = option.substr(0, eq);
+            const std::string value =
+                eq == std::string::npos ? "" : option.substr(eq + 1);
+            if (value.empty() || value[0] == '-') {
+                throw std::invalid_argument(option);
+            }
+            if (name == "threads") {
+                threads = std::stoul(value);
+            } else if (name == "entropy") {
+                const int e = std::stoi(value) - 1;
+                if (e < ENTROPY_PRESET_1 || e > ENTROPY_PRESET_5) {
+                    throw std::runtime_error(
+                        "Error: entropy preset must be between 1 and 5");
+                }
+                entropyPreset = (ENTROPY_PRESET)e;
+            } else {
+                throw std::runtime_error("Error: Unknown option " + option);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<uint64_t> keys(size);
+    EntropyGenerator gen(0, 10);
+    for (uint64_t& key : keys) {
+        key = gen.NextKey(entropyPreset);
+    }
+
+    const double bytes = (double)size * sizeof(uint64_t);
+    printf("Threads: %u\n", pool.ThreadCount());
+    printf("Widest supported: %s\n", HistogramISAName(DetectHistogramISA()));
+    printf("Selected: %s\n", HistogramISAName(SelectHistogramISA()));
+    printf("Size: %u\n", size);
+    printf("Entropy: %f bits\n", k_entropyLookup[entropyPreset]);
+    printf("Test size: %u\n\n", batchSize);
+
+    // The first run of each is a warm up
+    std::vector<uint64_t> sinks(pool.ThreadCount());
+    double readTime = 0.0;
+    for (uint32_t i = 0; i <= batchSize; ++i) {
+        const double t = RunStreamingRead(pool, keys, sinks);
+        readTime += i ? t : 0.0;
+    }
+    const double ceiling = bytes * batchSize / readTime / 1e9;
+    printf("%-10s %8.2f GB/s\n", "Read", ceiling);
+
+    std::vector<uint32_t> threadHist((size_t)pool.ThreadCount() *
+                                     HIST_REPLICAS * HIST_REPLICA_SIZE);
+    std::vector<uint32_t> reference(HIST_REPLICA_SIZE);
+    for (const uint64_t key : keys) {
+        for (uint32_t pass = 0; pass < RADIX_PASSES; ++pass) {
+            reference[pass * RADIX + (key >> (pass * RADIX_LOG) & RADIX_MASK)]++;
+        }
+    }
+
+    bool passed = true;
+    for (int i = HISTOGRAM_ISA_SCALAR; i <= HISTOGRAM_ISA_AVX512; ++i) {
+        const HISTOGRAM_ISA isa = (HISTOGRAM_ISA)i;
+        if (!IsHistogramISASupported(isa)) {
+            printf("%-10s not supported\n", HistogramISAName(isa));
+            continue;
+        }
+
+        const HistogramKernel kernel = GetHistogramKernel(isa);
+        double histTime = 0.0;
+        for (uint32_t j = 0; j <= batchSize; ++j) {
+            const double t = RunHistogram(pool, kernel, keys, threadHist);
+            histTime += j ? t : 0.0;
+        }
+
+        const bool valid = Reduce(threadHist) == reference;
+        passed &= valid;
+        const double rate = bytes * batchSize / histTime / 1e9;
+        printf("%-10s %8.2f GB/s %6.1f%% of read %s\n", HistogramISAName(isa),
+               rate, rate / ceiling * 100.0, valid ? "" : "VALIDATION FAILED");
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
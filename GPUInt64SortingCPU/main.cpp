@@ -0,0 +1,546 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Benchmark and validation for the CPU radix sorts
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Sorts the ENTROPY_PRESET distributions of UtilityKernels.cuh, checks
+ * each result against std::stable_sort, and times the radix sort against
+ * std::sort on the same input.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "DeviceRadixSort.h"
+#include "HybridRadixSort.h"
+#include "InPlaceRadixSort.h"
+#include "OneSweep.h"
+#include "SmallSort.h"
+#include "SortCommon.h"
+#include "ThreadPool.h"
+
+using namespace CPUSorting;
+
+// Grid of the CUDA InitRandom launch, <<<256, 256>>>
+constexpr uint32_t INIT_THREADS = 256 * 256;
+
+using Clock = std::chrono::steady_clock;
+
+enum class Algorithm { DeviceRadixSort, OneSweep, InPlace, Hybrid };
+
+// Order of the random keys handed to the sort, for the presort paths
+enum class InputOrder { Random, Sorted, Reversed, Runs };
+
+struct Options {
+    bool sortPairs = false;
+    bool payloadUlong = false;
+    uint32_t size = 0;
+    uint32_t batchSize = 0;
+    uint32_t threads = 0;
+    uint32_t partSize = PART_SIZE;
+    uint32_t beginBit = 0;
+    uint32_t endBit = KEY_BITS;
+    uint32_t seed = 10;
+    int entropy = -1;
+    ORDER order = ORDER_ASCENDING;
+    Algorithm algo = Algorithm::DeviceRadixSort;
+    DOWNSWEEP_MODE downsweep = DOWNSWEEP_DIRECT;
+    RANK_ISA rankISA = DetectRankISA();
+    bool skipTrivialPasses = false;
+    uint32_t msdBits = 0;
+    bool detectPresorted = false;
+    uint32_t presortMaxRuns = PRESORT_MAX_RUNS;
+    InputOrder input = InputOrder::Random;
+    uint32_t inputRuns = 1;
+    uint32_t smallSortSize = SMALL_SORT_SIZE;
+    SMALL_SORT_ISA smallSortISA = DetectSmallSortISA();
+};
+
+// Same striding as InitRandom, so every key sees the same generator
+// sequence as on the GPU
+static void InitRandom(std::vector<uint64_t>& keys, ENTROPY_PRESET entropyPreset,
+                       uint32_t seed) {
+    const uint32_t size = (uint32_t)keys.size();
+    for (uint32_t idx = 0; idx < INIT_THREADS && idx < size; ++idx) {
+        EntropyGenerator gen(idx, seed);
+        for (uint32_t i = idx; i < size; i += INIT_THREADS) {
+            keys[i] = gen.NextKey(entropyPreset);
+        }
+    }
+}
+
+// Sorted by the whole key, then reversed or cut into ascending runs of
+// near equal length
+static void ArrangeInput(std::vector<uint64_t>& keys, const Options& opt) {
+    if (opt.input == InputOrder::Random) {
+        return;
+    }
+
+    const size_t runs = opt.input == InputOrder::Runs ? opt.inputRuns : 1;
+    for (size_t r = 0; r < runs; ++r) {
+        std::sort(keys.begin() + keys.size() * r / runs,
+                  keys.begin() + keys.size() * (r + 1) / runs);
+    }
+    if (opt.input == InputOrder::Reversed) {
+        std::reverse(keys.begin(), keys.end());
+    }
+}
+
+// Payloads are the input index, so a failed stability check shows up as
+// a payload mismatch
+template <typename P>
+static void InitPayload(std::vector<P>& payload) {
+    for (size_t i = 0; i < payload.size(); ++i) {
+        payload[i] = (P)i;
+    }
+}
+
+// Stable by the windowed key. A descending sort mirrors the final index,
+// like DescendingIndex, so equal keys come out in reverse input order.
+static std::vector<uint32_t> ReferenceOrder(const std::vector<uint64_t>& keys,
+                                            const Options& opt) {
+    const uint64_t windowMask = KeyWindowMask(opt.beginBit, opt.endBit);
+    std::vector<uint32_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return (keys[a] & windowMask) < (keys[b] & windowMask);
+    });
+    if (opt.order == ORDER_DESCENDING) {
+        std::reverse(order.begin(), order.end());
+    }
+    return order;
+}
+
+template <typename P>
+static uint32_t Validate(const std::vector<uint64_t>& input,
+                         const std::vector<uint64_t>& sorted,
+                         const std::vector<P>* payload, const Options& opt) {
+    const std::vector<uint32_t> order = ReferenceOrder(input, opt);
+    const uint64_t windowMask = KeyWindowMask(opt.beginBit, opt.endBit);
+    const bool stable = opt.algo != Algorithm::InPlace;
+
+    // An unstable sort only has to match the reference order by the
+    // windowed key, with every payload still pointing at its own key
+    std::vector<uint64_t> sortedKeys;
+    std::vector<uint64_t> inputKeys;
+    std::vector<bool> seen(payload != nullptr ? input.size() : 0);
+    if (!stable && payload == nullptr) {
+        sortedKeys = sorted;
+        inputKeys = input;
+        std::sort(sortedKeys.begin(), sortedKeys.end());
+        std::sort(inputKeys.begin(), inputKeys.end());
+    }
+
+    uint32_t errors = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        bool ok = stable ? sorted[i] == input[order[i]]
+                         : (sorted[i] & windowMask) ==
+                               (input[order[i]] & windowMask);
+        if (payload != nullptr && stable) {
+            ok = ok && (*payload)[i] == (P)order[i];
+        } else if (payload != nullptr) {
+            const size_t index = (size_t)(*payload)[i];
+            ok = ok && index < input.size() && !seen[index] &&
+                 input[index] == sorted[i];
+            if (index < input.size()) {
+                seen[index] = true;
+            }
+        } else if (!stable) {
+            ok = ok && sortedKeys[i] == inputKeys[i];
+        }
+        if (!ok && errors++ < 8) {
+            printf("Error at index %zu: expected %llx got %llx\n", i,
+                   (unsigned long long)input[order[i]],
+                   (unsigned long long)sorted[i]);
+        }
+    }
+    return errors;
+}
+
+template <typename P>
+struct Pair {
+    uint64_t key;
+    P payload;
+};
+
+// Returns the seconds spent in std::sort, on the same input
+template <typename P>
+static double TimeStdSort(const std::vector<uint64_t>& keys, bool sortPairs) {
+    if (!sortPairs) {
+        std::vector<uint64_t> copy = keys;
+        const auto start = Clock::now();
+        std::sort(copy.begin(), copy.end());
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::vector<Pair<P>> pairs(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        pairs[i] = {keys[i], (P)i};
+    }
+    const auto start = Clock::now();
+    std::sort(pairs.begin(), pairs.end(),
+              [](const Pair<P>& a, const Pair<P>& b) { return a.key < b.key; });
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename P>
+static bool BatchTiming(CPUSortBase& sorter, ENTROPY_PRESET entropyPreset,
+                        const Options& opt) {
+    printf("Beginning CPU %s %s batch timing test at:\n", sorter.SortName(),
+           opt.sortPairs ? "pairs" : "keys");
+    printf("Size: %u\n", opt.size);
+    printf("Entropy: %f bits\n", k_entropyLookup[entropyPreset]);
+    printf("Test size: %u\n", opt.batchSize);
+
+    std::vector<uint64_t> input(opt.size);
+    std::vector<uint64_t> keys(opt.size);
+    // The in place sort never touches alt, so it is not allocated
+    const bool needsAlt = opt.algo != Algorithm::InPlace;
+    std::vector<uint64_t> alt(needsAlt ? opt.size : 0);
+    std::vector<P> payload(opt.sortPairs ? opt.size : 0);
+    std::vector<P> altPayload(opt.sortPairs && needsAlt ? opt.size : 0);
+
+    double radixTime = 0.0;
+    double stdTime = 0.0;
+    uint32_t errors = 0;
+    uint32_t skippedPasses = 0;
+    uint32_t presortPaths[4] = {};
+    uint64_t presortRuns = 0;
+    WriteCombiningStats flushStats;
+    const DeviceRadixSort* drs = dynamic_cast<const DeviceRadixSort*>(&sorter);
+    for (uint32_t i = 0; i <= opt.batchSize; ++i) {
+        InitRandom(input, entropyPreset, i + opt.seed);
+        ArrangeInput(input, opt);
+        keys = input;
+        if (opt.sortPairs) {
+            InitPayload(payload);
+        }
+
+        const auto start = Clock::now();
+        if (opt.sortPairs) {
+            sorter.Sort(keys.data(), payload.data(), alt.data(),
+                        altPayload.data(), opt.size, opt.order, opt.beginBit,
+                        opt.endBit);
+        } else {
+            sorter.Sort(keys.data(), alt.data(), opt.size, opt.order,
+                        opt.beginBit, opt.endBit);
+        }
+        const double elapsed =
+            std::chrono::duration<double>(Clock::now() - start).count();
+
+        // The first run is a warm up, and the one that gets validated
+        if (i) {
+            radixTime += elapsed;
+            stdTime += TimeStdSort<P>(input, opt.sortPairs);
+            skippedPasses += sorter.SkippedPasses();
+            presortPaths[sorter.LastPresortStats().path]++;
+            presortRuns += sorter.LastPresortStats().runs;
+            if (drs != nullptr) {
+                flushStats.streamedLines += drs->FlushStats().streamedLines;
+                flushStats.partialFlushes += drs->FlushStats().partialFlushes;
+            }
+        } else {
+            errors = Validate(input, keys, opt.sortPairs ? &payload : nullptr,
+                              opt);
+        }
+
+        if ((i & 15) == 0) {
+            printf(". ");
+        }
+    }
+    printf("\n");
+
+    if (errors) {
+        printf("Validation failed, %u errors\n\n", errors);
+        return false;
+    }
+
+    const double radixRate = opt.size / radixTime * opt.batchSize;
+    const double stdRate = opt.size / stdTime * opt.batchSize;
+    printf("Validation passed\n");
+    if (opt.skipTrivialPasses) {
+        printf("Skipped passes: %u\n", skippedPasses);
+    }
+    if (opt.detectPresorted) {
+        printf("Presorted: %u sorted, %u reversed, %u merged, %u radix\n",
+               presortPaths[PRESORT_SORTED], presortPaths[PRESORT_REVERSED],
+               presortPaths[PRESORT_MERGED], presortPaths[PRESORT_NONE]);
+        printf("Ascending runs per sort: %llu\n",
+               (unsigned long long)(presortRuns / opt.batchSize));
+    }
+    if (drs != nullptr && drs->DownsweepMode() == DOWNSWEEP_WRITE_COMBINING) {
+        printf("Streamed lines per sort: %llu\n",
+               (unsigned long long)(flushStats.streamedLines / opt.batchSize));
+        printf("Partial flushes per sort: %llu\n",
+               (unsigned long long)(flushStats.partialFlushes / opt.batchSize));
+    }
+    if (const auto* hybrid = dynamic_cast<const HybridRadixSort*>(&sorter)) {
+        printf("MSD bits: %u, large buckets: %u\n", hybrid->LastMSDBits(),
+               hybrid->LargeBuckets());
+    }
+    if (const auto* inPlace =
+            dynamic_cast<const InPlaceRadixSort*>(&sorter)) {
+        printf("Scratch memory: %.1f KiB, input: %.1f KiB\n",
+               inPlace->ScratchBytes() / 1024.0,
+               opt.size * (sizeof(uint64_t) + payload.size() / opt.size *
+                           sizeof(P)) / 1024.0);
+    }
+    printf("Total time elapsed: %f\n", radixTime);
+    printf("Estimated speed at %u 64-bit elements: %E keys/sec\n", opt.size,
+           radixRate);
+    printf("std::sort speed at %u 64-bit elements: %E keys/sec\n", opt.size,
+           stdRate);
+    printf("Speedup over std::sort: %.2fx\n\n", radixRate / stdRate);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: <Sort Type: keys | pairs> <Input Size as Power of "
+                     "Two: uint32_t> <Test Batch Size: uint32_t> "
+                     "[entropy=<1..5>] [threads=<Thread Count>] "
+                     "[part=<Tile Size>] [begin=<Begin Bit>] [end=<End Bit>] "
+                     "[payload=<uint | ulong>] "
+                     "[algo=<drs | onesweep | inplace | hybrid>] "
+                     "[msd=<0 | 8..11>] "
+                     "[downsweep=<direct | shared | wc>] "
+                     "[rank=<scalar | avx512>] [seed=<Seed>] "
+                     "[input=<random | sorted | reversed | runs:<k>>] "
+                     "[runs=<Max Merged Runs>] [small=<0..256>] "
+                     "[smallisa=<scalar | avx2>] [descend] [skip] [presort]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    Options opt;
+    try {
+        const std::string sortType = argv[1];
+        if (sortType != "keys" && sortType != "pairs") {
+            throw std::runtime_error("Error: Unknown sort type " + sortType);
+        }
+        opt.sortPairs = sortType == "pairs";
+
+        const uint32_t powerOfTwo = std::stoul(argv[2]);
+        if (powerOfTwo > 31 || argv[2][0] == '-') {
+            throw std::runtime_error(
+                "Error: input size power must be a value between 0 and 31");
+        }
+        opt.size = 1U << powerOfTwo;
+        opt.batchSize = std::stoul(argv[3]);
+        if (argv[3][0] == '-' || opt.batchSize == 0) {
+            throw std::runtime_error("Error: test batch size must be positive");
+        }
+
+        for (int i = 4; i < argc; ++i) {
+            const std::string option = argv[i];
+            const size_t eq = option.find('=');
+            const std::string name = option.substr(0, eq);
+            if (eq == std::string::npos) {
+                if (name == "descend") {
+                    opt.order = ORDER_DESCENDING;
+                } else if (name == "skip") {
+                    opt.skipTrivialPasses = true;
+                } else if (name == "presort") {
+                    opt.detectPresorted = true;
+                } else {
+                    throw std::runtime_error("Error: Unknown option " + option);
+                }
+                continue;
+            }
+
+            const std::string value = option.substr(eq + 1);
+            if (value.empty() || value[0] == '-') {
+                throw std::invalid_argument(option);
+            }
+            if (name == "entropy") {
+                opt.entropy = std::stoi(value) - 1;
+                if (opt.entropy < ENTROPY_PRESET_1 ||
+                    opt.entropy > ENTROPY_PRESET_5) {
+                    throw std::runtime_error(
+                        "Error: entropy preset must be between 1 and 5");
+                }
+            } else if (name == "threads") {
+                opt.threads = std::stoul(value);
+            } else if (name == "part") {
+                opt.partSize = std::stoul(value);
+            } else if (name == "begin") {
+                opt.beginBit = std::stoul(value);
+            } else if (name == "end") {
+                opt.endBit = std::stoul(value);
+            } else if (name == "seed") {
+                opt.seed = std::stoul(value);
+            } else if (name == "payload") {
+                if (value == "uint") {
+                    opt.payloadUlong = false;
+                } else if (value == "ulong") {
+                    opt.payloadUlong = true;
+                } else {
+                    throw std::runtime_error("Error: Unknown payload type " +
+                                             value);
+                }
+            } else if (name == "downsweep") {
+                if (value == "direct") {
+                    opt.downsweep = DOWNSWEEP_DIRECT;
+                } else if (value == "shared") {
+                    opt.downsweep = DOWNSWEEP_SHARED;
+                } else if (value == "wc") {
+                    opt.downsweep = DOWNSWEEP_WRITE_COMBINING;
+                } else {
+                    throw std::runtime_error("Error: Unknown downsweep " +
+                                             value);
+                }
+            } else if (name == "msd") {
+                opt.msdBits = std::stoul(value);
+                if (opt.msdBits != 0 && (opt.msdBits < HYBRID_MIN_MSD_BITS ||
+                                         opt.msdBits > HYBRID_MAX_MSD_BITS)) {
+                    throw std::runtime_error(
+                        "Error: msd bits must be 0, or between 8 and 11");
+                }
+            } else if (name == "runs") {
+                opt.presortMaxRuns = std::stoul(value);
+                if (opt.presortMaxRuns == 0) {
+                    throw std::runtime_error("Error: runs must be positive");
+                }
+            } else if (name == "input") {
+                if (value == "random") {
+                    opt.input = InputOrder::Random;
+                } else if (value == "sorted") {
+                    opt.input = InputOrder::Sorted;
+                } else if (value == "reversed") {
+                    opt.input = InputOrder::Reversed;
+                } else if (value.compare(0, 5, "runs:") == 0 &&
+                           value.size() > 5 && value[5] != '-') {
+                    opt.input = InputOrder::Runs;
+                    opt.inputRuns = std::stoul(value.substr(5));
+                    if (opt.inputRuns == 0) {
+                        throw std::runtime_error(
+                            "Error: input runs must be positive");
+                    }
+                } else {
+                    throw std::runtime_error("Error: Unknown input order " +
+                                             value);
+                }
+            } else if (name == "small") {
+                opt.smallSortSize = std::stoul(value);
+                if (opt.smallSortSize > SMALL_SORT_SIZE) {
+                    throw std::runtime_error(
+                        "Error: small sort size must be at most 256");
+                }
+            } else if (name == "smallisa") {
+                if (value == "scalar") {
+                    opt.smallSortISA = SMALL_SORT_ISA_SCALAR;
+                } else if (value == "avx2") {
+                    opt.smallSortISA = SMALL_SORT_ISA_AVX2;
+                } else {
+                    throw std::runtime_error("Error: Unknown small sort build " +
+                                             value);
+                }
+            } else if (name == "rank") {
+                if (value == "scalar") {
+                    opt.rankISA = RANK_ISA_SCALAR;
+                } else if (value == "avx512") {
+                    opt.rankISA = RANK_ISA_AVX512;
+                } else {
+                    throw std::runtime_error("Error: Unknown rank build " +
+                                             value);
+                }
+            } else if (name == "algo") {
+                if (value == "drs") {
+                    opt.algo = Algorithm::DeviceRadixSort;
+                } else if (value == "onesweep") {
+                    opt.algo = Algorithm::OneSweep;
+                } else if (value == "inplace") {
+                    opt.algo = Algorithm::InPlace;
+                } else if (value == "hybrid") {
+                    opt.algo = Algorithm::Hybrid;
+                } else {
+                    throw std::runtime_error("Error: Unknown algorithm " +
+                                             value);
+                }
+            } else {
+                throw std::runtime_error("Error: Unknown option " + option);
+            }
+        }
+
+        // The flag bits of the lookback leave 30 bits for a count
+        if (opt.algo == Algorithm::OneSweep && powerOfTwo > 29) {
+            throw std::runtime_error(
+                "Error: OneSweep input size power must be at most 29");
+        }
+
+        if (opt.beginBit >= opt.endBit || opt.endBit > KEY_BITS) {
+            throw std::runtime_error(
+                "Error: expected begin < end <= 64 for the bit window");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(opt.threads);
+    std::unique_ptr<CPUSortBase> sorter;
+    if (opt.algo == Algorithm::OneSweep) {
+        sorter = std::make_unique<OneSweep>(pool, opt.partSize);
+    } else if (opt.algo == Algorithm::InPlace) {
+        sorter = std::make_unique<InPlaceRadixSort>(pool);
+    } else if (opt.algo == Algorithm::Hybrid) {
+        auto hybrid = std::make_unique<HybridRadixSort>(pool, opt.partSize);
+        hybrid->SetMSDBits(opt.msdBits);
+        printf("Bucket size: %zu KiB\n", hybrid->BucketBytes() / 1024);
+        sorter = std::move(hybrid);
+    } else {
+        auto drs = std::make_unique<DeviceRadixSort>(pool, opt.partSize);
+        drs->SetDownsweepMode(opt.downsweep);
+        drs->SetRankISA(opt.rankISA);
+        if (opt.downsweep == DOWNSWEEP_SHARED) {
+            printf("Downsweep: shared, %s ranking\n",
+                   RankISAName(drs->RankISA()));
+        } else if (opt.downsweep == DOWNSWEEP_WRITE_COMBINING) {
+            printf("Downsweep: write combining, %u key chunks\n",
+                   WC_CHUNK_SIZE);
+        }
+        sorter = std::move(drs);
+    }
+    sorter->SetSkipTrivialPasses(opt.skipTrivialPasses);
+    sorter->SetDetectPresorted(opt.detectPresorted);
+    sorter->SetPresortMaxRuns(opt.presortMaxRuns);
+    sorter->SetSmallSortSize(opt.smallSortSize);
+    sorter->SetSmallSortISA(opt.smallSortISA);
+    if (opt.size <= sorter->SmallSortSize()) {
+        printf("Small sort: %s network\n",
+               SmallSortISAName(sorter->SmallSortISA()));
+    }
+    printf("Threads: %u\n", pool.ThreadCount());
+    if (opt.algo == Algorithm::InPlace) {
+        printf("Block size: %u\n\n", IPR_BLOCK_SIZE);
+    } else {
+        printf("Tile size: %u\n\n", opt.partSize);
+    }
+
+    bool passed = true;
+    for (int e = ENTROPY_PRESET_1; e <= ENTROPY_PRESET_5; ++e) {
+        if (opt.entropy >= 0 && opt.entropy != e) {
+            continue;
+        }
+
+        if (opt.payloadUlong) {
+            passed &= BatchTiming<uint64_t>(*sorter, (ENTROPY_PRESET)e, opt);
+        } else {
+            passed &= BatchTiming<uint32_t>(*sorter, (ENTROPY_PRESET)e, opt);
+        }
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,239 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Microbenchmark for the tile ranking and scatter strategies
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Runs a single digit pass over PART_SIZE tiles on one thread, for every
+ * ENTROPY_PRESET. It times the ranking kernels on their own, then a
+ * whole tile downsweep: the direct counting sort scatter against ranking
+ * into a tile buffer followed by one copy per digit run. Lower entropy
+ * means more repeated digits, more conflicts inside a group of sixteen
+ * and longer runs of stores to the same destination stream.
+ *
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Multisplit.h"
+#include "SortCommon.h"
+
+using namespace CPUSorting;
+
+using Clock = std::chrono::steady_clock;
+
+// Every tile's destination offsets, the result of the upsweep and scan
+static std::vector<uint32_t> TileOffsets(const std::vector<uint64_t>& keys,
+                                         uint32_t radixShift) {
+    const uint32_t size = (uint32_t)keys.size();
+    const uint32_t tiles = DivRoundUp(size, PART_SIZE);
+    std::vector<uint32_t> offsets((size_t)tiles * RADIX);
+    for (uint32_t i = 0; i < size; ++i) {
+        offsets[(size_t)(i / PART_SIZE) * RADIX +
+                (keys[i] >> radixShift & RADIX_MASK)]++;
+    }
+
+    uint32_t reduction = 0;
+    for (uint32_t d = 0; d < RADIX; ++d) {
+        for (uint32_t t = 0; t < tiles; ++t) {
+            const uint32_t count = offsets[(size_t)t * RADIX + d];
+            offsets[(size_t)t * RADIX + d] = reduction;
+            reduction += count;
+        }
+    }
+    return offsets;
+}
+
+static double TimeRank(RankKernel kernel, const std::vector<uint64_t>& keys,
+                       uint32_t radixShift, std::vector<uint32_t>& ranks) {
+    const uint32_t size = (uint32_t)keys.size();
+    const auto start = Clock::now();
+    for (uint32_t begin = 0; begin < size; begin += PART_SIZE) {
+        uint32_t hist[RADIX] = {};
+        kernel(keys.data() + begin, std::min(size - begin, PART_SIZE),
+               radixShift, RADIX_MASK, hist, ranks.data() + begin);
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double TimeDirect(const std::vector<uint64_t>& keys,
+                         const std::vector<uint32_t>& tileOffsets,
+                         uint32_t radixShift, std::vector<uint64_t>& alt) {
+    const uint32_t size = (uint32_t)keys.size();
+    const auto start = Clock::now();
+    for (uint32_t begin = 0; begin < size; begin += PART_SIZE) {
+        uint32_t offsets[RADIX];
+        memcpy(offsets, &tileOffsets[(size_t)(begin / PART_SIZE) * RADIX],
+               sizeof(offsets));
+        const uint32_t end = std::min(size - begin, PART_SIZE) + begin;
+        for (uint32_t i = begin; i < end; ++i) {
+            alt[offsets[keys[i] >> radixShift & RADIX_MASK]++] = keys[i];
+        }
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static double TimeShared(RankKernel kernel, const std::vector<uint64_t>& keys,
+                         const std::vector<uint32_t>& tileOffsets,
+                         uint32_t radixShift, std::vector<uint64_t>& alt) {
+    const uint32_t size = (uint32_t)keys.size();
+    std::vector<uint64_t> shared(PART_SIZE);
+    std::vector<uint32_t> ranks(PART_SIZE);
+    const auto start = Clock::now();
+    for (uint32_t begin = 0; begin < size; begin += PART_SIZE) {
+        const uint32_t count = std::min(size - begin, PART_SIZE);
+        uint32_t hist[RADIX] = {};
+        kernel(keys.data() + begin, count, radixShift, RADIX_MASK, hist,
+               ranks.data());
+
+        uint32_t local[RADIX];
+        uint32_t reduction = 0;
+        for (uint32_t d = 0; d < RADIX; ++d) {
+            local[d] = reduction;
+            reduction += hist[d];
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            const uint64_t key = keys[begin + i];
+            shared[local[key >> radixShift & RADIX_MASK] + ranks[i]] = key;
+        }
+
+        const uint32_t* offsets =
+            &tileOffsets[(size_t)(begin / PART_SIZE) * RADIX];
+        for (uint32_t d = 0; d < RADIX; ++d) {
+            if (hist[d]) {
+                memcpy(&alt[offsets[d]], &shared[local[d]],
+                       hist[d] * sizeof(uint64_t));
+            }
+        }
+    }
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "Usage: <Input Size as Power of Two: uint32_t> <Test "
+                     "Batch Size: uint32_t> [shift=<Radix Shift>]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t size;
+    uint32_t batchSize;
+    uint32_t radixShift = 0;
+    try {
+        const uint32_t powerOfTwo = std::stoul(argv[1]);
+        if (powerOfTwo > 30 || argv[1][0] == '-') {
+            throw std::runtime_error(
+                "Error: input size power must be a value between 0 and 30");
+        }
+        size = 1U << powerOfTwo;
+        batchSize = std::stoul(argv[2]);
+        if (argv[2][0] == '-' || batchSize == 0) {
+            throw std::runtime_error("Error: test batch size must be positive");
+        }
+
+        for (int i = 3; i < argc; ++i) {
+            const std::string option = argv[i];
+            const size_t eq = option.find('=');
+            const std::string name = option.substr(0, eq);
+            const std::string value =
+                eq == std::string::npos ? "" : option.substr(eq + 1);
+            if (value.empty() || value[0] == '-') {
+                throw std::invalid_argument(option);
+            }
+            if (name == "shift") {
+                radixShift = std::stoul(value);
+                if (radixShift > KEY_BITS - RADIX_LOG || radixShift % 8) {
+                    throw std::runtime_error(
+                        "Error: shift must be a multiple of 8 up to 56");
+                }
+            } else {
+                throw std::runtime_error("Error: Unknown option " + option);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    printf("Size: %u\n", size);
+    printf("Radix shift: %u\n", radixShift);
+    printf("Test size: %u\n\n", batchSize);
+    printf("%-8s %-16s %10s\n", "Entropy", "Kernel", "Mkeys/s");
+
+    std::vector<uint64_t> keys(size);
+    std::vector<uint64_t> alt(size);
+    std::vector<uint64_t> reference(size);
+    std::vector<uint32_t> ranks(size);
+    std::vector<uint32_t> referenceRanks(size);
+    bool passed = true;
+    for (int e = ENTROPY_PRESET_1; e <= ENTROPY_PRESET_5; ++e) {
+        EntropyGenerator gen(0, 10);
+        for (uint64_t& key : keys) {
+            key = gen.NextKey((ENTROPY_PRESET)e);
+        }
+        const std::vector<uint32_t> tileOffsets = TileOffsets(keys, radixShift);
+
+        // The first run of each is a warm up, and the one validated
+        auto report = [&](const char* name, auto run) {
+            double time = 0.0;
+            for (uint32_t i = 0; i <= batchSize; ++i) {
+                const double t = run();
+                time += i ? t : 0.0;
+            }
+            printf("%-8.3f %-16s %10.1f\n", k_entropyLookup[e], name,
+                   size / time * batchSize / 1e6);
+        };
+
+        TimeDirect(keys, tileOffsets, radixShift, reference);
+        TimeRank(RankScalar, keys, radixShift, referenceRanks);
+        for (int r = RANK_ISA_SCALAR; r <= RANK_ISA_AVX512; ++r) {
+            const RANK_ISA isa = (RANK_ISA)r;
+            if (!IsRankISASupported(isa)) {
+                continue;
+            }
+            const RankKernel kernel = GetRankKernel(isa);
+            const std::string name = std::string("Rank ") + RankISAName(isa);
+            report(name.c_str(), [&] {
+                return TimeRank(kernel, keys, radixShift, ranks);
+            });
+            if (ranks != referenceRanks) {
+                printf("%s ranks failed validation\n", name.c_str());
+                passed = false;
+            }
+        }
+
+        report("Scatter direct", [&] {
+            return TimeDirect(keys, tileOffsets, radixShift, alt);
+        });
+        for (int r = RANK_ISA_SCALAR; r <= RANK_ISA_AVX512; ++r) {
+            const RANK_ISA isa = (RANK_ISA)r;
+            if (!IsRankISASupported(isa)) {
+                continue;
+            }
+            const RankKernel kernel = GetRankKernel(isa);
+            const std::string name =
+                std::string("Shared ") + RankISAName(isa);
+            report(name.c_str(), [&] {
+                return TimeShared(kernel, keys, tileOffsets, radixShift, alt);
+            });
+            if (alt != reference) {
+                printf("%s scatter failed validation\n", name.c_str());
+                passed = false;
+            }
+        }
+        printf("\n");
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
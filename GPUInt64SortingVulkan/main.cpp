@@ -0,0 +1,1833 @@
+/******************************************************************************
+ * GPUInt64Sorting
+ * Vulkan host for the int64 DeviceRadixSort compute shaders
+ *
+ * SPDX-License-Identifier: MIT
+ * https://github.com/zhaosiwen1949/Int64RadixSort
+ *
+ * Compiles the Unity HLSL with dxc to SPIR-V and runs it through plain
+ * Vulkan, so the sort can be validated and timed headless on a CPU
+ * driver such as lavapipe or SwiftShader.
+ *
+ ******************************************************************************/
+
+#include <vulkan/vulkan.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef DXC_PATH
+#define DXC_PATH "dxc"
+#endif
+
+#ifndef SHADER_DIR
+#define SHADER_DIR "../GPUInt64Sorting/Shaders"
+#endif
+
+// MUST match the defines in SortCommon.hlsl and DeviceRadixSort.compute
+constexpr uint32_t RADIX = 256;
+constexpr uint32_t RADIX_PASSES = 8;
+constexpr uint32_t DIGIT_BITS = 8;
+// RADIX_11 digits never straddle the two words of a key, so they come in
+// 11, 11 and 10 bit triples
+constexpr uint32_t WIDE_DIGIT_BITS = 11;
+constexpr uint32_t WIDE_DIGIT_SHARED_MEMORY = 32768;
+constexpr uint32_t INIT_DIM = 1024;
+constexpr uint32_t PART_SIZE = 3840;
+constexpr uint32_t G_HIST_PART_SIZE = 32768;
+// DeviceRadixSort defines G_HIST_TILE_COUNTS, its GlobalHistogram tiles are
+// G_HIST_TILES sorting tiles
+constexpr uint32_t G_HIST_TILES = 8;
+constexpr uint32_t DRS_G_HIST_PART_SIZE = PART_SIZE * G_HIST_TILES;
+constexpr uint32_t PASS_FLAG_FIRST = 1;
+constexpr uint32_t PASS_FLAG_LAST = 2;
+constexpr uint32_t MAX_DISPATCH_DIM = 65535;
+constexpr uint32_t IS_PARTIAL_BIT_FLAG = 1;
+constexpr uint32_t INDIRECT_ARGS_SIZE = 6;
+constexpr uint32_t PARTITION_ARGS_OFFSET = 3 * sizeof(uint32_t);
+constexpr uint32_t SORT_INFO_SIZE = 3;
+
+// Uniform slots are bound with dynamic offsets into a single buffer,
+// INFO_SIZE MUST match the size of cbGpuSorting
+constexpr uint32_t MAX_INFO_SLOTS = 64;
+constexpr uint32_t INFO_SIZE = 8;
+constexpr uint32_t MAX_SETS_PER_SORT = 256;
+// Start and end of the sort, then either side of the trivial pass readback
+constexpr uint32_t TIMESTAMP_COUNT = 4;
+
+struct GPUContext {
+    VkInstance instance = VK_NULL_HANDLE;
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+    uint32_t queueFamily = 0;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memProps{};
+    float timestampPeriod = 1.0f;
+    uint32_t subgroupSize = 0;
+    // Nonzero when every pipeline is created with this subgroup size
+    uint32_t requiredSubgroupSize = 0;
+    uint32_t maxSharedMemory = 0;
+    VkDeviceSize infoStride = 256;
+};
+
+struct Buffer {
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize size = 0;
+    void* mapped = nullptr;
+};
+
+struct GPUBuffers {
+    Buffer info;
+    Buffer sort;
+    Buffer alt;
+    Buffer sortPayload;
+    Buffer altPayload;
+    Buffer globalHist;
+    Buffer passHist;
+    Buffer index;
+    Buffer keyCount;
+    Buffer indirectArgs;
+    Buffer sortInfo;
+};
+
+struct ShaderBinding {
+    uint32_t binding;
+    VkDescriptorType type;
+};
+
+struct ComputeShader {
+    VkShaderModule module = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipeLayout = VK_NULL_HANDLE;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    std::map<std::string, ShaderBinding> bindings;
+    uint32_t sharedBytes = 0;
+    std::string label;
+};
+
+struct Shaders {
+    ComputeShader init;
+    ComputeShader globalHist;
+    ComputeShader globalHistScan;
+    ComputeShader upsweep;
+    ComputeShader scan;
+    ComputeShader downsweep;
+    ComputeShader digitBinningPass;
+    ComputeShader setupIndirect;
+    ComputeShader smallSort;
+};
+
+// A named buffer argument, the equivalent of ComputeShader.SetBuffer
+struct BufferArg {
+    const char* name;
+    const Buffer* buffer;
+};
+
+enum class KeyType { Ulong, Long, Double };
+
+enum class Algorithm { DeviceRadixSort, OneSweep, SmallSort };
+
+struct TestArgs {
+    GPUContext& gpu;
+    GPUBuffers& buffs;
+    Shaders& shaders;
+    uint32_t size;
+    uint32_t batchSize;
+    uint32_t keyBits;
+    uint32_t beginBit = 0;
+    uint32_t endBit = 64;
+    bool sortPairs = false;
+    bool shouldAscend = true;
+    bool shouldValidate = true;
+    bool shouldTime = true;
+    bool skipTrivialPasses = false;
+    bool payloadUlong = false;
+    KeyType keyType = KeyType::Ulong;
+    Algorithm algo = Algorithm::DeviceRadixSort;
+    // DIGIT_BITS, or WIDE_DIGIT_BITS for shaders compiled with RADIX_11
+    uint32_t digitBits = DIGIT_BITS;
+    // With indirect, the key count is read on the device. count is what the
+    // device is expected to sort, size is the upper bound it is clamped to.
+    // The small sort sorts the first count keys, set from the host.
+    bool indirect = false;
+    uint32_t count = 0;
+    // Lowered, along with the shaders' define, to split small sorts into
+    // 2D dispatches
+    uint32_t maxDispatchDim = MAX_DISPATCH_DIM;
+};
+
+void CheckVk(VkResult result, const char* what) {
+    if (result != VK_SUCCESS) {
+        throw std::runtime_error(std::string("Vulkan error ") +
+                                 std::to_string(result) + " in " + what);
+    }
+}
+
+uint32_t DivRoundUp(uint32_t x, uint32_t y) { return (x + y - 1) / y; }
+
+// The digit layout of GPUSortBase, for either digit width
+uint32_t DigitsPerWord(uint32_t digitBits) { return DivRoundUp(32, digitBits); }
+
+uint32_t RadixPasses(uint32_t digitBits) {
+    return 2 * DigitsPerWord(digitBits);
+}
+
+uint32_t PassShift(uint32_t pass, uint32_t digitBits) {
+    return (pass / DigitsPerWord(digitBits) << 5) +
+           pass % DigitsPerWord(digitBits) * digitBits;
+}
+
+// The last digit of each word is cut short at the word boundary
+uint32_t PassWidth(uint32_t pass, uint32_t digitBits) {
+    return std::min(digitBits, 32 - (PassShift(pass, digitBits) & 31));
+}
+
+uint32_t PassIndex(uint32_t radixShift, uint32_t digitBits) {
+    return (radixShift >> 5) * DigitsPerWord(digitBits) +
+           (radixShift & 31) / digitBits;
+}
+
+uint32_t GlobalHistSize(uint32_t digitBits) {
+    return (1U << digitBits) * RadixPasses(digitBits);
+}
+
+// Signed and double keys are converted on the first dispatched pass and
+// converted back on the last one
+uint32_t GetPassFlags(uint32_t passMask, uint32_t pass) {
+    return ((passMask & ((1U << pass) - 1)) ? 0 : PASS_FLAG_FIRST) |
+           ((passMask >> (pass + 1)) ? 0 : PASS_FLAG_LAST);
+}
+
+//*****************************************************************************
+// CONTEXT
+//*****************************************************************************
+// A nonzero waveSize pins the subgroup size of every pipeline through
+// VK_EXT_subgroup_size_control, so the WGE16 and WLT16 paths can both be
+// run on the same device
+int GetGPUContext(GPUContext* context, uint32_t waveSize) {
+    VkApplicationInfo appInfo{VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    appInfo.pApplicationName = "GPUInt64Sorting";
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo instInfo{VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    instInfo.pApplicationInfo = &appInfo;
+    if (vkCreateInstance(&instInfo, nullptr, &context->instance) !=
+        VK_SUCCESS) {
+        std::cerr << "Instance creation failed!\n";
+        return EXIT_FAILURE;
+    }
+
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(context->instance, &deviceCount, nullptr);
+    if (deviceCount == 0) {
+        std::cerr << "Failed to get adapter" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(context->instance, &deviceCount,
+                               devices.data());
+
+    // Prefer a CPU driver, this host exists to run without a real GPU
+    context->physicalDevice = devices[0];
+    for (VkPhysicalDevice dev : devices) {
+        VkPhysicalDeviceProperties props;
+        vkGetPhysicalDeviceProperties(dev, &props);
+        if (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+            context->physicalDevice = dev;
+            break;
+        }
+    }
+
+    bool hasSizeControl = false;
+    uint32_t extCount = 0;
+    vkEnumerateDeviceExtensionProperties(context->physicalDevice, nullptr,
+                                         &extCount, nullptr);
+    std::vector<VkExtensionProperties> exts(extCount);
+    vkEnumerateDeviceExtensionProperties(context->physicalDevice, nullptr,
+                                         &extCount, exts.data());
+    for (const VkExtensionProperties& ext : exts) {
+        if (std::strcmp(ext.extensionName,
+                        VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME) == 0) {
+            hasSizeControl = true;
+        }
+    }
+
+    VkPhysicalDeviceSubgroupSizeControlPropertiesEXT sizeControlProps{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_PROPERTIES_EXT};
+    VkPhysicalDeviceSubgroupProperties subgroupProps{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+    if (hasSizeControl) {
+        subgroupProps.pNext = &sizeControlProps;
+    }
+    VkPhysicalDeviceProperties2 props2{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    props2.pNext = &subgroupProps;
+    vkGetPhysicalDeviceProperties2(context->physicalDevice, &props2);
+    const VkPhysicalDeviceProperties& props = props2.properties;
+
+    std::cout << "Name: " << props.deviceName << std::endl;
+    std::cout << "Type: "
+              << (props.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? "cpu"
+                                                                 : "not cpu")
+              << std::endl;
+    std::cout << "Subgroup size: " << subgroupProps.subgroupSize << std::endl;
+    if (hasSizeControl) {
+        std::cout << "Subgroup size range: " << sizeControlProps.minSubgroupSize
+                  << " to " << sizeControlProps.maxSubgroupSize << std::endl;
+    }
+    if (waveSize &&
+        (!hasSizeControl || waveSize < sizeControlProps.minSubgroupSize ||
+         waveSize > sizeControlProps.maxSubgroupSize ||
+         !(sizeControlProps.requiredSubgroupSizeStages &
+           VK_SHADER_STAGE_COMPUTE_BIT))) {
+        std::cerr << "Device cannot run compute with a subgroup size of "
+                  << waveSize << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const VkSubgroupFeatureFlags reqSubgroupOps =
+        VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_VOTE_BIT |
+        VK_SUBGROUP_FEATURE_ARITHMETIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT |
+        VK_SUBGROUP_FEATURE_SHUFFLE_BIT;
+    if ((subgroupProps.supportedOperations & reqSubgroupOps) !=
+            reqSubgroupOps ||
+        !(subgroupProps.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT)) {
+        std::cerr << "Device lacks the required subgroup operations"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    VkPhysicalDeviceFeatures supported;
+    vkGetPhysicalDeviceFeatures(context->physicalDevice, &supported);
+    if (!supported.shaderInt64) {
+        std::cerr << "Device lacks shaderInt64" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice,
+                                             &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice,
+                                             &familyCount, families.data());
+    bool foundFamily = false;
+    for (uint32_t i = 0; i < familyCount; ++i) {
+        if (families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) {
+            context->queueFamily = i;
+            foundFamily = true;
+            break;
+        }
+    }
+    if (!foundFamily) {
+        std::cerr << "No compute queue" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+    queueInfo.queueFamilyIndex = context->queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    VkPhysicalDeviceFeatures features{};
+    features.shaderInt64 = VK_TRUE;
+    VkDeviceCreateInfo devInfo{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    devInfo.queueCreateInfoCount = 1;
+    devInfo.pQueueCreateInfos = &queueInfo;
+    devInfo.pEnabledFeatures = &features;
+
+    const char* sizeControlExt = VK_EXT_SUBGROUP_SIZE_CONTROL_EXTENSION_NAME;
+    VkPhysicalDeviceSubgroupSizeControlFeaturesEXT sizeControlFeatures{
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_SIZE_CONTROL_FEATURES_EXT};
+    if (waveSize) {
+        sizeControlFeatures.subgroupSizeControl = VK_TRUE;
+        devInfo.pNext = &sizeControlFeatures;
+        devInfo.enabledExtensionCount = 1;
+        devInfo.ppEnabledExtensionNames = &sizeControlExt;
+    }
+    if (vkCreateDevice(context->physicalDevice, &devInfo, nullptr,
+                       &context->device) != VK_SUCCESS) {
+        std::cerr << "Failed to get device" << std::endl;
+        return EXIT_FAILURE;
+    }
+    vkGetDeviceQueue(context->device, context->queueFamily, 0,
+                     &context->queue);
+
+    VkCommandPoolCreateInfo poolInfo{
+        VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex = context->queueFamily;
+    CheckVk(vkCreateCommandPool(context->device, &poolInfo, nullptr,
+                                &context->commandPool),
+            "vkCreateCommandPool");
+
+    std::vector<VkDescriptorPoolSize> poolSizes = {
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_SETS_PER_SORT * 8},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, MAX_SETS_PER_SORT},
+    };
+    VkDescriptorPoolCreateInfo descPoolInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    descPoolInfo.maxSets = MAX_SETS_PER_SORT;
+    descPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    descPoolInfo.pPoolSizes = poolSizes.data();
+    CheckVk(vkCreateDescriptorPool(context->device, &descPoolInfo, nullptr,
+                                   &context->descriptorPool),
+            "vkCreateDescriptorPool");
+
+    VkQueryPoolCreateInfo queryInfo{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryInfo.queryCount = TIMESTAMP_COUNT;
+    CheckVk(vkCreateQueryPool(context->device, &queryInfo, nullptr,
+                              &context->queryPool),
+            "vkCreateQueryPool");
+
+    vkGetPhysicalDeviceMemoryProperties(context->physicalDevice,
+                                        &context->memProps);
+    context->timestampPeriod = props.limits.timestampPeriod;
+    context->maxSharedMemory = props.limits.maxComputeSharedMemorySize;
+    context->subgroupSize = waveSize ? waveSize : subgroupProps.subgroupSize;
+    context->requiredSubgroupSize = waveSize;
+    context->infoStride = std::max<VkDeviceSize>(
+        256, props.limits.minUniformBufferOffsetAlignment);
+    return EXIT_SUCCESS;
+}
+
+//*****************************************************************************
+// BUFFERS
+//*****************************************************************************
+// Everything is host visible, CPU drivers have a single heap anyway and it
+// keeps upload and readback trivial.
+Buffer CreateBuffer(const GPUContext& gpu, VkDeviceSize size,
+                    VkBufferUsageFlags usage) {
+    Buffer buff;
+    buff.size = size;
+
+    VkBufferCreateInfo bufInfo{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufInfo.size = size;
+    bufInfo.usage = usage;
+    bufInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    CheckVk(vkCreateBuffer(gpu.device, &bufInfo, nullptr, &buff.buffer),
+            "vkCreateBuffer");
+
+    VkMemoryRequirements req;
+    vkGetBufferMemoryRequirements(gpu.device, buff.buffer, &req);
+    const VkMemoryPropertyFlags wanted = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    uint32_t memType = UINT32_MAX;
+    for (uint32_t i = 0; i < gpu.memProps.memoryTypeCount; ++i) {
+        if ((req.memoryTypeBits & (1U << i)) &&
+            (gpu.memProps.memoryTypes[i].propertyFlags & wanted) == wanted) {
+            memType = i;
+            break;
+        }
+    }
+    if (memType == UINT32_MAX) {
+        throw std::runtime_error("No host visible memory type");
+    }
+
+    VkMemoryAllocateInfo allocInfo{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocInfo.allocationSize = req.size;
+    allocInfo.memoryTypeIndex = memType;
+    CheckVk(vkAllocateMemory(gpu.device, &allocInfo, nullptr, &buff.memory),
+            "vkAllocateMemory");
+    CheckVk(vkBindBufferMemory(gpu.device, buff.buffer, buff.memory, 0),
+            "vkBindBufferMemory");
+    CheckVk(vkMapMemory(gpu.device, buff.memory, 0, VK_WHOLE_SIZE, 0,
+                        &buff.mapped),
+            "vkMapMemory");
+    return buff;
+}
+
+void GetGPUBuffers(const GPUContext& gpu, GPUBuffers* buffs, uint32_t size,
+                   bool sortPairs, bool payloadUlong, Algorithm algo,
+                   bool indirect, uint32_t digitBits) {
+    const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    const uint32_t threadBlocks = DivRoundUp(size, PART_SIZE);
+    buffs->info = CreateBuffer(gpu, gpu.infoStride * MAX_INFO_SLOTS,
+                               VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+    buffs->sort = CreateBuffer(gpu, sizeof(uint64_t) * size, storage);
+    buffs->alt = CreateBuffer(gpu, sizeof(uint64_t) * size, storage);
+    if (sortPairs) {
+        const VkDeviceSize payloadSize =
+            (payloadUlong ? sizeof(uint64_t) : sizeof(uint32_t)) * size;
+        buffs->sortPayload = CreateBuffer(gpu, payloadSize, storage);
+        buffs->altPayload = CreateBuffer(gpu, payloadSize, storage);
+    }
+    buffs->globalHist = CreateBuffer(
+        gpu, sizeof(uint32_t) * GlobalHistSize(digitBits), storage);
+    // OneSweep keeps the tile reductions of every pass, plus one tile
+    // counter per pass
+    const uint32_t histPasses =
+        algo == Algorithm::OneSweep ? RADIX_PASSES : 1;
+    buffs->passHist = CreateBuffer(
+        gpu, sizeof(uint32_t) * (1U << digitBits) * threadBlocks * histPasses,
+        storage);
+    if (algo == Algorithm::OneSweep) {
+        buffs->index =
+            CreateBuffer(gpu, sizeof(uint32_t) * RADIX_PASSES, storage);
+    }
+    if (indirect) {
+        buffs->keyCount = CreateBuffer(
+            gpu, sizeof(uint32_t), storage | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+        buffs->indirectArgs =
+            CreateBuffer(gpu, sizeof(uint32_t) * INDIRECT_ARGS_SIZE,
+                         storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+        buffs->sortInfo =
+            CreateBuffer(gpu, sizeof(uint32_t) * SORT_INFO_SIZE, storage);
+    }
+}
+
+void DestroyBuffer(const GPUContext& gpu, Buffer* buff) {
+    if (buff->buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(gpu.device, buff->buffer, nullptr);
+        vkFreeMemory(gpu.device, buff->memory, nullptr);
+    }
+    *buff = Buffer{};
+}
+
+//*****************************************************************************
+// SHADERS
+//*****************************************************************************
+// Unity binds resources by name, so we do the same: pull the name, binding
+// and descriptor type of every resource variable out of the SPIR-V.
+std::map<std::string, ShaderBinding> ReflectBindings(
+    const std::vector<uint32_t>& spirv) {
+    constexpr uint32_t OP_NAME = 5;
+    constexpr uint32_t OP_TYPE_POINTER = 32;
+    constexpr uint32_t OP_VARIABLE = 59;
+    constexpr uint32_t OP_DECORATE = 71;
+    constexpr uint32_t DECORATION_BLOCK = 2;
+    constexpr uint32_t DECORATION_BUFFER_BLOCK = 3;
+    constexpr uint32_t DECORATION_BINDING = 33;
+    constexpr uint32_t STORAGE_UNIFORM = 2;
+    constexpr uint32_t STORAGE_STORAGE_BUFFER = 12;
+
+    std::map<uint32_t, std::string> names;
+    std::map<uint32_t, uint32_t> bindings;
+    std::map<uint32_t, bool> bufferBlocks;
+    std::map<uint32_t, uint32_t> pointees;
+    std::vector<uint32_t> variables;
+    std::map<uint32_t, uint32_t> variableStorage;
+    std::map<uint32_t, uint32_t> variableTypes;
+
+    for (size_t i = 5; i < spirv.size();) {
+        const uint32_t opcode = spirv[i] & 0xffff;
+        const uint32_t wordCount = spirv[i] >> 16;
+        if (wordCount == 0 || i + wordCount > spirv.size()) {
+            throw std::runtime_error("Malformed SPIR-V");
+        }
+
+        if (opcode == OP_NAME) {
+            names[spirv[i + 1]] =
+                reinterpret_cast<const char*>(&spirv[i + 2]);
+        } else if (opcode == OP_DECORATE) {
+            if (spirv[i + 2] == DECORATION_BINDING) {
+                bindings[spirv[i + 1]] = spirv[i + 3];
+            } else if (spirv[i + 2] == DECORATION_BUFFER_BLOCK) {
+                bufferBlocks[spirv[i + 1]] = true;
+            } else if (spirv[i + 2] == DECORATION_BLOCK) {
+                bufferBlocks[spirv[i + 1]] = false;
+            }
+        } else if (opcode == OP_TYPE_POINTER) {
+            pointees[spirv[i + 1]] = spirv[i + 3];
+        } else if (opcode == OP_VARIABLE) {
+            variables.push_back(spirv[i + 2]);
+            variableTypes[spirv[i + 2]] = spirv[i + 1];
+            variableStorage[spirv[i + 2]] = spirv[i + 3];
+        }
+        i += wordCount;
+    }
+
+    std::map<std::string, ShaderBinding> reflected;
+    for (uint32_t var : variables) {
+        if (!bindings.count(var)) {
+            continue;
+        }
+
+        const uint32_t storage = variableStorage[var];
+        const uint32_t pointee = pointees[variableTypes[var]];
+        VkDescriptorType type;
+        if (storage == STORAGE_STORAGE_BUFFER ||
+            (storage == STORAGE_UNIFORM && bufferBlocks[pointee])) {
+            type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        } else if (storage == STORAGE_UNIFORM) {
+            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        } else {
+            continue;
+        }
+        reflected[names[var]] = {bindings[var], type};
+    }
+    return reflected;
+}
+
+// Total size of the groupshared variables, the main occupancy limiter of the
+// sorting kernels. Workgroup memory has no explicit layout, so members are
+// assumed to be tightly packed.
+uint32_t ReflectSharedBytes(const std::vector<uint32_t>& spirv) {
+    constexpr uint32_t OP_TYPE_BOOL = 20;
+    constexpr uint32_t OP_TYPE_INT = 21;
+    constexpr uint32_t OP_TYPE_FLOAT = 22;
+    constexpr uint32_t OP_TYPE_VECTOR = 23;
+    constexpr uint32_t OP_TYPE_ARRAY = 28;
+    constexpr uint32_t OP_TYPE_STRUCT = 30;
+    constexpr uint32_t OP_TYPE_POINTER = 32;
+    constexpr uint32_t OP_CONSTANT = 43;
+    constexpr uint32_t OP_VARIABLE = 59;
+    constexpr uint32_t STORAGE_WORKGROUP = 4;
+
+    std::map<uint32_t, uint32_t> sizes;
+    std::map<uint32_t, uint32_t> constants;
+    std::map<uint32_t, uint32_t> pointees;
+    uint32_t total = 0;
+    for (size_t i = 5; i < spirv.size();) {
+        const uint32_t opcode = spirv[i] & 0xffff;
+        const uint32_t wordCount = spirv[i] >> 16;
+        if (wordCount == 0 || i + wordCount > spirv.size()) {
+            throw std::runtime_error("Malformed SPIR-V");
+        }
+
+        const uint32_t* op = &spirv[i];
+        if (opcode == OP_TYPE_BOOL) {
+            sizes[op[1]] = 4;
+        } else if (opcode == OP_TYPE_INT || opcode == OP_TYPE_FLOAT) {
+            sizes[op[1]] = op[2] / 8;
+        } else if (opcode == OP_TYPE_VECTOR) {
+            sizes[op[1]] = sizes[op[2]] * op[3];
+        } else if (opcode == OP_TYPE_ARRAY) {
+            sizes[op[1]] = sizes[op[2]] * constants[op[3]];
+        } else if (opcode == OP_TYPE_STRUCT) {
+            uint32_t structSize = 0;
+            for (uint32_t m = 2; m < wordCount; ++m) {
+                structSize += sizes[op[m]];
+            }
+            sizes[op[1]] = structSize;
+        } else if (opcode == OP_CONSTANT) {
+            constants[op[2]] = op[3];
+        } else if (opcode == OP_TYPE_POINTER) {
+            pointees[op[1]] = op[3];
+        } else if (opcode == OP_VARIABLE && op[3] == STORAGE_WORKGROUP) {
+            total += sizes[pointees[op[1]]];
+        }
+        i += wordCount;
+    }
+    return total;
+}
+
+std::vector<uint32_t> CompileHLSL(const std::string& path,
+                                  const char* entryPoint,
+                                  const std::vector<std::string>& defines) {
+    std::string spvPath = std::string(entryPoint);
+    std::string defineArgs;
+    for (const std::string& def : defines) {
+        spvPath += "_" + def;
+        defineArgs += " -D " + def;
+    }
+    spvPath += ".spv";
+
+    // Wave intrinsics need shader model 6, WaveReadLaneAt with a non uniform
+    // lane needs SPIR-V 1.5
+    const std::string command = std::string(DXC_PATH) +
+                                " -spirv -T cs_6_0 -fspv-target-env=vulkan1.2" +
+                                " -E " + entryPoint + defineArgs + " -Fo " +
+                                spvPath + " " + path;
+    if (std::system(command.c_str()) != 0) {
+        throw std::runtime_error("Shader compilation error: " + command);
+    }
+
+    std::ifstream file(spvPath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + spvPath);
+    }
+    const std::streamsize bytes = file.tellg();
+    file.seekg(0);
+    std::vector<uint32_t> spirv(static_cast<size_t>(bytes) / 4);
+    file.read(reinterpret_cast<char*>(spirv.data()), bytes);
+    return spirv;
+}
+
+void CreateShaderFromSource(const GPUContext& gpu, ComputeShader* cs,
+                            const char* entryPoint, const std::string& path,
+                            const std::vector<std::string>& defines,
+                            const std::string& csLabel) {
+    const std::vector<uint32_t> spirv = CompileHLSL(path, entryPoint, defines);
+    cs->bindings = ReflectBindings(spirv);
+    cs->sharedBytes = ReflectSharedBytes(spirv);
+    cs->label = csLabel;
+
+    VkShaderModuleCreateInfo modInfo{
+        VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    modInfo.codeSize = spirv.size() * sizeof(uint32_t);
+    modInfo.pCode = spirv.data();
+    CheckVk(vkCreateShaderModule(gpu.device, &modInfo, nullptr, &cs->module),
+            "vkCreateShaderModule");
+
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    for (const auto& [name, bind] : cs->bindings) {
+        VkDescriptorSetLayoutBinding lb{};
+        lb.binding = bind.binding;
+        lb.descriptorType = bind.type;
+        lb.descriptorCount = 1;
+        lb.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        layoutBindings.push_back(lb);
+    }
+    VkDescriptorSetLayoutCreateInfo setInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    setInfo.bindingCount = static_cast<uint32_t>(layoutBindings.size());
+    setInfo.pBindings = layoutBindings.data();
+    CheckVk(vkCreateDescriptorSetLayout(gpu.device, &setInfo, nullptr,
+                                        &cs->setLayout),
+            "vkCreateDescriptorSetLayout");
+
+    VkPipelineLayoutCreateInfo pipeLayoutInfo{
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    pipeLayoutInfo.setLayoutCount = 1;
+    pipeLayoutInfo.pSetLayouts = &cs->setLayout;
+    CheckVk(vkCreatePipelineLayout(gpu.device, &pipeLayoutInfo, nullptr,
+                                   &cs->pipeLayout),
+            "vkCreatePipelineLayout");
+
+    VkComputePipelineCreateInfo pipeInfo{
+        VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    pipeInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeInfo.stage.module = cs->module;
+    pipeInfo.stage.pName = entryPoint;
+    pipeInfo.layout = cs->pipeLayout;
+    VkPipelineShaderStageRequiredSubgroupSizeCreateInfoEXT requiredSize{
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_REQUIRED_SUBGROUP_SIZE_CREATE_INFO_EXT};
+    if (gpu.requiredSubgroupSize) {
+        requiredSize.requiredSubgroupSize = gpu.requiredSubgroupSize;
+        pipeInfo.stage.pNext = &requiredSize;
+    }
+    CheckVk(vkCreateComputePipelines(gpu.device, VK_NULL_HANDLE, 1, &pipeInfo,
+                                     nullptr, &cs->pipeline),
+            "vkCreateComputePipelines");
+}
+
+void GetAllShaders(const GPUContext& gpu, Shaders* shaders, KeyType keyType,
+                   bool sortPairs, bool payloadUlong, bool shouldAscend,
+                   Algorithm algo, bool decoupledFallback, bool indirect,
+                   uint32_t digitBits, uint32_t spinCount,
+                   uint32_t maxDispatchDim) {
+    const std::string path =
+        std::string(SHADER_DIR) + (algo == Algorithm::OneSweep
+                                       ? "/OneSweep.compute"
+                                       : "/DeviceRadixSort.compute");
+    std::vector<std::string> defines = {
+        keyType == KeyType::Long     ? "KEY_LONG"
+        : keyType == KeyType::Double ? "KEY_DOUBLE"
+                                     : "KEY_ULONG"};
+    if (shouldAscend) {
+        defines.push_back("SHOULD_ASCEND");
+    }
+    if (sortPairs) {
+        defines.push_back("SORT_PAIRS");
+        defines.push_back(payloadUlong ? "PAYLOAD_ULONG" : "PAYLOAD_UINT");
+    }
+    if (maxDispatchDim != MAX_DISPATCH_DIM) {
+        defines.push_back("MAX_DISPATCH_DIM=" + std::to_string(maxDispatchDim) +
+                          "U");
+    }
+
+    if (algo == Algorithm::OneSweep) {
+        if (decoupledFallback) {
+            defines.push_back("DECOUPLED_FALLBACK");
+        }
+        // A single spin sends nearly every lookback down the fallback path
+        if (decoupledFallback && spinCount) {
+            defines.push_back("MAX_SPIN_COUNT=" + std::to_string(spinCount));
+        }
+        CreateShaderFromSource(gpu, &shaders->init, "InitSweep", path, defines,
+                               "Init");
+        CreateShaderFromSource(gpu, &shaders->globalHist, "GlobalHistogram",
+                               path, defines, "Global Histogram");
+        CreateShaderFromSource(gpu, &shaders->scan, "Scan", path, defines,
+                               "Scan");
+        CreateShaderFromSource(gpu, &shaders->digitBinningPass,
+                               "DigitBinningPass", path, defines,
+                               "Digit Binning Pass");
+        return;
+    }
+
+    // SmallSort splits 8-bit digits whatever the width, so it is only ever
+    // compiled narrow, as GPUSortBase does
+    if (algo == Algorithm::SmallSort) {
+        CreateShaderFromSource(gpu, &shaders->smallSort, "SmallSort", path,
+                               defines, "Small Sort");
+        return;
+    }
+
+    if (digitBits == WIDE_DIGIT_BITS) {
+        defines.push_back("RADIX_11");
+    }
+    if (indirect) {
+        defines.push_back("INDIRECT_COUNT");
+        CreateShaderFromSource(gpu, &shaders->setupIndirect, "SetupIndirect",
+                               path, defines, "Setup Indirect");
+    }
+    CreateShaderFromSource(gpu, &shaders->init, "InitDeviceRadixSort", path,
+                           defines, "Init");
+    CreateShaderFromSource(gpu, &shaders->globalHist, "GlobalHistogram", path,
+                           defines, "Global Histogram");
+    CreateShaderFromSource(gpu, &shaders->globalHistScan, "GlobalHistScan",
+                           path, defines, "Global Histogram Scan");
+    CreateShaderFromSource(gpu, &shaders->upsweep, "Upsweep", path, defines,
+                           "Upsweep");
+    CreateShaderFromSource(gpu, &shaders->scan, "Scan", path, defines, "Scan");
+    CreateShaderFromSource(gpu, &shaders->downsweep, "Downsweep", path, defines,
+                           "Downsweep");
+}
+
+// Shared memory per workgroup, and how many workgroups of that size fit in
+// the shared memory limit of the device
+void PrintOccupancy(const GPUContext& gpu, const Shaders& shaders) {
+    std::cout << "Shared memory limit: " << gpu.maxSharedMemory << " bytes"
+              << std::endl;
+    for (const ComputeShader* cs :
+         {&shaders.globalHist, &shaders.upsweep, &shaders.scan,
+          &shaders.downsweep, &shaders.digitBinningPass, &shaders.smallSort}) {
+        if (cs->module == VK_NULL_HANDLE) {
+            continue;
+        }
+        std::cout << cs->label << ": " << cs->sharedBytes << " bytes shared";
+        if (cs->sharedBytes) {
+            std::cout << ", " << gpu.maxSharedMemory / cs->sharedBytes
+                      << " workgroups per limit";
+        }
+        std::cout << std::endl;
+    }
+}
+
+void DestroyShader(const GPUContext& gpu, ComputeShader* cs) {
+    vkDestroyPipeline(gpu.device, cs->pipeline, nullptr);
+    vkDestroyPipelineLayout(gpu.device, cs->pipeLayout, nullptr);
+    vkDestroyDescriptorSetLayout(gpu.device, cs->setLayout, nullptr);
+    vkDestroyShaderModule(gpu.device, cs->module, nullptr);
+}
+
+//*****************************************************************************
+// DISPATCH
+//*****************************************************************************
+// Writes the cbGpuSorting constants into a uniform slot, returns the offset
+uint32_t SetInfo(const TestArgs& args, uint32_t slot, uint32_t radixShift,
+                 uint32_t threadBlocks, uint32_t passFlags = 0,
+                 uint32_t isPartial = 0) {
+    if (slot >= MAX_INFO_SLOTS) {
+        throw std::runtime_error("Out of uniform slots");
+    }
+    const uint32_t offset = static_cast<uint32_t>(slot * args.gpu.infoStride);
+    const uint32_t numKeys =
+        args.algo == Algorithm::SmallSort ? args.count : args.size;
+    const uint32_t info[INFO_SIZE] = {
+        numKeys,     radixShift, threadBlocks, args.beginBit,
+        args.endBit, passFlags,  isPartial,    0};
+    GPUBuffers* buffs = &args.buffs;
+    std::memcpy(static_cast<char*>(buffs->info.mapped) + offset, info,
+                sizeof(info));
+    return offset;
+}
+
+void BindComputePass(const GPUContext& gpu, VkCommandBuffer cmd,
+                     const ComputeShader& cs, const GPUBuffers& buffs,
+                     uint32_t infoOffset, const std::vector<BufferArg>& args) {
+    VkDescriptorSetAllocateInfo allocInfo{
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    allocInfo.descriptorPool = gpu.descriptorPool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &cs.setLayout;
+    VkDescriptorSet set;
+    CheckVk(vkAllocateDescriptorSets(gpu.device, &allocInfo, &set),
+            "vkAllocateDescriptorSets");
+
+    // The compiler strips whatever the entry point does not touch, so only
+    // the reflected resources are written, and every one of them must be set.
+    std::vector<VkDescriptorBufferInfo> infos;
+    infos.reserve(cs.bindings.size());
+    std::vector<VkWriteDescriptorSet> writes;
+    bool usesInfo = false;
+    for (const auto& [name, bind] : cs.bindings) {
+        const Buffer* buff = nullptr;
+        VkDeviceSize range = VK_WHOLE_SIZE;
+        if (bind.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            buff = &buffs.info;
+            range = sizeof(uint32_t) * INFO_SIZE;
+            usesInfo = true;
+        } else {
+            for (const BufferArg& arg : args) {
+                if (name == arg.name) {
+                    buff = arg.buffer;
+                }
+            }
+        }
+        if (buff == nullptr || buff->buffer == VK_NULL_HANDLE) {
+            throw std::runtime_error(cs.label + ": no buffer bound to " +
+                                     name);
+        }
+
+        infos.push_back({buff->buffer, 0, range});
+        VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = set;
+        write.dstBinding = bind.binding;
+        write.descriptorCount = 1;
+        write.descriptorType = bind.type;
+        write.pBufferInfo = &infos.back();
+        writes.push_back(write);
+    }
+    vkUpdateDescriptorSets(gpu.device, static_cast<uint32_t>(writes.size()),
+                           writes.data(), 0, nullptr);
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cs.pipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cs.pipeLayout,
+                            0, 1, &set, usesInfo ? 1 : 0, &infoOffset);
+}
+
+// Every dispatch may feed the next one, including its indirect arguments
+void ComputeBarrier(VkCommandBuffer cmd) {
+    VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT |
+                            VK_ACCESS_SHADER_WRITE_BIT |
+                            VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                             VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+}
+
+void SetComputePass(const GPUContext& gpu, VkCommandBuffer cmd,
+                    const ComputeShader& cs, const GPUBuffers& buffs,
+                    uint32_t infoOffset, const std::vector<BufferArg>& args,
+                    uint32_t threadBlocks, uint32_t threadBlocksY = 1) {
+    BindComputePass(gpu, cmd, cs, buffs, infoOffset, args);
+    vkCmdDispatch(cmd, threadBlocks, threadBlocksY, 1);
+    ComputeBarrier(cmd);
+}
+
+void SetComputePassIndirect(const GPUContext& gpu, VkCommandBuffer cmd,
+                            const ComputeShader& cs, const GPUBuffers& buffs,
+                            uint32_t infoOffset,
+                            const std::vector<BufferArg>& args,
+                            VkDeviceSize argsOffset) {
+    BindComputePass(gpu, cmd, cs, buffs, infoOffset, args);
+    vkCmdDispatchIndirect(cmd, buffs.indirectArgs.buffer, argsOffset);
+    ComputeBarrier(cmd);
+}
+
+// Mirrors GPUSortBase.DispatchFlattened: full rows of MAX_DISPATCH_DIM go
+// out as one 2D dispatch, the remainder as a 1D dispatch that carries the
+// row count in e_isPartial. Each half needs its own uniform slot.
+void SetComputePassFlattened(const TestArgs& args, VkCommandBuffer cmd,
+                             const ComputeShader& cs, uint32_t* slot,
+                             uint32_t radixShift, uint32_t threadBlocks,
+                             uint32_t passFlags,
+                             const std::vector<BufferArg>& buffArgs) {
+    const uint32_t fullBlocks = threadBlocks / args.maxDispatchDim;
+    if (fullBlocks) {
+        const uint32_t info =
+            SetInfo(args, (*slot)++, radixShift, threadBlocks, passFlags);
+        SetComputePass(args.gpu, cmd, cs, args.buffs, info, buffArgs,
+                       args.maxDispatchDim, fullBlocks);
+    }
+
+    const uint32_t partialBlocks =
+        threadBlocks - fullBlocks * args.maxDispatchDim;
+    if (partialBlocks) {
+        const uint32_t info =
+            SetInfo(args, (*slot)++, radixShift, threadBlocks, passFlags,
+                    fullBlocks << 1 | IS_PARTIAL_BIT_FLAG);
+        SetComputePass(args.gpu, cmd, cs, args.buffs, info, buffArgs,
+                       partialBlocks);
+    }
+}
+
+// Mirrors DeviceRadixSort.Dispatch in the Unity runtime. Recording is split
+// around the global histogram so trivial passes can be found on the host.
+// The global histogram also writes the tile counts of tileCountPass.
+uint32_t RecordGlobalHist(const TestArgs& args, VkCommandBuffer cmd,
+                          uint32_t tileCountPass) {
+    GPUContext& gpu = args.gpu;
+    GPUBuffers& buffs = args.buffs;
+    Shaders& shaders = args.shaders;
+    const uint32_t threadBlocks = DivRoundUp(args.size, PART_SIZE);
+    const uint32_t globalHistThreadBlocks =
+        DivRoundUp(args.size, DRS_G_HIST_PART_SIZE);
+    uint32_t slot = 0;
+
+    uint32_t info = SetInfo(args, slot++, 0, threadBlocks);
+    SetComputePass(gpu, cmd, shaders.init, buffs, info,
+                   {{"b_globalHist", &buffs.globalHist}},
+                   GlobalHistSize(args.digitBits) / INIT_DIM);
+
+    SetComputePassFlattened(args, cmd, shaders.globalHist, &slot,
+                            PassShift(tileCountPass, args.digitBits),
+                            globalHistThreadBlocks, 0,
+                            {{"b_sort", &buffs.sort},
+                             {"b_globalHist", &buffs.globalHist},
+                             {"b_passHist", &buffs.passHist}});
+    info = SetInfo(args, slot++, 0, globalHistThreadBlocks);
+    SetComputePass(gpu, cmd, shaders.globalHistScan, buffs, info,
+                   {{"b_globalHist", &buffs.globalHist}},
+                   RadixPasses(args.digitBits));
+    return slot;
+}
+
+void RecordPasses(const TestArgs& args, VkCommandBuffer cmd, uint32_t slot,
+                  uint32_t passMask, uint32_t tileCountPass) {
+    GPUContext& gpu = args.gpu;
+    GPUBuffers& buffs = args.buffs;
+    Shaders& shaders = args.shaders;
+    const uint32_t threadBlocks = DivRoundUp(args.size, PART_SIZE);
+
+    const Buffer* toSort = &buffs.sort;
+    const Buffer* alt = &buffs.alt;
+    const Buffer* toSortPayload = &buffs.sortPayload;
+    const Buffer* altPayload = &buffs.altPayload;
+    for (uint32_t pass = 0; pass < RadixPasses(args.digitBits); ++pass) {
+        // Outside of the window, or an identity permutation
+        if (!(passMask >> pass & 1)) {
+            continue;
+        }
+
+        const uint32_t radixShift = PassShift(pass, args.digitBits);
+        const uint32_t passFlags = GetPassFlags(passMask, pass);
+        if (pass != tileCountPass) {
+            SetComputePassFlattened(args, cmd, shaders.upsweep, &slot,
+                                    radixShift, threadBlocks, passFlags,
+                                    {{"b_sort", toSort},
+                                     {"b_passHist", &buffs.passHist}});
+        }
+        const uint32_t info =
+            SetInfo(args, slot++, radixShift, threadBlocks, passFlags);
+        SetComputePass(gpu, cmd, shaders.scan, buffs, info,
+                       {{"b_passHist", &buffs.passHist}},
+                       1U << args.digitBits);
+        SetComputePassFlattened(args, cmd, shaders.downsweep, &slot,
+                                radixShift, threadBlocks, passFlags,
+                                {{"b_sort", toSort},
+                                 {"b_alt", alt},
+                                 {"b_sortPayload", toSortPayload},
+                                 {"b_altPayload", altPayload},
+                                 {"b_passHist", &buffs.passHist},
+                                 {"b_globalHist", &buffs.globalHist}});
+        std::swap(toSort, alt);
+        std::swap(toSortPayload, altPayload);
+    }
+}
+
+// Mirrors OneSweep.Dispatch in the Unity runtime. The scan writes the
+// global prefix of every pass straight into the pass histogram, so there is
+// nothing to split around and skipping is not supported.
+void RecordOneSweep(const TestArgs& args, VkCommandBuffer cmd,
+                    uint32_t passMask) {
+    GPUContext& gpu = args.gpu;
+    GPUBuffers& buffs = args.buffs;
+    Shaders& shaders = args.shaders;
+    const uint32_t threadBlocks = DivRoundUp(args.size, PART_SIZE);
+    const uint32_t globalHistThreadBlocks =
+        DivRoundUp(args.size, G_HIST_PART_SIZE);
+    uint32_t slot = 0;
+
+    uint32_t info = SetInfo(args, slot++, 0, threadBlocks);
+    SetComputePass(gpu, cmd, shaders.init, buffs, info,
+                   {{"b_passHist", &buffs.passHist},
+                    {"b_globalHist", &buffs.globalHist},
+                    {"b_index", &buffs.index}},
+                   256);
+
+    SetComputePassFlattened(
+        args, cmd, shaders.globalHist, &slot, 0, globalHistThreadBlocks, 0,
+        {{"b_sort", &buffs.sort}, {"b_globalHist", &buffs.globalHist}});
+
+    info = SetInfo(args, slot++, 0, threadBlocks);
+    SetComputePass(gpu, cmd, shaders.scan, buffs, info,
+                   {{"b_passHist", &buffs.passHist},
+                    {"b_globalHist", &buffs.globalHist}},
+                   RADIX_PASSES);
+
+    const Buffer* toSort = &buffs.sort;
+    const Buffer* alt = &buffs.alt;
+    const Buffer* toSortPayload = &buffs.sortPayload;
+    const Buffer* altPayload = &buffs.altPayload;
+    for (uint32_t pass = 0; pass < RadixPasses(args.digitBits); ++pass) {
+        if (!(passMask >> pass & 1)) {
+            continue;
+        }
+
+        const uint32_t radixShift = PassShift(pass, args.digitBits);
+        const uint32_t passFlags = GetPassFlags(passMask, pass);
+        SetComputePassFlattened(args, cmd, shaders.digitBinningPass, &slot,
+                                radixShift, threadBlocks, passFlags,
+                                {{"b_sort", toSort},
+                                 {"b_alt", alt},
+                                 {"b_sortPayload", toSortPayload},
+                                 {"b_altPayload", altPayload},
+                                 {"b_passHist", &buffs.passHist},
+                                 {"b_index", &buffs.index}});
+        std::swap(toSort, alt);
+        std::swap(toSortPayload, altPayload);
+    }
+}
+
+// Mirrors DeviceRadixSort.DispatchIndirect. Only e_numKeys, the clamp, is
+// known on the host, every grid comes from SetupIndirect.
+void RecordIndirect(const TestArgs& args, VkCommandBuffer cmd,
+                    uint32_t passMask, uint32_t tileCountPass) {
+    GPUContext& gpu = args.gpu;
+    GPUBuffers& buffs = args.buffs;
+    Shaders& shaders = args.shaders;
+    const Buffer* sortInfo = &buffs.sortInfo;
+    uint32_t slot = 0;
+
+    // Stands in for an earlier pass producing the count, so SetupIndirect
+    // reads a value that never went through the host mapping
+    vkCmdFillBuffer(cmd, buffs.keyCount.buffer, 0, sizeof(uint32_t),
+                    args.count);
+    VkMemoryBarrier barrier{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+
+    uint32_t info = SetInfo(args, slot++, 0, 0);
+    SetComputePass(gpu, cmd, shaders.setupIndirect, buffs, info,
+                   {{"b_keyCount", &buffs.keyCount},
+                    {"b_indirectArgs", &buffs.indirectArgs},
+                    {"b_sortInfo", sortInfo}},
+                   1);
+    SetComputePass(gpu, cmd, shaders.init, buffs, info,
+                   {{"b_globalHist", &buffs.globalHist}},
+                   GlobalHistSize(args.digitBits) / INIT_DIM);
+    info = SetInfo(args, slot++, PassShift(tileCountPass, args.digitBits), 0);
+    SetComputePassIndirect(gpu, cmd, shaders.globalHist, buffs, info,
+                           {{"b_sort", &buffs.sort},
+                            {"b_globalHist", &buffs.globalHist},
+                            {"b_passHist", &buffs.passHist},
+                            {"b_sortInfo", sortInfo}},
+                           0);
+    SetComputePass(gpu, cmd, shaders.globalHistScan, buffs, info,
+                   {{"b_globalHist", &buffs.globalHist}},
+                   RadixPasses(args.digitBits));
+
+    const Buffer* toSort = &buffs.sort;
+    const Buffer* alt = &buffs.alt;
+    const Buffer* toSortPayload = &buffs.sortPayload;
+    const Buffer* altPayload = &buffs.altPayload;
+    for (uint32_t pass = 0; pass < RadixPasses(args.digitBits); ++pass) {
+        if (!(passMask >> pass & 1)) {
+            continue;
+        }
+
+        const uint32_t radixShift = PassShift(pass, args.digitBits);
+        const uint32_t passFlags = GetPassFlags(passMask, pass);
+        info = SetInfo(args, slot++, radixShift, 0, passFlags);
+        if (pass != tileCountPass) {
+            SetComputePassIndirect(gpu, cmd, shaders.upsweep, buffs, info,
+                                   {{"b_sort", toSort},
+                                    {"b_passHist", &buffs.passHist},
+                                    {"b_sortInfo", sortInfo}},
+                                   PARTITION_ARGS_OFFSET);
+        }
+        SetComputePass(gpu, cmd, shaders.scan, buffs, info,
+                       {{"b_passHist", &buffs.passHist},
+                        {"b_sortInfo", sortInfo}},
+                       1U << args.digitBits);
+        SetComputePassIndirect(gpu, cmd, shaders.downsweep, buffs, info,
+                               {{"b_sort", toSort},
+                                {"b_alt", alt},
+                                {"b_sortPayload", toSortPayload},
+                                {"b_altPayload", altPayload},
+                                {"b_passHist", &buffs.passHist},
+                                {"b_globalHist", &buffs.globalHist},
+                                {"b_sortInfo", sortInfo}},
+                               PARTITION_ARGS_OFFSET);
+        std::swap(toSort, alt);
+        std::swap(toSortPayload, altPayload);
+    }
+}
+
+// Mirrors DispatchSmallSort: one threadblock sorts b_sort in place
+void RecordSmallSort(const TestArgs& args, VkCommandBuffer cmd) {
+    const uint32_t info = SetInfo(args, 0, 0, 1);
+    SetComputePass(args.gpu, cmd, args.shaders.smallSort,
+                   args.buffs, info,
+                   {{"b_sort", &args.buffs.sort},
+                    {"b_sortPayload", &args.buffs.sortPayload}},
+                   1);
+}
+
+// Same rules as DeviceRadixSort.GetTrivialPassMask and GetPassMask
+uint32_t GetTrivialPassMask(const TestArgs& args) {
+    const uint32_t* globalHist =
+        static_cast<const uint32_t*>(args.buffs.globalHist.mapped);
+    const uint32_t radix = 1U << args.digitBits;
+    const uint32_t passBegin = PassIndex(args.beginBit, args.digitBits);
+    const uint32_t passEnd = PassIndex(args.endBit - 1, args.digitBits) +
+                             (args.shouldAscend ? 1 : 0);
+    uint32_t skipMask = 0;
+    for (uint32_t pass = passBegin; pass < passEnd; ++pass) {
+        const uint32_t* hist = globalHist + pass * radix;
+        for (uint32_t i = 0; i < radix; ++i) {
+            const uint32_t next = i < radix - 1 ? hist[i + 1] : args.size;
+            if (next - hist[i] == args.size) {
+                skipMask |= 1U << pass;
+                break;
+            }
+        }
+    }
+    return skipMask;
+}
+
+uint32_t GetPassMask(const TestArgs& args, uint32_t trivialMask) {
+    const uint32_t digitBits = args.digitBits;
+    uint32_t passMask = 0;
+    for (uint32_t pass = 0; pass < RadixPasses(digitBits); ++pass) {
+        const uint32_t radixShift = PassShift(pass, digitBits);
+        if (radixShift < args.endBit &&
+            radixShift + PassWidth(pass, digitBits) > args.beginBit) {
+            passMask |= 1U << pass;
+        }
+    }
+    passMask &= ~trivialMask;
+
+    uint32_t passCount = 0;
+    for (uint32_t t = passMask; t; t &= t - 1) {
+        passCount++;
+    }
+    if (passCount & 1) {
+        const uint32_t beginPass = PassIndex(args.beginBit, digitBits);
+        if (trivialMask) {
+            passMask |= trivialMask & (~trivialMask + 1);
+        } else {
+            passMask |= 1U << (beginPass > 0
+                                   ? beginPass - 1
+                                   : PassIndex(args.endBit - 1, digitBits) + 1);
+        }
+    }
+    return passMask;
+}
+
+// Same rule as DeviceRadixSort.GetTileCountPass: the lowest pass dispatched
+// without skipping, the first dispatched pass whenever it is dispatched
+uint32_t GetTileCountPass(const TestArgs& args) {
+    const uint32_t passMask = GetPassMask(args, 0);
+    uint32_t pass = 0;
+    while (!(passMask >> pass & 1)) {
+        pass++;
+    }
+    return pass;
+}
+
+void BeginCommands(VkCommandBuffer cmd) {
+    VkCommandBufferBeginInfo beginInfo{
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    CheckVk(vkBeginCommandBuffer(cmd, &beginInfo), "vkBeginCommandBuffer");
+}
+
+void SubmitSync(const GPUContext& gpu, VkCommandBuffer cmd) {
+    CheckVk(vkEndCommandBuffer(cmd), "vkEndCommandBuffer");
+    VkSubmitInfo submit{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &cmd;
+    CheckVk(vkQueueSubmit(gpu.queue, 1, &submit, VK_NULL_HANDLE),
+            "vkQueueSubmit");
+    CheckVk(vkQueueWaitIdle(gpu.queue), "vkQueueWaitIdle");
+}
+
+//*****************************************************************************
+// TESTING
+//*****************************************************************************
+void InitializeInput(const TestArgs& args, uint32_t seed,
+                     std::vector<uint64_t>* keys) {
+    std::mt19937_64 rng(seed);
+    if (args.keyType == KeyType::Double) {
+        std::uniform_real_distribution<double> dist(-1e9, 1e9);
+        for (uint32_t i = 0; i < args.size; ++i) {
+            const double d = dist(rng);
+            std::memcpy(&(*keys)[i], &d, sizeof(double));
+        }
+    } else {
+        // Signed keys keep their top bits random, so both signs show up
+        const uint64_t mask =
+            args.keyBits >= 64 ? ~0ULL : (1ULL << args.keyBits) - 1;
+        const uint64_t signBits =
+            args.keyType == KeyType::Long ? ~mask : 0;
+        for (uint32_t i = 0; i < args.size; ++i) {
+            const uint64_t t = rng();
+            (*keys)[i] = (t & mask) | ((t >> 63) ? signBits : 0);
+        }
+    }
+    std::memcpy(args.buffs.sort.mapped, keys->data(),
+                sizeof(uint64_t) * args.size);
+    // The count is written on the device by RecordIndirect. The host only
+    // poisons it, which would sort the whole buffer if that write is lost.
+    if (args.indirect) {
+        *static_cast<uint32_t*>(args.buffs.keyCount.mapped) = UINT32_MAX;
+    }
+
+    if (args.sortPairs) {
+        if (args.payloadUlong) {
+            // Put the index in both halves so a lost high word is caught
+            uint64_t* payload =
+                static_cast<uint64_t*>(args.buffs.sortPayload.mapped);
+            for (uint32_t i = 0; i < args.size; ++i) {
+                payload[i] = (static_cast<uint64_t>(~i) << 32) | i;
+            }
+        } else {
+            uint32_t* payload =
+                static_cast<uint32_t*>(args.buffs.sortPayload.mapped);
+            for (uint32_t i = 0; i < args.size; ++i) {
+                payload[i] = i;
+            }
+        }
+    }
+}
+
+// The same radix tricks as SortCommon.hlsl, on the raw key bits
+uint64_t ToRadixKey(const TestArgs& args, uint64_t key) {
+    switch (args.keyType) {
+        case KeyType::Long:
+            return key ^ (1ULL << 63);
+        case KeyType::Double:
+            return key ^ ((key >> 63) ? ~0ULL : 1ULL << 63);
+        default:
+            return key;
+    }
+}
+
+// An indirect count past the allocation is clamped on the device
+uint32_t SortedCount(const TestArgs& args) {
+    return args.indirect || args.algo == Algorithm::SmallSort
+               ? std::min(args.count, args.size)
+               : args.size;
+}
+
+// Only the bits in [beginBit, endBit) take part in the sort
+uint64_t KeyWindowMask(const TestArgs& args) {
+    const uint64_t high =
+        args.endBit >= 64 ? ~0ULL : (1ULL << args.endBit) - 1;
+    return high & ~((1ULL << args.beginBit) - 1);
+}
+
+// The global histogram must hold the exclusive prefix sum of every digit.
+// OneSweep scans into the pass histogram instead, leaving the raw counts.
+bool ValidateGlobalHist(const TestArgs& args,
+                        const std::vector<uint64_t>& keys) {
+    const uint64_t windowMask = KeyWindowMask(args);
+    const uint32_t radix = 1U << args.digitBits;
+    const uint32_t radixPasses = RadixPasses(args.digitBits);
+    std::vector<uint32_t> expected(GlobalHistSize(args.digitBits), 0);
+    for (uint32_t k = 0; k < SortedCount(args); ++k) {
+        const uint64_t key = ToRadixKey(args, keys[k]) & windowMask;
+        for (uint32_t pass = 0; pass < radixPasses; ++pass) {
+            const uint32_t digitMask =
+                (1U << PassWidth(pass, args.digitBits)) - 1;
+            expected[pass * radix +
+                     (key >> PassShift(pass, args.digitBits) & digitMask)]++;
+        }
+    }
+    for (uint32_t pass = 0;
+         pass < radixPasses && args.algo == Algorithm::DeviceRadixSort;
+         ++pass) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < radix; ++i) {
+            const uint32_t t = expected[pass * radix + i];
+            expected[pass * radix + i] = sum;
+            sum += t;
+        }
+    }
+
+    const uint32_t* globalHist =
+        static_cast<const uint32_t*>(args.buffs.globalHist.mapped);
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < GlobalHistSize(args.digitBits); ++i) {
+        if (globalHist[i] != expected[i]) {
+            if (errors < 16) {
+                std::cerr << "Global hist error at pass " << i / radix
+                          << " digit " << i % radix << ": " << globalHist[i]
+                          << " expected " << expected[i] << std::endl;
+            }
+            errors++;
+        }
+    }
+    return errors == 0;
+}
+
+bool ValidateSort(const TestArgs& args, const std::vector<uint64_t>& keys) {
+    const uint32_t count = SortedCount(args);
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i) {
+        order[i] = i;
+    }
+    const uint64_t windowMask = KeyWindowMask(args);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return (ToRadixKey(args, keys[a]) & windowMask) <
+               (ToRadixKey(args, keys[b]) & windowMask);
+    });
+    // Descending is produced by reversing the final pass, so ties come
+    // out in reverse input order
+    if (!args.shouldAscend) {
+        std::reverse(order.begin(), order.end());
+    }
+
+    const uint64_t* sorted = static_cast<const uint64_t*>(args.buffs.sort.mapped);
+    const void* payload = args.buffs.sortPayload.mapped;
+    uint32_t errors = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const bool keyOk = sorted[i] == keys[order[i]];
+        bool payloadOk = true;
+        if (args.sortPairs && args.payloadUlong) {
+            const uint64_t expected =
+                (static_cast<uint64_t>(~order[i]) << 32) | order[i];
+            payloadOk = static_cast<const uint64_t*>(payload)[i] == expected;
+        } else if (args.sortPairs) {
+            payloadOk = static_cast<const uint32_t*>(payload)[i] == order[i];
+        }
+        if (!keyOk || !payloadOk) {
+            if (errors < 16) {
+                std::cerr << "Sort error at " << i << ": " << sorted[i]
+                          << " expected " << keys[order[i]] << std::endl;
+            }
+            errors++;
+        }
+    }
+    // Keys past the device count must never be touched
+    for (uint32_t i = count; i < args.size; ++i) {
+        if (sorted[i] != keys[i]) {
+            if (errors < 16) {
+                std::cerr << "Tail key modified at " << i << std::endl;
+            }
+            errors++;
+        }
+    }
+    if (errors) {
+        std::cerr << "Test failed: " << errors << " errors" << std::endl;
+    }
+    return errors == 0;
+}
+
+void Run(const std::string& testLabel, const TestArgs& args) {
+    VkCommandBufferAllocateInfo cmdInfo{
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    cmdInfo.commandPool = args.gpu.commandPool;
+    cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cmdInfo.commandBufferCount = 1;
+    VkCommandBuffer cmd;
+    CheckVk(vkAllocateCommandBuffers(args.gpu.device, &cmdInfo, &cmd),
+            "vkAllocateCommandBuffers");
+
+    std::vector<uint64_t> keys(args.size);
+    uint32_t testsPassed = 0;
+    uint32_t totalSkipped = 0;
+    double totalTime = 0.0;
+    double totalStall = 0.0;
+    for (uint32_t i = 0; i < args.batchSize; ++i) {
+        InitializeInput(args, i + 10, &keys);
+        CheckVk(vkResetDescriptorPool(args.gpu.device,
+                                      args.gpu.descriptorPool, 0),
+                "vkResetDescriptorPool");
+
+        BeginCommands(cmd);
+        vkCmdResetQueryPool(cmd, args.gpu.queryPool, 0, TIMESTAMP_COUNT);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                            args.gpu.queryPool, 0);
+        uint32_t trivialMask = 0;
+        uint32_t passMask;
+        if (args.algo == Algorithm::SmallSort) {
+            passMask = 0;
+            RecordSmallSort(args, cmd);
+        } else if (args.algo == Algorithm::OneSweep) {
+            passMask = GetPassMask(args, 0);
+            RecordOneSweep(args, cmd, passMask);
+        } else if (args.indirect) {
+            passMask = GetPassMask(args, 0);
+            RecordIndirect(args, cmd, passMask, GetTileCountPass(args));
+        } else {
+            const uint32_t tileCountPass = GetTileCountPass(args);
+            const uint32_t slot = RecordGlobalHist(args, cmd, tileCountPass);
+
+            // Skipping needs the histograms on the host, so the sort is
+            // split into two submissions, exactly like the Unity immediate
+            // mode path. The device idles from the end of the first to the
+            // start of the second, that gap is the cost of the readback.
+            if (args.skipTrivialPasses) {
+                vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                    args.gpu.queryPool, 2);
+                SubmitSync(args.gpu, cmd);
+                trivialMask = GetTrivialPassMask(args);
+                BeginCommands(cmd);
+                vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                                    args.gpu.queryPool, 3);
+            }
+
+            passMask = GetPassMask(args, trivialMask);
+            RecordPasses(args, cmd, slot, passMask, tileCountPass);
+        }
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                            args.gpu.queryPool, 1);
+        SubmitSync(args.gpu, cmd);
+        for (uint32_t t = trivialMask & ~passMask; t; t &= t - 1) {
+            totalSkipped++;
+        }
+
+        // The first test is always discarded to prep caches and TLB
+        if (args.shouldTime && i != 0) {
+            const uint32_t stampCount =
+                args.skipTrivialPasses ? TIMESTAMP_COUNT : 2;
+            uint64_t stamps[TIMESTAMP_COUNT];
+            CheckVk(vkGetQueryPoolResults(
+                        args.gpu.device, args.gpu.queryPool, 0, stampCount,
+                        sizeof(stamps), stamps, sizeof(uint64_t),
+                        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT),
+                    "vkGetQueryPoolResults");
+            totalTime += static_cast<double>(stamps[1] - stamps[0]) *
+                         args.gpu.timestampPeriod;
+            if (args.skipTrivialPasses) {
+                totalStall += static_cast<double>(stamps[3] - stamps[2]) *
+                              args.gpu.timestampPeriod;
+            }
+        }
+
+        if (args.shouldValidate) {
+            // The small sort builds no global histogram
+            testsPassed += (args.algo == Algorithm::SmallSort ||
+                            ValidateGlobalHist(args, keys)) &&
+                           ValidateSort(args, keys);
+        }
+    }
+    vkFreeCommandBuffers(args.gpu.device, args.gpu.commandPool, 1, &cmd);
+    std::cout << std::endl;
+
+    if (args.shouldValidate) {
+        std::cout << testsPassed << "/" << args.batchSize << " " << testLabel;
+        if (testsPassed == args.batchSize) {
+            std::cout << " ALL TESTS PASSED" << std::endl;
+        } else {
+            std::cout << " TEST FAILED" << std::endl;
+        }
+    }
+
+    if (args.skipTrivialPasses) {
+        std::cout << "Skipped " << totalSkipped << "/"
+                  << RadixPasses(args.digitBits) * args.batchSize << " passes"
+                  << std::endl;
+    }
+
+    // Already part of the total time, skipping only pays off when the
+    // passes it saves take longer than this
+    if (args.skipTrivialPasses && args.shouldTime && args.batchSize > 1) {
+        printf("Average readback stall %f ms\n",
+               totalStall / 1e6 / (args.batchSize - 1));
+    }
+
+    if (args.shouldTime && args.batchSize > 1) {
+        double dTime = totalTime / 1e9;
+        std::cout << "Total time elapsed " << dTime << std::endl;
+        double speed =
+            ((uint64_t)SortedCount(args) * (uint64_t)(args.batchSize - 1)) /
+            dTime;
+        printf("Estimated speed %e keys/s\n", speed);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 4) {
+        std::cerr << "Usage: <Sort Type: keys | pairs> <Input Size as Power of "
+                     "Two: uint32_t> <Test Batch Size: uint32_t> [bits=<Random "
+                     "Key Bits>] [begin=<Begin Bit>] [end=<End Bit>] "
+                     "[key=<ulong | long | double>] [payload=<uint | ulong>] "
+                     "[algo=<drs | onesweep | small>] [radix=<8 | 11>] "
+                     "[count=<Indirect or Small Sort Key Count>] "
+                     "[spin=<Fallback Max Spin Count>] "
+                     "[dim=<Max Dispatch Dimension>] [wave=<Subgroup Size>] "
+                     "[descend] [skip] [fallback] [indirect]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const std::string sortType = argv[1];
+    if (sortType != "keys" && sortType != "pairs") {
+        std::cerr << "Error: Unknown sort type " << sortType << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    uint32_t powerOfTwo;
+    uint32_t batchSize;
+    uint32_t keyBits = 64;
+    uint32_t beginBit = 0;
+    uint32_t endBit = 64;
+    bool shouldAscend = true;
+    bool skipTrivialPasses = false;
+    bool payloadUlong = false;
+    bool decoupledFallback = false;
+    bool indirect = false;
+    bool hasCount = false;
+    uint32_t count = 0;
+    uint32_t digitBits = DIGIT_BITS;
+    uint32_t spinCount = 0;
+    uint32_t maxDispatchDim = MAX_DISPATCH_DIM;
+    uint32_t waveSize = 0;
+    KeyType keyType = KeyType::Ulong;
+    Algorithm algo = Algorithm::DeviceRadixSort;
+    try {
+        powerOfTwo = std::stoul(argv[2]);
+        if (powerOfTwo > 30 || argv[2][0] == '-') {
+            throw std::runtime_error(
+                "Error: input size power must be a value between 0 and 30");
+        }
+        batchSize = std::stoul(argv[3]);
+        if (argv[3][0] == '-' || batchSize == 0) {
+            throw std::runtime_error(
+                "Error: test batch size must be positive");
+        }
+
+        for (int i = 4; i < argc; ++i) {
+            const std::string option = argv[i];
+            const size_t eq = option.find('=');
+            const std::string name = option.substr(0, eq);
+            if (eq == std::string::npos) {
+                if (name == "descend") {
+                    shouldAscend = false;
+                } else if (name == "skip") {
+                    skipTrivialPasses = true;
+                } else if (name == "fallback") {
+                    decoupledFallback = true;
+                } else if (name == "indirect") {
+                    indirect = true;
+                } else {
+                    throw std::runtime_error("Error: Unknown option " + option);
+                }
+                continue;
+            }
+
+            const std::string value = option.substr(eq + 1);
+            if (value.empty() || value[0] == '-') {
+                throw std::invalid_argument(option);
+            }
+            if (name == "bits") {
+                keyBits = std::stoul(value);
+            } else if (name == "begin") {
+                beginBit = std::stoul(value);
+            } else if (name == "end") {
+                endBit = std::stoul(value);
+            } else if (name == "key") {
+                if (value == "ulong") {
+                    keyType = KeyType::Ulong;
+                } else if (value == "long") {
+                    keyType = KeyType::Long;
+                } else if (value == "double") {
+                    keyType = KeyType::Double;
+                } else {
+                    throw std::runtime_error("Error: Unknown key type " +
+                                             value);
+                }
+            } else if (name == "payload") {
+                if (value == "uint") {
+                    payloadUlong = false;
+                } else if (value == "ulong") {
+                    payloadUlong = true;
+                } else {
+                    throw std::runtime_error("Error: Unknown payload type " +
+                                             value);
+                }
+            } else if (name == "radix") {
+                digitBits = std::stoul(value);
+                if (digitBits != DIGIT_BITS && digitBits != WIDE_DIGIT_BITS) {
+                    throw std::runtime_error(
+                        "Error: digit width must be 8 or 11");
+                }
+            } else if (name == "spin") {
+                spinCount = std::stoul(value);
+                if (spinCount == 0) {
+                    throw std::runtime_error(
+                        "Error: the spin count must be positive");
+                }
+            } else if (name == "dim") {
+                maxDispatchDim = std::stoul(value);
+                if (maxDispatchDim == 0 || maxDispatchDim > MAX_DISPATCH_DIM) {
+                    throw std::runtime_error(
+                        "Error: the dispatch dimension must be a value "
+                        "between 1 and 65535");
+                }
+            } else if (name == "wave") {
+                waveSize = std::stoul(value);
+                if (waveSize == 0 || (waveSize & (waveSize - 1))) {
+                    throw std::runtime_error(
+                        "Error: the subgroup size must be a power of two");
+                }
+            } else if (name == "count") {
+                count = std::stoul(value);
+                hasCount = true;
+            } else if (name == "algo") {
+                if (value == "drs") {
+                    algo = Algorithm::DeviceRadixSort;
+                } else if (value == "onesweep") {
+                    algo = Algorithm::OneSweep;
+                } else if (value == "small") {
+                    algo = Algorithm::SmallSort;
+                } else {
+                    throw std::runtime_error("Error: Unknown algorithm " +
+                                             value);
+                }
+            } else {
+                throw std::runtime_error("Error: Unknown option " + option);
+            }
+        }
+
+        if (keyBits == 0 || keyBits > 64) {
+            throw std::runtime_error(
+                "Error: key bits must be a value between 1 and 64");
+        }
+        if (beginBit >= endBit || endBit > 64) {
+            throw std::runtime_error(
+                "Error: the bit window must satisfy begin < end <= 64");
+        }
+        if (algo == Algorithm::OneSweep && powerOfTwo > 29) {
+            throw std::runtime_error(
+                "Error: OneSweep prefix sums must fit in 30 bits");
+        }
+        if (indirect &&
+            (algo != Algorithm::DeviceRadixSort || skipTrivialPasses)) {
+            throw std::runtime_error(
+                "Error: the indirect count is DeviceRadixSort only, without "
+                "skipping");
+        }
+        if (hasCount && !indirect && algo != Algorithm::SmallSort) {
+            throw std::runtime_error(
+                "Error: count requires indirect or the small sort");
+        }
+        if (algo == Algorithm::SmallSort &&
+            (skipTrivialPasses || digitBits != DIGIT_BITS ||
+             (hasCount ? count : 1U << powerOfTwo) > PART_SIZE ||
+             (hasCount && count > 1U << powerOfTwo))) {
+            throw std::runtime_error(
+                "Error: the small sort takes at most PART_SIZE keys, up to "
+                "the input size, with 8-bit digits and no skipping");
+        }
+        if (algo == Algorithm::OneSweep && skipTrivialPasses) {
+            throw std::runtime_error(
+                "Error: trivial pass skipping is DeviceRadixSort only");
+        }
+        if (algo == Algorithm::DeviceRadixSort && decoupledFallback) {
+            throw std::runtime_error(
+                "Error: the decoupled fallback is OneSweep only");
+        }
+        if (spinCount && !decoupledFallback) {
+            throw std::runtime_error(
+                "Error: the spin count only bounds the decoupled fallback");
+        }
+        if (algo == Algorithm::OneSweep && digitBits != DIGIT_BITS) {
+            throw std::runtime_error(
+                "Error: wide digits are DeviceRadixSort only");
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << "Error: Arguments must be unsigned integers." << std::endl;
+        return EXIT_FAILURE;
+    } catch (const std::out_of_range& e) {
+        std::cerr << "Error: Arguments are out of range for unsigned integers."
+                  << std::endl;
+        return EXIT_FAILURE;
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // The indirect count defaults to a partial last tile, the other sorts
+    // always sort the whole input
+    const uint32_t size = 1U << powerOfTwo;
+    if (!hasCount) {
+        count = indirect ? size - size / 4 : size;
+        if (indirect && count % PART_SIZE == 0) {
+            count--;
+        }
+    }
+    const bool sortPairs = sortType == "pairs";
+
+    GPUContext gpu;
+    if (GetGPUContext(&gpu, waveSize) == EXIT_FAILURE) {
+        return EXIT_FAILURE;
+    }
+    if (digitBits == WIDE_DIGIT_BITS &&
+        gpu.maxSharedMemory < WIDE_DIGIT_SHARED_MEMORY) {
+        std::cerr << "Error: wide digits need " << WIDE_DIGIT_SHARED_MEMORY
+                  << " bytes of shared memory" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        GPUBuffers buffs;
+        GetGPUBuffers(gpu, &buffs, size, sortPairs, payloadUlong, algo,
+                      indirect, digitBits);
+        Shaders shaders;
+        GetAllShaders(gpu, &shaders, keyType, sortPairs, payloadUlong,
+                      shouldAscend, algo, decoupledFallback, indirect,
+                      digitBits, spinCount, maxDispatchDim);
+        PrintOccupancy(gpu, shaders);
+
+        TestArgs args = {gpu, buffs, shaders, size, batchSize, keyBits};
+        args.sortPairs = sortPairs;
+        args.shouldAscend = shouldAscend;
+        args.skipTrivialPasses = skipTrivialPasses;
+        args.beginBit = beginBit;
+        args.endBit = endBit;
+        args.keyType = keyType;
+        args.payloadUlong = payloadUlong;
+        args.algo = algo;
+        args.indirect = indirect;
+        args.count = count;
+        args.digitBits = digitBits;
+        args.maxDispatchDim = maxDispatchDim;
+        const std::string algoLabel =
+            algo == Algorithm::OneSweep
+                ? (decoupledFallback ? "OneSweep Fallback" : "OneSweep") +
+                      (spinCount ? " Spin " + std::to_string(spinCount)
+                                 : std::string())
+            : algo == Algorithm::SmallSort
+                ? "SmallSort " + std::to_string(count)
+            : indirect ? "DeviceRadixSort Indirect " + std::to_string(count)
+                       : "DeviceRadixSort";
+        Run(algoLabel + (digitBits == WIDE_DIGIT_BITS ? " Radix 11" : "") +
+                (sortPairs ? " Pairs" : " Keys"),
+            args);
+
+        for (ComputeShader* cs :
+             {&shaders.init, &shaders.globalHist, &shaders.globalHistScan,
+              &shaders.upsweep, &shaders.scan, &shaders.downsweep,
+              &shaders.digitBinningPass, &shaders.setupIndirect,
+              &shaders.smallSort}) {
+            DestroyShader(gpu, cs);
+        }
+        for (Buffer* buff :
+             {&buffs.info, &buffs.sort, &buffs.alt, &buffs.sortPayload,
+              &buffs.altPayload, &buffs.globalHist, &buffs.passHist,
+              &buffs.index, &buffs.keyCount, &buffs.indirectArgs,
+              &buffs.sortInfo}) {
+            DestroyBuffer(gpu, buff);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    vkDestroyQueryPool(gpu.device, gpu.queryPool, nullptr);
+    vkDestroyDescriptorPool(gpu.device, gpu.descriptorPool, nullptr);
+    vkDestroyCommandPool(gpu.device, gpu.commandPool, nullptr);
+    vkDestroyDevice(gpu.device, nullptr);
+    vkDestroyInstance(gpu.instance, nullptr);
+    return EXIT_SUCCESS;
+}
@@ -9,11 +9,17 @@
 
 #include <dawn/webgpu_cpp.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <future>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -23,6 +29,20 @@ struct GPUContext {
     wgpu::Device device;
     wgpu::Queue queue;
     wgpu::QuerySet querySet;
+    wgpu::Limits limits;  // What the device was created with
+};
+
+// Backs Dawn's blob cache with one file per entry, so a warm start loads
+// translated shaders and compiled pipelines instead of building them. Dawn
+// keys each entry by the shader source and pipeline state, the isolation key
+// keeps entries of different adapters and drivers apart.
+struct PipelineCache {
+    std::string directory;
+    std::string isolationKey;
+    std::mutex mutex;  // Dawn may call back from its worker threads
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+    uint32_t stores = 0;
 };
 
 struct ComputeShader {
@@ -57,6 +77,7 @@ struct GPUBuffers {
     wgpu::Buffer readbackTimestamp;
     wgpu::Buffer readback;
     wgpu::Buffer misc;
+    wgpu::Buffer miscSlots;  // A copy of misc per scan of a batched submit
 };
 
 struct TestArgs {
@@ -75,6 +96,65 @@ struct TestArgs {
     uint32_t (*MainPass)(const TestArgs&, wgpu::CommandEncoder*) = nullptr;
     bool (*ValidateSync)(const GPUContext&, GPUBuffers*,
                          const Shaders&) = nullptr;
+    uint32_t scansPerSubmit = 1;  // Scans recorded into one command buffer
+    uint32_t timestampBase = 0;   // First timestamp pair of the scan
+};
+
+// Sort constants, MUST match the shaders in SharedShaders/Sort
+constexpr uint32_t SORT_RADIX = 256;
+constexpr uint32_t SORT_RADIX_PASSES = 8;  // Of 64-bit keys, 32-bit keys take 4
+constexpr uint32_t SORT_PART_SIZE = 3072;
+constexpr uint32_t SORT_G_HIST_PART_SIZE = 32768;
+constexpr uint32_t SORT_INFO_STRIDE =
+    256;  // Per pass uniforms, at the default minUniformBufferOffsetAlignment
+constexpr uint32_t SORT_MIN_POWER = 10;
+constexpr uint32_t SORT_MAX_POWER =
+    24;  // 2^24 8-byte keys fill the default maxStorageBufferBindingSize
+
+// Sweep constants, every scan at every power of two in between
+constexpr uint32_t SWEEP_MIN_POWER = 10;
+constexpr uint32_t SWEEP_MAX_POWER = 28;
+
+struct SortShaders {
+    ComputeShader init;
+    ComputeShader globalHist;
+    ComputeShader globalHistScan;
+    ComputeShader upsweep;
+    ComputeShader scan;
+    ComputeShader downsweep;
+    ComputeShader digitBinning;
+    ComputeShader validate;
+};
+
+// Every sort kernel shares one layout. The passes ping pong between the
+// two bind groups, and pick their uniforms with a dynamic offset.
+struct SortBuffers {
+    wgpu::Buffer info;
+    wgpu::Buffer sort;
+    wgpu::Buffer alt;
+    wgpu::Buffer globalHist;
+    wgpu::Buffer passHist;
+    wgpu::Buffer misc;
+    wgpu::Buffer bump;
+    wgpu::Buffer timestamp;
+    wgpu::Buffer readbackTimestamp;
+    wgpu::Buffer readback;
+    wgpu::BindGroupLayout bindGroupLayout;
+    wgpu::BindGroup bindGroups[2];  // sort to alt, alt to sort
+};
+
+struct SortArgs {
+    GPUContext& gpu;
+    SortBuffers& buffs;
+    SortShaders& shaders;
+    uint32_t size = 0;
+    uint32_t batchSize = 0;
+    uint32_t radixPasses = SORT_RADIX_PASSES;
+    uint32_t threadBlocks = 0;
+    uint32_t globalHistThreadBlocks = 0;
+    bool shouldValidate = true;
+    bool shouldTime = true;
+    uint32_t (*MainPass)(const SortArgs&, wgpu::CommandEncoder*) = nullptr;
 };
 
 enum class ScanType {
@@ -86,10 +166,103 @@ enum class ScanType {
     CsdldfStruct,
     CsdldfStructStats,
     CsdldfStructOcc,
+    Drs,
+    Drs32,
+    OneSweep,
+    OneSweep32,
+    Sweep,
     Unknown
 };
 
-int GetGPUContext(GPUContext* context, uint32_t timestampCount) {
+// FNV-1a over the isolation key and Dawn's key
+std::string GetPipelineCachePath(const PipelineCache& cache, const void* key,
+                                 size_t keySize) {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&](const uint8_t* bytes, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+    mix(reinterpret_cast<const uint8_t*>(cache.isolationKey.data()),
+        cache.isolationKey.size());
+    mix(static_cast<const uint8_t*>(key), keySize);
+
+    std::stringstream path;
+    path << cache.directory << "/" << std::hex << std::setw(16)
+         << std::setfill('0') << hash << ".bin";
+    return path.str();
+}
+
+// Each file holds the full key ahead of the value, so a hash collision
+// reads as a miss. Dawn asks for the size first, with no value to fill.
+size_t LoadPipelineCacheData(const void* key, size_t keySize, void* value,
+                             size_t valueSize, void* userdata) {
+    PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+    std::ifstream file(GetPipelineCachePath(*cache, key, keySize),
+                       std::ios::binary);
+    std::string stored;
+    if (file.is_open()) {
+        stored.assign(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+    }
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (stored.size() <= keySize ||
+        std::memcmp(stored.data(), key, keySize) != 0) {
+        cache->misses += value == nullptr;
+        return 0;
+    }
+
+    const size_t dataSize = stored.size() - keySize;
+    if (value == nullptr) {
+        return dataSize;
+    }
+    if (valueSize < dataSize) {
+        return 0;
+    }
+    std::memcpy(value, stored.data() + keySize, dataSize);
+    cache->hits++;
+    return dataSize;
+}
+
+void StorePipelineCacheData(const void* key, size_t keySize, const void* value,
+                            size_t valueSize, void* userdata) {
+    PipelineCache* cache = static_cast<PipelineCache*>(userdata);
+    std::ofstream file(GetPipelineCachePath(*cache, key, keySize),
+                       std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return;
+    }
+    file.write(static_cast<const char*>(key), keySize);
+    file.write(static_cast<const char*>(value), valueSize);
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    cache->stores++;
+}
+
+// From the start of the program until the pipelines are ready. Warm when
+// every pipeline the run needed came out of the cache.
+void ReportStartup(PipelineCache* cache,
+                   std::chrono::steady_clock::time_point startTime) {
+    const double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - startTime)
+                          .count();
+    if (cache == nullptr) {
+        std::cout << "Uncached startup " << ms << " ms" << std::endl;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    const bool warm = cache->hits != 0 && cache->misses == 0;
+    std::cout << (warm ? "Warm" : "Cold") << " startup " << ms
+              << " ms, pipeline cache " << cache->hits << " hits, "
+              << cache->misses << " misses, " << cache->stores << " stored"
+              << std::endl;
+}
+
+// Pass a null cache to compile everything from scratch
+int GetGPUContext(GPUContext* context, uint32_t timestampCount,
+                  PipelineCache* cache) {
     wgpu::InstanceDescriptor instanceDescriptor{};
     instanceDescriptor.features.timedWaitAnyEnable = true;
     wgpu::Instance instance = wgpu::CreateInstance(&instanceDescriptor);
@@ -151,6 +324,18 @@ int GetGPUContext(GPUContext* context, uint32_t timestampCount) {
     devDescriptor.requiredFeatureCount =
         static_cast<uint32_t>(reqFeatures.size());
 
+    // The defaults cap a binding at 128MB, too small for the largest sweep
+    // sizes, so ask for whatever the adapter allows
+    wgpu::Limits adapterLimits = {};
+    adapter.GetLimits(&adapterLimits);
+    wgpu::Limits reqLimits = {};
+    reqLimits.maxStorageBufferBindingSize =
+        adapterLimits.maxStorageBufferBindingSize;
+    reqLimits.maxBufferSize = adapterLimits.maxBufferSize;
+    reqLimits.maxComputeWorkgroupsPerDimension =
+        adapterLimits.maxComputeWorkgroupsPerDimension;
+    devDescriptor.requiredLimits = &reqLimits;
+
     WGPUErrorCallback errorCallback = [](WGPUErrorType type,
                                          WGPUStringView message, void*) {
         std::cerr << "Error: " << std::string(message.data, message.length)
@@ -161,6 +346,23 @@ int GetGPUContext(GPUContext* context, uint32_t timestampCount) {
     errorCallbackInfo.userdata = nullptr;
     devDescriptor.uncapturedErrorCallbackInfo = errorCallbackInfo;
 
+    wgpu::DawnCacheDeviceDescriptor cacheDescriptor = {};
+    if (cache != nullptr) {
+        std::error_code ec;
+        std::filesystem::create_directories(cache->directory, ec);
+        std::stringstream key;
+        key << std::hex << info.vendorID << ":" << info.deviceID << ":"
+            << static_cast<uint32_t>(info.backendType) << ":"
+            << std::string(info.description.data, info.description.length);
+        cache->isolationKey = key.str();
+        cacheDescriptor.isolationKey = wgpu::StringView(
+            cache->isolationKey.data(), cache->isolationKey.size());
+        cacheDescriptor.loadDataFunction = LoadPipelineCacheData;
+        cacheDescriptor.storeDataFunction = StorePipelineCacheData;
+        cacheDescriptor.functionUserdata = cache;
+        devDescriptor.nextInChain = &cacheDescriptor;
+    }
+
     wgpu::Device device;
     std::promise<void> devPromise;
     adapter.RequestDevice(
@@ -207,12 +409,14 @@ int GetGPUContext(GPUContext* context, uint32_t timestampCount) {
     (*context).device = device;
     (*context).queue = queue;
     (*context).querySet = querySet;
+    device.GetLimits(&(*context).limits);
     return EXIT_SUCCESS;
 }
 
 void GetGPUBuffers(const wgpu::Device& device, GPUBuffers* buffs,
                    uint32_t threadBlocks, uint32_t timestampCount,
-                   uint32_t size, uint32_t miscSize, uint32_t maxReadbackSize) {
+                   uint32_t size, uint32_t miscSize, uint32_t maxReadbackSize,
+                   uint32_t maxScansPerSubmit) {
     wgpu::BufferDescriptor infoDesc = {};
     infoDesc.label = "Info";
     infoDesc.size = sizeof(uint32_t) * 3;
@@ -272,6 +476,13 @@ void GetGPUBuffers(const wgpu::Device& device, GPUBuffers* buffs,
     miscDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
     wgpu::Buffer misc = device.CreateBuffer(&miscDesc);
 
+    wgpu::BufferDescriptor miscSlotsDesc = {};
+    miscSlotsDesc.label = "Miscellaneous Per Scan";
+    miscSlotsDesc.size = sizeof(uint32_t) * miscSize * maxScansPerSubmit;
+    miscSlotsDesc.usage =
+        wgpu::BufferUsage::CopySrc | wgpu::BufferUsage::CopyDst;
+    wgpu::Buffer miscSlots = device.CreateBuffer(&miscSlotsDesc);
+
     (*buffs).info = info;
     (*buffs).scanIn = scanIn;
     (*buffs).scanOut = scanOut;
@@ -281,6 +492,7 @@ void GetGPUBuffers(const wgpu::Device& device, GPUBuffers* buffs,
     (*buffs).readbackTimestamp = timestampReadback;
     (*buffs).readback = readback;
     (*buffs).misc = misc;
+    (*buffs).miscSlots = miscSlots;
 }
 
 // For simplicity we will use the same brind group and layout for all kernels
@@ -394,27 +606,27 @@ void GetComputeShaderPipeline(const wgpu::Device& device,
     (*cs).label = csLabel;
 }
 
-std::string ReadWGSL(const std::string& path) {
-    std::ifstream file(path);
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << path << std::endl;
-        return "";
-    }
-
+// Concatenates the files in order, so a shader can be assembled from parts
+std::string ReadWGSL(const std::vector<std::string>& paths) {
     std::stringstream buffer;
     buffer << "enable subgroups;\n";  // Enable subgroups here. I dont think
                                       // wgpu uses this notatation
-    buffer << file.rdbuf();
-    file.close();
+    for (const std::string& path : paths) {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            std::cerr << "Failed to open file: " << path << std::endl;
+            return "";
+        }
+        buffer << file.rdbuf() << "\n";
+        file.close();
+    }
     return buffer.str();
 }
 
-void CreateShaderFromSource(const GPUContext& gpu, const GPUBuffers& buffs,
-                            ComputeShader* cs, const char* entryPoint,
-                            const std::string& path,
-                            const std::string& csLabel) {
+wgpu::ShaderModule CreateShaderModule(const GPUContext& gpu,
+                                     const std::vector<std::string>& paths) {
     wgpu::ShaderSourceWGSL wgslSource = {};
-    std::string source = ReadWGSL(path);
+    std::string source = ReadWGSL(paths);
     wgslSource.code = source.c_str();
     wgpu::ShaderModuleDescriptor desc = {};
     desc.nextInChain = &wgslSource;
@@ -446,57 +658,108 @@ void CreateShaderFromSource(const GPUContext& gpu, const GPUBuffers& buffs,
            std::future_status::timeout) {
         gpu.instance.ProcessEvents();
     }
+    return mod;
+}
+
+wgpu::ShaderModule CreateShaderModule(const GPUContext& gpu,
+                                     const std::string& path) {
+    return CreateShaderModule(gpu, std::vector<std::string>{path});
+}
+
+void CreateShaderFromSource(const GPUContext& gpu, const GPUBuffers& buffs,
+                            ComputeShader* cs, const char* entryPoint,
+                            const std::string& path,
+                            const std::string& csLabel) {
+    wgpu::ShaderModule mod = CreateShaderModule(gpu, path);
     GetComputeShaderPipeline(gpu.device, buffs, cs, entryPoint, mod, csLabel);
 }
 
-void GetAllShaders(const GPUContext& gpu, const GPUBuffers& buffs,
-                   Shaders* shaders) {
+// Only the pipelines the scan types use, so a run does not pay for
+// compiling every variant
+void GetShaders(const GPUContext& gpu, const GPUBuffers& buffs,
+                const std::vector<ScanType>& scanTypes, Shaders* shaders) {
     CreateShaderFromSource(gpu, buffs, &shaders->init, "main",
                            "../SharedShaders/init.wgsl", "Init");
 
-    CreateShaderFromSource(gpu, buffs, &shaders->reduce, "reduce",
-                           "../SharedShaders/rts.wgsl", "Reduce");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->spineScan, "spine_scan",
-                           "../SharedShaders/rts.wgsl", "Spine Scan");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->downsweep, "downsweep",
-                           "../SharedShaders/rts.wgsl", "Downsweep");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->csdl, "main",
-                           "../SharedShaders/csdl.wgsl", "CSDL");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->csdldf, "main",
-                           "../SharedShaders/csdldf.wgsl", "CSDLDF");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->csdldfStruct, "main",
-                           "../SharedShaders/csdldf_struct.wgsl",
-                           "CSDLDF Struct");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->csdldfStats, "main",
-                           "../SharedShaders/TestVariants/csdldf_stats.wgsl",
-                           "CSDLDF Stats");
-
-    CreateShaderFromSource(
-        gpu, buffs, &shaders->csdldfStructStats, "main",
-        "../SharedShaders/TestVariants/csdldf_struct_stats.wgsl",
-        "CSDLDF Struct Stats");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->csdldfOcc, "main",
-                           "../SharedShaders/TestVariants/csdldf_occ.wgsl",
-                           "CSDLDF Occupancy");
-
-    CreateShaderFromSource(
-        gpu, buffs, &shaders->csdldfStructOcc, "main",
-        "../SharedShaders/TestVariants/csdldf_struct_occ.wgsl",
-        "CSDLDF Struct Occupancy");
-
-    CreateShaderFromSource(gpu, buffs, &shaders->validate, "main",
-                           "../SharedShaders/validate.wgsl", "Validate");
+    bool isStruct = false;
+    bool isGeneric = false;
+    for (ScanType scanType : scanTypes) {
+        isGeneric |= scanType == ScanType::Rts || scanType == ScanType::Csdl ||
+                     scanType == ScanType::Csdldf ||
+                     scanType == ScanType::CsdldfStats ||
+                     scanType == ScanType::CsdldfOcc;
+        switch (scanType) {
+            case ScanType::Rts: {
+                wgpu::ShaderModule mod =
+                    CreateShaderModule(gpu, "../SharedShaders/rts.wgsl");
+                GetComputeShaderPipeline(gpu.device, buffs, &shaders->reduce,
+                                         "reduce", mod, "Reduce");
+                GetComputeShaderPipeline(gpu.device, buffs, &shaders->spineScan,
+                                         "spine_scan", mod, "Spine Scan");
+                GetComputeShaderPipeline(gpu.device, buffs, &shaders->downsweep,
+                                         "downsweep", mod, "Downsweep");
+                break;
+            }
+            case ScanType::Csdl:
+                CreateShaderFromSource(gpu, buffs, &shaders->csdl, "main",
+                                       "../SharedShaders/csdl.wgsl", "CSDL");
+                break;
+            case ScanType::Csdldf:
+                CreateShaderFromSource(gpu, buffs, &shaders->csdldf, "main",
+                                       "../SharedShaders/csdldf.wgsl",
+                                       "CSDLDF");
+                break;
+            case ScanType::CsdldfStats:
+                CreateShaderFromSource(
+                    gpu, buffs, &shaders->csdldfStats, "main",
+                    "../SharedShaders/TestVariants/csdldf_stats.wgsl",
+                    "CSDLDF Stats");
+                break;
+            case ScanType::CsdldfOcc:
+                CreateShaderFromSource(
+                    gpu, buffs, &shaders->csdldfOcc, "main",
+                    "../SharedShaders/TestVariants/csdldf_occ.wgsl",
+                    "CSDLDF Occupancy");
+                break;
+            case ScanType::CsdldfStruct:
+                isStruct = true;
+                CreateShaderFromSource(gpu, buffs, &shaders->csdldfStruct,
+                                       "main",
+                                       "../SharedShaders/csdldf_struct.wgsl",
+                                       "CSDLDF Struct");
+                break;
+            case ScanType::CsdldfStructStats:
+                isStruct = true;
+                CreateShaderFromSource(
+                    gpu, buffs, &shaders->csdldfStructStats, "main",
+                    "../SharedShaders/TestVariants/csdldf_struct_stats.wgsl",
+                    "CSDLDF Struct Stats");
+                break;
+            case ScanType::CsdldfStructOcc:
+                isStruct = true;
+                CreateShaderFromSource(
+                    gpu, buffs, &shaders->csdldfStructOcc, "main",
+                    "../SharedShaders/TestVariants/csdldf_struct_occ.wgsl",
+                    "CSDLDF Struct Occupancy");
+                break;
+            default:
+                break;
+        }
+    }
 
-    CreateShaderFromSource(gpu, buffs, &shaders->validateStruct,
-                           "validate_struct", "../SharedShaders/validate.wgsl",
-                           "Validate");
+    if (isStruct || isGeneric) {
+        wgpu::ShaderModule mod =
+            CreateShaderModule(gpu, "../SharedShaders/validate.wgsl");
+        if (isGeneric) {
+            GetComputeShaderPipeline(gpu.device, buffs, &shaders->validate,
+                                     "main", mod, "Validate");
+        }
+        if (isStruct) {
+            GetComputeShaderPipeline(gpu.device, buffs,
+                                     &shaders->validateStruct,
+                                     "validate_struct", mod, "Validate");
+        }
+    }
 }
 
 void SetComputePass(const ComputeShader& cs, wgpu::CommandEncoder* comEncoder,
@@ -624,6 +887,12 @@ bool ValidateStruct(const GPUContext& gpu, GPUBuffers* buffs,
     return ValidateBase(gpu, buffs, shaders.validateStruct);
 }
 
+// The kernel ValidateSync dispatches, for recording it into a batch
+const ComputeShader& GetValidateShader(const TestArgs& args) {
+    return args.ValidateSync == ValidateStruct ? args.shaders.validateStruct
+                                               : args.shaders.validate;
+}
+
 void ReadbackAndPrintSync(const GPUContext& gpu, GPUBuffers* buffs,
                           uint32_t readbackSize) {
     std::vector<uint32_t> readOut(readbackSize);
@@ -637,21 +906,23 @@ void ReadbackAndPrintSync(const GPUContext& gpu, GPUBuffers* buffs,
     }
 }
 
-void ResolveTimestampQuery(GPUBuffers* buffs, const wgpu::QuerySet& query,
+void ResolveTimestampQuery(const wgpu::Buffer& timestamp,
+                           const wgpu::Buffer& readbackTimestamp,
+                           const wgpu::QuerySet& query,
                            const wgpu::CommandEncoder* comEncoder,
                            uint32_t passCount) {
     uint32_t entriesToResolve = passCount * 2;
+    (*comEncoder).ResolveQuerySet(query, 0, entriesToResolve, timestamp, 0ULL);
     (*comEncoder)
-        .ResolveQuerySet(query, 0, entriesToResolve, buffs->timestamp, 0ULL);
-    (*comEncoder)
-        .CopyBufferToBuffer(buffs->timestamp, 0ULL, buffs->readbackTimestamp,
-                            0ULL, entriesToResolve * sizeof(uint64_t));
+        .CopyBufferToBuffer(timestamp, 0ULL, readbackTimestamp, 0ULL,
+                            entriesToResolve * sizeof(uint64_t));
 }
 
-uint64_t GetTime(const GPUContext& gpu, GPUBuffers* buffs, uint32_t passCount) {
+uint64_t GetTime(const GPUContext& gpu, wgpu::Buffer* readbackTimestamp,
+                 uint32_t passCount) {
     uint64_t totalTime = 0ULL;
     std::vector<uint64_t> timeOut(passCount * 2);
-    ReadbackSync(gpu, &buffs->readbackTimestamp, &timeOut,
+    ReadbackSync(gpu, readbackTimestamp, &timeOut,
                  passCount * 2 * sizeof(uint64_t));
     for (uint32_t i = 0; i < passCount; ++i) {
         totalTime += timeOut[i * 2 + 1] - timeOut[i * 2];
@@ -689,11 +960,12 @@ uint32_t RTS(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 3;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.reduce, comEncoder, args.gpu.querySet,
-                            args.threadBlocks, 0);
+                            args.threadBlocks, args.timestampBase);
         SetComputePassTimed(args.shaders.spineScan, comEncoder,
-                            args.gpu.querySet, 1, 1);
+                            args.gpu.querySet, 1, args.timestampBase + 1);
         SetComputePassTimed(args.shaders.downsweep, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 2);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase + 2);
     } else {
         SetComputePass(args.shaders.reduce, comEncoder, args.threadBlocks);
         SetComputePass(args.shaders.spineScan, comEncoder, 1);
@@ -706,7 +978,7 @@ uint32_t CSDL(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdl, comEncoder, args.gpu.querySet,
-                            args.threadBlocks, 0);
+                            args.threadBlocks, args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdl, comEncoder, args.threadBlocks);
     }
@@ -717,7 +989,7 @@ uint32_t CSDLDF(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldf, comEncoder, args.gpu.querySet,
-                            args.threadBlocks, 0);
+                            args.threadBlocks, args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldf, comEncoder, args.threadBlocks);
     }
@@ -728,7 +1000,8 @@ uint32_t CSDLDFStruct(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldfStruct, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 0);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldfStruct, comEncoder,
                        args.threadBlocks);
@@ -740,7 +1013,8 @@ uint32_t CSDLDFStats(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldfStats, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 0);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldfStats, comEncoder, args.threadBlocks);
     }
@@ -752,7 +1026,8 @@ uint32_t CSDLDFStructStats(const TestArgs& args,
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldfStructStats, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 0);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldfStructStats, comEncoder,
                        args.threadBlocks);
@@ -764,7 +1039,8 @@ uint32_t CSDLDFOcc(const TestArgs& args, wgpu::CommandEncoder* comEncoder) {
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldfOcc, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 0);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldfOcc, comEncoder, args.threadBlocks);
     }
@@ -776,7 +1052,8 @@ uint32_t CSDLDFStructOcc(const TestArgs& args,
     const uint32_t passCount = 1;
     if (args.shouldTime) {
         SetComputePassTimed(args.shaders.csdldfStructOcc, comEncoder,
-                            args.gpu.querySet, args.threadBlocks, 0);
+                            args.gpu.querySet, args.threadBlocks,
+                            args.timestampBase);
     } else {
         SetComputePass(args.shaders.csdldfStructOcc, comEncoder,
                        args.threadBlocks);
@@ -784,13 +1061,148 @@ uint32_t CSDLDFStructOcc(const TestArgs& args,
     return passCount;
 }
 
-void Run(std::string testLabel, const TestArgs& args) {
+// Everything one batch measured. The first run is always discarded to prep
+// caches and TLB, so times holds batchSize - 1 entries.
+struct RunResults {
+    std::vector<uint64_t> times;
+    std::vector<uint64_t> gaps;  // From the end of a scan to the next one
+    uint64_t wallTime = 0ULL;    // Submission to completion, on the host
+    uint32_t testsPassed = 0;
+    uint32_t testsRun = 0;
+    uint32_t statsSamples = 0;
     uint32_t totalSpins = 0;
     uint32_t fallbacksAttempted = 0;
     uint32_t successfulInsertions = 0;
+};
 
-    uint32_t testsPassed = 0;
-    uint64_t totalTime = 0ULL;
+uint64_t SubmitAndTimeSync(const GPUContext& gpu,
+                           const wgpu::CommandBuffer& comBuffer) {
+    const std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    gpu.queue.Submit(1, &comBuffer);
+    QueueSync(gpu);
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+}
+
+void ReadbackResultsSync(const TestArgs& args, RunResults* results) {
+    if (args.shouldGetStats) {
+        std::vector<uint32_t> stats(3, 0);
+        GetFallbackStatistics(args.gpu, &args.buffs, &stats);
+        results->totalSpins += stats[0];
+        results->fallbacksAttempted += stats[1];
+        results->successfulInsertions += stats[2];
+        results->statsSamples++;
+    }
+
+    if (args.shouldValidate) {
+        results->testsPassed +=
+            args.ValidateSync(args.gpu, &args.buffs, args.shaders);
+        results->testsRun++;
+    }
+}
+
+// Records up to scansPerSubmit scans, each with its init pass, into one
+// command buffer, so that nothing between two scans waits on the host. Every
+// timed pass of every scan gets its own pair of timestamps, and the gap
+// between two scans, the init pass and the dispatch overhead, is measured
+// from the end of one to the beginning of the next.
+//
+// The next scan's init pass clears misc, so each scan is validated by its own
+// validate pass and misc is copied to that scan's slot right after. With
+// validation on, the gap also holds the validate pass and the copy.
+RunResults RunBatchSubmitted(const TestArgs& args) {
+    const uint32_t miscSize =
+        static_cast<uint32_t>(args.buffs.misc.GetSize() / sizeof(uint32_t));
+    const bool shouldReadMisc = args.shouldValidate || args.shouldGetStats;
+    RunResults results;
+    for (uint32_t first = 0; first < args.batchSize;
+         first += args.scansPerSubmit) {
+        const uint32_t scanCount =
+            std::min(args.scansPerSubmit, args.batchSize - first);
+        wgpu::CommandEncoderDescriptor comEncDesc = {};
+        comEncDesc.label = "Batched Command Encoder";
+        wgpu::CommandEncoder comEncoder =
+            args.gpu.device.CreateCommandEncoder(&comEncDesc);
+        uint32_t passCount = 0;
+        for (uint32_t k = 0; k < scanCount; ++k) {
+            TestArgs scanArgs = args;
+            scanArgs.timestampBase = k * passCount;
+            SetComputePass(args.shaders.init, &comEncoder, 256);
+            passCount = args.MainPass(scanArgs, &comEncoder);
+            if (args.shouldValidate) {
+                SetComputePass(GetValidateShader(args), &comEncoder, 256);
+            }
+            if (shouldReadMisc) {
+                comEncoder.CopyBufferToBuffer(
+                    args.buffs.misc, 0ULL, args.buffs.miscSlots,
+                    k * miscSize * sizeof(uint32_t),
+                    miscSize * sizeof(uint32_t));
+            }
+        }
+        if (args.shouldTime) {
+            ResolveTimestampQuery(args.buffs.timestamp,
+                                  args.buffs.readbackTimestamp,
+                                  args.gpu.querySet, &comEncoder,
+                                  scanCount * passCount);
+        }
+        wgpu::CommandBuffer comBuffer = comEncoder.Finish();
+        results.wallTime += SubmitAndTimeSync(args.gpu, comBuffer);
+
+        if (args.shouldTime) {
+            std::vector<uint64_t> timeOut(scanCount * passCount * 2);
+            ReadbackSync(args.gpu, &args.buffs.readbackTimestamp, &timeOut,
+                         timeOut.size() * sizeof(uint64_t));
+            for (uint32_t k = 0; k < scanCount; ++k) {
+                const uint64_t* t = timeOut.data() + k * passCount * 2;
+                uint64_t scanTime = 0ULL;
+                for (uint32_t i = 0; i < passCount; ++i) {
+                    scanTime += t[i * 2 + 1] - t[i * 2];
+                }
+                if (first + k != 0) {
+                    results.times.push_back(scanTime);
+                }
+                if (k != 0) {
+                    results.gaps.push_back(t[0] -
+                                           timeOut[k * passCount * 2 - 1]);
+                }
+            }
+        }
+
+        if (shouldReadMisc) {
+            std::vector<uint32_t> miscOut(scanCount * miscSize);
+            CopyAndReadbackSync(args.gpu, &args.buffs.miscSlots,
+                                &args.buffs.readback, &miscOut, 0,
+                                scanCount * miscSize);
+            for (uint32_t k = 0; k < scanCount; ++k) {
+                const uint32_t* m = miscOut.data() + k * miscSize;
+                if (args.shouldGetStats) {
+                    results.totalSpins += m[1];
+                    results.fallbacksAttempted += m[2];
+                    results.successfulInsertions += m[3];
+                    results.statsSamples++;
+                }
+                if (args.shouldValidate) {
+                    if (m[0] != 0) {
+                        std::cerr << "Test failed: " << m[0] << " errors"
+                                  << std::endl;
+                    }
+                    results.testsPassed += m[0] == 0;
+                    results.testsRun++;
+                }
+            }
+        }
+    }
+    return results;
+}
+
+RunResults RunBatch(const TestArgs& args) {
+    if (args.scansPerSubmit > 1) {
+        return RunBatchSubmitted(args);
+    }
+
+    RunResults results;
     for (uint32_t i = 0; i < args.batchSize; ++i) {
         wgpu::CommandEncoderDescriptor comEncDesc = {};
         comEncDesc.label = "Command Encoder";
@@ -799,31 +1211,24 @@ void Run(std::string testLabel, const TestArgs& args) {
         SetComputePass(args.shaders.init, &comEncoder, 256);
         uint32_t passCount = args.MainPass(args, &comEncoder);
         if (args.shouldTime) {
-            ResolveTimestampQuery(&args.buffs, args.gpu.querySet, &comEncoder,
-                                  passCount);
+            ResolveTimestampQuery(args.buffs.timestamp,
+                                  args.buffs.readbackTimestamp,
+                                  args.gpu.querySet, &comEncoder, passCount);
         }
         wgpu::CommandBuffer comBuffer = comEncoder.Finish();
-        args.gpu.queue.Submit(1, &comBuffer);
-        QueueSync(args.gpu);
+        results.wallTime += SubmitAndTimeSync(args.gpu, comBuffer);
 
-        // The first test is always discarded to prep caches and TLB
         if (args.shouldTime && i != 0) {
-            totalTime += GetTime(args.gpu, &args.buffs, passCount);
-        }
-
-        if (args.shouldGetStats) {
-            std::vector<uint32_t> stats(3, 0);
-            GetFallbackStatistics(args.gpu, &args.buffs, &stats);
-            totalSpins += stats[0];
-            fallbacksAttempted += stats[1];
-            successfulInsertions += stats[2];
-        }
-
-        if (args.shouldValidate) {
-            testsPassed +=
-                args.ValidateSync(args.gpu, &args.buffs, args.shaders);
+            results.times.push_back(
+                GetTime(args.gpu, &args.buffs.readbackTimestamp, passCount));
         }
+        ReadbackResultsSync(args, &results);
     }
+    return results;
+}
+
+void Run(std::string testLabel, const TestArgs& args) {
+    const RunResults results = RunBatch(args);
     std::cout << std::endl;
 
     if (args.shouldReadback) {
@@ -836,11 +1241,14 @@ void Run(std::string testLabel, const TestArgs& args) {
     }
 
     if (args.shouldGetStats) {
-        double avgTotalSpins = static_cast<double>(totalSpins) / args.batchSize;
+        double avgTotalSpins =
+            static_cast<double>(results.totalSpins) / results.statsSamples;
         double avgFallbacksAttempted =
-            static_cast<double>(fallbacksAttempted) / args.batchSize;
+            static_cast<double>(results.fallbacksAttempted) /
+            results.statsSamples;
         double avgSuccessfulInsertions =
-            static_cast<double>(successfulInsertions) / args.batchSize;
+            static_cast<double>(results.successfulInsertions) /
+            results.statsSamples;
         std::cout << "Threadblocks Launched: " << args.threadBlocks
                   << std::endl;
         std::cout << "Average Total Spins: " << avgTotalSpins << std::endl;
@@ -851,8 +1259,9 @@ void Run(std::string testLabel, const TestArgs& args) {
     }
 
     if (args.shouldValidate) {
-        std::cout << testsPassed << "/" << args.batchSize << " " << testLabel;
-        if (testsPassed == args.batchSize) {
+        std::cout << results.testsPassed << "/" << results.testsRun << " "
+                  << testLabel;
+        if (results.testsPassed == results.testsRun) {
             std::cout << " ALL TESTS PASSED" << std::endl;
         } else {
             std::cout << " TEST FAILED" << std::endl;
@@ -860,6 +1269,10 @@ void Run(std::string testLabel, const TestArgs& args) {
     }
 
     if (args.shouldTime) {
+        uint64_t totalTime = 0ULL;
+        for (uint64_t t : results.times) {
+            totalTime += t;
+        }
         double dTime = static_cast<double>(totalTime);
         dTime /= 1e9;
         std::cout << "Total time elapsed " << dTime << std::endl;
@@ -867,6 +1280,624 @@ void Run(std::string testLabel, const TestArgs& args) {
             ((uint64_t)args.size * (uint64_t)(args.batchSize - 1)) / dTime;
         printf("Estimated speed %e ele/s\n", speed);
     }
+
+    // The host side cost of each scan, init pass included, against the
+    // time the GPU spent on it
+    std::cout << "Scans per submit " << args.scansPerSubmit << std::endl;
+    std::cout << "Average wall time per scan "
+              << static_cast<double>(results.wallTime) / args.batchSize
+              << " ns" << std::endl;
+    if (!results.gaps.empty()) {
+        uint64_t totalGap = 0ULL;
+        for (uint64_t g : results.gaps) {
+            totalGap += g;
+        }
+        std::cout << "Average gap between scans"
+                  << (args.shouldValidate ? ", validation included " : " ")
+                  << static_cast<double>(totalGap) / results.gaps.size()
+                  << " ns" << std::endl;
+    }
+}
+
+void GetSortBuffers(const wgpu::Device& device, SortBuffers* buffs,
+                    uint32_t maxSize, uint32_t timestampCount) {
+    auto makeBuffer = [&](const char* label, uint64_t size,
+                          wgpu::BufferUsage usage) -> wgpu::Buffer {
+        wgpu::BufferDescriptor desc = {};
+        desc.label = label;
+        desc.size = size;
+        desc.usage = usage;
+        return device.CreateBuffer(&desc);
+    };
+
+    const uint32_t maxThreadBlocks =
+        (maxSize + SORT_PART_SIZE - 1) / SORT_PART_SIZE;
+    buffs->info =
+        makeBuffer("Sort Info", SORT_INFO_STRIDE * SORT_RADIX_PASSES,
+                   wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    buffs->sort = makeBuffer("Sort", sizeof(uint64_t) * maxSize,
+                             wgpu::BufferUsage::Storage);
+    buffs->alt = makeBuffer("Alt", sizeof(uint64_t) * maxSize,
+                            wgpu::BufferUsage::Storage);
+    buffs->globalHist =
+        makeBuffer("Global Histogram",
+                   sizeof(uint32_t) * SORT_RADIX * SORT_RADIX_PASSES,
+                   wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    buffs->passHist = makeBuffer(
+        "Pass Histogram",
+        sizeof(uint32_t) * SORT_RADIX * SORT_RADIX_PASSES * maxThreadBlocks,
+        wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    buffs->misc = makeBuffer("Sort Miscellaneous", sizeof(uint32_t) * 4,
+                             wgpu::BufferUsage::Storage |
+                                 wgpu::BufferUsage::CopySrc |
+                                 wgpu::BufferUsage::CopyDst);
+    buffs->bump = makeBuffer(
+        "Sort Bump", sizeof(uint32_t) * SORT_RADIX_PASSES,
+        wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    buffs->timestamp =
+        makeBuffer("Sort Timestamp", sizeof(uint64_t) * timestampCount * 2,
+                   wgpu::BufferUsage::QueryResolve |
+                       wgpu::BufferUsage::CopySrc);
+    buffs->readbackTimestamp =
+        makeBuffer("Sort Timestamp Readback",
+                   sizeof(uint64_t) * timestampCount * 2,
+                   wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    buffs->readback =
+        makeBuffer("Sort Readback", sizeof(uint32_t) * 4,
+                   wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+
+    constexpr uint32_t bindingCount = 7;
+    std::vector<wgpu::BindGroupLayoutEntry> bglEntries(bindingCount);
+    for (uint32_t i = 0; i < bindingCount; ++i) {
+        bglEntries[i].binding = i;
+        bglEntries[i].visibility = wgpu::ShaderStage::Compute;
+        bglEntries[i].buffer.type = wgpu::BufferBindingType::Storage;
+    }
+    bglEntries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    bglEntries[0].buffer.hasDynamicOffset = true;
+
+    wgpu::BindGroupLayoutDescriptor bglDesc = {};
+    bglDesc.label = "Sort Bind Group Layout";
+    bglDesc.entries = bglEntries.data();
+    bglDesc.entryCount = static_cast<uint32_t>(bglEntries.size());
+    buffs->bindGroupLayout = device.CreateBindGroupLayout(&bglDesc);
+
+    for (uint32_t i = 0; i < 2; ++i) {
+        const wgpu::Buffer& keysIn = i == 0 ? buffs->sort : buffs->alt;
+        const wgpu::Buffer& keysOut = i == 0 ? buffs->alt : buffs->sort;
+        const wgpu::Buffer bound[bindingCount] = {
+            buffs->info,     keysIn,      keysOut,    buffs->globalHist,
+            buffs->passHist, buffs->misc, buffs->bump};
+        std::vector<wgpu::BindGroupEntry> bgEntries(bindingCount);
+        for (uint32_t k = 0; k < bindingCount; ++k) {
+            bgEntries[k].binding = k;
+            bgEntries[k].buffer = bound[k];
+            bgEntries[k].size = bound[k].GetSize();
+        }
+        bgEntries[0].size = sizeof(uint32_t) * 4;
+
+        wgpu::BindGroupDescriptor bindGroupDesc = {};
+        bindGroupDesc.entries = bgEntries.data();
+        bindGroupDesc.entryCount = static_cast<uint32_t>(bgEntries.size());
+        bindGroupDesc.layout = buffs->bindGroupLayout;
+        buffs->bindGroups[i] = device.CreateBindGroup(&bindGroupDesc);
+    }
+}
+
+void GetSortPipeline(const wgpu::Device& device, const SortBuffers& buffs,
+                     ComputeShader* cs, const char* entryPoint,
+                     const wgpu::ShaderModule& module,
+                     const std::string& csLabel,
+                     const std::vector<wgpu::ConstantEntry>& constants = {}) {
+    wgpu::PipelineLayoutDescriptor pipeLayoutDesc = {};
+    pipeLayoutDesc.bindGroupLayoutCount = 1;
+    pipeLayoutDesc.bindGroupLayouts = &buffs.bindGroupLayout;
+    wgpu::PipelineLayout pipeLayout =
+        device.CreatePipelineLayout(&pipeLayoutDesc);
+
+    wgpu::ProgrammableStageDescriptor stageDesc = {};
+    stageDesc.entryPoint = entryPoint;
+    stageDesc.module = module;
+    stageDesc.constantCount = constants.size();
+    stageDesc.constants = constants.data();
+
+    wgpu::ComputePipelineDescriptor compPipeDesc = {};
+    compPipeDesc.layout = pipeLayout;
+    compPipeDesc.compute = stageDesc;
+    (*cs).computePipeline = device.CreateComputePipeline(&compPipeDesc);
+    (*cs).label = csLabel;
+}
+
+// Every sort is its key file, then sort_common.wgsl, then its own kernels
+wgpu::ShaderModule CreateSortModule(const GPUContext& gpu,
+                                    const std::string& keyPath,
+                                    const std::string& sortPath) {
+    return CreateShaderModule(
+        gpu, {keyPath, "../SharedShaders/Sort/sort_common.wgsl", sortPath});
+}
+
+// The kernels of sort_common.wgsl
+void GetCommonSortPipelines(const wgpu::Device& device,
+                            const SortBuffers& buffs,
+                            const wgpu::ShaderModule& mod,
+                            SortShaders* shaders) {
+    GetSortPipeline(device, buffs, &shaders->init, "init", mod, "Sort Init");
+    GetSortPipeline(device, buffs, &shaders->globalHist, "global_histogram",
+                    mod, "Global Histogram");
+    GetSortPipeline(device, buffs, &shaders->globalHistScan,
+                    "global_hist_scan", mod, "Global Histogram Scan");
+    GetSortPipeline(device, buffs, &shaders->validate, "validate", mod,
+                    "Sort Validate");
+}
+
+void GetDeviceRadixSortShaders(const GPUContext& gpu, const SortBuffers& buffs,
+                               const std::string& keyPath,
+                               SortShaders* shaders) {
+    wgpu::ShaderModule mod =
+        CreateSortModule(gpu, keyPath, "../SharedShaders/Sort/drs.wgsl");
+    GetCommonSortPipelines(gpu.device, buffs, mod, shaders);
+    GetSortPipeline(gpu.device, buffs, &shaders->upsweep, "upsweep", mod,
+                    "Upsweep");
+    GetSortPipeline(gpu.device, buffs, &shaders->scan, "scan", mod, "Scan");
+    GetSortPipeline(gpu.device, buffs, &shaders->downsweep, "downsweep", mod,
+                    "Downsweep");
+}
+
+// A nonzero maxSpinCount overrides MAX_SPIN_COUNT, so the fallback can be
+// forced on adapters that would otherwise never take it
+void GetOneSweepShaders(const GPUContext& gpu, const SortBuffers& buffs,
+                        const std::string& keyPath, uint32_t maxSpinCount,
+                        SortShaders* shaders) {
+    wgpu::ShaderModule mod =
+        CreateSortModule(gpu, keyPath, "../SharedShaders/Sort/onesweep.wgsl");
+    GetCommonSortPipelines(gpu.device, buffs, mod, shaders);
+    std::vector<wgpu::ConstantEntry> constants;
+    if (maxSpinCount) {
+        wgpu::ConstantEntry spin = {};
+        spin.key = "MAX_SPIN_COUNT";
+        spin.value = maxSpinCount;
+        constants.push_back(spin);
+    }
+    GetSortPipeline(gpu.device, buffs, &shaders->digitBinning,
+                    "digit_binning", mod, "Digit Binning", constants);
+}
+
+void SetSortDispatch(const ComputeShader& cs,
+                     const wgpu::ComputePassEncoder& pass,
+                     const wgpu::BindGroup& bindGroup, uint32_t sortPass,
+                     uint32_t threadBlocks) {
+    const uint32_t infoOffset = sortPass * SORT_INFO_STRIDE;
+    pass.SetPipeline(cs.computePipeline);
+    pass.SetBindGroup(0, bindGroup, 1, &infoOffset);
+    pass.DispatchWorkgroups(threadBlocks, 1, 1);
+}
+
+void SetSortComputePass(const ComputeShader& cs, const SortBuffers& buffs,
+                        wgpu::CommandEncoder* comEncoder,
+                        uint32_t threadBlocks) {
+    wgpu::ComputePassDescriptor comDesc = {};
+    comDesc.label = cs.label.c_str();
+    wgpu::ComputePassEncoder pass = (*comEncoder).BeginComputePass(&comDesc);
+    SetSortDispatch(cs, pass, buffs.bindGroups[0], 0, threadBlocks);
+    pass.End();
+}
+
+// The keys start and end in the sort buffer. Dispatches within a pass are
+// ordered, so the whole sort is one compute pass and one timestamp pair.
+uint32_t DeviceRadixSort(const SortArgs& args,
+                         wgpu::CommandEncoder* comEncoder) {
+    const uint32_t passCount = 1;
+    wgpu::ComputePassTimestampWrites timeStamp = {};
+    timeStamp.beginningOfPassWriteIndex = 0;
+    timeStamp.endOfPassWriteIndex = 1;
+    timeStamp.querySet = args.gpu.querySet;
+    wgpu::ComputePassDescriptor comDesc = {};
+    comDesc.label = "Device Radix Sort";
+    if (args.shouldTime) {
+        comDesc.timestampWrites = &timeStamp;
+    }
+
+    const SortShaders& shaders = args.shaders;
+    const SortBuffers& buffs = args.buffs;
+    wgpu::ComputePassEncoder pass = (*comEncoder).BeginComputePass(&comDesc);
+    SetSortDispatch(shaders.globalHist, pass, buffs.bindGroups[0], 0,
+                    args.globalHistThreadBlocks);
+    SetSortDispatch(shaders.globalHistScan, pass, buffs.bindGroups[0], 0,
+                    args.radixPasses);
+    for (uint32_t i = 0; i < args.radixPasses; ++i) {
+        const wgpu::BindGroup& bindGroup = buffs.bindGroups[i & 1];
+        SetSortDispatch(shaders.upsweep, pass, bindGroup, i,
+                        args.threadBlocks);
+        SetSortDispatch(shaders.scan, pass, bindGroup, i, SORT_RADIX);
+        SetSortDispatch(shaders.downsweep, pass, bindGroup, i,
+                        args.threadBlocks);
+    }
+    pass.End();
+    return passCount;
+}
+
+// One kernel per digit pass, each tile looking back on the tiles ahead of it
+// in the pass histogram. The lookback flags and the tile counters must start
+// cleared, which is done outside of the timed pass.
+uint32_t OneSweep(const SortArgs& args, wgpu::CommandEncoder* comEncoder) {
+    const SortShaders& shaders = args.shaders;
+    const SortBuffers& buffs = args.buffs;
+    (*comEncoder)
+        .ClearBuffer(buffs.passHist, 0,
+                     sizeof(uint32_t) * SORT_RADIX * args.radixPasses *
+                         args.threadBlocks);
+    (*comEncoder).ClearBuffer(buffs.bump);
+
+    const uint32_t passCount = 1;
+    wgpu::ComputePassTimestampWrites timeStamp = {};
+    timeStamp.beginningOfPassWriteIndex = 0;
+    timeStamp.endOfPassWriteIndex = 1;
+    timeStamp.querySet = args.gpu.querySet;
+    wgpu::ComputePassDescriptor comDesc = {};
+    comDesc.label = "OneSweep";
+    if (args.shouldTime) {
+        comDesc.timestampWrites = &timeStamp;
+    }
+
+    wgpu::ComputePassEncoder pass = (*comEncoder).BeginComputePass(&comDesc);
+    SetSortDispatch(shaders.globalHist, pass, buffs.bindGroups[0], 0,
+                    args.globalHistThreadBlocks);
+    SetSortDispatch(shaders.globalHistScan, pass, buffs.bindGroups[0], 0,
+                    args.radixPasses);
+    for (uint32_t i = 0; i < args.radixPasses; ++i) {
+        SetSortDispatch(shaders.digitBinning, pass, buffs.bindGroups[i & 1], i,
+                        args.threadBlocks);
+    }
+    pass.End();
+    return passCount;
+}
+
+void InitializeSortUniforms(const GPUContext& gpu, SortBuffers* buffs,
+                            uint32_t size, uint32_t threadBlocks) {
+    const uint32_t stride = SORT_INFO_STRIDE / sizeof(uint32_t);
+    std::vector<uint32_t> info(stride * SORT_RADIX_PASSES, 0);
+    for (uint32_t i = 0; i < SORT_RADIX_PASSES; ++i) {
+        info[i * stride] = size;
+        info[i * stride + 1] = i * 8;
+        info[i * stride + 2] = threadBlocks;
+    }
+    gpu.queue.WriteBuffer(buffs->info, 0ULL, info.data(),
+                          info.size() * sizeof(uint32_t));
+    QueueSync(gpu);
+}
+
+// Errors count neighbours out of order, and the checksums of the input and
+// output only match if the output is a permutation of the input
+bool ValidateSort(const GPUContext& gpu, SortBuffers* buffs) {
+    std::vector<uint32_t> readOut(3, 0);
+    CopyAndReadbackSync(gpu, &buffs->misc, &buffs->readback, &readOut, 0, 3);
+    bool testPassed = readOut[0] == 0 && readOut[1] == readOut[2];
+    if (!testPassed) {
+        std::cerr << "Test failed: " << readOut[0] << " errors, checksum "
+                  << std::hex << readOut[1] << " expected " << readOut[2]
+                  << std::dec << std::endl;
+    }
+    return testPassed;
+}
+
+bool RunSort(std::string testLabel, const SortArgs& args) {
+    InitializeSortUniforms(args.gpu, &args.buffs, args.size,
+                           args.threadBlocks);
+
+    uint32_t testsPassed = 0;
+    uint64_t totalTime = 0ULL;
+    for (uint32_t i = 0; i < args.batchSize; ++i) {
+        wgpu::CommandEncoderDescriptor comEncDesc = {};
+        comEncDesc.label = "Sort Command Encoder";
+        wgpu::CommandEncoder comEncoder =
+            args.gpu.device.CreateCommandEncoder(&comEncDesc);
+        comEncoder.ClearBuffer(args.buffs.misc);
+        comEncoder.ClearBuffer(args.buffs.globalHist);
+        SetSortComputePass(args.shaders.init, args.buffs, &comEncoder, 256);
+        uint32_t passCount = args.MainPass(args, &comEncoder);
+        if (args.shouldValidate) {
+            SetSortComputePass(args.shaders.validate, args.buffs, &comEncoder,
+                               256);
+        }
+        if (args.shouldTime) {
+            ResolveTimestampQuery(args.buffs.timestamp,
+                                  args.buffs.readbackTimestamp,
+                                  args.gpu.querySet, &comEncoder, passCount);
+        }
+        wgpu::CommandBuffer comBuffer = comEncoder.Finish();
+        args.gpu.queue.Submit(1, &comBuffer);
+        QueueSync(args.gpu);
+
+        // The first test is always discarded to prep caches and TLB
+        if (args.shouldTime && i != 0) {
+            totalTime +=
+                GetTime(args.gpu, &args.buffs.readbackTimestamp, passCount);
+        }
+
+        if (args.shouldValidate) {
+            testsPassed += ValidateSort(args.gpu, &args.buffs);
+        }
+    }
+
+    bool passed = true;
+    if (args.shouldValidate) {
+        passed = testsPassed == args.batchSize;
+        std::cout << testsPassed << "/" << args.batchSize << " " << testLabel
+                  << " size " << args.size;
+        std::cout << (passed ? " ALL TESTS PASSED" : " TEST FAILED")
+                  << std::endl;
+    }
+
+    if (args.shouldTime && args.batchSize > 1) {
+        double dTime = static_cast<double>(totalTime);
+        dTime /= 1e9;
+        std::cout << "Total time elapsed " << dTime << std::endl;
+        double speed =
+            ((uint64_t)args.size * (uint64_t)(args.batchSize - 1)) / dTime;
+        printf("Estimated speed %e keys/s\n", speed);
+    }
+    return passed;
+}
+
+// Times and validates every power of two up to the requested size, then
+// validates sizes that leave partial tiles, all in one set of buffers
+int TestSort(GPUContext& gpu, ScanType sortType, uint32_t maxPower,
+             uint32_t batchSize, uint32_t maxSpinCount,
+             uint32_t timestampCount, PipelineCache* cache,
+             std::chrono::steady_clock::time_point startTime) {
+    const uint32_t maxSize = 1u << maxPower;
+    SortBuffers buffs;
+    GetSortBuffers(gpu.device, &buffs, maxSize, timestampCount);
+    SortShaders shaders;
+    std::string testLabel;
+    SortArgs args = {gpu, buffs, shaders};
+    const std::string key32 = "../SharedShaders/Sort/key32.wgsl";
+    const std::string key64 = "../SharedShaders/Sort/key64.wgsl";
+    switch (sortType) {
+        case ScanType::Drs:
+            GetDeviceRadixSortShaders(gpu, buffs, key64, &shaders);
+            args.MainPass = DeviceRadixSort;
+            testLabel = "DRS";
+            break;
+        case ScanType::Drs32:
+            GetDeviceRadixSortShaders(gpu, buffs, key32, &shaders);
+            args.MainPass = DeviceRadixSort;
+            args.radixPasses = SORT_RADIX_PASSES / 2;
+            testLabel = "DRS32";
+            break;
+        case ScanType::OneSweep:
+            GetOneSweepShaders(gpu, buffs, key64, maxSpinCount, &shaders);
+            args.MainPass = OneSweep;
+            testLabel = "OneSweep";
+            break;
+        case ScanType::OneSweep32:
+            GetOneSweepShaders(gpu, buffs, key32, maxSpinCount, &shaders);
+            args.MainPass = OneSweep;
+            args.radixPasses = SORT_RADIX_PASSES / 2;
+            testLabel = "OneSweep32";
+            break;
+        default:
+            std::cerr << "Error: Unsupported sort type" << std::endl;
+            return EXIT_FAILURE;
+    }
+    if (maxSpinCount) {
+        testLabel += "_Spin" + std::to_string(maxSpinCount);
+    }
+    ReportStartup(cache, startTime);
+
+    auto runSize = [&](uint32_t size, uint32_t batch, bool shouldTime) {
+        args.size = size;
+        args.batchSize = batch;
+        args.threadBlocks = (size + SORT_PART_SIZE - 1) / SORT_PART_SIZE;
+        args.globalHistThreadBlocks =
+            (size + SORT_G_HIST_PART_SIZE - 1) / SORT_G_HIST_PART_SIZE;
+        args.shouldTime = shouldTime;
+        return RunSort(testLabel, args);
+    };
+
+    bool passed = true;
+    for (uint32_t p = std::min(SORT_MIN_POWER, maxPower); p <= maxPower; ++p) {
+        passed &= runSize(1u << p, batchSize, true);
+    }
+
+    const uint32_t raggedSizes[] = {1, SORT_PART_SIZE - 1, SORT_PART_SIZE + 1,
+                                    SORT_G_HIST_PART_SIZE + SORT_PART_SIZE / 2,
+                                    maxSize - 1};
+    for (uint32_t size : raggedSizes) {
+        if (size != 0 && size <= maxSize) {
+            passed &= runSize(size, 2, false);
+        }
+    }
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// One scan of the sweep. The stats variant, where there is one, runs as a
+// separate untimed batch so that its counters do not skew the timing.
+struct SweepAlgorithm {
+    const char* label;
+    uint32_t (*MainPass)(const TestArgs&, wgpu::CommandEncoder*);
+    bool (*ValidateSync)(const GPUContext&, GPUBuffers*, const Shaders&);
+    uint32_t (*StatsPass)(const TestArgs&, wgpu::CommandEncoder*);
+};
+
+struct SweepResult {
+    std::string label;
+    uint32_t size = 0;
+    uint32_t testsPassed = 0;
+    uint32_t testsRun = 0;
+    uint32_t batchSize = 0;
+    uint32_t scansPerSubmit = 0;
+    double wallNsPerScan = 0.0;
+    double medianNs = 0.0;
+    double p10Ns = 0.0;
+    double p90Ns = 0.0;
+    double elementsPerSec = 0.0;
+    double gbPerSec = 0.0;
+    bool hasStats = false;
+    double avgSpins = 0.0;
+    double avgFallbacksAttempted = 0.0;
+    double avgSuccessfulInsertions = 0.0;
+};
+
+// Nearest rank, of sorted times
+double GetPercentile(const std::vector<uint64_t>& sorted, double p) {
+    return static_cast<double>(
+        sorted[static_cast<size_t>(p * (sorted.size() - 1) + 0.5)]);
+}
+
+// The largest power the sweep can reach, limited by the binding size of the
+// scan buffers and by the dispatch size
+uint32_t GetSweepMaxPower(const wgpu::Limits& limits, uint32_t partSize,
+                          uint32_t maxPower) {
+    uint32_t power = maxPower;
+    auto fits = [&](uint32_t p) {
+        const uint64_t bytes = static_cast<uint64_t>(sizeof(uint32_t)) << p;
+        const uint64_t threadBlocks = ((1ULL << p) + partSize - 1) / partSize;
+        return bytes <= limits.maxStorageBufferBindingSize &&
+               bytes <= limits.maxBufferSize &&
+               threadBlocks <= limits.maxComputeWorkgroupsPerDimension;
+    };
+    while (power > SWEEP_MIN_POWER && !fits(power)) {
+        --power;
+    }
+    return power;
+}
+
+void WriteSweepCSV(const std::string& path,
+                   const std::vector<SweepResult>& results) {
+    std::ofstream file(path);
+    file << "algorithm,size,tests_passed,tests_run,batch_size,"
+            "scans_per_submit,wall_ns_per_scan,median_ns,p10_ns,p90_ns,"
+            "elements_per_s,gb_per_s,avg_spins,avg_fallbacks_attempted,"
+            "avg_successful_insertions\n";
+    for (const SweepResult& r : results) {
+        file << r.label << "," << r.size << "," << r.testsPassed << ","
+             << r.testsRun << "," << r.batchSize << "," << r.scansPerSubmit
+             << "," << r.wallNsPerScan << "," << r.medianNs << "," << r.p10Ns
+             << "," << r.p90Ns << "," << r.elementsPerSec << ","
+             << r.gbPerSec;
+        if (r.hasStats) {
+            file << "," << r.avgSpins << "," << r.avgFallbacksAttempted << ","
+                 << r.avgSuccessfulInsertions;
+        } else {
+            file << ",,,";
+        }
+        file << "\n";
+    }
+}
+
+void WriteSweepJSON(const std::string& path,
+                    const std::vector<SweepResult>& results) {
+    std::ofstream file(path);
+    file << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const SweepResult& r = results[i];
+        file << "  {\"algorithm\": \"" << r.label << "\", \"size\": " << r.size
+             << ", \"tests_passed\": " << r.testsPassed
+             << ", \"tests_run\": " << r.testsRun
+             << ", \"batch_size\": " << r.batchSize
+             << ", \"scans_per_submit\": " << r.scansPerSubmit
+             << ", \"wall_ns_per_scan\": " << r.wallNsPerScan
+             << ", \"median_ns\": " << r.medianNs
+             << ", \"p10_ns\": " << r.p10Ns << ", \"p90_ns\": " << r.p90Ns
+             << ", \"elements_per_s\": " << r.elementsPerSec
+             << ", \"gb_per_s\": " << r.gbPerSec << ", \"fallback\": ";
+        if (r.hasStats) {
+            file << "{\"avg_spins\": " << r.avgSpins
+                 << ", \"avg_fallbacks_attempted\": " << r.avgFallbacksAttempted
+                 << ", \"avg_successful_insertions\": "
+                 << r.avgSuccessfulInsertions << "}";
+        } else {
+            file << "null";
+        }
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "]\n";
+}
+
+// Every scan at every power of two from 2^SWEEP_MIN_POWER up, reusing the
+// device and the buffers allocated for the largest size. Bandwidth counts
+// one read and one write of each element, the least any scan can move.
+int Sweep(const TestArgs& baseArgs, uint32_t partSize, uint32_t maxPower,
+          const std::string& outPath) {
+    const SweepAlgorithm algorithms[] = {
+        {"RTS", RTS, ValidateGeneric, nullptr},
+        {"CSDL", CSDL, ValidateGeneric, nullptr},
+        {"CSDLDF", CSDLDF, ValidateGeneric, CSDLDFStats},
+        {"CSDLDF_Struct", CSDLDFStruct, ValidateStruct, CSDLDFStructStats},
+    };
+
+    std::vector<SweepResult> results;
+    bool passed = true;
+    for (uint32_t p = SWEEP_MIN_POWER; p <= maxPower; ++p) {
+        TestArgs args = baseArgs;
+        args.size = 1u << p;
+        args.threadBlocks = (args.size + partSize - 1) / partSize;
+        InitializeUniforms(args.gpu, &args.buffs, args.size, args.threadBlocks);
+
+        for (const SweepAlgorithm& alg : algorithms) {
+            args.MainPass = alg.MainPass;
+            args.ValidateSync = alg.ValidateSync;
+            args.shouldTime = true;
+            args.shouldValidate = true;
+            args.shouldGetStats = false;
+            RunResults run = RunBatch(args);
+            std::sort(run.times.begin(), run.times.end());
+
+            SweepResult r;
+            r.label = alg.label;
+            r.size = args.size;
+            r.testsPassed = run.testsPassed;
+            r.testsRun = run.testsRun;
+            r.batchSize = args.batchSize;
+            r.scansPerSubmit = args.scansPerSubmit;
+            r.wallNsPerScan =
+                static_cast<double>(run.wallTime) / args.batchSize;
+            r.medianNs = GetPercentile(run.times, 0.5);
+            r.p10Ns = GetPercentile(run.times, 0.1);
+            r.p90Ns = GetPercentile(run.times, 0.9);
+            // A timestamp period too coarse for the size can round the median
+            // to zero, which would write inf, and inf is not valid JSON
+            if (r.medianNs > 0.0) {
+                r.elementsPerSec = args.size / (r.medianNs / 1e9);
+                r.gbPerSec =
+                    2.0 * sizeof(uint32_t) * args.size / r.medianNs;  // B/ns
+            }
+            passed &= r.testsPassed == r.testsRun;
+
+            if (alg.StatsPass != nullptr) {
+                args.MainPass = alg.StatsPass;
+                args.shouldTime = false;
+                args.shouldValidate = false;
+                args.shouldGetStats = true;
+                const RunResults stats = RunBatch(args);
+                r.hasStats = stats.statsSamples != 0;
+                if (r.hasStats) {
+                    r.avgSpins = static_cast<double>(stats.totalSpins) /
+                                 stats.statsSamples;
+                    r.avgFallbacksAttempted =
+                        static_cast<double>(stats.fallbacksAttempted) /
+                        stats.statsSamples;
+                    r.avgSuccessfulInsertions =
+                        static_cast<double>(stats.successfulInsertions) /
+                        stats.statsSamples;
+                }
+            }
+
+            std::cout << r.label << " size " << r.size << " " << r.testsPassed
+                      << "/" << r.testsRun << " median " << r.medianNs
+                      << " ns, " << r.elementsPerSec << " ele/s, "
+                      << r.gbPerSec << " GB/s" << std::endl;
+            results.push_back(r);
+        }
+    }
+
+    WriteSweepCSV(outPath + ".csv", results);
+    WriteSweepJSON(outPath + ".json", results);
+    std::cout << "Results written to " << outPath << ".csv and " << outPath
+              << ".json" << std::endl;
+    std::cout << (passed ? "ALL TESTS PASSED" : "TEST FAILED") << std::endl;
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
 ScanType ParseScanType(const std::string& str) {
@@ -886,23 +1917,48 @@ ScanType ParseScanType(const std::string& str) {
         return ScanType::CsdldfStructStats;
     else if (str == "csdldf_struct_occ")
         return ScanType::CsdldfStructOcc;
+    else if (str == "drs")
+        return ScanType::Drs;
+    else if (str == "drs32")
+        return ScanType::Drs32;
+    else if (str == "onesweep")
+        return ScanType::OneSweep;
+    else if (str == "onesweep32")
+        return ScanType::OneSweep32;
+    else if (str == "sweep")
+        return ScanType::Sweep;
     else
         return ScanType::Unknown;
 }
 
 int main(int argc, char* argv[]) {
+    const std::chrono::steady_clock::time_point startTime =
+        std::chrono::steady_clock::now();
     constexpr uint32_t MISC_SIZE =
         4;  // Max scratch memory we use to track various stats
     constexpr uint32_t PART_SIZE =
         4096;  // MUST match the partition size specified in shaders.
     constexpr uint32_t MAX_TIMESTAMPS =
         3;  // Max number of passes to track with our query set
+    constexpr uint32_t MAX_SCANS_PER_SUBMIT =
+        128;  // Max scans in one command buffer, each with its own timestamps
     constexpr uint32_t MAX_READBACK_SIZE =
         8192;  // Max size of our readback buffer
 
-    if (argc != 4) {
+    if (argc != 4 && argc != 5) {
         std::cerr << "Usage: <Scan Type: String> <Input Size as Power of Two: "
-                     "uint32_t> <Test Batch Size: uint32_t>"
+                     "uint32_t> <Test Batch Size: uint32_t> <Scans per "
+                     "Submit: uint32_t, optional>"
+                  << std::endl;
+        std::cerr << "Sort Types: drs, drs32, onesweep, onesweep32, sizes "
+                     "from 2^"
+                  << SORT_MIN_POWER << " up to the given power" << std::endl;
+        std::cerr << "The optional last argument of onesweep and onesweep32 "
+                     "is the max spin count before the fallback, at least 1"
+                  << std::endl;
+        std::cerr << "sweep: every scan at every size from 2^"
+                  << SWEEP_MIN_POWER << " up to the given power, at most 2^"
+                  << SWEEP_MAX_POWER << ", written to sweep.csv and sweep.json"
                   << std::endl;
         return EXIT_FAILURE;
     }
@@ -914,11 +1970,24 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    const bool isSweep = scan_type == ScanType::Sweep;
     uint32_t powerOfTwo;
     uint32_t batchSize;
+    uint32_t scansPerSubmit = 1;
+    uint32_t maxSpinCount = 0;
+    const bool isOneSweep = scan_type == ScanType::OneSweep ||
+                            scan_type == ScanType::OneSweep32;
     try {
         powerOfTwo = std::stoul(argv[2]);
-        if (powerOfTwo > 25 || argv[2][0] == '-') {
+        if (isSweep) {
+            if (powerOfTwo < SWEEP_MIN_POWER || powerOfTwo > SWEEP_MAX_POWER ||
+                argv[2][0] == '-') {
+                throw std::runtime_error(
+                    "Error: sweep size power must be a value between " +
+                    std::to_string(SWEEP_MIN_POWER) + " and " +
+                    std::to_string(SWEEP_MAX_POWER));
+            }
+        } else if (powerOfTwo > 25 || argv[2][0] == '-') {
             throw std::runtime_error(
                 "Error: input size power must be a value between 0 and 25");
         }
@@ -927,6 +1996,26 @@ int main(int argc, char* argv[]) {
             throw std::runtime_error(
                 "Error: test batch size must not be negative");
         }
+        if (isSweep && batchSize < 2) {
+            throw std::runtime_error(
+                "Error: sweep batch size must be at least 2, the first run "
+                "is discarded");
+        }
+        if (argc == 5 && isOneSweep) {
+            maxSpinCount = std::stoul(argv[4]);
+            if (maxSpinCount == 0 || argv[4][0] == '-') {
+                throw std::runtime_error(
+                    "Error: max spin count must be at least 1");
+            }
+        } else if (argc == 5) {
+            scansPerSubmit = std::stoul(argv[4]);
+            if (scansPerSubmit == 0 || scansPerSubmit > MAX_SCANS_PER_SUBMIT ||
+                argv[4][0] == '-') {
+                throw std::runtime_error(
+                    "Error: scans per submit must be a value between 1 and " +
+                    std::to_string(MAX_SCANS_PER_SUBMIT));
+            }
+        }
     } catch (const std::invalid_argument& e) {
         std::cerr << "Error: Arguments must be unsigned integers." << std::endl;
         return EXIT_FAILURE;
@@ -939,6 +2028,15 @@ int main(int argc, char* argv[]) {
         return EXIT_FAILURE;
     }
 
+    const bool isSort =
+        scan_type == ScanType::Drs || scan_type == ScanType::Drs32 ||
+        scan_type == ScanType::OneSweep || scan_type == ScanType::OneSweep32;
+    if (isSort && powerOfTwo > SORT_MAX_POWER) {
+        std::cerr << "Error: sort input size power must be at most "
+                  << SORT_MAX_POWER << std::endl;
+        return EXIT_FAILURE;
+    }
+
     uint32_t size =
         1 << powerOfTwo;     // Input size to test, must be a multiple of 4
     uint32_t threadBlocks =  // Thread Blocks to launch based on input
@@ -949,21 +2047,56 @@ int main(int argc, char* argv[]) {
     bool shouldReadback = false;  // Use readback to sanity check results
     bool shouldTime = true;       // Time results?
 
+    // Relative to the working directory, like the shaders. Delete it to time
+    // a cold start.
+    PipelineCache pipelineCache;
+    pipelineCache.directory = "pipeline_cache";
+
     GPUContext gpu;
-    if (GetGPUContext(&gpu, MAX_TIMESTAMPS) == EXIT_FAILURE) {
+    if (GetGPUContext(&gpu, MAX_TIMESTAMPS * MAX_SCANS_PER_SUBMIT,
+                      &pipelineCache) == EXIT_FAILURE) {
         return EXIT_FAILURE;
     }
+    if (isSort) {
+        return TestSort(gpu, scan_type, powerOfTwo, batchSize, maxSpinCount,
+                        MAX_TIMESTAMPS, &pipelineCache, startTime);
+    }
+
+    // The buffers are allocated once, for the largest size of the sweep
+    std::vector<ScanType> scanTypes = {scan_type};
+    if (isSweep) {
+        const uint32_t maxPower =
+            GetSweepMaxPower(gpu.limits, PART_SIZE, powerOfTwo);
+        if (maxPower != powerOfTwo) {
+            std::cout << "Sweep capped at 2^" << maxPower
+                      << ", the largest size the device allows" << std::endl;
+        }
+        powerOfTwo = maxPower;
+        size = 1 << powerOfTwo;
+        threadBlocks = (size + PART_SIZE - 1) / PART_SIZE;
+        scanTypes = {ScanType::Rts,          ScanType::Csdl,
+                     ScanType::Csdldf,       ScanType::CsdldfStats,
+                     ScanType::CsdldfStruct, ScanType::CsdldfStructStats};
+    }
+
     GPUBuffers buffs;
-    GetGPUBuffers(gpu.device, &buffs, threadBlocks, MAX_TIMESTAMPS, size,
-                  MISC_SIZE, MAX_READBACK_SIZE);
+    GetGPUBuffers(gpu.device, &buffs, threadBlocks,
+                  MAX_TIMESTAMPS * MAX_SCANS_PER_SUBMIT, size, MISC_SIZE,
+                  MAX_READBACK_SIZE, MAX_SCANS_PER_SUBMIT);
     Shaders shaders;
-    GetAllShaders(gpu, buffs, &shaders);
+    GetShaders(gpu, buffs, scanTypes, &shaders);
+    ReportStartup(&pipelineCache, startTime);
     InitializeUniforms(gpu, &buffs, size, threadBlocks);
 
     TestArgs args = {
         gpu,          buffs,        shaders,        size,           batchSize,
         threadBlocks, readbackSize, shouldValidate, shouldReadback, shouldTime,
     };
+    args.scansPerSubmit = scansPerSubmit;
+
+    if (isSweep) {
+        return Sweep(args, PART_SIZE, powerOfTwo, "sweep");
+    }
 
     try {
         switch (scan_type) {
@@ -0,0 +1,84 @@
+//****************************************************************************
+// GPUPrefixSums
+// Device Radix Sort: 8-bit LSD radix sort using reduce then scan, ported
+// from the HLSL DeviceRadixSort of GPUInt64Sorting
+//
+// Concatenated by the host after key32.wgsl or key64.wgsl and
+// sort_common.wgsl, which hold the key type, the bindings shared with
+// OneSweep, the tile ranking and the init, histogram and validate kernels.
+//
+// SPDX-License-Identifier: MIT
+// Copyright Thomas Smith 10/23/2024
+// https://github.com/b0nes164/GPUPrefixSums
+//
+//****************************************************************************
+
+@group(0) @binding(4)
+var<storage, read_write> pass_hist: array<u32>;
+
+//Digit counts of each tile, stored digit major for the scan
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn upsweep(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(workgroup_id) blockid: vec3<u32>) {
+
+    atomicStore(&wg_digit[threadid.x], 0u);
+    workgroupBarrier();
+
+    let end = min((blockid.x + 1u) * PART_SIZE, info.size);
+    for(var i = threadid.x + blockid.x * PART_SIZE; i < end; i += BLOCK_DIM){
+        atomicAdd(&wg_digit[extract_digit(keys_in[i], info.shift)], 1u);
+    }
+    workgroupBarrier();
+
+    pass_hist[threadid.x * info.thread_blocks + blockid.x] = atomicLoad(&wg_digit[threadid.x]);
+}
+
+//One workgroup per digit, exclusive scan its tile counts in place
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn scan(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(workgroup_id) blockid: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32,
+    @builtin(subgroup_size) lane_count: u32) {
+
+    let offset = blockid.x * info.thread_blocks;
+    var reduction = 0u;
+    for(var j = 0u; j < info.thread_blocks; j += BLOCK_DIM){
+        let i = threadid.x + j;
+        var t = 0u;
+        if(i < info.thread_blocks){
+            t = pass_hist[i + offset];
+        }
+
+        let s = block_exclusive_scan(vec4<u32>(t, 0u, 0u, 0u), threadid.x, laneid, lane_count);
+        if(i < info.thread_blocks){
+            pass_hist[i + offset] = s.prefix.x + reduction;
+        }
+        reduction += s.total.x;
+    }
+}
+
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn downsweep(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(workgroup_id) blockid: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32,
+    @builtin(subgroup_size) lane_count: u32) {
+
+    let tid = threadid.x;
+    let part_start = blockid.x * PART_SIZE;
+    let part_count = min(PART_SIZE, info.size - part_start);
+    load_records(part_start, part_count, tid);
+
+    {
+        let t = atomicLoad(&wg_digit[tid]);
+        let s = block_exclusive_scan(vec4<u32>(t, 0u, 0u, 0u), tid, laneid, lane_count);
+        let pass_offset = (info.shift >> 3u) * RADIX;
+        atomicStore(&wg_digit[tid], atomicLoad(&global_hist[tid + pass_offset]) +
+            pass_hist[tid * info.thread_blocks + blockid.x] - s.prefix.x);
+    }
+
+    rank_records(tid, laneid, lane_count);
+    scatter_keys(part_start, part_count, tid);
+}
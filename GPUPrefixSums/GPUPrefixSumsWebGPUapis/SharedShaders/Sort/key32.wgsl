@@ -0,0 +1,29 @@
+//****************************************************************************
+// GPUPrefixSums
+// 32-bit keys for the radix sorts, concatenated ahead of sort_common.wgsl
+//
+// SPDX-License-Identifier: MIT
+// Copyright Thomas Smith 10/23/2024
+// https://github.com/b0nes164/GPUPrefixSums
+//
+//****************************************************************************
+
+alias Key = u32;
+
+const RADIX_PASSES = 4u;
+
+fn extract_digit(key: Key, shift: u32) -> u32 {
+    return (key >> shift) & RADIX_MASK;
+}
+
+fn key_greater(a: Key, b: Key) -> bool {
+    return a > b;
+}
+
+fn make_key(i: u32) -> Key {
+    return hash(i);
+}
+
+fn key_checksum(key: Key) -> u32 {
+    return hash(key);
+}
@@ -0,0 +1,35 @@
+//****************************************************************************
+// GPUPrefixSums
+// 64-bit keys for the radix sorts, concatenated ahead of sort_common.wgsl
+//
+// Keys are vec2<u32>, x holding the low and y the high 32 bits, and are
+// ordered as unsigned 64-bit integers.
+//
+// SPDX-License-Identifier: MIT
+// Copyright Thomas Smith 10/23/2024
+// https://github.com/b0nes164/GPUPrefixSums
+//
+//****************************************************************************
+
+alias Key = vec2<u32>;
+
+const RADIX_PASSES = 8u;
+
+fn extract_digit(key: Key, shift: u32) -> u32 {
+    if(shift < 32u){
+        return (key.x >> shift) & RADIX_MASK;
+    }
+    return (key.y >> (shift - 32u)) & RADIX_MASK;
+}
+
+fn key_greater(a: Key, b: Key) -> bool {
+    return a.y > b.y || (a.y == b.y && a.x > b.x);
+}
+
+fn make_key(i: u32) -> Key {
+    return vec2<u32>(hash(i << 1u), hash((i << 1u) | 1u));
+}
+
+fn key_checksum(key: Key) -> u32 {
+    return hash(key.x ^ hash(key.y));
+}
@@ -0,0 +1,156 @@
+//****************************************************************************
+// GPUPrefixSums
+// OneSweep: 8-bit LSD radix sort that ranks, looks back and scatters each
+// tile in a single kernel per digit pass, with the decoupled fallback of
+// csdldf.wgsl so that it does not depend on forward thread progress
+//
+// Concatenated by the host after key32.wgsl or key64.wgsl and
+// sort_common.wgsl. Each of the BLOCK_DIM threads of a tile looks back on
+// one digit. A thread that spins MAX_SPIN_COUNT times without progress votes
+// for the tile it waits on, and the workgroup recounts the highest voted
+// tile itself, publishing the counts with atomicMax so that it never
+// overwrites a tile which has already published.
+//
+// SPDX-License-Identifier: MIT
+// Copyright Thomas Smith 10/23/2024
+// https://github.com/b0nes164/GPUPrefixSums
+//
+//****************************************************************************
+
+//Flag in the low 2 bits, count above. One RADIX wide row per tile, per
+//digit pass, cleared by the host before the sort.
+@group(0) @binding(4)
+var<storage, read_write> pass_hist: array<atomic<u32>>;
+
+//Tile counter of each digit pass, cleared by the host before the sort
+@group(0) @binding(6)
+var<storage, read_write> bump: array<atomic<u32>>;
+
+const FLAG_NOT_READY = 0u;
+const FLAG_REDUCTION = 1u;
+const FLAG_INCLUSIVE = 2u;
+const FLAG_MASK = 3u;
+
+//The host can lower it, 1 sends nearly every stalled digit down the fallback
+override MAX_SPIN_COUNT: u32 = 4u;
+
+var<workgroup> wg_broadcast: u32;
+var<workgroup> wg_fallback_vote: atomic<u32>;
+var<workgroup> wg_fallback: array<atomic<u32>, RADIX>;
+
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn digit_binning(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32,
+    @builtin(subgroup_size) lane_count: u32) {
+
+    let tid = threadid.x;
+    let pass_index = info.shift >> 3u;
+
+    //Tiles are taken in launch order, so a tile only ever waits on tiles
+    //which have already started
+    if(tid == 0u){
+        wg_broadcast = atomicAdd(&bump[pass_index], 1u);
+        atomicStore(&wg_fallback_vote, 0u);
+    }
+    let part_id = workgroupUniformLoad(&wg_broadcast);
+
+    let part_start = part_id * PART_SIZE;
+    let part_count = min(PART_SIZE, info.size - part_start);
+    load_records(part_start, part_count, tid);
+
+    //Device broadcast
+    let pass_offset = pass_index * info.thread_blocks * RADIX;
+    let count = atomicLoad(&wg_digit[tid]);
+    atomicStore(&pass_hist[pass_offset + part_id * RADIX + tid], (count << 2u) |
+        select(FLAG_INCLUSIVE, FLAG_REDUCTION, part_id != 0u));
+
+    //Ranking the tile first gives the tiles ahead time to publish
+    let s = block_exclusive_scan(vec4<u32>(count, 0u, 0u, 0u), tid, laneid, lane_count);
+    rank_records(tid, laneid, lane_count);
+
+    //Lookback, one thread per digit
+    var prev = 0u;
+    var done = part_id == 0u;
+    var lookback_id = part_id - 1u;
+    loop {
+        if(!done){
+            var spin_count = 0u;
+            for(; spin_count < MAX_SPIN_COUNT; ){
+                let flag_payload = atomicLoad(&pass_hist[pass_offset + lookback_id * RADIX + tid]);
+                if((flag_payload & FLAG_MASK) > FLAG_NOT_READY){
+                    prev += flag_payload >> 2u;
+                    spin_count = 0u;
+                    if((flag_payload & FLAG_MASK) == FLAG_INCLUSIVE){
+                        atomicStore(&pass_hist[pass_offset + part_id * RADIX + tid],
+                            ((prev + count) << 2u) | FLAG_INCLUSIVE);
+                        done = true;
+                        break;
+                    } else {
+                        lookback_id -= 1u;
+                    }
+                } else {
+                    spin_count += 1u;
+                }
+            }
+
+            //Offset by one, so that zero means no digit is stuck
+            if(!done){
+                atomicMax(&wg_fallback_vote, lookback_id + 1u);
+            }
+        }
+        workgroupBarrier();
+
+        if(tid == 0u){
+            wg_broadcast = atomicLoad(&wg_fallback_vote);
+            atomicStore(&wg_fallback_vote, 0u);
+        }
+        let vote = workgroupUniformLoad(&wg_broadcast);
+        if(vote == 0u){
+            break;
+        }
+
+        //Fallback, recount the tile every stuck digit at it is waiting on.
+        //No tile past it is waited on, so at least one digit moves on.
+        let fallback_id = vote - 1u;
+        atomicStore(&wg_fallback[tid], 0u);
+        workgroupBarrier();
+
+        {
+            let f_start = fallback_id * PART_SIZE;
+            let f_end = min(f_start + PART_SIZE, info.size);
+            for(var i = tid + f_start; i < f_end; i += BLOCK_DIM){
+                atomicAdd(&wg_fallback[extract_digit(keys_in[i], info.shift)], 1u);
+            }
+        }
+        workgroupBarrier();
+
+        {
+            //Max will store when no insertion has been made, but will not overwrite a tile
+            //which has already inserted, or been updated to FLAG_INCLUSIVE
+            let f_red = atomicLoad(&wg_fallback[tid]);
+            let f_flag = select(FLAG_INCLUSIVE, FLAG_REDUCTION, fallback_id != 0u);
+            let f_payload = atomicMax(&pass_hist[pass_offset + fallback_id * RADIX + tid],
+                (f_red << 2u) | f_flag);
+            if(!done && lookback_id == fallback_id){
+                if(f_payload == 0u){
+                    prev += f_red;
+                } else {
+                    prev += f_payload >> 2u;
+                }
+
+                if(fallback_id == 0u || (f_payload & FLAG_MASK) == FLAG_INCLUSIVE){
+                    atomicStore(&pass_hist[pass_offset + part_id * RADIX + tid],
+                        ((prev + count) << 2u) | FLAG_INCLUSIVE);
+                    done = true;
+                } else {
+                    lookback_id -= 1u;
+                }
+            }
+        }
+    }
+
+    atomicStore(&wg_digit[tid], atomicLoad(&global_hist[tid + pass_index * RADIX]) + prev - s.prefix.x);
+    workgroupBarrier();
+    scatter_keys(part_start, part_count, tid);
+}
@@ -0,0 +1,277 @@
+//****************************************************************************
+// GPUPrefixSums
+// Shared by the 8-bit LSD radix sorts, concatenated after key32.wgsl or
+// key64.wgsl and ahead of drs.wgsl or onesweep.wgsl
+//
+// WebGPU only guarantees 16KB of workgroup memory, too little for per
+// subgroup digit histograms at small subgroup sizes, so a tile is ranked
+// with two stable 4-bit splits of packed digit and index records instead.
+// Nothing here depends on the subgroup size.
+//
+// SPDX-License-Identifier: MIT
+// Copyright Thomas Smith 10/23/2024
+// https://github.com/b0nes164/GPUPrefixSums
+//
+//****************************************************************************
+
+struct InfoStruct
+{
+    size: u32,
+    shift: u32,
+    thread_blocks: u32,
+    pad: u32,
+};
+
+//One per digit pass, bound with a dynamic offset
+@group(0) @binding(0)
+var<uniform> info : InfoStruct;
+
+@group(0) @binding(1)
+var<storage, read_write> keys_in: array<Key>;
+
+@group(0) @binding(2)
+var<storage, read_write> keys_out: array<Key>;
+
+@group(0) @binding(3)
+var<storage, read_write> global_hist: array<atomic<u32>>;
+
+@group(0) @binding(5)
+var<storage, read_write> misc: array<atomic<u32>>;
+
+const BLOCK_DIM = 256u;
+const MIN_SUBGROUP_SIZE = 4u;
+const MAX_SUBGROUPS = BLOCK_DIM / MIN_SUBGROUP_SIZE;
+
+const RADIX = 256u;
+const RADIX_MASK = 255u;
+const RADIX_LOG = 8u;
+
+const KEYS_PER_THREAD = 12u;
+const PART_SIZE = BLOCK_DIM * KEYS_PER_THREAD;  //MUST match the host
+const G_HIST_PART_SIZE = 32768u;                //MUST match the host
+
+//A record is the key's digit above its index within the tile. Padding past
+//the end of the last tile gets every digit bit set, so it splits last.
+const DIGIT_SHIFT = 16u;
+const INDEX_MASK = 0xffffu;
+const PAD_RECORD = 0xffff0000u;
+
+//Bins of a split, counted 16 bits to a field, two fields to a word
+const SPLIT_BITS = 4u;
+const SPLIT_MASK = 15u;
+const SPLIT_BINS = 16u;
+const SPLIT_WORDS = 8u;
+const FIELD_MASK = 0xffffu;
+
+const ERR_COUNT_INDEX = 0u;
+const CHECKSUM_IN_INDEX = 1u;
+const CHECKSUM_OUT_INDEX = 2u;
+
+var<workgroup> wg_hist: array<atomic<u32>, RADIX * RADIX_PASSES>;
+var<workgroup> wg_digit: array<atomic<u32>, RADIX>;
+var<workgroup> wg_records: array<u32, PART_SIZE>;
+var<workgroup> wg_sg: array<vec4<u32>, MAX_SUBGROUPS>;
+
+struct ScanResult
+{
+    prefix: vec4<u32>,
+    total: vec4<u32>,
+};
+
+//lowbias32
+fn hash(x: u32) -> u32 {
+    var h = x;
+    h ^= h >> 16u;
+    h *= 0x7feb352du;
+    h ^= h >> 15u;
+    h *= 0x846ca68bu;
+    h ^= h >> 16u;
+    return h;
+}
+
+//Exclusive workgroup wide sum. Ends on a barrier so wg_sg can be reused by
+//the next call.
+fn block_exclusive_scan(v: vec4<u32>, tid: u32, laneid: u32, lane_count: u32) -> ScanResult {
+    let sid = tid / lane_count;
+    let prefix = subgroupExclusiveAdd(v);
+    if(laneid == lane_count - 1u){
+        wg_sg[sid] = prefix + v;
+    }
+    workgroupBarrier();
+
+    var result = ScanResult(prefix, vec4<u32>());
+    for(var i = 0u; i < BLOCK_DIM / lane_count; i += 1u){
+        let t = wg_sg[i];
+        if(i < sid){
+            result.prefix += t;
+        }
+        result.total += t;
+    }
+    workgroupBarrier();
+    return result;
+}
+
+//Striped, so the loads coalesce. Leaves the tile's digit counts in wg_digit.
+fn load_records(part_start: u32, part_count: u32, tid: u32) {
+    atomicStore(&wg_digit[tid], 0u);
+    workgroupBarrier();
+
+    for(var i = tid; i < PART_SIZE; i += BLOCK_DIM){
+        var record = PAD_RECORD | i;
+        if(i < part_count){
+            let digit = extract_digit(keys_in[i + part_start], info.shift);
+            atomicAdd(&wg_digit[digit], 1u);
+            record = (digit << DIGIT_SHIFT) | i;
+        }
+        wg_records[i] = record;
+    }
+    workgroupBarrier();
+}
+
+//Stable split of the tile's records on SPLIT_BITS bits. Each thread counts
+//its KEYS_PER_THREAD consecutive records, then one scan of the packed
+//counters gives every bin of every thread its offset at once.
+fn split_records(bit: u32, tid: u32, laneid: u32, lane_count: u32) {
+    var records: array<u32, KEYS_PER_THREAD>;
+    var counts = array<u32, SPLIT_WORDS>();
+    for(var k = 0u; k < KEYS_PER_THREAD; k += 1u){
+        records[k] = wg_records[tid * KEYS_PER_THREAD + k];
+        let b = (records[k] >> bit) & SPLIT_MASK;
+        counts[b & 7u] += 1u << ((b >> 3u) << 4u);
+    }
+
+    let lo = block_exclusive_scan(
+        vec4<u32>(counts[0], counts[1], counts[2], counts[3]), tid, laneid, lane_count);
+    let hi = block_exclusive_scan(
+        vec4<u32>(counts[4], counts[5], counts[6], counts[7]), tid, laneid, lane_count);
+
+    //Fields never pass PART_SIZE * 2, so adding the bin starts cannot carry
+    var offsets = array<u32, SPLIT_WORDS>(
+        lo.prefix.x, lo.prefix.y, lo.prefix.z, lo.prefix.w,
+        hi.prefix.x, hi.prefix.y, hi.prefix.z, hi.prefix.w);
+    var totals = array<u32, SPLIT_WORDS>(
+        lo.total.x, lo.total.y, lo.total.z, lo.total.w,
+        hi.total.x, hi.total.y, hi.total.z, hi.total.w);
+    var bin_start = 0u;
+    for(var b = 0u; b < SPLIT_BINS; b += 1u){
+        let field = (b >> 3u) << 4u;
+        offsets[b & 7u] += bin_start << field;
+        bin_start += (totals[b & 7u] >> field) & FIELD_MASK;
+    }
+
+    //Every record was read before the barriers of the scans
+    for(var k = 0u; k < KEYS_PER_THREAD; k += 1u){
+        let b = (records[k] >> bit) & SPLIT_MASK;
+        let field = (b >> 3u) << 4u;
+        wg_records[(offsets[b & 7u] >> field) & FIELD_MASK] = records[k];
+        offsets[b & 7u] += 1u << field;
+    }
+    workgroupBarrier();
+}
+
+//Orders the records by digit, stably
+fn rank_records(tid: u32, laneid: u32, lane_count: u32) {
+    for(var bit = DIGIT_SHIFT; bit < DIGIT_SHIFT + RADIX_LOG; bit += SPLIT_BITS){
+        split_records(bit, tid, laneid, lane_count);
+    }
+}
+
+//wg_digit holds the device offset of each digit less its offset within the
+//tile, so adding a record's position in the ranked tile gives its destination
+fn scatter_keys(part_start: u32, part_count: u32, tid: u32) {
+    for(var i = tid; i < part_count; i += BLOCK_DIM){
+        let record = wg_records[i];
+        keys_out[atomicLoad(&wg_digit[record >> DIGIT_SHIFT]) + i] =
+            keys_in[(record & INDEX_MASK) + part_start];
+    }
+}
+
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn init(
+    @builtin(global_invocation_id) id: vec3<u32>,
+    @builtin(num_workgroups) griddim: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32) {
+
+    var checksum = 0u;
+    for(var i = id.x; i < info.size; i += griddim.x * BLOCK_DIM){
+        let key = make_key(i);
+        keys_in[i] = key;
+        checksum += key_checksum(key);
+    }
+
+    let s_checksum = subgroupAdd(checksum);
+    if(laneid == 0u){
+        atomicAdd(&misc[CHECKSUM_IN_INDEX], s_checksum);
+    }
+}
+
+//Every digit of every pass in a single read. The global histogram is
+//cleared by the host before the sort.
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn global_histogram(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(workgroup_id) blockid: vec3<u32>) {
+
+    for(var i = threadid.x; i < RADIX * RADIX_PASSES; i += BLOCK_DIM){
+        atomicStore(&wg_hist[i], 0u);
+    }
+    workgroupBarrier();
+
+    let end = min((blockid.x + 1u) * G_HIST_PART_SIZE, info.size);
+    for(var i = threadid.x + blockid.x * G_HIST_PART_SIZE; i < end; i += BLOCK_DIM){
+        let key = keys_in[i];
+        for(var k = 0u; k < RADIX_PASSES; k += 1u){
+            atomicAdd(&wg_hist[k * RADIX + extract_digit(key, k * RADIX_LOG)], 1u);
+        }
+    }
+    workgroupBarrier();
+
+    for(var i = threadid.x; i < RADIX * RADIX_PASSES; i += BLOCK_DIM){
+        let t = atomicLoad(&wg_hist[i]);
+        if(t != 0u){
+            atomicAdd(&global_hist[i], t);
+        }
+    }
+}
+
+//One workgroup per digit pass, exclusive scan the pass histogram in place
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn global_hist_scan(
+    @builtin(local_invocation_id) threadid: vec3<u32>,
+    @builtin(workgroup_id) blockid: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32,
+    @builtin(subgroup_size) lane_count: u32) {
+
+    let i = threadid.x + blockid.x * RADIX;
+    let t = atomicLoad(&global_hist[i]);
+    let s = block_exclusive_scan(vec4<u32>(t, 0u, 0u, 0u), threadid.x, laneid, lane_count);
+    atomicStore(&global_hist[i], s.prefix.x);
+}
+
+//Errors count neighbours out of order, and the checksums of the input and
+//output only match if the output is a permutation of the input
+@compute @workgroup_size(BLOCK_DIM, 1, 1)
+fn validate(
+    @builtin(global_invocation_id) id: vec3<u32>,
+    @builtin(num_workgroups) griddim: vec3<u32>,
+    @builtin(subgroup_invocation_id) laneid: u32) {
+
+    var checksum = 0u;
+    var errors = 0u;
+    for(var i = id.x; i < info.size; i += griddim.x * BLOCK_DIM){
+        let key = keys_in[i];
+        checksum += key_checksum(key);
+        if(i + 1u < info.size && key_greater(key, keys_in[i + 1u])){
+            errors += 1u;
+        }
+    }
+
+    let s_checksum = subgroupAdd(checksum);
+    let s_errors = subgroupAdd(errors);
+    if(laneid == 0u){
+        atomicAdd(&misc[CHECKSUM_OUT_INDEX], s_checksum);
+        if(s_errors != 0u){
+            atomicAdd(&misc[ERR_COUNT_INDEX], s_errors);
+        }
+    }
+}